@@ -55,7 +55,8 @@ EMITTER_ORDERING = [
     'constant',
     'envmap',
     'spot',
-    'projector'
+    'projector',
+    'volumelight'
 ]
 
 SENSOR_ORDERING = [
@@ -94,6 +95,7 @@ INTEGRATOR_ORDERING = [
     'aov',
     'volpath',
     'volpathmis',
+    'vpm',
     '../src/python/python/ad/integrators/prb.py',
     '../src/python/python/ad/integrators/prb_basic.py',
     '../src/python/python/ad/integrators/direct_projective.py',
@@ -128,7 +130,10 @@ PHASE_ORDERING = [
 
 VOLUME_ORDERING = [
     'constvolume',
-    'gridvolume'
+    'gridvolume',
+    'sparsegridvolume',
+    'gridsequence',
+    'blackbodyvolume'
 ]
 
 
@@ -271,6 +271,269 @@ private:
     Vector2u m_valid;
 };
 
+/**
+ * \brief Discrete 1D probability distribution based on the alias method
+ *
+ * This data structure provides the same interface as \ref
+ * DiscreteDistribution for evaluating and sampling probability mass
+ * functions, but it does not search the cumulative distribution function.
+ * Instead, it follows Walker's alias method: each entry stores a probability
+ * threshold and an alternative (alias) entry, which turns sampling into a
+ * constant-time operation. The threshold, alias index and the normalized
+ * probabilities of both candidates are interleaved in a single table, hence
+ * drawing a sample only reads one 16 byte record (32 bytes in double
+ * precision).
+ *
+ * The table is built on the CPU using Vose's algorithm. In JIT variants, \ref
+ * update() therefore copies the PMF to host memory.
+ */
+template <typename Value> struct AliasDistribution {
+    using Float = std::conditional_t<dr::is_static_array_v<Value>,
+                                     dr::value_t<Value>, Value>;
+    using FloatStorage   = DynamicBuffer<Float>;
+    using UInt32         = dr::uint32_array_t<Float>;
+    using Index          = dr::uint32_array_t<Value>;
+    using Mask           = dr::mask_t<Value>;
+
+    using ScalarFloat    = dr::scalar_t<Float>;
+    using ScalarUInt     = dr::uint_array_t<ScalarFloat>;
+
+    /// Contents of a table entry: threshold, alias, pmf and pmf of the alias
+    using Entry          = dr::Array<Value, 4>;
+
+public:
+    /// Create an uninitialized AliasDistribution instance
+    AliasDistribution() { }
+
+    /// Initialize from a given probability mass function
+    AliasDistribution(const FloatStorage &pmf)
+        : m_pmf(pmf) {
+        update();
+    }
+
+    /// Initialize from a given probability mass function (rvalue version)
+    AliasDistribution(FloatStorage &&pmf)
+        : m_pmf(std::move(pmf)) {
+        update();
+    }
+
+    /// Initialize from a given floating point array
+    AliasDistribution(const ScalarFloat *values, size_t size)
+        : m_pmf(dr::load<FloatStorage>(values, size)) {
+        build_table(values, size);
+    }
+
+    /// Update the internal state. Must be invoked when changing the pmf.
+    void update() {
+        if (m_pmf.empty())
+            Throw("AliasDistribution: empty distribution!");
+
+        if constexpr (dr::is_jit_v<Float>) {
+            auto &&pmf = dr::migrate(dr::detach(m_pmf), AllocType::Host);
+            dr::sync_thread();
+            build_table(pmf.data(), pmf.size());
+        } else {
+            build_table(m_pmf.data(), m_pmf.size());
+        }
+    }
+
+    /// Return the unnormalized probability mass function
+    FloatStorage &pmf() { return m_pmf; }
+
+    /// Return the unnormalized probability mass function (const version)
+    const FloatStorage &pmf() const { return m_pmf; }
+
+    /**
+     * \brief Return the interleaved alias table
+     *
+     * Entry \c i occupies four consecutive values: the probability of keeping
+     * \c i, the bit pattern of its alias index, and the normalized
+     * probabilities of \c i and of its alias.
+     */
+    const FloatStorage &table() const { return m_table; }
+
+    /// \brief Return the original sum of PMF entries before normalization
+    Float sum() const { return m_sum; }
+
+    /// \brief Return the normalization factor (i.e. the inverse of \ref sum())
+    Float normalization() const { return m_normalization; }
+
+    /// Return the number of entries
+    size_t size() const { return m_pmf.size(); }
+
+    /// Is the distribution object empty/uninitialized?
+    bool empty() const { return m_pmf.empty(); }
+
+    /// Evaluate the unnormalized probability mass function (PMF) at index \c index
+    Value eval_pmf(Index index, Mask active = true) const {
+        return dr::gather<Value>(m_pmf, index, active);
+    }
+
+    /// Evaluate the normalized probability mass function (PMF) at index \c index
+    Value eval_pmf_normalized(Index index, Mask active = true) const {
+        return dr::gather<Value>(m_pmf, index, active) * m_normalization;
+    }
+
+    /**
+     * \brief %Transform a uniformly distributed sample to the stored
+     * distribution
+     *
+     * \param sample
+     *     A uniformly distributed sample on the interval [0, 1].
+     *
+     * \return
+     *     The discrete index associated with the sample
+     */
+    Index sample(Value sample, Mask active = true) const {
+        return std::get<0>(sample_reuse_pmf(sample, active));
+    }
+
+    /**
+     * \brief %Transform a uniformly distributed sample to the stored
+     * distribution
+     *
+     * \param value
+     *     A uniformly distributed sample on the interval [0, 1].
+     *
+     * \return
+     *     A tuple consisting of
+     *
+     *     1. the discrete index associated with the sample, and
+     *     2. the normalized probability value of the sample.
+     */
+    std::pair<Index, Value> sample_pmf(Value value, Mask active = true) const {
+        auto [index, sample, pmf] = sample_reuse_pmf(value, active);
+        DRJIT_MARK_USED(sample);
+        return { index, pmf };
+    }
+
+    /**
+     * \brief %Transform a uniformly distributed sample to the stored
+     * distribution
+     *
+     * The original sample is value adjusted so that it can be reused as a
+     * uniform variate.
+     *
+     * \param value
+     *     A uniformly distributed sample on the interval [0, 1].
+     *
+     * \return
+     *     A tuple consisting of
+     *
+     *     1. the discrete index associated with the sample, and
+     *     2. the re-scaled sample value.
+     */
+    std::pair<Index, Value>
+    sample_reuse(Value value, Mask active = true) const {
+        auto [index, sample, pmf] = sample_reuse_pmf(value, active);
+        DRJIT_MARK_USED(pmf);
+        return { index, sample };
+    }
+
+    /**
+     * \brief %Transform a uniformly distributed sample to the stored
+     * distribution.
+     *
+     * The original sample is value adjusted so that it can be reused as a
+     * uniform variate.
+     *
+     * \param value
+     *     A uniformly distributed sample on the interval [0, 1].
+     *
+     * \return
+     *     A tuple consisting of
+     *
+     *     1. the discrete index associated with the sample
+     *     2. the re-scaled sample value
+     *     3. the normalized probability value of the sample
+     */
+    std::tuple<Index, Value, Value>
+    sample_reuse_pmf(Value value, Mask active = true) const {
+        MI_MASK_ARGUMENT(active);
+
+        // Select a table entry uniformly, the remainder picks a candidate
+        value = dr::clamp(value, 0.f, dr::OneMinusEpsilon<ScalarFloat>) * m_scale;
+        Index index = dr::minimum(Index(value), m_max_index);
+        value = dr::minimum(value - Value(index), dr::OneMinusEpsilon<ScalarFloat>);
+
+        Entry entry = dr::gather<Entry>(m_table, index, active);
+        Index alias = Index(dr::reinterpret_array<dr::uint_array_t<Value>>(entry.y()));
+        Mask use_alias = value >= entry.x();
+
+        return {
+            dr::select(use_alias, alias, index),
+            dr::select(use_alias, (value - entry.x()) / (1.f - entry.x()),
+                       value / entry.x()),
+            dr::select(use_alias, entry.w(), entry.z())
+        };
+    }
+
+private:
+    void build_table(const ScalarFloat *pmf, size_t size) {
+        if (size == 0)
+            Throw("AliasDistribution: empty distribution!");
+
+        double sum = 0.0;
+        for (size_t i = 0; i < size; ++i) {
+            if (pmf[i] < 0)
+                Throw("AliasDistribution: entries must be non-negative!");
+            sum += (double) pmf[i];
+        }
+
+        if (!(sum > 0.0))
+            Throw("AliasDistribution: no probability mass found!");
+
+        // Vose's algorithm: pair underfull entries with overfull ones
+        std::vector<double> prob(size);
+        std::vector<uint32_t> alias(size), small, large;
+        for (uint32_t i = 0; i < size; ++i) {
+            prob[i] = (double) pmf[i] * size / sum;
+            alias[i] = i;
+            (prob[i] < 1.0 ? small : large).push_back(i);
+        }
+
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back(), l = large.back();
+            small.pop_back();
+            alias[s] = l;
+            prob[l] -= 1.0 - prob[s];
+            if (prob[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        // Leftover entries are full up to round-off errors
+        for (uint32_t i : small)
+            prob[i] = 1.0;
+        for (uint32_t i : large)
+            prob[i] = 1.0;
+
+        std::vector<ScalarFloat> table(4 * size);
+        for (uint32_t i = 0; i < size; ++i) {
+            table[4 * i + 0] = (ScalarFloat) prob[i];
+            table[4 * i + 1] = dr::memcpy_cast<ScalarFloat>((ScalarUInt) alias[i]);
+            table[4 * i + 2] = (ScalarFloat) (pmf[i] / sum);
+            table[4 * i + 3] = (ScalarFloat) (pmf[alias[i]] / sum);
+        }
+
+        m_table = dr::load<FloatStorage>(table.data(), table.size());
+        m_sum = (ScalarFloat) sum;
+        m_normalization = (ScalarFloat) (1.0 / sum);
+        m_scale = (ScalarFloat) size;
+        m_max_index = (uint32_t) (size - 1);
+        dr::make_opaque(m_sum, m_normalization, m_scale, m_max_index);
+    }
+
+private:
+    FloatStorage m_pmf;
+    FloatStorage m_table;
+    Float m_sum = 0.f;
+    Float m_normalization = 0.f;
+    Float m_scale = 0.f;
+    UInt32 m_max_index = 0;
+};
+
 /**
  * \brief Continuous 1D probability distribution defined in terms of a regularly
  * sampled linear interpolant
@@ -985,6 +1248,16 @@ std::ostream &operator<<(std::ostream &os, const DiscreteDistribution<Value> &di
     return os;
 }
 
+template <typename Value>
+std::ostream &operator<<(std::ostream &os, const AliasDistribution<Value> &distr) {
+    os << "AliasDistribution[" << std::endl
+        << "  size = " << distr.size() << "," << std::endl
+        << "  sum = " << distr.sum() << "," << std::endl
+        << "  pmf = " << distr.pmf() << std::endl
+        << "]";
+    return os;
+}
+
 template <typename Value>
 std::ostream &operator<<(std::ostream &os, const ContinuousDistribution<Value> &distr) {
     os << "ContinuousDistribution[" << std::endl
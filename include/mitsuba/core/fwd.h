@@ -64,6 +64,7 @@ template <typename Point>                       struct BoundingBox;
 template <typename Point>                       struct BoundingSphere;
 template <typename Vector>                      struct Frame;
 template <typename Float>                       struct DiscreteDistribution;
+template <typename Float>                       struct AliasDistribution;
 template <typename Float>                       struct ContinuousDistribution;
 
 template <typename Spectrum> using StokesVector  = dr::Array<Spectrum, 4>;
@@ -426,6 +426,124 @@ Parameter ``sample_scale``:
     A scale factor that must be applied to each sample to account for
     the film resolution and number of samples.)doc";
 
+static const char *__doc_mitsuba_AliasDistribution =
+R"doc(Discrete 1D probability distribution based on the alias method
+
+This data structure provides the same interface as
+DiscreteDistribution for evaluating and sampling probability mass
+functions, but it does not search the cumulative distribution
+function. Instead, it follows Walker's alias method: each entry stores
+a probability threshold and an alternative (alias) entry, which turns
+sampling into a constant-time operation. The threshold, alias index
+and the normalized probabilities of both candidates are interleaved in
+a single table, hence drawing a sample only reads one 16 byte record
+(32 bytes in double precision).
+
+The table is built on the CPU using Vose's algorithm. In JIT variants,
+update() therefore copies the PMF to host memory.)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_AliasDistribution = R"doc(Create an uninitialized AliasDistribution instance)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_AliasDistribution_2 = R"doc(Initialize from a given probability mass function)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_AliasDistribution_3 = R"doc(Initialize from a given probability mass function (rvalue version))doc";
+
+static const char *__doc_mitsuba_AliasDistribution_AliasDistribution_4 = R"doc(Initialize from a given floating point array)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_build_table = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasDistribution_empty = R"doc(Is the distribution object empty/uninitialized?)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_eval_pmf =
+R"doc(Evaluate the unnormalized probability mass function (PMF) at index
+``index``)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_eval_pmf_normalized =
+R"doc(Evaluate the normalized probability mass function (PMF) at index
+``index``)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_m_max_index = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasDistribution_m_normalization = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasDistribution_m_pmf = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasDistribution_m_scale = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasDistribution_m_sum = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasDistribution_m_table = R"doc()doc";
+
+static const char *__doc_mitsuba_AliasDistribution_normalization = R"doc(Return the normalization factor (i.e. the inverse of sum()))doc";
+
+static const char *__doc_mitsuba_AliasDistribution_pmf = R"doc(Return the unnormalized probability mass function)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_pmf_2 = R"doc(Return the unnormalized probability mass function (const version))doc";
+
+static const char *__doc_mitsuba_AliasDistribution_sample =
+R"doc(%Transform a uniformly distributed sample to the stored distribution
+
+Parameter ``sample``:
+    A uniformly distributed sample on the interval [0, 1].
+
+Returns:
+    The discrete index associated with the sample)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_sample_pmf =
+R"doc(%Transform a uniformly distributed sample to the stored distribution
+
+Parameter ``value``:
+    A uniformly distributed sample on the interval [0, 1].
+
+Returns:
+    A tuple consisting of
+
+1. the discrete index associated with the sample, and 2. the
+normalized probability value of the sample.)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_sample_reuse =
+R"doc(%Transform a uniformly distributed sample to the stored distribution
+
+The original sample is value adjusted so that it can be reused as a
+uniform variate.
+
+Parameter ``value``:
+    A uniformly distributed sample on the interval [0, 1].
+
+Returns:
+    A tuple consisting of
+
+1. the discrete index associated with the sample, and 2. the re-scaled
+sample value.)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_sample_reuse_pmf =
+R"doc(%Transform a uniformly distributed sample to the stored distribution.
+
+The original sample is value adjusted so that it can be reused as a
+uniform variate.
+
+Parameter ``value``:
+    A uniformly distributed sample on the interval [0, 1].
+
+Returns:
+    A tuple consisting of
+
+1. the discrete index associated with the sample 2. the re-scaled
+sample value 3. the normalized probability value of the sample)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_size = R"doc(Return the number of entries)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_sum = R"doc(Return the original sum of PMF entries before normalization)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_table =
+R"doc(Return the interleaved alias table
+
+Entry ``i`` occupies four consecutive values: the probability of
+keeping ``i``, the bit pattern of its alias index, and the normalized
+probabilities of ``i`` and of its alias.)doc";
+
+static const char *__doc_mitsuba_AliasDistribution_update = R"doc(Update the internal state. Must be invoked when changing the pmf.)doc";
+
 static const char *__doc_mitsuba_Appender =
 R"doc(This class defines an abstract destination for logging-relevant
 information)doc";
@@ -2417,6 +2535,8 @@ static const char *__doc_mitsuba_EmitterFlags_SpatiallyVarying = R"doc(The emiss
 
 static const char *__doc_mitsuba_EmitterFlags_Surface = R"doc(The emitter is attached to a surface (e.g. area emitters))doc";
 
+static const char *__doc_mitsuba_EmitterFlags_Volume = R"doc(The emitter is a participating medium (i.e. emits from a volume))doc";
+
 static const char *__doc_mitsuba_Emitter_Emitter = R"doc()doc";
 
 static const char *__doc_mitsuba_Emitter_class = R"doc()doc";
@@ -3633,8 +3753,31 @@ The default implementation simply returns an empty vector.)doc";
 
 static const char *__doc_mitsuba_Integrator_cancel = R"doc(Cancel a running render job (e.g. after receiving Ctrl-C))doc";
 
+static const char *__doc_mitsuba_Integrator_check_volume_emitters = R"doc(Warn if ``scene`` contains volume emitters that this integrator ignores)doc";
+
 static const char *__doc_mitsuba_Integrator_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Integrator_eval_transmittance =
+R"doc(Estimate the transmittance along a ray through participating media,
+up to its ``maxt``
+
+Homogeneous media are handled in closed form, other media by residual
+ratio tracking against their control extinction (see
+Medium::get_control_extinction()). Surfaces with a null BSDF along the
+way are passed through, all other surfaces are occluders.
+
+Parameter ``medium``:
+    Medium containing the origin of the ray
+
+Parameter ``channel``:
+    Channel used to sample collisions (see
+    Medium::sample_interaction())
+
+Parameter ``footprint``:
+    Width of the path footprint at the ray origin)doc";
+
+static const char *__doc_mitsuba_Integrator_eval_transmittance_2 = R"doc(Estimate the transmittance between an interaction and a point ``p``)doc";
+
 static const char *__doc_mitsuba_Integrator_m_hide_emitters = R"doc(Flag for disabling direct visibility of emitters)doc";
 
 static const char *__doc_mitsuba_Integrator_m_render_timer = R"doc(Timer used to enforce the timeout.)doc";
@@ -3828,6 +3971,35 @@ This function is just a thin wrapper around the previous
 render_forward() function. It accepts a sensor *index* instead and
 renders the scene using sensor 0 by default.)doc";
 
+static const char *__doc_mitsuba_Integrator_sample_light_bsdf =
+R"doc(Continue a light path at a surface by sampling the adjoint BSDF
+
+Directions that would leak light through shading normals are rejected,
+and ``medium`` is updated when the path crosses a medium boundary.
+
+Returns:
+    The mask of lanes that continue and the mask of those that sampled
+    a non-null component (i.e. that count a bounce).)doc";
+
+static const char *__doc_mitsuba_Integrator_sample_light_collision =
+R"doc(Sample the next collision of a light path in a medium
+
+Free-flight distances are sampled by delta tracking against the
+largest majorant over all channels, and collisions are classified
+according to the largest extinction. ``throughput`` is updated with
+the weight of the sampled event. Null collisions move the origin of
+``ray`` (and the distance to ``si``) to the collision, so that the
+flight resumes there.
+
+Returns:
+    The medium interaction, the mask of lanes that collided inside the
+    medium and the mask of those whose collision is a real scattering
+    event.)doc";
+
+static const char *__doc_mitsuba_Integrator_sample_light_phase =
+R"doc(Continue a light path at a real scattering event in a medium by
+sampling its (self-adjoint) phase function)doc";
+
 static const char *__doc_mitsuba_Integrator_should_stop =
 R"doc(Indicates whether cancel() or a timeout have occurred. Should be
 checked regularly in the integrator's main loop so that timeouts are
@@ -3836,6 +4008,17 @@ enforced accurately.
 Note that accurate timeouts rely on m_render_timer, which needs to be
 reset at the beginning of the rendering phase.)doc";
 
+static const char *__doc_mitsuba_Integrator_supports_volume_emitters =
+R"doc(Does this integrator account for volume emitters?
+
+Volume emitters (see EmitterFlags::Volume) sample points inside of
+emissive media, with densities per unit solid angle and distance. Only
+integrators that also collect the emission of media along their paths
+can combine them with their other sampling strategies. Scenes
+therefore only create volume emitters when their integrator opts in
+(see the ``volume_emitters`` parameter of Scene). The default
+implementation returns ``False``.)doc";
+
 static const char *__doc_mitsuba_Interaction = R"doc(Generic surface interaction data structure)doc";
 
 static const char *__doc_mitsuba_Interaction_Interaction = R"doc(Constructor)doc";
@@ -4278,6 +4461,10 @@ static const char *__doc_mitsuba_MediumInteraction_apply_label = R"doc()doc";
 
 static const char *__doc_mitsuba_MediumInteraction_combined_extinction = R"doc()doc";
 
+static const char *__doc_mitsuba_MediumInteraction_footprint =
+R"doc(Width of the path footprint at ``p`` in world space units, used by
+media to select a level of detail. Zero requests the finest level.)doc";
+
 static const char *__doc_mitsuba_MediumInteraction_medium = R"doc(Pointer to the associated medium)doc";
 
 static const char *__doc_mitsuba_MediumInteraction_mint = R"doc(mint used when sampling the given distance ``t``)doc";
@@ -4292,6 +4479,12 @@ static const char *__doc_mitsuba_MediumInteraction_operator_assign_3 = R"doc()do
 
 static const char *__doc_mitsuba_MediumInteraction_operator_assign_4 = R"doc()doc";
 
+static const char *__doc_mitsuba_MediumInteraction_phase_params =
+R"doc(Parameters of a spatially varying phase function at ``p`` (e.g. the
+SGGX matrix), cached by the medium when sampling the interaction so
+that later phase function queries can skip the volume lookup. An all-
+zero array denotes an empty cache.)doc";
+
 static const char *__doc_mitsuba_MediumInteraction_sh_frame = R"doc(Shading frame)doc";
 
 static const char *__doc_mitsuba_MediumInteraction_sigma_n = R"doc()doc";
@@ -4310,24 +4503,68 @@ space)doc";
 
 static const char *__doc_mitsuba_MediumInteraction_wi = R"doc(Incident direction in world frame)doc";
 
+static const char *__doc_mitsuba_Medium_MaxMajorantChannel =
+R"doc(Channel index instructing sample_interaction() to sample against the
+maximum majorant over all channels)doc";
+
 static const char *__doc_mitsuba_Medium_Medium = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_Medium_2 = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Medium_emission_power =
+R"doc(Estimate of the total power emitted by the medium
+
+Used to weight the medium against other light sources when the scene
+builds its emitter sampling distribution. Media that are not emitters
+return zero.)doc";
+
+static const char *__doc_mitsuba_Medium_emitter =
+R"doc(Return the volume emitter through which the scene samples this
+medium's emission (or ``nullptr``)
+
+The emitter is created and owned by the Scene that references the
+medium.)doc";
+
+static const char *__doc_mitsuba_Medium_emitter_2 = R"doc(Return the volume emitter associated with this medium (non-const version))doc";
+
+static const char *__doc_mitsuba_Medium_get_control_extinction =
+R"doc(Returns the control extinction used by residual ratio tracking
+
+The control extinction is a constant approximation of Sigma_t along
+the ray leaving mi, whose transmittance is evaluated analytically.
+Only the residual between both quantities then needs to be estimated
+stochastically. The estimate is unbiased for any value; it is most
+efficient when the control bounds Sigma_t from below. Homogeneous
+media return Sigma_t itself, so that their transmittance is exact.
+
+The default implementation returns zero (i.e. plain ratio tracking).)doc";
+
 static const char *__doc_mitsuba_Medium_get_majorant = R"doc(Returns the medium's majorant used for delta tracking)doc";
 
+static const char *__doc_mitsuba_Medium_get_radiance =
+R"doc(Returns the radiance emitted by the medium at a given
+MediumInteraction mi
+
+The volumetric emission term of the RTE is obtained by multiplying the
+returned radiance with the absorption coefficient ``sigma_t -
+sigma_s``. Media that are not emitters return zero.)doc";
+
 static const char *__doc_mitsuba_Medium_get_scattering_coefficients =
 R"doc(Returns the medium coefficients Sigma_s, Sigma_n and Sigma_t evaluated
 at a given MediumInteraction mi)doc";
 
+static const char *__doc_mitsuba_Medium_has_majorant_grid = R"doc(Returns whether free-flight sampling uses a local majorant supergrid)doc";
+
 static const char *__doc_mitsuba_Medium_has_spectral_extinction = R"doc(Returns whether this medium has a spectrally varying extinction)doc";
 
 static const char *__doc_mitsuba_Medium_id = R"doc(Return a string identifier)doc";
 
 static const char *__doc_mitsuba_Medium_intersect_aabb = R"doc(Intersects a ray with the medium's bounding box)doc";
 
+static const char *__doc_mitsuba_Medium_is_emitter = R"doc(Returns whether this medium emits light)doc";
+
 static const char *__doc_mitsuba_Medium_is_homogeneous = R"doc(Returns whether this medium is homogeneous)doc";
 
 static const char *__doc_mitsuba_Medium_m_has_spectral_extinction = R"doc()doc";
@@ -4348,6 +4585,8 @@ static const char *__doc_mitsuba_Medium_operator_new = R"doc()doc";
 
 static const char *__doc_mitsuba_Medium_operator_new_2 = R"doc()doc";
 
+static const char *__doc_mitsuba_Medium_pdf_emission = R"doc(Evaluate the density per unit volume of sample_emission() at ``p``)doc";
+
 static const char *__doc_mitsuba_Medium_phase_function = R"doc(Return the phase function of this medium)doc";
 
 static const char *__doc_mitsuba_Medium_sample_interaction =
@@ -4367,12 +4606,39 @@ Parameter ``sample``:
 Parameter ``channel``:
     The channel according to which we will sample the free-flight
     distance. This argument is only used when rendering in RGB modes.
+    MaxMajorantChannel (or any value beyond the number of channels)
+    selects the maximum of the majorant over all channels (and
+    wavelengths) instead, which is then reported as a spectrally
+    constant ``combined_extinction``. This mode is used by spectral
+    tracking.
+
+Parameter ``footprint``:
+    Width of the path footprint at the ray origin (in world space
+    units)
+
+Parameter ``spread``:
+    Growth of the footprint width per unit distance along the ray. The
+    footprint at the sampled position is stored in the returned
+    interaction and selects the level of detail of the medium.
 
 Returns:
     This method returns a MediumInteraction. The MediumInteraction
     will always be valid, except if the ray missed the Medium's
     bounding box.)doc";
 
+static const char *__doc_mitsuba_Medium_sample_emission =
+R"doc(Sample a position inside the medium proportionally to its emission
+
+Parameter ``sample``:
+    A uniformly distributed 3D sample
+
+Returns:
+    The sampled world-space position and its probability density per
+    unit volume. The density is zero when the medium is not an
+    emitter.)doc";
+
+static const char *__doc_mitsuba_Medium_set_emitter = R"doc(Set the volume emitter associated with this medium)doc";
+
 static const char *__doc_mitsuba_Medium_set_id = R"doc(Set a string identifier)doc";
 
 static const char *__doc_mitsuba_Medium_to_string = R"doc(Return a human-readable representation of the Medium)doc";
@@ -5456,6 +5722,22 @@ static const char *__doc_mitsuba_PhaseFunction_class = R"doc()doc";
 
 static const char *__doc_mitsuba_PhaseFunction_component_count = R"doc(Number of components this phase function is comprised of.)doc";
 
+static const char *__doc_mitsuba_PhaseFunction_eval_params =
+R"doc(Evaluates the spatially varying parameters of the phase function
+
+Media store the result in ``mi.phase_params`` when sampling an
+interaction, so that projected_area(), eval_pdf() and sample() can
+reuse it instead of repeating the volume lookup at the same position.
+Phase functions without spatially varying parameters return an all-
+zero array, which denotes an empty cache.
+
+Parameter ``mi``:
+    A medium interaction data structure describing the underlying
+    medium position.
+
+Returns:
+    The parameters at position ``mi.p``)doc";
+
 static const char *__doc_mitsuba_PhaseFunction_eval_pdf =
 R"doc(Evaluates the phase function model value and PDF
 
@@ -6705,7 +6987,12 @@ light sources in the scene (see sample_emitter_ray())
 
 * Sampling directions approximately proportional to the direct
 radiance from emitters received at a given scene location (see
-sample_emitter_direction()).)doc";
+sample_emitter_direction()).
+
+The emission of participating media is exposed to emitter sampling
+through volume emitters when the boolean parameter ``volume_emitters``
+is set. It defaults to ``True`` when the scene's integrator supports
+them (see Integrator::supports_volume_emitters()).)doc";
 
 static const char *__doc_mitsuba_Scene_2 = R"doc()doc";
 
@@ -6778,6 +7065,10 @@ Returns:
     The incident radiance and discrete or solid angle density of the
     sample.)doc";
 
+static const char *__doc_mitsuba_Scene_has_media =
+R"doc(Specifies whether any shape, sensor or emitter of the scene references
+a participating medium)doc";
+
 static const char *__doc_mitsuba_Scene_integrator = R"doc(Return the scene's integrator)doc";
 
 static const char *__doc_mitsuba_Scene_integrator_2 = R"doc(Return the scene's integrator)doc";
@@ -6812,6 +7103,8 @@ static const char *__doc_mitsuba_Scene_m_emitters_dr = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_m_environment = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_m_has_media = R"doc()doc";
+
 static const char *__doc_mitsuba_Scene_m_integrator = R"doc()doc";
 
 static const char *__doc_mitsuba_Scene_m_sensors = R"doc()doc";
@@ -7014,6 +7307,36 @@ static const char *__doc_mitsuba_Scene_ray_intersect_preliminary_cpu = R"doc(Tra
 
 static const char *__doc_mitsuba_Scene_ray_intersect_preliminary_gpu = R"doc()doc";
 
+static const char *__doc_mitsuba_Scene_ray_intersect_sorted =
+R"doc(Intersect incoherent rays after reordering them for coherence
+
+This function is equivalent to ray_intersect(), but it first sorts the
+active rays by the cell containing their origin (in a regular grid
+over the scene's bounding box) and by the octant of their direction
+using a parallel radix sort. The rays are intersected in this order,
+and the results are permuted back before the surface interactions are
+computed. On large scenes, this considerably improves the memory
+access patterns of the ray tracing backend for incoherent rays, e.g.
+after a bounce in a wavefront-style renderer.
+
+Active rays only trade places with other active rays, so that this
+function can be used within a Dr.Jit loop in wavefront mode. Sorting
+requires evaluating the rays and is only performed in ``llvm_*``
+variants when no loop or virtual function call is being recorded.
+Otherwise, this function simply calls ray_intersect().
+
+Parameter ``ray``:
+    A 3D ray including maximum extent (Ray::maxt) and time (Ray::time)
+    information, which matters when the shapes are in motion
+
+Parameter ``ray_flags``:
+    An integer combining flag bits from RayFlags (merged using binary
+    or).
+
+Returns:
+    A detailed surface interaction record. Its ``is_valid()`` method
+    should be queried to check if an intersection was actually found.)doc";
+
 static const char *__doc_mitsuba_Scene_ray_test =
 R"doc(Intersect a ray with the shapes comprising the scene and return a
 boolean specifying whether or not an intersection was found.
@@ -9957,7 +10280,15 @@ static const char *__doc_mitsuba_VolumeGrid_VolumeGrid =
 R"doc(Load a VolumeGrid from a given filename
 
 Parameter ``path``:
-    Name of the file to be loaded)doc";
+    Name of the file to be loaded
+
+Parameter ``use_mmap``:
+    When set to ``True`` (the default), the file is mapped into memory
+    and the grid refers to its payload directly instead of copying it.
+    This is only possible when the voxel values are stored with the
+    same representation as ``ScalarFloat`` (i.e., single precision on
+    a little endian machine); the loader silently falls back to
+    reading the file otherwise.)doc";
 
 static const char *__doc_mitsuba_VolumeGrid_VolumeGrid_2 =
 R"doc(Load a VolumeGrid from an arbitrary stream data source
@@ -9979,20 +10310,31 @@ static const char *__doc_mitsuba_VolumeGrid_channel_count = R"doc(Return the num
 
 static const char *__doc_mitsuba_VolumeGrid_class = R"doc()doc";
 
-static const char *__doc_mitsuba_VolumeGrid_data = R"doc(Return a pointer to the underlying volume storage)doc";
+static const char *__doc_mitsuba_VolumeGrid_data =
+R"doc(Return a pointer to the underlying volume storage
+
+Memory-mapped files are read-only: if the grid refers to such a
+mapping, its contents are first copied into memory owned by the grid.
+Use the ``const`` overload to access the data without this copy.)doc";
 
 static const char *__doc_mitsuba_VolumeGrid_data_2 = R"doc(Return a pointer to the underlying volume storage)doc";
 
+static const char *__doc_mitsuba_VolumeGrid_is_mapped = R"doc(Does the grid refer to the payload of a memory-mapped file?)doc";
+
 static const char *__doc_mitsuba_VolumeGrid_m_bbox = R"doc()doc";
 
 static const char *__doc_mitsuba_VolumeGrid_m_channel_count = R"doc()doc";
 
-static const char *__doc_mitsuba_VolumeGrid_m_data = R"doc()doc";
+static const char *__doc_mitsuba_VolumeGrid_m_data = R"doc(Voxel storage owned by the grid (unused when the file is mapped))doc";
+
+static const char *__doc_mitsuba_VolumeGrid_m_data_ptr = R"doc(Points to the voxel values, either in ``m_data`` or in ``m_mmap``)doc";
 
 static const char *__doc_mitsuba_VolumeGrid_m_max = R"doc()doc";
 
 static const char *__doc_mitsuba_VolumeGrid_m_max_per_channel = R"doc()doc";
 
+static const char *__doc_mitsuba_VolumeGrid_m_mmap = R"doc(Memory mapping of the volume file, if any)doc";
+
 static const char *__doc_mitsuba_VolumeGrid_m_size = R"doc()doc";
 
 static const char *__doc_mitsuba_VolumeGrid_max = R"doc(Return the precomputed maximum over the volume grid)doc";
@@ -10004,6 +10346,8 @@ Pointer allocation/deallocation must be performed by the caller.)doc";
 
 static const char *__doc_mitsuba_VolumeGrid_read = R"doc()doc";
 
+static const char *__doc_mitsuba_VolumeGrid_read_header = R"doc(Parse the header of a volume file and return the payload size in values)doc";
+
 static const char *__doc_mitsuba_VolumeGrid_set_max = R"doc(Set the precomputed maximum over the volume grid)doc";
 
 static const char *__doc_mitsuba_VolumeGrid_set_max_per_channel =
@@ -10013,6 +10357,13 @@ Pointer allocation/deallocation must be performed by the caller.)doc";
 
 static const char *__doc_mitsuba_VolumeGrid_size = R"doc(Return the resolution of the voxel grid)doc";
 
+static const char *__doc_mitsuba_VolumeGrid_update_max =
+R"doc(Recompute the maximum over the volume grid (overall and per channel)
+from its current contents
+
+The voxels are processed in parallel blocks, which makes this cheap
+enough to be called after loading or modifying large grids.)doc";
+
 static const char *__doc_mitsuba_VolumeGrid_to_string = R"doc(Return a human-readable summary of this volume grid)doc";
 
 static const char *__doc_mitsuba_VolumeGrid_write =
@@ -10039,6 +10390,14 @@ support per-channel queries.)doc";
 
 static const char *__doc_mitsuba_Volume_class = R"doc()doc";
 
+static const char *__doc_mitsuba_Volume_empty_space_block_size =
+R"doc(Returns the edge length (in voxels) of the blocks in which the volume
+tracks empty space, or zero if it has no empty blocks
+
+Media use it as the resolution factor of their majorant supergrid, so
+that free-flight sampling skips the empty blocks. The default
+implementation returns zero.)doc";
+
 static const char *__doc_mitsuba_Volume_eval =
 R"doc(Evaluate the volume at the given surface interaction, with color
 processing.)doc";
@@ -10058,6 +10417,14 @@ static const char *__doc_mitsuba_Volume_eval_gradient =
 R"doc(Evaluate the volume at the given surface interaction, and compute the
 gradients of the linear interpolant as well.)doc";
 
+static const char *__doc_mitsuba_Volume_eval_filtered =
+R"doc(Evaluate the volume filtered over a footprint of the given width (in
+world space units), with color processing
+
+Volumes with a level-of-detail representation use it to select a
+prefiltered version of their data. The default implementation ignores
+the footprint and calls eval().)doc";
+
 static const char *__doc_mitsuba_Volume_eval_n =
 R"doc(Evaluate this volume as a n-channel float quantity
 
@@ -10079,6 +10446,22 @@ maximum value for each channel.
 
 Pointer allocation/deallocation must be performed by the caller.)doc";
 
+static const char *__doc_mitsuba_Volume_min =
+R"doc(Returns a lower bound of the volume over all dimensions.
+
+The default implementation returns zero, which is a valid bound for
+the non-negative quantities (e.g. densities) that volumes usually
+store.)doc";
+
+static const char *__doc_mitsuba_Volume_occupied_bbox =
+R"doc(Returns a bounding box of the region in which the volume can evaluate
+to nonzero values
+
+The bounding box is expressed in the local ``[0, 1]^3`` coordinates of
+the volume (see to_local()). Media use it to clip rays to the occupied
+part of a sparse volume. The default implementation returns the unit
+cube.)doc";
+
 static const char *__doc_mitsuba_Volume_resolution =
 R"doc(Returns the resolution of the volume, assuming that it is based on a
 discrete representation.
@@ -10089,6 +10472,17 @@ static const char *__doc_mitsuba_Volume_to_string = R"doc(Returns a human-reable
 
 static const char *__doc_mitsuba_Volume_update_bbox = R"doc()doc";
 
+static const char *__doc_mitsuba_Volume_voxel_data =
+R"doc(Returns the voxel data of a grid-based volume
+
+When lookups interpolate a tensor of shape ``(Z, Y, X, C)`` over the
+local ``[0, 1]^3`` domain of the volume, this function returns it and
+sets the filter and wrap modes used to interpolate it, as well as
+whether lookups use hardware-accelerated textures. Media use it to
+pack several volumes into a single texture. The default implementation
+returns ``nullptr``, which is also the right answer for data that is
+transformed during lookups (e.g. spectral upsampling).)doc";
+
 static const char *__doc_mitsuba_ZStream =
 R"doc(Transparent compression/decompression stream based on ``zlib``.
 
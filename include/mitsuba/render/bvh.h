@@ -0,0 +1,356 @@
+#pragma once
+
+#include <atomic>
+
+#include <nanothread/nanothread.h>
+#include <mitsuba/core/bbox.h>
+#include <mitsuba/core/fwd.h>
+#include <mitsuba/core/logger.h>
+#include <mitsuba/core/math.h>
+#include <mitsuba/core/object.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/core/timer.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/core/vector.h>
+#include <mitsuba/render/interaction.h>
+#include <mitsuba/render/mesh.h>
+
+/// Number of children per BVH node (4: SSE/NEON, 8: AVX)
+#define MI_BVH_WIDTH 4u
+
+/// Compile-time BVH depth limit to enable traversal with stack memory
+#define MI_BVH_MAXDEPTH 64u
+
+/// Number of bins used to evaluate the surface area heuristic
+#define MI_BVH_BINS 16u
+
+/// Grain size for parallelization
+#define MI_BVH_GRAIN_SIZE 4096u
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**
+ * \brief Wide bounding volume hierarchy (BVH) over the shapes of a scene
+ *
+ * This class is an alternative to \ref ShapeKDTree for the native CPU ray
+ * tracing backend (i.e. when Mitsuba is compiled without Embree). It is
+ * selected by setting the scene parameter <tt>accel</tt> to <tt>"bvh"</tt>.
+ *
+ * The hierarchy is first built top-down as a binary BVH. Each node is split
+ * using the surface area heuristic (SAH), which is evaluated over
+ * \c MI_BVH_BINS bins of the primitive centroids along every axis. Large
+ * subtrees are built in parallel. The binary BVH is then collapsed into a
+ * tree with \c MI_BVH_WIDTH children per node. The bounding boxes of the
+ * children of a node are stored in SoA layout, which lets the traversal test
+ * a ray against all of them at once using packet instructions.
+ *
+ * The following scene parameters control the construction:
+ *
+ * - <tt>bvh_max_leaf_size</tt>: Nodes with more primitives are always split
+ *   (default: 4). Smaller nodes become leaves when the SAH predicts that
+ *   this is cheaper than splitting them.
+ * - <tt>bvh_traversal_cost</tt>: Cost of a node traversal relative to
+ *   the intersection of a primitive in the SAH (default: 1).
+ */
+template <typename Float, typename Spectrum>
+class MI_EXPORT_LIB ShapeBVH : public Object {
+public:
+    MI_IMPORT_TYPES(Shape, Mesh)
+
+    using ScalarRay3f = Ray<ScalarPoint3f, Spectrum>;
+    using Size        = uint32_t;
+    using Index       = uint32_t;
+
+    static constexpr size_t Width = MI_BVH_WIDTH;
+    using FloatW = dr::Array<ScalarFloat, Width>;
+    using MaskW  = dr::mask_t<FloatW>;
+
+    /// Create an empty BVH and take build-related parameters from \c props.
+    ShapeBVH(const Properties &props);
+
+    /// Clear the BVH (build-related parameters remain)
+    void clear();
+
+    /// Register a new shape with the BVH (to be called before \ref build())
+    void add_shape(Shape *shape);
+
+    /// Build the BVH
+    void build();
+
+    /// Has the BVH been built?
+    bool ready() const { return (bool) m_nodes; }
+
+    /// Return the number of registered shapes
+    Size shape_count() const { return Size(m_shapes.size()); }
+
+    /// Return the number of registered primitives
+    Size primitive_count() const { return m_primitive_map.back(); }
+
+    /// Return the number of nodes of the BVH
+    Size node_count() const { return m_node_count; }
+
+    /// Return the i-th shape (const version)
+    const Shape *shape(size_t i) const { Assert(i < m_shapes.size()); return m_shapes[i]; }
+
+    /// Return the i-th shape
+    Shape *shape(size_t i) { Assert(i < m_shapes.size()); return m_shapes[i]; }
+
+    /// Return the bounding box of the entire BVH
+    const ScalarBoundingBox3f &bbox() const { return m_bbox; }
+
+    template <bool ShadowRay>
+    MI_INLINE PreliminaryIntersection3f ray_intersect_preliminary(const Ray3f &ray,
+                                                                   Mask active) const {
+        DRJIT_MARK_USED(active);
+        if constexpr (!dr::is_array_v<Float>)
+            return ray_intersect_scalar<ShadowRay>(ray);
+        else
+            Throw("BVH should only be used in scalar mode");
+    }
+
+    template <bool ShadowRay>
+    MI_INLINE PreliminaryIntersection<ScalarFloat, Shape>
+    ray_intersect_scalar(ScalarRay3f ray) const {
+        /// Ray traversal stack entry (an inner node or a leaf)
+        struct BVHStackEntry {
+            // Entry distance of the ray into the bounding box
+            ScalarFloat t;
+            // Node index (inner node) or primitive offset (leaf)
+            Index child;
+            // Primitive count (zero for inner nodes)
+            Size count;
+        };
+
+        BVHStackEntry stack[MI_BVH_MAXDEPTH * (Width - 1) + 1];
+        size_t stack_index = 0;
+
+        PreliminaryIntersection<ScalarFloat, Shape> pi;
+
+        /* Avoid infinite reciprocals, whose product with a zero distance to
+           a bounding box plane would produce a NaN */
+        ScalarVector3f d = ray.d;
+        for (size_t k = 0; k < 3; ++k) {
+            if (unlikely(dr::abs(d[k]) < dr::Epsilon<ScalarFloat>))
+                d[k] = dr::copysign(dr::Epsilon<ScalarFloat>, d[k]);
+        }
+        ScalarVector3f d_rcp = dr::rcp(d);
+
+        /* Rows of the node bounds that hold the entry and exit planes */
+        size_t row_near[3], row_far[3];
+        for (size_t k = 0; k < 3; ++k) {
+            row_near[k] = d_rcp[k] >= 0.f ? k : k + 3;
+            row_far[k]  = d_rcp[k] >= 0.f ? k + 3 : k;
+        }
+
+        const FloatW o_x(ray.o.x()), o_y(ray.o.y()), o_z(ray.o.z()),
+                     r_x(d_rcp.x()), r_y(d_rcp.y()), r_z(d_rcp.z());
+
+        /* Conservative exit distances guard against missed intersections
+           due to round-off errors (Ize, 2013) */
+        const ScalarFloat far_scale = 1.f + 6.f * dr::Epsilon<ScalarFloat>;
+
+        stack[stack_index++] = { 0.f, 0, 0 };
+
+        while (stack_index > 0) {
+            const BVHStackEntry entry = stack[--stack_index];
+            if (entry.t > ray.maxt)
+                continue;
+
+            if (entry.count > 0) { // Arrived at a leaf
+                for (Index i = entry.child; i < entry.child + entry.count; ++i) {
+                    PreliminaryIntersection<ScalarFloat, Shape> prim_pi =
+                        intersect_prim<ShadowRay>(m_indices[i], ray);
+
+                    if (unlikely(prim_pi.is_valid())) {
+                        if constexpr (ShadowRay)
+                            return prim_pi;
+
+                        Assert(prim_pi.t >= 0.f && prim_pi.t <= ray.maxt);
+                        pi = prim_pi;
+                        ray.maxt = pi.t;
+                    }
+                }
+                continue;
+            }
+
+            // Test the ray against the bounding boxes of all children at once
+            const Node &node = m_nodes[entry.child];
+            FloatW t_near_x = (dr::load<FloatW>(node.bounds[row_near[0]]) - o_x) * r_x,
+                   t_near_y = (dr::load<FloatW>(node.bounds[row_near[1]]) - o_y) * r_y,
+                   t_near_z = (dr::load<FloatW>(node.bounds[row_near[2]]) - o_z) * r_z,
+                   t_far_x  = (dr::load<FloatW>(node.bounds[row_far[0]]) - o_x) * r_x,
+                   t_far_y  = (dr::load<FloatW>(node.bounds[row_far[1]]) - o_y) * r_y,
+                   t_far_z  = (dr::load<FloatW>(node.bounds[row_far[2]]) - o_z) * r_z;
+
+            FloatW t_near = dr::maximum(dr::maximum(t_near_x, t_near_y),
+                                        dr::maximum(t_near_z, 0.f)),
+                   t_far  = dr::minimum(dr::minimum(t_far_x, t_far_y), t_far_z);
+            t_far = dr::minimum(t_far * far_scale, ray.maxt);
+
+            MaskW hit = t_near <= t_far;
+            if (dr::none(hit))
+                continue;
+
+            /* Push the children that were hit, ordered such that the closest
+               one is visited first */
+            size_t first = stack_index;
+            for (size_t i = 0; i < Width; ++i) {
+                if (!hit[i])
+                    continue;
+
+                BVHStackEntry child { t_near[i], node.child[i], node.count[i] };
+                size_t j = stack_index++;
+                while (j > first && stack[j - 1].t < child.t) {
+                    stack[j] = stack[j - 1];
+                    --j;
+                }
+                stack[j] = child;
+            }
+        }
+
+        return pi;
+    }
+
+    /// Brute force intersection routine for debugging purposes
+    template <bool ShadowRay>
+    MI_INLINE PreliminaryIntersection3f
+    ray_intersect_naive(Ray3f ray, Mask active) const {
+        if constexpr (!dr::is_array_v<Float>) {
+            PreliminaryIntersection3f pi = dr::zeros<PreliminaryIntersection3f>();
+
+            for (Size i = 0; i < primitive_count(); ++i) {
+                PreliminaryIntersection3f prim_pi = intersect_prim<ShadowRay>(i, ray);
+
+                if (prim_pi.is_valid()) {
+                    pi = prim_pi;
+                    ray.maxt = prim_pi.t;
+                }
+
+                if (ShadowRay && dr::all(pi.is_valid() || !active))
+                    break;
+            }
+
+            return pi;
+        } else {
+            Throw("BVH should only be used in scalar mode");
+        }
+    }
+
+    /// Return a human-readable string representation of the scene contents.
+    virtual std::string to_string() const override;
+
+    MI_DECLARE_CLASS()
+protected:
+    /**
+     * \brief Node of the wide BVH
+     *
+     * The child \c i is an inner node when <tt>count[i] == 0</tt>, in which
+     * case \c child[i] is its node index. Otherwise, it is a leaf holding
+     * the \c count[i] primitives <tt>m_indices[child[i] + j]</tt>. Unused
+     * slots have an empty bounding box, which is never intersected.
+     */
+    struct alignas(64) Node {
+        /// Bounding boxes of the children (rows: min. X/Y/Z, max. X/Y/Z)
+        ScalarFloat bounds[6][Width];
+        Index child[Width];
+        Size count[Width];
+    };
+
+    /// Node of the intermediate binary BVH
+    struct BuildNode {
+        ScalarBoundingBox3f bbox;
+        /// Index of the left child (inner node) or primitive offset (leaf)
+        Index offset;
+        /// Primitive count (zero for inner nodes)
+        Size count;
+    };
+
+    /// Helper data structure used during construction (shared by all threads)
+    struct BuildContext {
+        ThreadEnvironment env;
+        std::vector<BuildNode> nodes;
+        std::atomic<Index> node_count { 1 };
+        std::vector<ScalarBoundingBox3f> prim_bbox;
+        std::vector<ScalarPoint3f> prim_center;
+    };
+
+    /// Recursively build the binary BVH over the primitives in <tt>[begin, end)</tt>
+    void build_node(BuildContext &ctx, Index node_index, Index begin,
+                    Index end, Size depth) const;
+
+    /// Recursively convert a subtree of the binary BVH into wide nodes
+    Index collapse(const BuildContext &ctx, Index node_index,
+                   std::vector<Node> &nodes) const;
+
+    /**
+     * \brief Map a primitive index to a specific shape managed by the BVH.
+     *
+     * The function returns the shape index and updates the \a idx parameter to
+     * point to the primitive index (e.g. triangle ID) within the shape.
+     */
+    MI_INLINE Index find_shape(Index &i) const {
+        Assert(i < primitive_count());
+
+        Index shape_index = math::find_interval<Index>(
+            Size(m_primitive_map.size()),
+            [&](Index k) DRJIT_INLINE_LAMBDA {
+                return m_primitive_map[k] <= i;
+            }
+        );
+
+        i -= m_primitive_map[shape_index];
+        return shape_index;
+    }
+
+    /// Check whether a primitive is intersected by the given ray.
+    template <bool ShadowRay = false>
+    MI_INLINE PreliminaryIntersection<ScalarFloat, Shape>
+    intersect_prim(Index prim_index, const ScalarRay3f &ray) const {
+        Index shape_index  = find_shape(prim_index);
+        const Shape *shape = this->shape(shape_index);
+        const Mesh *mesh = (const Mesh *) shape;
+
+        PreliminaryIntersection<ScalarFloat, Shape> pi;
+
+        if constexpr (ShadowRay) {
+            bool hit;
+            if (shape->is_mesh())
+                hit = mesh->ray_intersect_triangle_scalar(prim_index, ray).first != dr::Infinity<ScalarFloat>;
+            else
+                hit = shape->ray_test_scalar(ray);
+            pi.t = dr::select(hit, 0.f , pi.t);
+        } else {
+            uint32_t inst_index = (uint32_t) -1;
+            if (shape->is_mesh())
+                std::tie(pi.t, pi.prim_uv) = mesh->ray_intersect_triangle_scalar(prim_index, ray);
+            else
+                std::tie(pi.t, pi.prim_uv, inst_index, prim_index) =
+                    shape->ray_intersect_preliminary_scalar(ray);
+            pi.prim_index = prim_index;
+
+            bool hit_inst  = (inst_index != (uint32_t) -1);
+            pi.shape       = hit_inst ? (const Shape *) (size_t) shape_index : shape; // shape_index for LLVM + BVH
+            pi.instance    = hit_inst ? shape : nullptr;
+            pi.shape_index = hit_inst ? inst_index : shape_index;
+        }
+
+        return pi;
+    }
+
+protected:
+    std::vector<ref<Shape>> m_shapes;
+    std::vector<Size> m_primitive_map;
+    ScalarBoundingBox3f m_bbox;
+
+    std::unique_ptr<Node[]> m_nodes;
+    std::unique_ptr<Index[]> m_indices;
+    Size m_node_count = 0;
+    Size m_index_count = 0;
+
+    Size m_max_leaf_size;
+    ScalarFloat m_traversal_cost;
+};
+
+MI_EXTERN_CLASS(ShapeBVH)
+NAMESPACE_END(mitsuba)
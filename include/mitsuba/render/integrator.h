@@ -36,7 +36,8 @@ NAMESPACE_BEGIN(mitsuba)
 template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB Integrator : public Object {
 public:
-    MI_IMPORT_TYPES(Scene, Sensor)
+    MI_IMPORT_TYPES(Scene, Sensor, Sampler, Medium, MediumPtr, BSDFPtr,
+                     PhaseFunctionContext)
 
     /**
      * \brief Render the scene
@@ -309,11 +310,104 @@ public:
      */
     virtual std::vector<std::string> aov_names() const;
 
+    /**
+     * \brief Does this integrator account for volume emitters?
+     *
+     * Volume emitters (see \ref EmitterFlags::Volume) sample points inside of
+     * emissive media, with densities per unit solid angle and distance. Only
+     * integrators that also collect the emission of media along their paths
+     * can combine them with their other sampling strategies. Scenes therefore
+     * only create volume emitters when their integrator opts in (see the \c
+     * volume_emitters parameter of \ref Scene). The default implementation
+     * returns \c false.
+     */
+    virtual bool supports_volume_emitters() const { return false; }
+
     MI_DECLARE_CLASS()
 protected:
     /// Create an integrator
     Integrator(const Properties & props);
 
+    /// Warn if \c scene contains volume emitters that this integrator ignores
+    void check_volume_emitters(const Scene *scene) const;
+
+    /**
+     * \brief Estimate the transmittance along a ray through participating
+     * media, up to its \c maxt
+     *
+     * Homogeneous media are handled in closed form, other media by residual
+     * ratio tracking against their control extinction (see \ref
+     * Medium::get_control_extinction()). Surfaces with a null BSDF along the
+     * way are passed through, all other surfaces are occluders.
+     *
+     * \param medium    Medium containing the origin of the ray
+     * \param channel   Channel used to sample collisions (see \ref
+     *                  Medium::sample_interaction())
+     * \param footprint Width of the path footprint at the ray origin
+     */
+    Spectrum eval_transmittance(const Scene *scene, Ray3f ray,
+                                MediumPtr medium, Sampler *sampler,
+                                UInt32 channel, Float footprint,
+                                Mask active) const;
+
+    /// Estimate the transmittance between an interaction and a point \c p
+    template <typename Interaction>
+    Spectrum eval_transmittance(const Scene *scene,
+                                const Interaction &ref_interaction,
+                                const Point3f &p, MediumPtr medium,
+                                Sampler *sampler, UInt32 channel,
+                                Float footprint, Mask active) const {
+        Ray3f ray = ref_interaction.spawn_ray_to(p);
+
+        // Potentially escaping the medium if this is the current medium's boundary
+        if constexpr (std::is_convertible_v<Interaction, SurfaceInteraction3f>)
+            dr::masked(medium, ref_interaction.is_medium_transition()) =
+                ref_interaction.target_medium(ray.d);
+
+        return eval_transmittance(scene, ray, medium, sampler, channel,
+                                  footprint, active);
+    }
+
+    /**
+     * \brief Sample the next collision of a light path in a medium
+     *
+     * Free-flight distances are sampled by delta tracking against the largest
+     * majorant over all channels, and collisions are classified according to
+     * the largest extinction. \c throughput is updated with the weight of the
+     * sampled event. Null collisions move the origin of \c ray (and the
+     * distance to \c si) to the collision, so that the flight resumes there.
+     *
+     * \return The medium interaction, the mask of lanes that collided inside
+     * the medium and the mask of those whose collision is a real scattering
+     * event.
+     */
+    std::tuple<MediumInteraction3f, Mask, Mask>
+    sample_light_collision(Ray3f &ray, SurfaceInteraction3f &si,
+                           MediumPtr medium, Sampler *sampler,
+                           Spectrum &throughput, Mask active) const;
+
+    /**
+     * \brief Continue a light path at a real scattering event in a medium by
+     * sampling its (self-adjoint) phase function
+     */
+    void sample_light_phase(const MediumInteraction3f &mei, Ray3f &ray,
+                            Sampler *sampler, Spectrum &throughput,
+                            Mask active) const;
+
+    /**
+     * \brief Continue a light path at a surface by sampling the adjoint BSDF
+     *
+     * Directions that would leak light through shading normals are rejected,
+     * and \c medium is updated when the path crosses a medium boundary.
+     *
+     * \return The mask of lanes that continue and the mask of those that
+     * sampled a non-null component (i.e. that count a bounce).
+     */
+    std::pair<Mask, Mask>
+    sample_light_bsdf(const SurfaceInteraction3f &si, Ray3f &ray,
+                      MediumPtr &medium, Sampler *sampler,
+                      Spectrum &throughput, Float &eta, Mask active) const;
+
     /// Virtual destructor
     virtual ~Integrator() { }
 
@@ -348,8 +442,10 @@ protected:
 template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB SamplingIntegrator : public Integrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(Integrator, should_stop, aov_names,
-                    m_stop, m_timeout, m_render_timer, m_hide_emitters)
+    MI_IMPORT_BASE(Integrator, should_stop, aov_names, check_volume_emitters,
+                    eval_transmittance, sample_light_collision,
+                    sample_light_phase, sample_light_bsdf, m_stop, m_timeout,
+                    m_render_timer, m_hide_emitters)
     MI_IMPORT_TYPES(Scene, Sensor, Film, ImageBlock, Medium, Sampler)
 
     /**
@@ -492,7 +588,9 @@ protected:
 template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB AdjointIntegrator : public Integrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(Integrator, should_stop, aov_names, m_stop, m_timeout,
+    MI_IMPORT_BASE(Integrator, should_stop, aov_names, check_volume_emitters,
+                    eval_transmittance, sample_light_collision,
+                    sample_light_phase, sample_light_bsdf, m_stop, m_timeout,
                     m_render_timer, m_hide_emitters)
     MI_IMPORT_TYPES(Scene, Sensor, Film, BSDF, BSDFPtr, ImageBlock, Sampler,
                      EmitterPtr)
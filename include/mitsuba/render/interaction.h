@@ -530,6 +530,20 @@ struct MediumInteraction : Interaction<Float_, Spectrum_> {
     /// mint used when sampling the given distance ``t``
     Float mint;
 
+    /**
+     * Width of the path footprint at ``p`` in world space units, used by
+     * media to select a level of detail. Zero requests the finest level.
+     */
+    Float footprint;
+
+    /**
+     * Parameters of a spatially varying phase function at ``p`` (e.g. the
+     * SGGX matrix), cached by the medium when sampling the interaction so
+     * that later phase function queries can skip the volume lookup. An
+     * all-zero array denotes an empty cache.
+     */
+    dr::Array<Float, 6> phase_params = 0.f;
+
     //! @}
     // =============================================================
 
@@ -552,7 +566,7 @@ struct MediumInteraction : Interaction<Float_, Spectrum_> {
 
     DRJIT_STRUCT(MediumInteraction, t, time, wavelengths, p, n, medium,
                  sh_frame, wi, sigma_s, sigma_n, sigma_t,
-                 combined_extinction, mint)
+                 combined_extinction, mint, footprint, phase_params)
 };
 
 // -----------------------------------------------------------------------------
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <unordered_set>
+#include <bitset>
 #include <atomic>
 
 #include <nanothread/nanothread.h>
 #include <mitsuba/core/bbox.h>
+#include <mitsuba/core/filesystem.h>
 #include <mitsuba/core/fwd.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/math.h>
@@ -2141,6 +2143,7 @@ public:
     using Base::set_min_max_bins;
     using Base::set_retract_bad_splits;
     using Base::set_stop_primitives;
+    using Base::set_log_level;
     using Base::bbox;
     using Base::m_bbox;
     using Base::m_nodes;
@@ -2157,9 +2160,49 @@ public:
     /// Register a new shape with the kd-tree (to be called before \ref build())
     void add_shape(Shape *shape);
 
-    /// Build the kd-tree
+    /**
+     * \brief Build the kd-tree
+     *
+     * When the parameter \c kd_cache_dir specifies a cache directory, the
+     * finished tree is stored in a file of that directory, whose name is
+     * derived from \ref geometry_hash(). Later builds over the same geometry
+     * (e.g. by other processes rendering the same scene) load this file
+     * instead of building the tree again.
+     */
     void build();
 
+    /**
+     * \brief Return a hash of the geometry of all registered shapes and of
+     * the build-related parameters
+     *
+     * Two kd-trees with the same hash are built over identical primitive
+     * bounding boxes with identical settings, and are hence identical.
+     */
+    uint64_t geometry_hash() const;
+
+    /// Are the rays of LLVM kernels traced as packets? (see \ref ray_intersect_packet())
+    bool packet_traversal() const { return m_packet_traversal; }
+
+    /**
+     * \brief Incrementally update the kd-tree after some of its shapes changed
+     *
+     * The split planes of a kd-tree cannot be refit to moving geometry.
+     * Instead, the primitives of the changed shapes are disabled in the
+     * existing tree, and a small secondary kd-tree is built over all shapes
+     * that changed since the last call to \ref build(). Ray queries traverse
+     * both trees.
+     *
+     * \param dirty
+     *     Indices of the shapes that changed since the previous update.
+     *
+     * \return \c false if the kd-tree must be rebuilt instead, i.e. when
+     *     it is not built yet, when the primitive count of a shape changed,
+     *     or when the changed shapes hold more than the fraction
+     *     \c kd_rebuild_fraction of all primitives (the traversal of the
+     *     disabled primitives then becomes too costly).
+     */
+    bool update(const std::vector<Index> &dirty);
+
     /// Return the number of registered shapes
     Size shape_count() const { return Size(m_shapes.size()); }
 
@@ -2197,6 +2240,46 @@ public:
     template <bool ShadowRay>
     MI_INLINE PreliminaryIntersection<ScalarFloat, Shape>
     ray_intersect_scalar(ScalarRay3f ray) const {
+        PreliminaryIntersection<ScalarFloat, Shape> pi =
+            ray_intersect_nodes<ShadowRay>(ray);
+
+        // Shapes that changed since the last build live in a secondary tree
+        if (unlikely(m_dynamic)) {
+            if (pi.is_valid()) {
+                if constexpr (ShadowRay)
+                    return pi;
+                ray.maxt = pi.t;
+            }
+
+            PreliminaryIntersection<ScalarFloat, Shape> dyn_pi =
+                m_dynamic->template ray_intersect_scalar<ShadowRay>(ray);
+            if (dyn_pi.is_valid()) {
+                pi = dyn_pi;
+                if constexpr (!ShadowRay)
+                    remap_dynamic(pi);
+            }
+        }
+
+        return pi;
+    }
+
+    template <bool ShadowRay>
+    MI_INLINE PreliminaryIntersection<ScalarFloat, Shape>
+    ray_intersect_nodes(const ScalarRay3f &ray) const {
+        // Intersect against the scene bounding box
+        auto bbox_result = m_bbox.ray_intersect(ray);
+
+        ScalarFloat mint = std::max(ScalarFloat(0), std::get<1>(bbox_result)),
+                    maxt = std::min(ray.maxt, std::get<2>(bbox_result));
+
+        return ray_intersect_subtree<ShadowRay>(ray, m_nodes.get(), mint, maxt);
+    }
+
+    /// Traverse the subtree below \c node over the ray segment <tt>[mint, maxt]</tt>
+    template <bool ShadowRay>
+    MI_INLINE PreliminaryIntersection<ScalarFloat, Shape>
+    ray_intersect_subtree(ScalarRay3f ray, const KDNode *node,
+                          ScalarFloat mint, ScalarFloat maxt) const {
         /// Ray traversal stack entry
         struct KDStackEntry {
             // Ray distance associated with the node entry and exit point
@@ -2212,15 +2295,8 @@ public:
         // Resulting intersection struct
         PreliminaryIntersection<ScalarFloat, Shape> pi;
 
-        // Intersect against the scene bounding box
-        auto bbox_result = m_bbox.ray_intersect(ray);
-
-        ScalarFloat mint = std::max(ScalarFloat(0), std::get<1>(bbox_result)),
-                    maxt = std::min(ray.maxt, std::get<2>(bbox_result));
-
         ScalarVector3f d_rcp = dr::rcp(ray.d);
 
-        const KDNode *node = m_nodes.get();
         while (mint <= maxt) {
             if (likely(!node->leaf())) { // Inner node
                 const ScalarFloat split = node->split();
@@ -2292,16 +2368,41 @@ public:
         return pi;
     }
 
-#if 0
-    template <bool ShadowRay>
-    MI_INLINE PreliminaryIntersection3f ray_intersect_packet(Ray3f ray,
-                                                              Mask active) const {
+    /**
+     * \brief Traverse the kd-tree with a packet of rays
+     *
+     * This routine is used by the LLVM backend, whose ray tracing callback
+     * receives rays in groups of the JIT vector width. The lanes traverse the
+     * tree together as long as they visit the same nodes. When they disagree
+     * on the order of the children of a node, the order preferred by the
+     * majority of the active lanes is used. Leaves are intersected for all
+     * active lanes at once (using packet instructions for triangles). Once
+     * rays diverge so that a single lane remains active in a subtree, that
+     * lane continues with the scalar traversal of the subtree.
+     *
+     * \return
+     *     A tuple containing \c t (infinite for lanes without intersection),
+     *     \c prim_uv, \c prim_index, \c shape_index and \c inst_index.
+     *     For hits of an instance, \c inst_index is the shape index of the
+     *     instance and \c shape_index the index of the shape within its shape
+     *     group, and \c inst_index is <tt>(uint32_t) -1</tt> otherwise.
+     *     Only \c t is valid when \c ShadowRay is \c true.
+     */
+    template <bool ShadowRay, typename FloatP,
+              typename MaskP    = dr::mask_t<FloatP>,
+              typename UInt32P  = dr::uint32_array_t<FloatP>,
+              typename Point2fP = Point<FloatP, 2>,
+              typename Ray3fP   = Ray<Point<FloatP, 3>, Spectrum>>
+    std::tuple<FloatP, Point2fP, UInt32P, UInt32P, UInt32P>
+    ray_intersect_packet(Ray3fP ray, MaskP active) const {
+        constexpr size_t N = dr::array_size_v<FloatP>;
+
         /// Ray traversal stack entry
         struct KDStackEntry {
             // Ray distance associated with the node entry and exit point
-            Float mint, maxt;
+            FloatP mint, maxt;
             // Is the corresponding SIMD lane enabled?
-            Mask active;
+            MaskP active;
             // Pointer to the far child
             const KDNode *node;
         };
@@ -2310,96 +2411,187 @@ public:
         KDStackEntry stack[MI_KD_MAXDEPTH];
         int32_t stack_index = 0;
 
-        // Resulting intersection struct
-        PreliminaryIntersection3f pi = dr::zeros<PreliminaryIntersection3f>();
+        // Resulting intersections (per lane)
+        alignas(64) ScalarFloat t[N], u[N], v[N];
+        alignas(64) uint32_t prim_index[N], shape_index[N], inst_index[N];
+        for (size_t i = 0; i < N; ++i) {
+            t[i] = dr::Infinity<ScalarFloat>;
+            u[i] = v[i] = 0.f;
+            prim_index[i] = shape_index[i] = 0;
+            inst_index[i] = (uint32_t) -1;
+        }
 
-        const KDNode *node = m_nodes.get();
+        // Bit mask of the enabled lanes of a packet mask
+        auto lanes = [](const MaskP &mask) {
+            alignas(64) ScalarFloat value[N];
+            dr::store_aligned(value, dr::select(mask, FloatP(1.f), FloatP(0.f)));
+            uint32_t bits = 0;
+            for (size_t i = 0; i < N; ++i)
+                bits |= (value[i] != 0.f ? 1u : 0u) << i;
+            return bits;
+        };
+
+        // Extract the i-th lane of a packet
+        auto lane = [](const FloatP &value, size_t i) {
+            alignas(64) ScalarFloat tmp[N];
+            dr::store_aligned(tmp, value);
+            return tmp[i];
+        };
 
-        /* Intersect against the scene bounding box */
+        // Scalar ray of the i-th lane
+        auto lane_ray = [&](size_t i) {
+            return ScalarRay3f(
+                ScalarPoint3f(lane(ray.o.x(), i), lane(ray.o.y(), i), lane(ray.o.z(), i)),
+                ScalarVector3f(lane(ray.d.x(), i), lane(ray.d.y(), i), lane(ray.d.z(), i)),
+                lane(ray.maxt, i), lane(ray.time, i), wavelength_t<Spectrum>());
+        };
+
+        // Record an intersection found by the scalar code path for lane i
+        auto record = [&](size_t i, const PreliminaryIntersection<ScalarFloat, Shape> &pi) {
+            t[i] = pi.t;
+            if constexpr (!ShadowRay) {
+                u[i] = pi.prim_uv.x();
+                v[i] = pi.prim_uv.y();
+                prim_index[i] = pi.prim_index;
+                shape_index[i] = pi.shape_index;
+                inst_index[i] = pi.instance ? (uint32_t) (size_t) pi.shape // shape_index
+                                            : (uint32_t) -1;
+            }
+        };
+
+        uint32_t active_in = lanes(active);
+
+        // Intersect against the scene bounding box
         auto bbox_result = m_bbox.ray_intersect(ray);
-        Float mint = dr::maximum(ray.mint, std::get<1>(bbox_result));
-        Float maxt = dr::minimum(ray.maxt, std::get<2>(bbox_result));
+        FloatP mint = dr::maximum(0.f, std::get<1>(bbox_result)),
+               maxt = dr::minimum(ray.maxt, std::get<2>(bbox_result));
 
-        while (true) {
-            active = active && (maxt >= mint);
-            if (ShadowRay)
-                active = active && !pi.is_valid();
+        Point<FloatP, 3> d_rcp = dr::rcp(ray.d);
 
-            if (likely(dr::any(active))) {
+        const KDNode *node = m_nodes.get();
+        while (true) {
+            active = active && (mint <= maxt);
+            if constexpr (ShadowRay)
+                active = active && !dr::isfinite(dr::load_aligned<FloatP>(t));
+
+            uint32_t active_lanes = dr::any(active) ? lanes(active) : 0u;
+
+            if (unlikely(active_lanes != 0 && (active_lanes & (active_lanes - 1)) == 0)) {
+                /* Only a single lane is left in this subtree: switch to the
+                   (cheaper) scalar traversal */
+                size_t i = 0;
+                while (!(active_lanes & (1u << i)))
+                    ++i;
+
+                PreliminaryIntersection<ScalarFloat, Shape> pi =
+                    ray_intersect_subtree<ShadowRay>(lane_ray(i), node,
+                                                     lane(mint, i), lane(maxt, i));
+                if (pi.is_valid()) {
+                    record(i, pi);
+                    ray.maxt = dr::minimum(ray.maxt, dr::load_aligned<FloatP>(t));
+                }
+            } else if (likely(active_lanes != 0)) {
                 if (likely(!node->leaf())) { // Inner node
-                    const dr::scalar_t<Float> split = node->split();
-                    const uint32_t axis = node->axis();
-
-                    // Compute parametric distance along the rays to the split plane
-                    Float t_plane          = (split - ray.o[axis]) * ray.d_rcp[axis];
-                    Mask left_first        = (ray.o[axis] < split) ||
-                                              (dr::eq(ray.o[axis], split) && ray.d[axis] >= 0.f),
-                         start_after       = t_plane < mint,
-                         end_before        = t_plane > maxt || t_plane < 0.f || !dr::isfinite(t_plane),
-                         single_node       = start_after || end_before,
-                         visit_left        = dr::eq(end_before, left_first),
-                         visit_only_left   = single_node &&  visit_left,
-                         visit_only_right  = single_node && !visit_left;
-
-                    bool all_visit_only_left  = dr::all(visit_only_left || !active),
-                         all_visit_only_right = dr::all(visit_only_right || !active),
-                         all_visit_same_node  = all_visit_only_left || all_visit_only_right;
+                    const ScalarFloat split = node->split();
+                    const uint32_t axis     = node->axis();
+
+                    /* Compute parametric distance along the rays to the split plane */
+                    FloatP t_plane = (split - ray.o[axis]) * d_rcp[axis];
+
+                    MaskP left_first  = (ray.o[axis] < split) ||
+                                        (dr::eq(ray.o[axis], split) && ray.d[axis] >= 0.f),
+                          start_after = t_plane < mint,
+                          end_before  = t_plane > maxt || t_plane < 0.f || !dr::isfinite(t_plane),
+                          single_node = start_after || end_before,
+                          visit_left  = !(end_before ^ left_first);
+
+                    bool all_visit_only_left  = dr::all((single_node &&  visit_left) || !active),
+                         all_visit_only_right = dr::all((single_node && !visit_left) || !active);
 
                     /* If we only need to visit one node, just pick the correct one and continue */
-                    if (all_visit_same_node) {
+                    if (all_visit_only_left || all_visit_only_right) {
                         node = node->left() + (all_visit_only_left ? 0 : 1);
                         continue;
                     }
 
-                    size_t left_votes  = count(left_first && active),
-                           right_votes = count(!left_first && active);
-
-                    bool go_left = left_votes >= right_votes;
+                    /* Visit both child nodes in the order preferred by most lanes */
+                    size_t left_votes  = std::bitset<32>(lanes(left_first && active)).count();
+                    bool go_left = 2 * left_votes >= std::bitset<32>(active_lanes).count();
 
-                    Mask go_left_bcast = Mask(go_left),
-                         correct_order = dr::eq(left_first, go_left_bcast),
-                         visit_both    = !single_node,
-                         visit_cur     = visit_both || eq (visit_left, go_left_bcast),
-                         visit_next    = visit_both || dr::neq(visit_left, go_left_bcast);
+                    MaskP visit_both    = !single_node,
+                          correct_order = go_left ? left_first : !left_first,
+                          visit_cur     = visit_both || (go_left ? visit_left : !visit_left),
+                          visit_next    = visit_both || (go_left ? !visit_left : visit_left);
 
-                    /* Visit both child nodes in the right order */
                     Index node_offset = go_left ? 0 : 1;
                     const KDNode *left   = node->left(),
                                  *n_cur  = left + node_offset,
                                  *n_next = left + (1 - node_offset);
 
                     /* Postpone visit to 'n_next' */
-                    Mask sel0 =  correct_order && visit_both,
-                         sel1 = !correct_order && visit_both;
-                    KDStackEntry& entry = stack[stack_index++];
-                    entry.mint = dr::select(sel0, t_plane, mint);
-                    entry.maxt = dr::select(sel1, t_plane, maxt);
+                    MaskP sel0 =  correct_order && visit_both,
+                          sel1 = !correct_order && visit_both;
+                    KDStackEntry &entry = stack[stack_index++];
+                    entry.mint   = dr::select(sel0, t_plane, mint);
+                    entry.maxt   = dr::select(sel1, t_plane, maxt);
                     entry.active = active && visit_next;
-                    entry.node = n_next;
+                    entry.node   = n_next;
 
                     /* Visit 'n_cur' now */
-                    mint = dr::select(sel1, t_plane, mint);
-                    maxt = dr::select(sel0, t_plane, maxt);
+                    mint   = dr::select(sel1, t_plane, mint);
+                    maxt   = dr::select(sel0, t_plane, maxt);
                     active = active && visit_cur;
-                    node = n_cur;
+                    node   = n_cur;
                     continue;
                 } else if (node->primitive_count() > 0) { // Arrived at a leaf node
                     Index prim_start = node->primitive_offset();
                     Index prim_end = prim_start + node->primitive_count();
                     for (Index i = prim_start; i < prim_end; i++) {
-                        Index prim_index = m_indices[i];
-
-                        PreliminaryIntersection3f prim_pi =
-                            intersect_prim<ShadowRay>(prim_index, ray, active);
-
-                        dr::masked(pi, prim_pi.is_valid()) = prim_pi;
-
-                        if constexpr (!ShadowRay) {
-                            Assert(dr::all(!prim_pi.is_valid() ||
-                                       (prim_pi.t >= ray.mint &&
-                                        prim_pi.t <= ray.maxt)));
-                            dr::masked(ray.maxt, prim_pi.is_valid()) = prim_pi.t;
+                        Index prim_index_local = m_indices[i];
+                        Index shape_idx = find_shape(prim_index_local);
+                        const Shape *shape = m_shapes[shape_idx];
+
+                        if (unlikely(m_dynamic && m_shape_outdated[shape_idx]))
+                            continue;
+
+                        if (shape->is_mesh()) {
+                            auto [prim_t, prim_uv] =
+                                ((const Mesh *) shape)->template ray_intersect_triangle_impl<FloatP>(
+                                    UInt32P(prim_index_local), ray, active);
+
+                            MaskP hit = active && dr::isfinite(prim_t) && prim_t <= ray.maxt;
+                            if (dr::none(hit))
+                                continue;
+
+                            auto update = [&](auto *ptr, const auto &value) {
+                                using T = std::decay_t<decltype(value)>;
+                                dr::store_aligned(ptr, dr::select(hit, value, dr::load_aligned<T>(ptr)));
+                            };
+                            update(t, prim_t);
+                            if constexpr (!ShadowRay) {
+                                update(u, prim_uv.x());
+                                update(v, prim_uv.y());
+                                update(prim_index, UInt32P(prim_index_local));
+                                update(shape_index, UInt32P(shape_idx));
+                                update(inst_index, UInt32P((uint32_t) -1));
+                            }
+                            ray.maxt = dr::select(hit, prim_t, ray.maxt);
+                        } else {
+                            // Other shapes only provide scalar intersection routines
+                            uint32_t bits = lanes(active);
+                            for (size_t j = 0; j < N; ++j) {
+                                if (!(bits & (1u << j)))
+                                    continue;
+                                PreliminaryIntersection<ScalarFloat, Shape> pi =
+                                    intersect_prim<ShadowRay>(m_indices[i], lane_ray(j));
+                                if (pi.is_valid())
+                                    record(j, pi);
+                            }
+                            ray.maxt = dr::minimum(ray.maxt, dr::load_aligned<FloatP>(t));
                         }
+
+                        if (ShadowRay && dr::all(dr::isfinite(dr::load_aligned<FloatP>(t)) || !active))
+                            break;
                     }
                 }
             }
@@ -2416,9 +2608,31 @@ public:
             }
         }
 
-        return pi;
+        // Shapes that changed since the last build live in a secondary tree
+        if (unlikely(m_dynamic)) {
+            for (size_t i = 0; i < N; ++i) {
+                if (!(active_in & (1u << i)) || (ShadowRay && dr::isfinite(t[i])))
+                    continue;
+
+                ScalarRay3f ray_i = lane_ray(i);
+                ray_i.maxt = std::min(ray_i.maxt, t[i]);
+
+                PreliminaryIntersection<ScalarFloat, Shape> pi =
+                    m_dynamic->template ray_intersect_scalar<ShadowRay>(ray_i);
+                if (pi.is_valid()) {
+                    if constexpr (!ShadowRay)
+                        remap_dynamic(pi);
+                    record(i, pi);
+                }
+            }
+        }
+
+        return { dr::load_aligned<FloatP>(t),
+                 Point2fP(dr::load_aligned<FloatP>(u), dr::load_aligned<FloatP>(v)),
+                 dr::load_aligned<UInt32P>(prim_index),
+                 dr::load_aligned<UInt32P>(shape_index),
+                 dr::load_aligned<UInt32P>(inst_index) };
     }
-#endif
 
     /// Brute force intersection routine for debugging purposes
     template <bool ShadowRay>
@@ -2441,6 +2655,15 @@ public:
                     break;
             }
 
+            if (m_dynamic && !(ShadowRay && pi.is_valid())) {
+                PreliminaryIntersection3f dyn_pi =
+                    m_dynamic->template ray_intersect_naive<ShadowRay>(ray, active);
+                if (dyn_pi.is_valid()) {
+                    pi = dyn_pi;
+                    remap_dynamic(pi);
+                }
+            }
+
             return pi;
         } else {
             Throw("kdtree should only be used in scalar mode");
@@ -2452,6 +2675,15 @@ public:
 
     MI_DECLARE_CLASS()
 protected:
+    /// Create an empty kd-tree with the given cost model (used by \ref update())
+    ShapeKDTree(const SurfaceAreaHeuristic3f &model);
+
+    /// Load a tree previously stored by \ref save_cache(), returns \c false on failure
+    bool load_cache(const fs::path &filename, uint64_t hash);
+
+    /// Store the finished tree in a file of the cache directory
+    void save_cache(const fs::path &filename, uint64_t hash) const;
+
     /**
      * \brief Map an abstract \ref TShapeKDTree primitive index to a specific
      * shape managed by the \ref ShapeKDTree.
@@ -2494,6 +2726,10 @@ protected:
 
         PreliminaryIntersection<ScalarFloat, Shape> pi;
 
+        // Primitives of shapes that moved to the secondary tree are outdated
+        if (unlikely(m_dynamic && m_shape_outdated[shape_index]))
+            return pi;
+
         if constexpr (ShadowRay) {
             bool hit;
             if (shape->is_mesh())
@@ -2519,9 +2755,32 @@ protected:
         return pi;
     }
 
+    /// Map the shape index of an intersection with \c m_dynamic to this tree
+    MI_INLINE void remap_dynamic(PreliminaryIntersection<ScalarFloat, Shape> &pi) const {
+        if (pi.instance)
+            pi.shape = (const Shape *) (size_t) m_dynamic_shapes[(size_t) pi.shape];
+        else
+            pi.shape_index = m_dynamic_shapes[pi.shape_index];
+    }
+
 protected:
     std::vector<ref<Shape>> m_shapes;
     std::vector<Size> m_primitive_map;
+
+    /// Fraction of outdated primitives above which \ref update() fails
+    ScalarFloat m_rebuild_fraction;
+    /// Secondary kd-tree over the shapes that changed since the last build
+    ref<ShapeKDTree> m_dynamic;
+    /// Shape indices (in this tree) of the shapes of \c m_dynamic
+    std::vector<Index> m_dynamic_shapes;
+    /// Per-shape flag: are the primitives of this tree outdated?
+    std::vector<uint8_t> m_shape_outdated;
+
+    /// Trace the rays of LLVM kernels as packets?
+    bool m_packet_traversal;
+
+    /// Directory of the on-disk cache of built trees (disabled when empty)
+    fs::path m_cache_dir;
 };
 
 MI_EXTERN_CLASS(ShapeKDTree)
@@ -3,7 +3,9 @@
 #include <mitsuba/core/object.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/traits.h>
+#include <mitsuba/core/transform.h>
 #include <mitsuba/render/fwd.h>
+#include <drjit/dynamic.h>
 #include <drjit/vcall.h>
 
 NAMESPACE_BEGIN(mitsuba)
@@ -11,7 +13,9 @@ NAMESPACE_BEGIN(mitsuba)
 template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB Medium : public Object {
 public:
-    MI_IMPORT_TYPES(PhaseFunction, Sampler, Scene, Texture);
+    MI_IMPORT_TYPES(PhaseFunction, Sampler, Scene, Texture, Volume, Emitter);
+    using FloatStorage = DynamicBuffer<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
 
     /// Intersects a ray with the medium's bounding box
     virtual std::tuple<Mask, Float, Float>
@@ -22,6 +26,22 @@ public:
     get_majorant(const MediumInteraction3f &mi,
                  Mask active = true) const = 0;
 
+    /**
+     * \brief Returns the control extinction used by residual ratio tracking
+     *
+     * The control extinction is a constant approximation of Sigma_t along
+     * the ray leaving mi, whose transmittance is evaluated analytically.
+     * Only the residual between both quantities then needs to be estimated
+     * stochastically. The estimate is unbiased for any value; it is most
+     * efficient when the control bounds Sigma_t from below. Homogeneous
+     * media return Sigma_t itself, so that their transmittance is exact.
+     *
+     * The default implementation returns zero (i.e. plain ratio tracking).
+     */
+    virtual UnpolarizedSpectrum
+    get_control_extinction(const MediumInteraction3f &mi,
+                           Mask active = true) const;
+
     /// Returns the medium coefficients Sigma_s, Sigma_n and Sigma_t evaluated
     /// at a given MediumInteraction mi
     virtual std::tuple<UnpolarizedSpectrum, UnpolarizedSpectrum,
@@ -41,14 +61,32 @@ public:
      * \param sample   A uniformly distributed random sample
      * \param channel  The channel according to which we will sample the
      * free-flight distance. This argument is only used when rendering in RGB
-     * modes.
+     * modes. \ref MaxMajorantChannel (or any value beyond the number of
+     * channels) selects the maximum of the majorant over all channels (and
+     * wavelengths) instead, which is then reported as a spectrally constant
+     * \c combined_extinction. This mode is used by spectral tracking.
+     *
+     * \param footprint Width of the path footprint at the ray origin (in
+     * world space units)
+     *
+     * \param spread   Growth of the footprint width per unit distance along
+     * the ray. The footprint at the sampled position is stored in the
+     * returned interaction and selects the level of detail of the medium.
      *
      * \return         This method returns a MediumInteraction.
      *                 The MediumInteraction will always be valid,
      *                 except if the ray missed the Medium's bounding box.
      */
     MediumInteraction3f sample_interaction(const Ray3f &ray, Float sample,
-                                           UInt32 channel, Mask active) const;
+                                           UInt32 channel, Mask active,
+                                           Float footprint = 0.f,
+                                           Float spread = 0.f) const;
+
+    /**
+     * \brief Channel index instructing \ref sample_interaction() to sample
+     * against the maximum majorant over all channels
+     */
+    static constexpr uint32_t MaxMajorantChannel = (uint32_t) -1;
 
     /**
      * \brief Compute the transmittance and PDF
@@ -70,6 +108,42 @@ public:
                            const SurfaceInteraction3f &si,
                            Mask active) const;
 
+    /**
+     * \brief Returns the radiance emitted by the medium at a given
+     * MediumInteraction mi
+     *
+     * The volumetric emission term of the RTE is obtained by multiplying the
+     * returned radiance with the absorption coefficient <tt>sigma_t -
+     * sigma_s</tt>. Media that are not emitters return zero.
+     */
+    virtual UnpolarizedSpectrum get_radiance(const MediumInteraction3f &mi,
+                                             Mask active = true) const;
+
+    /**
+     * \brief Sample a position inside the medium proportionally to its
+     * emission
+     *
+     * \param sample   A uniformly distributed 3D sample
+     *
+     * \return         The sampled world-space position and its probability
+     *                 density per unit volume. The density is zero when the
+     *                 medium is not an emitter.
+     */
+    virtual std::pair<Point3f, Float> sample_emission(const Point3f &sample,
+                                                      Mask active = true) const;
+
+    /// Evaluate the density per unit volume of \ref sample_emission() at \c p
+    virtual Float pdf_emission(const Point3f &p, Mask active = true) const;
+
+    /**
+     * \brief Estimate of the total power emitted by the medium
+     *
+     * Used to weight the medium against other light sources when the scene
+     * builds its emitter sampling distribution. Media that are not emitters
+     * return zero.
+     */
+    virtual ScalarFloat emission_power() const;
+
     /// Return the phase function of this medium
     MI_INLINE const PhaseFunction *phase_function() const {
         return m_phase_function.get();
@@ -78,6 +152,24 @@ public:
     /// Returns whether this specific medium instance uses emitter sampling
     MI_INLINE bool use_emitter_sampling() const { return m_sample_emitters; }
 
+    /// Returns whether this medium emits light
+    MI_INLINE bool is_emitter() const { return m_is_emitter; }
+
+    /**
+     * \brief Return the volume emitter through which the scene samples this
+     * medium's emission (or \c nullptr)
+     *
+     * The emitter is created and owned by the \ref Scene that references the
+     * medium.
+     */
+    MI_INLINE const Emitter *emitter() const { return m_emitter; }
+
+    /// Return the volume emitter associated with this medium (non-const version)
+    MI_INLINE Emitter *emitter() { return m_emitter; }
+
+    /// Set the volume emitter associated with this medium
+    void set_emitter(Emitter *emitter);
+
     /// Returns whether this medium is homogeneous
     MI_INLINE bool is_homogeneous() const { return m_is_homogeneous; }
 
@@ -86,6 +178,11 @@ public:
         return m_has_spectral_extinction;
     }
 
+    /// Returns whether free-flight sampling uses a local majorant supergrid
+    MI_INLINE bool has_majorant_grid() const {
+        return m_majorant_grid.size() > 0;
+    }
+
     void traverse(TraversalCallback *callback) override;
 
     /// Return a string identifier
@@ -105,9 +202,52 @@ protected:
     Medium(const Properties &props);
     virtual ~Medium();
 
+    /**
+     * \brief (Re-)build the local majorant supergrid from a volume
+     *
+     * Each cell of the supergrid covers \c factor^3 voxels of \c volume and
+     * stores a conservative bound of <tt>scale * volume</tt> over that region.
+     * A coarser occupancy bitmask with one bit per block of
+     * <tt>2^MajorantBlockShift</tt> cells along each axis marks the blocks
+     * containing a nonzero majorant. A factor of zero releases the supergrid, in which case free-flight
+     * sampling falls back to the global majorant returned by \ref get_majorant().
+     */
+    void update_majorant_grid(const Volume *volume, ScalarFloat scale,
+                              uint32_t factor);
+
+    /// Look up the local majorant of the supergrid cell containing \c p
+    Float eval_majorant_grid(const Point3f &p, Mask active) const;
+
+    /**
+     * \brief Sample a free-flight distance by walking the majorant supergrid
+     * with a 3D-DDA
+     *
+     * The traversal accumulates the majorant optical depth cell by cell until
+     * it exceeds \c tau. Empty blocks of the occupancy bitmask are skipped in
+     * a single step. Returns the sampled distance (infinity if the ray
+     * left the interval <tt>[mint, maxt]</tt>) and the local majorant.
+     */
+    std::pair<Float, Float> sample_majorant_grid(const Ray3f &ray, Float mint,
+                                                 Float maxt, Float tau,
+                                                 Mask active) const;
+
 protected:
     ref<PhaseFunction> m_phase_function;
     bool m_sample_emitters, m_is_homogeneous, m_has_spectral_extinction;
+    bool m_is_emitter;
+
+    /// Volume emitter wrapping this medium (not owned, set by the scene)
+    Emitter *m_emitter = nullptr;
+
+    /// Local majorant supergrid (empty when disabled)
+    FloatStorage m_majorant_grid;
+    ScalarVector3i m_majorant_resolution;
+    ScalarTransform4f m_majorant_to_local;
+
+    /// Occupancy bitmask over blocks of supergrid cells
+    static constexpr int MajorantBlockShift = 2;
+    UInt32Storage m_majorant_occupancy;
+    ScalarVector3i m_majorant_block_resolution;
 
     /// Identifier (if available)
     std::string m_id;
@@ -125,11 +265,17 @@ DRJIT_VCALL_TEMPLATE_BEGIN(mitsuba::Medium)
     DRJIT_VCALL_GETTER(use_emitter_sampling, bool)
     DRJIT_VCALL_GETTER(is_homogeneous, bool)
     DRJIT_VCALL_GETTER(has_spectral_extinction, bool)
+    DRJIT_VCALL_GETTER(is_emitter, bool)
+    DRJIT_VCALL_GETTER(emitter, const typename Class::Emitter *)
     DRJIT_VCALL_METHOD(get_majorant)
+    DRJIT_VCALL_METHOD(get_control_extinction)
     DRJIT_VCALL_METHOD(intersect_aabb)
     DRJIT_VCALL_METHOD(sample_interaction)
     DRJIT_VCALL_METHOD(transmittance_eval_pdf)
     DRJIT_VCALL_METHOD(get_scattering_coefficients)
+    DRJIT_VCALL_METHOD(get_radiance)
+    DRJIT_VCALL_METHOD(sample_emission)
+    DRJIT_VCALL_METHOD(pdf_emission)
 DRJIT_VCALL_TEMPLATE_END(mitsuba::Medium)
 
 //! @}
@@ -293,11 +293,13 @@ public:
         Point3T p0, p1, p2;
 #if defined(MI_ENABLE_LLVM) && !defined(MI_ENABLE_EMBREE)
         // Ensure we don't rely on drjit-core when called from an LLVM kernel
-        if constexpr (!dr::is_array_v<T> && dr::is_llvm_v<Float>) {
+        // (scalar or packet queries of the kd-tree)
+        if constexpr (!dr::is_jit_v<T> && dr::is_llvm_v<Float>) {
+            using InputPoint3T = Point<dr::replace_scalar_t<T, InputFloat>, 3>;
             fi = dr::gather<Faces>(m_faces_ptr, index, active);
-            p0 = dr::gather<InputPoint3f>(m_vertex_positions_ptr, fi[0], active),
-            p1 = dr::gather<InputPoint3f>(m_vertex_positions_ptr, fi[1], active),
-            p2 = dr::gather<InputPoint3f>(m_vertex_positions_ptr, fi[2], active);
+            p0 = dr::gather<InputPoint3T>(m_vertex_positions_ptr, fi[0], active),
+            p1 = dr::gather<InputPoint3T>(m_vertex_positions_ptr, fi[1], active),
+            p2 = dr::gather<InputPoint3T>(m_vertex_positions_ptr, fi[2], active);
         } else
 #endif
         {
@@ -567,7 +569,7 @@ protected:
 
     /* Surface area distribution -- generated on demand when \ref
        prepare_area_pmf() is first called. */
-    DiscreteDistribution<Float> m_area_pmf;
+    AliasDistribution<Float> m_area_pmf;
     std::mutex m_mutex;
 
     /// Optional: used in eval_parameterization()
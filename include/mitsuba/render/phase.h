@@ -181,6 +181,26 @@ public:
     /// Return the maximum projected area of the microflake distribution
     virtual Float max_projected_area() const { return 1.f; }
 
+    /**
+     * \brief Evaluates the spatially varying parameters of the phase function
+     *
+     * Media store the result in <tt>mi.phase_params</tt> when sampling an
+     * interaction, so that \ref projected_area(), \ref eval_pdf() and
+     * \ref sample() can reuse it instead of repeating the volume lookup at
+     * the same position. Phase functions without spatially varying
+     * parameters return an all-zero array, which denotes an empty cache.
+     *
+     * \param mi
+     *     A medium interaction data structure describing the underlying
+     *     medium position.
+     *
+     * \return The parameters at position <tt>mi.p</tt>
+     */
+    virtual dr::Array<Float, 6> eval_params(const MediumInteraction3f & /* mi */,
+                                            Mask /* active */ = true) const {
+        return 0.f;
+    }
+
     /// Flags for this phase function.
     uint32_t flags(Mask /*active*/ = true) const { return m_flags; }
 
@@ -253,6 +273,7 @@ DRJIT_VCALL_TEMPLATE_BEGIN(mitsuba::PhaseFunction)
     DRJIT_VCALL_METHOD(eval_pdf)
     DRJIT_VCALL_METHOD(projected_area)
     DRJIT_VCALL_METHOD(max_projected_area)
+    DRJIT_VCALL_METHOD(eval_params)
     DRJIT_VCALL_GETTER(flags, uint32_t)
     DRJIT_VCALL_GETTER(component_count, size_t)
 DRJIT_VCALL_TEMPLATE_END(mitsuba::PhaseFunction)
@@ -32,6 +32,11 @@ NAMESPACE_BEGIN(mitsuba)
  *        direct radiance from emitters received at a given scene location
  *        (see \ref sample_emitter_direction()).</li>
  * </ul>
+ *
+ * The emission of participating media is exposed to emitter sampling through
+ * volume emitters when the boolean parameter \c volume_emitters is set. It
+ * defaults to \c true when the scene's integrator supports them (see \ref
+ * Integrator::supports_volume_emitters()).
  */
 template <typename Float, typename Spectrum>
 class MI_EXPORT_LIB Scene : public Object {
@@ -145,6 +150,40 @@ public:
                                        Mask coherent,
                                        Mask active = true) const;
 
+    /**
+     * \brief Intersect incoherent rays after reordering them for coherence
+     *
+     * This function is equivalent to \ref ray_intersect(), but it first
+     * sorts the active rays by the cell containing their origin (in a regular
+     * grid over the scene's bounding box) and by the octant of their
+     * direction using a parallel radix sort. The rays are intersected in this
+     * order, and the results are permuted back before the surface
+     * interactions are computed. On large scenes, this considerably improves
+     * the memory access patterns of the ray tracing backend for incoherent
+     * rays, e.g. after a bounce in a wavefront-style renderer.
+     *
+     * Active rays only trade places with other active rays, so that this
+     * function can be used within a Dr.Jit loop in wavefront mode. Sorting
+     * requires evaluating the rays and is only performed in <tt>llvm_*</tt>
+     * variants when no loop or virtual function call is being recorded.
+     * Otherwise, this function simply calls \ref ray_intersect().
+     *
+     * \param ray
+     *    A 3D ray including maximum extent (\ref Ray::maxt) and time (\ref
+     *    Ray::time) information, which matters when the shapes are in motion
+     *
+     * \param ray_flags
+     *    An integer combining flag bits from \ref RayFlags (merged using
+     *    binary or).
+     *
+     * \return
+     *    A detailed surface interaction record. Its <tt>is_valid()</tt> method
+     *    should be queried to check if an intersection was actually found.
+     */
+    SurfaceInteraction3f ray_intersect_sorted(const Ray3f &ray,
+                                              uint32_t ray_flags = +RayFlags::All,
+                                              Mask active = true) const;
+
     /**
      * \brief Intersect a ray with the shapes comprising the scene and return a
      * boolean specifying whether or not an intersection was found.
@@ -553,6 +592,12 @@ public:
      */
     bool shapes_grad_enabled() const { return m_shapes_grad_enabled; };
 
+    /**
+     * \brief Specifies whether any shape, sensor or emitter of the scene
+     * references a participating medium
+     */
+    bool has_media() const { return m_has_media; }
+
     /// Return a human-readable string representation of the scene contents.
     virtual std::string to_string() const override;
 
@@ -603,6 +648,7 @@ protected:
     MI_INLINE Mask ray_test_gpu(const Ray3f &ray, Mask active) const;
 
     using ShapeKDTree = mitsuba::ShapeKDTree<Float, Spectrum>;
+    using ShapeBVH = mitsuba::ShapeBVH<Float, Spectrum>;
 
     /// Updates the discrete distribution used to select an emitter
     void update_emitter_sampling_distribution();
@@ -633,13 +679,14 @@ protected:
     ref<Emitter> m_environment;
 
     ScalarFloat m_emitter_pmf;
-    std::unique_ptr<DiscreteDistribution<Float>> m_emitter_distr = nullptr;
+    std::unique_ptr<AliasDistribution<Float>> m_emitter_distr = nullptr;
 
     std::vector<ref<Shape>> m_silhouette_shapes;
     DynamicBuffer<ShapePtr> m_silhouette_shapes_dr;
     std::unique_ptr<DiscreteDistribution<Float>> m_silhouette_distr = nullptr;
 
     bool m_shapes_grad_enabled;
+    bool m_has_media;
 };
 
 /// Dummy function which can be called to ensure that the librender shared library is loaded
@@ -6,6 +6,7 @@
 #include <mitsuba/render/interaction.h>
 #include <mitsuba/render/shape.h>
 #include <mitsuba/render/texture.h>
+#include <drjit/texture.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -49,9 +50,29 @@ public:
     virtual std::pair<UnpolarizedSpectrum, Vector3f> eval_gradient(const Interaction3f &it,
                                                                    Mask active = true) const;
 
+    /**
+     * \brief Evaluate the volume filtered over a footprint of the given
+     * width (in world space units), with color processing
+     *
+     * Volumes with a level-of-detail representation use it to select a
+     * prefiltered version of their data. The default implementation ignores
+     * the footprint and calls \ref eval().
+     */
+    virtual UnpolarizedSpectrum eval_filtered(const Interaction3f &it,
+                                              Float width,
+                                              Mask active = true) const;
+
     /// Returns the maximum value of the volume over all dimensions.
     virtual ScalarFloat max() const;
 
+    /**
+     * \brief Returns a lower bound of the volume over all dimensions.
+     *
+     * The default implementation returns zero, which is a valid bound for
+     * the non-negative quantities (e.g. densities) that volumes usually store.
+     */
+    virtual ScalarFloat min() const;
+
     /**
      * \brief In the case of a multi-channel volume, this function returns
      * the maximum value for each channel.
@@ -60,9 +81,63 @@ public:
      */
     virtual void max_per_channel(ScalarFloat *out) const;
 
+    /**
+     * \brief Computes a grid of local majorants (upper bounds) of the volume
+     *
+     * The volume's local <tt>[0, 1]^3</tt> domain is split into a regular
+     * grid of the given resolution, and each cell receives a conservative
+     * upper bound of the values that \ref eval() can return inside it. The
+     * output is ordered so that <tt>out[(z * res.y() + y) * res.x() + x]</tt>
+     * refers to cell <tt>(x, y, z)</tt>.
+     *
+     * The default implementation fills every cell with \ref max().
+     * Pointer allocation/deallocation must be performed by the caller.
+     */
+    virtual void local_majorants(const ScalarVector3i &resolution,
+                                 ScalarFloat *out) const;
+
+    /**
+     * \brief Returns a bounding box of the region in which the volume can
+     * evaluate to nonzero values
+     *
+     * The bounding box is expressed in the local <tt>[0, 1]^3</tt>
+     * coordinates of the volume (see \ref to_local()). Media use it to clip
+     * rays to the occupied part of a sparse volume. The default
+     * implementation returns the unit cube.
+     */
+    virtual ScalarBoundingBox3f occupied_bbox() const;
+
+    /**
+     * \brief Returns the edge length (in voxels) of the blocks in which the
+     * volume tracks empty space, or zero if it has no empty blocks
+     *
+     * Media use it as the resolution factor of their majorant supergrid, so
+     * that free-flight sampling skips the empty blocks. The default
+     * implementation returns zero.
+     */
+    virtual uint32_t empty_space_block_size() const;
+
+    /**
+     * \brief Returns the voxel data of a grid-based volume
+     *
+     * When lookups interpolate a tensor of shape <tt>(Z, Y, X, C)</tt> over
+     * the local <tt>[0, 1]^3</tt> domain of the volume, this function returns
+     * it and sets the filter and wrap modes used to interpolate it, as well
+     * as whether lookups use hardware-accelerated textures. Media use it to
+     * pack several volumes into a single texture. The default implementation
+     * returns \c nullptr, which is also the right answer for data that is
+     * transformed during lookups (e.g. spectral upsampling).
+     */
+    virtual const TensorXf *voxel_data(dr::FilterMode &filter_mode,
+                                       dr::WrapMode &wrap_mode,
+                                       bool &accel) const;
+
     /// Returns the bounding box of the volume
     ScalarBoundingBox3f bbox() const { return m_bbox; }
 
+    /// Returns the transformation from world space to local volume coordinates
+    ScalarTransform4f to_local() const { return m_to_local; }
+
     /**
      * \brief Returns the resolution of the volume, assuming that it is based
      * on a discrete representation.
@@ -3,6 +3,7 @@
 #include <drjit/tensor.h>
 
 #include <mitsuba/core/bbox.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/transform.h>
@@ -34,8 +35,16 @@ public:
      *
      * \param path
      *    Name of the file to be loaded
+     *
+     * \param use_mmap
+     *    When set to \c true (the default), the file is mapped into memory
+     *    and the grid refers to its payload directly instead of copying it.
+     *    This is only possible when the voxel values are stored with the
+     *    same representation as \c ScalarFloat (i.e., single precision on a
+     *    little endian machine); the loader silently falls back to reading
+     *    the file otherwise.
      */
-    VolumeGrid(const fs::path &path);
+    VolumeGrid(const fs::path &path, bool use_mmap = true);
 
     /**
      * \brief Load a VolumeGrid from an arbitrary stream data source
@@ -47,11 +56,20 @@ public:
 
     VolumeGrid(ScalarVector3u size, ScalarUInt32 channel_count);
 
-    /// Return a pointer to the underlying volume storage
-    ScalarFloat *data() { return m_data.get(); }
+    /**
+     * \brief Return a pointer to the underlying volume storage
+     *
+     * Memory-mapped files are read-only: if the grid refers to such a
+     * mapping, its contents are first copied into memory owned by the grid.
+     * Use the \c const overload to access the data without this copy.
+     */
+    ScalarFloat *data();
 
     /// Return a pointer to the underlying volume storage
-    const ScalarFloat *data() const { return m_data.get(); }
+    const ScalarFloat *data() const { return m_data_ptr; }
+
+    /// Does the grid refer to the payload of a memory-mapped file?
+    bool is_mapped() const { return m_mmap != nullptr; }
 
     /// Return the resolution of the voxel grid
     ScalarVector3u size() const { return m_size; }
@@ -72,6 +90,15 @@ public:
     /// Set the precomputed maximum over the volume grid
     void set_max(ScalarFloat max) { m_max = max; }
 
+    /**
+     * \brief Recompute the maximum over the volume grid (overall and per
+     * channel) from its current contents
+     *
+     * The voxels are processed in parallel blocks, which makes this cheap
+     * enough to be called after loading or modifying large grids.
+     */
+    void update_max();
+
     /**
      * \brief Set the precomputed maximum over the volume grid per channel
      *
@@ -112,8 +139,16 @@ public:
 protected:
     void read(Stream *stream);
 
+    /// Parse the header of a volume file and return the payload size in values
+    size_t read_header(Stream *stream);
+
 protected:
+    /// Voxel storage owned by the grid (unused when the file is mapped)
     std::unique_ptr<ScalarFloat[]> m_data;
+    /// Memory mapping of the volume file, if any
+    ref<MemoryMappedFile> m_mmap;
+    /// Points to the voxel values, either in \c m_data or in \c m_mmap
+    const ScalarFloat *m_data_ptr = nullptr;
 
     ScalarVector3u m_size;
     ScalarUInt32 m_channel_count;
@@ -268,3 +268,56 @@ def test18_irrcont_simple_function(variants_vec_backends_once):
                 0.48734, 0.654313, 0.786607, 0.899653, 1.])
          * d.normalization())
     )
+
+
+def test19_alias_invalid(variants_all_backends_once):
+    # Test that invalid alias distributions throw
+    with pytest.raises(RuntimeError) as excinfo:
+        mi.AliasDistribution([])
+    assert 'empty distribution' in str(excinfo.value)
+
+    with pytest.raises(RuntimeError) as excinfo:
+        mi.AliasDistribution([0, 0, 0])
+    assert 'no probability mass found' in str(excinfo.value)
+
+    with pytest.raises(RuntimeError) as excinfo:
+        mi.AliasDistribution([1, -1, 1])
+    assert 'entries must be non-negative' in str(excinfo.value)
+
+
+def test20_alias_sample(variants_vec_backends_once):
+    # Validate alias table sampling against hand-computed reference
+    x = mi.AliasDistribution([1, 3, 2])
+    assert len(x) == 3
+    assert x.sum() == 6
+    assert dr.allclose(x.normalization(), 1.0 / 6.0)
+    assert dr.allclose(x.eval_pmf_normalized([1, 2, 0]), mi.Float([3, 2, 1]) / 6.0)
+
+    # Entries 0 and 2 are half full and borrow from entries 2 and 1
+    assert dr.allclose(
+        x.sample_reuse_pmf([0.1, 0.25, 0.5, 0.9]),
+        ([0, 2, 1, 1], mi.Float([.6, .5, .5, .4]), mi.Float([1, 2, 3, 3]) / 6)
+    )
+
+    # Out of range samples are clamped
+    assert x.sample([-1, 2]) == [0, 1]
+
+
+def test21_alias_bruteforce(variants_vec_backends_once):
+    # The sampled frequencies match the PMF, and zero-valued entries are never chosen
+    rng = mi.PCG32(initseq=dr.arange(mi.UInt64, 50))
+
+    n = 100000
+    for size in range(2, 20, 5):
+        density = mi.Float(rng.next_uint32_bounded(4)[0:size])
+        if dr.sum(density)[0] == 0:
+            continue
+        x = mi.AliasDistribution(density)
+
+        index, sample, pmf = x.sample_reuse_pmf(dr.linspace(mi.Float, 0, 1, n, False))
+        assert dr.allclose(pmf, x.eval_pmf_normalized(index))
+        assert dr.all((sample >= 0) & (sample < 1))
+
+        hist = dr.zeros(mi.Float, size)
+        dr.scatter_reduce(dr.ReduceOp.Add, hist, 1.0 / n, index)
+        assert dr.allclose(hist, density / dr.sum(density), atol=1e-3)
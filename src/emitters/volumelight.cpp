@@ -0,0 +1,236 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/random.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/warp.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/medium.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _emitter-volumelight:
+
+Volume emitter (:monosp:`volumelight`)
+--------------------------------------
+
+.. pluginparameters::
+
+ * - medium
+   - |medium|
+   - The emissive medium whose emission this emitter samples (e.g. a
+     :ref:`heterogeneous <medium-heterogeneous>` medium with a ``radiance``
+     volume).
+
+ * - sampling_weight
+   - |float|
+   - Weight of this emitter in the scene's emitter sampling distribution.
+     (Default: estimate of the total power emitted by the medium)
+
+This plugin exposes the volumetric emission of a participating medium as a
+regular light source, so that next event estimation at any surface or medium
+vertex of the scene can sample it. Positions are drawn from the medium's
+emission distribution (see ``Medium::sample_emission()``); the resulting
+direction sample densities are expressed with respect to the product of
+solid angle and distance along the ray, which is the measure in which
+free-flight sampling reaches the same point.
+
+The scene creates one such emitter for every emissive medium it references,
+hence there is usually no need to instantiate this plugin manually. By
+default, its sampling weight is proportional to the power emitted by the
+medium. Since surface emitters default to a unit weight, their
+``sampling_weight`` should be set to their power as well when a fully
+power-proportional emitter distribution is desired.
+
+ */
+
+template <typename Float, typename Spectrum>
+class VolumeLight final : public Emitter<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Emitter, m_flags, m_medium, m_sampling_weight)
+    MI_IMPORT_TYPES(Medium)
+
+    VolumeLight(const Properties &props) : Base(props) {
+        if (!m_medium || !m_medium->is_emitter())
+            Throw("A volume emitter requires an emissive medium!");
+
+        m_power_weighted = !props.has_property("sampling_weight");
+        if (m_power_weighted)
+            m_sampling_weight = m_medium->emission_power();
+
+        m_flags = +EmitterFlags::Volume;
+        dr::set_attr(this, "flags", m_flags);
+    }
+
+    void parameters_changed(const std::vector<std::string> &keys = {}) override {
+        // Follow the emitted power of the medium, e.g. after its radiance changed
+        if (m_power_weighted)
+            m_sampling_weight = m_medium->emission_power();
+        Base::parameters_changed(keys);
+    }
+
+    Spectrum eval(const SurfaceInteraction3f &, Mask) const override {
+        // Volume emitters cannot be intersected by rays
+        return 0.f;
+    }
+
+    std::pair<Ray3f, Spectrum> sample_ray(Float time, Float wavelength_sample,
+                                          const Point2f &sample2,
+                                          const Point2f &sample3,
+                                          Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointSampleRay, active);
+
+        // 1. Sample spatial component
+        auto [ps, pos_weight] = sample_position(time, sample2, active);
+
+        // 2. Sample directional component (isotropic emission)
+        Vector3f d = warp::square_to_uniform_sphere(sample3);
+
+        // 3. Sample spectral component
+        auto [wavelengths, wav_weight] =
+            sample_wavelength<Float, Spectrum>(wavelength_sample);
+
+        UnpolarizedSpectrum emission =
+            eval_emission(ps.p, -d, time, wavelengths, active);
+
+        // Note: 1 / warp::square_to_uniform_sphere_pdf() == 4 pi
+        UnpolarizedSpectrum weight = emission * unpolarized_spectrum(wav_weight) *
+                                     pos_weight * (4.f * dr::Pi<ScalarFloat>);
+
+        return { Ray3f(ps.p, d, time, wavelengths),
+                 depolarizer<Spectrum>(weight) & active };
+    }
+
+    std::pair<DirectionSample3f, Spectrum>
+    sample_direction(const Interaction3f &it, const Point2f &sample,
+                     Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointSampleDirection, active);
+
+        auto [p, pdf] = m_medium->sample_emission(sample_3d(sample), active);
+
+        DirectionSample3f ds = dr::zeros<DirectionSample3f>();
+        ds.p = p;
+        ds.d = p - it.p;
+        ds.time = it.time;
+        ds.delta = false;
+        ds.emitter = this;
+
+        Float dist_squared = dr::squared_norm(ds.d);
+        ds.dist = dr::sqrt(dist_squared);
+        ds.d /= ds.dist;
+
+        active &= (pdf > 0.f) && (dist_squared > 0.f);
+        ds.pdf = dr::select(active, pdf * dist_squared, 0.f);
+
+        UnpolarizedSpectrum spec =
+            eval_emission(p, -ds.d, it.time, it.wavelengths, active) / ds.pdf;
+
+        return { ds, depolarizer<Spectrum>(spec) & active };
+    }
+
+    Float pdf_direction(const Interaction3f &it, const DirectionSample3f &ds,
+                        Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointEvaluate, active);
+        return m_medium->pdf_emission(ds.p, active) *
+               dr::squared_norm(ds.p - it.p);
+    }
+
+    Spectrum eval_direction(const Interaction3f &it,
+                            const DirectionSample3f &ds,
+                            Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointEvaluate, active);
+        return depolarizer<Spectrum>(
+            eval_emission(ds.p, -ds.d, it.time, it.wavelengths, active));
+    }
+
+    std::pair<PositionSample3f, Float>
+    sample_position(Float time, const Point2f &sample,
+                    Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointSamplePosition, active);
+
+        auto [p, pdf] = m_medium->sample_emission(sample_3d(sample), active);
+
+        PositionSample3f ps = dr::zeros<PositionSample3f>();
+        ps.p     = p;
+        ps.pdf   = pdf;
+        ps.time  = time;
+        ps.delta = false;
+
+        Float weight = dr::select(active && pdf > 0.f, dr::rcp(pdf), Float(0.f));
+        return { ps, weight };
+    }
+
+    Float pdf_position(const PositionSample3f &ps,
+                       Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::EndpointEvaluate, active);
+        return m_medium->pdf_emission(ps.p, active);
+    }
+
+    std::pair<Wavelength, Spectrum>
+    sample_wavelengths(const SurfaceInteraction3f &si, Float sample,
+                       Mask active) const override {
+        auto [wavelengths, weight] = sample_wavelength<Float, Spectrum>(sample);
+        UnpolarizedSpectrum emission =
+            eval_emission(si.p, si.wi, si.time, wavelengths, active);
+        return { wavelengths,
+                 depolarizer<Spectrum>(emission * unpolarized_spectrum(weight)) };
+    }
+
+    /// Volume emitters do not contribute to the scene's bounding box
+    ScalarBoundingBox3f bbox() const override { return ScalarBoundingBox3f(); }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "VolumeLight[" << std::endl
+            << "  sampling_weight = " << m_sampling_weight << "," << std::endl
+            << "  medium = " << string::indent(m_medium) << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /**
+     * \brief Extend a 2D sample to the three dimensions needed to pick a
+     * position inside the medium
+     *
+     * The emitter interfaces only provide 2D samples. The third dimension is
+     * obtained by hashing the bit patterns of the first two, which keeps it
+     * uniformly distributed and decorrelated from them.
+     */
+    Point3f sample_3d(const Point2f &sample) const {
+        using Float32 = dr::float32_array_t<Float>;
+        Float sample_z = Float(sample_tea_float32(
+            dr::reinterpret_array<UInt32>(Float32(sample.x())),
+            dr::reinterpret_array<UInt32>(Float32(sample.y()))));
+        return Point3f(sample.x(), sample.y(), sample_z);
+    }
+
+    /// Emission term <tt>sigma_a * radiance</tt> of the medium at \c p
+    UnpolarizedSpectrum eval_emission(const Point3f &p, const Vector3f &wi,
+                                      const Float &time,
+                                      const Wavelength &wavelengths,
+                                      Mask active) const {
+        MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
+        mei.p           = p;
+        mei.wi          = wi;
+        mei.sh_frame    = Frame3f(mei.wi);
+        mei.time        = time;
+        mei.wavelengths = wavelengths;
+        mei.medium      = m_medium.get();
+
+        auto [sigma_s, sigma_n, sigma_t] =
+            m_medium->get_scattering_coefficients(mei, active);
+        DRJIT_MARK_USED(sigma_n);
+        return dr::select(active,
+                          (sigma_t - sigma_s) * m_medium->get_radiance(mei, active),
+                          0.f);
+    }
+
+    /// Whether the sampling weight tracks the emitted power of the medium
+    bool m_power_weighted;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(VolumeLight, Emitter)
+MI_EXPORT_PLUGIN(VolumeLight, "Volume emitter")
+NAMESPACE_END(mitsuba)
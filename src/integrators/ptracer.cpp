@@ -3,6 +3,8 @@
 #include <mitsuba/render/integrator.h>
 #include <mitsuba/render/bsdf.h>
 #include <mitsuba/render/emitter.h>
+#include <mitsuba/render/medium.h>
+#include <mitsuba/render/phase.h>
 #include <mitsuba/render/records.h>
 #include <mitsuba/render/sampler.h>
 
@@ -39,7 +41,15 @@ Particle tracer (:monosp:`ptracer`)
 
 This integrator traces rays starting from light sources and attempts to connect them
 to the sensor at each bounce.
-It does not support media (volumes).
+
+Participating media are supported: particles sample free-flight distances
+using delta tracking, scatter according to the phase function of the medium
+and attempt to connect every real scattering event to the sensor. Sensor
+connections account for the transmittance of the media along the way (ratio
+tracking) and pass through surfaces with a ``null`` BSDF. Particles start in
+the medium of the emitter they were sampled from, and emissive media (see
+:ref:`volumelight <emitter-volumelight>`) emit particles directly from their
+emitting voxels.
 
 Usually, this is a relatively useless rendering technique due to its high variance, but there
 are some cases where it excels. In particular, it does a good job on scenes where most scattering
@@ -67,10 +77,12 @@ useful in wavefront mode.
 template <typename Float, typename Spectrum>
 class ParticleTracerIntegrator final : public AdjointIntegrator<Float, Spectrum> {
 public:
-    MI_IMPORT_BASE(AdjointIntegrator, m_samples_per_pass, m_hide_emitters,
-                    m_rr_depth, m_max_depth)
+    MI_IMPORT_BASE(AdjointIntegrator, eval_transmittance, sample_light_collision,
+                    sample_light_phase, sample_light_bsdf, m_samples_per_pass,
+                    m_hide_emitters, m_rr_depth, m_max_depth)
     MI_IMPORT_TYPES(Scene, Sensor, Film, Sampler, ImageBlock, Emitter,
-                     EmitterPtr, BSDF, BSDFPtr)
+                     EmitterPtr, BSDF, BSDFPtr, Medium, MediumPtr,
+                     PhaseFunctionContext)
 
     ParticleTracerIntegrator(const Properties &props) : Base(props) { }
 
@@ -81,12 +93,12 @@ public:
             sample_visible_emitters(scene, sensor, sampler, block, sample_scale);
 
         // Primary & further bounces illumination
-        auto [ray, throughput] = prepare_ray(scene, sensor, sampler);
+        auto [ray, throughput, medium] = prepare_ray(scene, sensor, sampler);
 
         Float throughput_max = dr::max(unpolarized_spectrum(throughput));
         Mask active = dr::neq(throughput_max, 0.f);
 
-        trace_light_ray(ray, scene, sensor, sampler, throughput, block,
+        trace_light_ray(ray, scene, sensor, sampler, throughput, medium, block,
                         sample_scale, active);
     }
 
@@ -112,6 +124,11 @@ public:
         // Don't connect delta emitters with sensor (both position and direction)
         Mask active = !has_flag(emitter->flags(), EmitterFlags::Delta);
 
+        // Medium surrounding the emitter (or containing it, for volume emitters)
+        MediumPtr medium = nullptr;
+        if (scene->has_media())
+            medium = emitter->medium();
+
         // 3. Emitter position sampling
         Spectrum emitter_weight = dr::zeros<Spectrum>();
         SurfaceInteraction3f si = dr::zeros<SurfaceInteraction3f>();
@@ -166,13 +183,33 @@ public:
         Spectrum weight = emitter_idx_weight * emitter_weight * wav_weight * sensor_weight;
 
         // No BSDF passed (should not evaluate it since there's no scattering)
-        connect_sensor(scene, si, sensor_ds, nullptr, weight, block, sample_scale, active);
+        Mask is_volume = has_flag(emitter->flags(), EmitterFlags::Volume);
+        connect_sensor(scene, si, sensor_ds, nullptr, weight, medium, sampler,
+                       block, sample_scale, active && !is_volume);
+
+        // Volume emitters radiate isotropically from within their medium
+        Mask active_v = active && is_volume;
+        if (scene->has_media() && dr::any_or<true>(active_v)) {
+            MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
+            mei.p           = si.p;
+            mei.wi          = si.wi;
+            mei.sh_frame    = Frame3f(mei.wi);
+            mei.time        = si.time;
+            mei.wavelengths = si.wavelengths;
+            mei.medium      = medium;
+            connect_sensor_medium(scene, mei, sensor_ds, weight, false, sampler,
+                                  block, sample_scale, active_v);
+        }
     }
 
-    /// Samples a ray from a random emitter in the scene.
-    std::pair<Ray3f, Spectrum> prepare_ray(const Scene *scene,
-                                           const Sensor *sensor,
-                                           Sampler *sampler) const {
+    /**
+     * Samples a ray from a random emitter in the scene.
+     *
+     * \return The ray, its weight and the medium in which it starts.
+     */
+    std::tuple<Ray3f, Spectrum, MediumPtr> prepare_ray(const Scene *scene,
+                                                       const Sensor *sensor,
+                                                       Sampler *sampler) const {
         Float time = sensor->shutter_open();
         if (sensor->shutter_open_time() > 0)
             time += sampler->next_1d() * sensor->shutter_open_time();
@@ -186,15 +223,23 @@ public:
         auto [ray, ray_weight, emitter] = scene->sample_emitter_ray(
             time, wavelength_sample, direction_sample, position_sample);
 
-        return { ray, ray_weight };
+        MediumPtr medium = nullptr;
+        if (scene->has_media() && !scene->emitters().empty())
+            medium = emitter->medium();
+
+        return { ray, ray_weight, medium };
     }
 
     /**
      * Intersects the given ray with the scene and recursively trace using
-     * BSDF sampling. The given `throughput` should account for emitted
-     * radiance from the sampled light source, wavelengths sampling weights,
-     * etc. At each interaction, we attempt to connect to the sensor and add
-     * the current radiance to the given `block`.
+     * BSDF and phase function sampling. The given `throughput` should account
+     * for emitted radiance from the sampled light source, wavelengths sampling
+     * weights, etc. At each interaction, we attempt to connect to the sensor
+     * and add the current radiance to the given `block`.
+     *
+     * The ray starts in the given `medium` (which may be \c nullptr), where
+     * free-flight distances are sampled by delta tracking against the
+     * largest majorant over all channels.
      *
      * Note: this will *not* account for directly visible emitters, since
      * they require a direct connection from the emitter to the sensor. See
@@ -204,18 +249,22 @@ public:
      */
     std::pair<Spectrum, Float>
     trace_light_ray(Ray3f ray, const Scene *scene, const Sensor *sensor,
-                    Sampler *sampler, Spectrum throughput, ImageBlock *block,
-                    ScalarFloat sample_scale, Mask active = true) const {
+                    Sampler *sampler, Spectrum throughput, MediumPtr medium,
+                    ImageBlock *block, ScalarFloat sample_scale,
+                    Mask active = true) const {
         // Tracks radiance scaling due to index of refraction changes
         Float eta(1.f);
 
         Int32 depth = 1;
+        bool has_media = scene->has_media();
 
         /* ---------------------- Path construction ------------------------- */
         // First intersection from the emitter to the scene
         SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+        MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
 
-        active &= si.is_valid();
+        // Particles inside a medium may scatter before reaching any surface
+        active &= si.is_valid() || dr::neq(medium, nullptr);
         if (m_max_depth >= 0)
             active &= depth < m_max_depth;
 
@@ -223,56 +272,71 @@ public:
            generates wavefront or megakernel renderer based on configuration).
            Register everything that changes as part of the loop here */
         dr::Loop<Mask> loop("Particle Tracer Integrator", active, depth, ray,
-                            throughput, si, eta, sampler);
+                            throughput, si, mei, medium, eta, sampler);
 
-        // Incrementally build light path using BSDF sampling.
+        // Incrementally build light path using BSDF and phase function sampling.
         while (loop(active)) {
-            BSDFPtr bsdf = si.bsdf(ray);
-
-            /* Connect to sensor and splat if successful. Sample a direction
-               from the sensor to the current surface point. */
-            auto [sensor_ds, sensor_weight] =
-                sensor->sample_direction(si, sampler->next_2d(), active);
-            connect_sensor(scene, si, sensor_ds, bsdf,
-                           throughput * sensor_weight, block, sample_scale,
-                           active);
-
-            /* ----------------------- BSDF sampling ------------------------ */
-            // Sample BSDF * cos(theta).
-            BSDFContext ctx(TransportMode::Importance);
-            auto [bs, bsdf_val] =
-                bsdf->sample(ctx, si, sampler->next_1d(active),
-                             sampler->next_2d(active), active);
-
-            // Using geometric normals (wo points to the camera)
-            Float wi_dot_geo_n = dr::dot(si.n, -ray.d),
-                  wo_dot_geo_n = dr::dot(si.n, si.to_world(bs.wo));
-
-            // Prevent light leaks due to shading normals
-            active &= (wi_dot_geo_n * Frame3f::cos_theta(si.wi) > 0.f) &&
-                      (wo_dot_geo_n * Frame3f::cos_theta(bs.wo) > 0.f);
-
-            // Adjoint BSDF for shading normals -- [Veach, p. 155]
-            Float correction = dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
-                                       (Frame3f::cos_theta(bs.wo) * wi_dot_geo_n));
-            throughput *= bsdf_val * correction;
-            eta *= bs.eta;
+            /* -------------------- Free-flight sampling -------------------- */
+            Mask active_medium = false, act_medium_scatter = false;
+            if (has_media) {
+                active_medium = active && dr::neq(medium, nullptr);
+                if (dr::any_or<true>(active_medium))
+                    std::tie(mei, active_medium, act_medium_scatter) =
+                        sample_light_collision(ray, si, medium, sampler,
+                                               throughput, active_medium);
+            }
 
+            /* ------------------- Medium interactions ---------------------- */
+            if (has_media && dr::any_or<true>(act_medium_scatter)) {
+                /* Connect to sensor and splat if successful. Sample a direction
+                   from the sensor to the current medium position. */
+                auto [sensor_ds, sensor_weight] = sensor->sample_direction(
+                    mei, sampler->next_2d(act_medium_scatter), act_medium_scatter);
+                connect_sensor_medium(scene, mei, sensor_ds,
+                                      throughput * sensor_weight, true, sampler,
+                                      block, sample_scale, act_medium_scatter);
+
+                // Sample the phase function (adjoint of itself)
+                sample_light_phase(mei, ray, sampler, throughput, act_medium_scatter);
+            }
+
+            /* -------------------- Surface interactions -------------------- */
+            Mask active_surface = active && !active_medium && si.is_valid();
+            Mask non_null_bsdf = false;
+            if (dr::any_or<true>(active_surface)) {
+                BSDFPtr bsdf = si.bsdf(ray);
+
+                /* Connect to sensor and splat if successful. Sample a direction
+                   from the sensor to the current surface point. */
+                auto [sensor_ds, sensor_weight] =
+                    sensor->sample_direction(si, sampler->next_2d(), active_surface);
+                connect_sensor(scene, si, sensor_ds, bsdf,
+                               throughput * sensor_weight, medium, sampler,
+                               block, sample_scale, active_surface);
+
+                /* --------------------- BSDF sampling ---------------------- */
+                // Sample BSDF * cos(theta).
+                std::tie(active_surface, non_null_bsdf) =
+                    sample_light_bsdf(si, ray, medium, sampler, throughput, eta,
+                                      active_surface);
+            }
+
+            active &= active_surface || active_medium;
             active &= dr::any(dr::neq(unpolarized_spectrum(throughput), 0.f));
             if (dr::none_or<false>(active))
                 break;
 
-            // Intersect the BSDF ray against scene geometry (next vertex).
-            ray = si.spawn_ray(si.to_world(bs.wo));
-            si = scene->ray_intersect(ray, active);
+            // Intersect the new ray against scene geometry (next vertex).
+            Mask scattered = active && (active_surface || act_medium_scatter);
+            dr::masked(si, scattered) = scene->ray_intersect(ray, scattered);
 
-            depth++;
+            dr::masked(depth, non_null_bsdf || act_medium_scatter) += 1;
             if (m_max_depth >= 0)
                 active &= depth < m_max_depth;
-            active &= si.is_valid();
+            active &= si.is_valid() || dr::neq(medium, nullptr);
 
             // Russian Roulette
-            Mask use_rr = depth > m_rr_depth;
+            Mask use_rr = (non_null_bsdf || act_medium_scatter) && depth > m_rr_depth;
             if (dr::any_or<true>(use_rr)) {
                 Float q = dr::minimum(
                     dr::max(unpolarized_spectrum(throughput)) * dr::sqr(eta), 0.95f);
@@ -291,13 +355,16 @@ public:
      * evaluate the BSDF in the direction of the sensor.
      *
      * Finally, splat `weight` (with all appropriate factors) to the
-     * given image block.
+     * given image block. In scenes with participating media, `medium` is
+     * the medium on the incident side of the point and the splatted value
+     * accounts for the transmittance towards the sensor.
      *
      * \return The quantity that was accumulated to the block.
      */
     Spectrum connect_sensor(const Scene *scene, const SurfaceInteraction3f &si,
                             const DirectionSample3f &sensor_ds,
                             const BSDFPtr &bsdf, const Spectrum &weight,
+                            MediumPtr medium, Sampler *sampler,
                             ImageBlock *block, ScalarFloat sample_scale,
                             Mask active) const {
         active &= (sensor_ds.pdf > 0.f) &&
@@ -307,7 +374,15 @@ public:
 
         // Check that sensor is visible from current position (shadow ray).
         Ray3f sensor_ray = si.spawn_ray_to(sensor_ds.p);
-        active &= !scene->ray_test(sensor_ray, active);
+        Spectrum transmittance(1.f);
+        if (scene->has_media()) {
+            transmittance = eval_transmittance(
+                scene, si, sensor_ds.p, medium, sampler,
+                UInt32(Medium::MaxMajorantChannel), 0.f, active);
+            active &= dr::any(dr::neq(unpolarized_spectrum(transmittance), 0.f));
+        } else {
+            active &= !scene->ray_test(sensor_ray, active);
+        }
         if (dr::none_or<false>(active))
             return 0.f;
 
@@ -353,7 +428,7 @@ public:
             surface_weight[not_on_surface && invalid_side] = 0.f;
         }
 
-        result = weight * surface_weight * sample_scale;
+        result = weight * surface_weight * transmittance * sample_scale;
 
         /* Splatting, adjusting UVs for sensor's crop window if needed.
            The crop window is already accounted for in the UV positions
@@ -370,9 +445,63 @@ public:
         return result;
     }
 
+    /**
+     * Attempt connecting the given medium position to the sensor.
+     *
+     * If `scatter` is set, the phase function of the medium is evaluated in
+     * the direction of the sensor. Otherwise, the position emits
+     * isotropically (e.g. a sample of a volume emitter).
+     *
+     * \return The quantity that was accumulated to the block.
+     */
+    Spectrum connect_sensor_medium(const Scene *scene,
+                                   const MediumInteraction3f &mei,
+                                   const DirectionSample3f &sensor_ds,
+                                   const Spectrum &weight, Mask scatter,
+                                   Sampler *sampler, ImageBlock *block,
+                                   ScalarFloat sample_scale,
+                                   Mask active) const {
+        active &= (sensor_ds.pdf > 0.f) &&
+                  dr::any(dr::neq(unpolarized_spectrum(weight), 0.f));
+        if (dr::none_or<false>(active))
+            return 0.f;
+
+        Spectrum transmittance = eval_transmittance(
+            scene, mei, sensor_ds.p, mei.medium, sampler,
+            UInt32(Medium::MaxMajorantChannel), 0.f, active);
+        active &= dr::any(dr::neq(unpolarized_spectrum(transmittance), 0.f));
+        if (dr::none_or<false>(active))
+            return 0.f;
+
+        // Phase function value for the direction towards the sensor
+        Spectrum phase_weight = 1.f;
+        Mask active_p = active && scatter;
+        if (dr::any_or<true>(active_p)) {
+            PhaseFunctionContext phase_ctx(sampler, TransportMode::Importance);
+            auto phase = mei.medium->phase_function();
+            dr::masked(phase, !active_p) = nullptr;
+            auto [phase_val, phase_pdf] =
+                phase->eval_pdf(phase_ctx, mei, sensor_ds.d, active_p);
+            DRJIT_MARK_USED(phase_pdf);
+            dr::masked(phase_weight, active_p) = phase_val;
+        }
+
+        Spectrum result = weight * phase_weight * transmittance * sample_scale;
+
+        // Splat onto the image buffer (see \ref connect_sensor)
+        Float alpha = dr::select(scatter, 1.f, 0.f);
+        Vector2f adjusted_position = sensor_ds.uv + block->offset();
+        block->put(adjusted_position, mei.wavelengths, result, alpha,
+                   /* weight = */ 0.f, active);
+
+        return result;
+    }
+
     //! @}
     // =============================================================
 
+    bool supports_volume_emitters() const override { return true; }
+
     std::string to_string() const override {
         return tfm::format("ParticleTracerIntegrator[\n"
                            "  max_depth = %i,\n"
@@ -236,3 +236,46 @@ def test07_adjoint_integrator_trampoline(variants_all_ad_rgb):
     mi.load_dict({
         'type': 'myptracer'
     })
+
+
+@pytest.mark.slow
+def test08_render_emissive_medium(variants_vec_backends_once_rgb):
+    """
+    Particles emitted by an emissive medium, scattering in it and bouncing off
+    a diffuse floor must match the volumetric path tracer.
+    """
+    def render(integrator):
+        scene = mi.load_dict({
+            'type': 'scene',
+            'integrator': integrator,
+            'sensor': {
+                'type': 'perspective',
+                'to_world': mi.ScalarTransform4f.look_at(
+                    origin=(2, 3, 4), target=(0.5, 0, 0.5), up=(0, 1, 0)),
+                'film': {'type': 'hdrfilm', 'width': 8, 'height': 8,
+                         'rfilter': {'type': 'box'}},
+            },
+            'cube': {
+                'type': 'cube',
+                'to_world': mi.ScalarTransform4f.translate(0.5).scale(0.5),
+                'bsdf': {'type': 'null'},
+                'interior': {
+                    'type': 'heterogeneous',
+                    'albedo': 0.5,
+                    'sigma_t': 2.0,
+                    'radiance': 1.0,
+                },
+            },
+            'floor': {
+                'type': 'rectangle',
+                'to_world': mi.ScalarTransform4f.translate([0.5, -0.1, 0.5])
+                                                .rotate([1, 0, 0], -90).scale(2),
+                'bsdf': {'type': 'diffuse'},
+            },
+        })
+        assert scene.has_media()
+        return dr.mean(mi.render(scene, spp=1024).array)
+
+    ref = render({'type': 'volpath', 'max_depth': 8})
+    assert ref > 0
+    assert dr.allclose(render({'type': 'ptracer', 'max_depth': 8}), ref, rtol=5e-2)
@@ -0,0 +1,77 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def create_medium_scene(integrator):
+    return mi.load_dict({
+        'type': 'scene',
+        'integrator': integrator,
+        'sensor': {
+            'type': 'perspective',
+            'to_world': mi.ScalarTransform4f.look_at(
+                origin=(0, 0, 4), target=(0, 0, 0), up=(0, 1, 0)),
+            'film': {'type': 'hdrfilm', 'width': 8, 'height': 8,
+                     'rfilter': {'type': 'box'}},
+        },
+        'emitter': {'type': 'constant'},
+        'cube': {
+            'type': 'cube',
+            'bsdf': {'type': 'null'},
+            'interior': {
+                'type': 'homogeneous',
+                'albedo': 0.9,
+                'sigma_t': 2.0,
+            },
+        },
+    })
+
+
+def test01_construction(variants_all_rgb):
+    with pytest.raises(RuntimeError, match='passes'):
+        mi.load_dict({'type': 'vpm', 'passes': 0})
+    with pytest.raises(RuntimeError, match='alpha'):
+        mi.load_dict({'type': 'vpm', 'alpha': 1.0})
+
+    scene = create_medium_scene({'type': 'vpm', 'passes': 3})
+    with pytest.raises(RuntimeError, match='multiple'):
+        mi.render(scene, spp=4)
+
+
+def test02_matches_volpath(variants_vec_backends_once_rgb):
+    reference = mi.render(create_medium_scene({'type': 'volpath'}), spp=1024)
+    image = mi.render(create_medium_scene({
+        'type': 'vpm',
+        'photon_count': 200000,
+        'passes': 4,
+        'radius': 0.1,
+    }), spp=256)
+
+    # The density estimate is biased by the finite lookup radius
+    assert dr.allclose(dr.mean(image.array), dr.mean(reference.array), rtol=5e-2)
+
+
+def test03_point_light(variants_vec_backends_once_rgb):
+    # Delta emitters can only be reached by emitter sampling at surfaces
+    def create_scene(integrator):
+        return mi.load_dict({
+            'type': 'scene',
+            'integrator': integrator,
+            'sensor': {
+                'type': 'perspective',
+                'to_world': mi.ScalarTransform4f.look_at(
+                    origin=(0, 0, 4), target=(0, 0, 0), up=(0, 1, 0)),
+                'film': {'type': 'hdrfilm', 'width': 8, 'height': 8,
+                         'rfilter': {'type': 'box'}},
+            },
+            'emitter': {'type': 'point', 'position': (0, 0, 2),
+                        'intensity': 10.0},
+            'rect': {'type': 'rectangle', 'bsdf': {'type': 'diffuse'}},
+        })
+
+    reference = mi.render(create_scene({'type': 'path'}), spp=64)
+    image = mi.render(create_scene({'type': 'vpm', 'photon_count': 1000}),
+                      spp=64)
+
+    assert dr.mean(image.array)[0] > 0
+    assert dr.allclose(dr.mean(image.array), dr.mean(reference.array), rtol=1e-2)
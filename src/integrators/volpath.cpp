@@ -1,3 +1,4 @@
+#include <mutex>
 #include <random>
 #include <tuple>
 #include <mitsuba/core/ray.h>
@@ -36,11 +37,51 @@ Volumetric path tracer (:monosp:`volpath`)
    - |bool|
    - Hide directly visible emitters. (Default: no, i.e. |false|)
 
+ * - volume_lod
+   - |bool|
+   - Track the footprint of paths after their first scattering event and let
+     media select a matching level of detail (see the :paramtype:`mipmap`
+     parameter of :ref:`grid volumes <volume-gridvolume>`). (Default: |false|)
+
+ * - spectral_tracking
+   - |bool|
+   - Sample free-flight distances against the maximum majorant over all
+     channels and choose collision types using spectral tracking, instead of
+     tracking a single randomly chosen channel. (Default: |false|)
+
+ * - cache_depth
+   - |int|
+   - Enables the radiance cache: medium scattering events at this depth or
+     deeper terminate the path and add the in-scattered radiance stored in the
+     cache instead (-1 disables the cache). (Default: -1)
+
+ * - cache_resolution
+   - |int|
+   - Resolution of the radiance cache grid along each axis of the scene's
+     bounding box. (Default: 32)
+
+ * - cache_passes
+   - |int|
+   - Number of samples per pixel traced to fill the radiance cache at the
+     beginning of each rendering. (Default: 4)
+
+ * - sort_rays
+   - |bool|
+   - Reorder the rays of each bounce by origin and direction before they are
+     intersected with the scene (see the :ref:`path tracer <integrator-path>`).
+     This only has an effect in wavefront mode. (Default: |false|)
+
 This plugin provides a volumetric path tracer that can be used to compute approximate solutions
 of the radiative transfer equation. Its implementation makes use of multiple importance sampling
 to combine BSDF and phase function sampling with direct illumination sampling strategies. On
 surfaces, it behaves exactly like the standard path tracer.
 
+Media that emit light (e.g. a :ref:`heterogeneous <medium-heterogeneous>` medium with a
+``radiance`` volume) are accounted for at every real and null collision. The scene exposes
+them to next event estimation as :ref:`volume emitters <emitter-volumelight>`, so that
+emission can also be sampled from surfaces and from other media. Both strategies are
+combined using multiple importance sampling.
+
 This integrator has special support for index-matched transmission events (i.e. surface scattering
 events that do not change the direction of light). As a consequence, participating media enclosed by
 a stencil shape are rendered considerably more efficiently when this shape
@@ -48,12 +89,44 @@ has a :ref:`null <bsdf-null>` or :ref:`thin dielectric <bsdf-thindielectric>` BS
 to it (as compared to, say, a :ref:`dielectric <bsdf-dielectric>` or
 :ref:`roughdielectric <bsdf-roughdielectric>` BSDF).
 
-.. note:: This integrator does not implement good sampling strategies to render
-    participating media with a spectrally varying extinction coefficient. For these cases,
-    it is better to use the more advanced :ref:`volumetric path tracer with
+With :paramtype:`volume_lod` enabled, the integrator maintains a coarse estimate of the
+width of each path: the footprint grows linearly along rays, and every non-specular
+scattering event sets its growth rate to :math:`1/\sqrt{p}`, where :math:`p` is the
+solid angle density of the sampled direction. Camera rays keep the finest level of detail.
+Media evaluate their coefficients filtered over this footprint, which trades a small bias
+for much cheaper lookups in far-field and multiply scattered light transport.
+
+By default, free-flight distances in media with a spectrally varying extinction are
+sampled according to a single channel (RGB modes) or the hero wavelength (spectral modes),
+and the throughput of the other channels is reweighted accordingly. In strongly chromatic
+media (e.g. subsurface scattering or colored smoke), these weights have a high variance.
+When :paramtype:`spectral_tracking` is enabled, distances are instead sampled against the
+maximum majorant over all channels, so that the free-flight sampling density is the same for
+every channel and shadow rays never produce negative weights. At each collision, the choice
+between a real and a null scattering event is made with probabilities proportional to the
+channel averages of :math:`\sigma_s` and :math:`\sigma_n` weighted by the current path
+throughput (history-aware spectral tracking), which keeps the throughput bounded.
+
+.. note:: Without :paramtype:`spectral_tracking`, this integrator does not implement good
+    sampling strategies to render participating media with a spectrally varying extinction
+    coefficient. It is then better to use the more advanced :ref:`volumetric path tracer with
     spectral MIS <integrator-volpathmis>`, which will produce in a significantly less noisy
     rendered image.
 
+In dense media with a high albedo (e.g. clouds), most of the rendering time is spent
+on long random walks. Setting :paramtype:`cache_depth` enables a radiance cache that
+trades a user-controlled bias for much shorter paths. Before rendering, the integrator
+traces :paramtype:`cache_passes` samples per pixel without the cache. At the first
+medium scattering event of each path at depth :paramtype:`cache_depth` or deeper, it
+records the radiance that the rest of the path scatters towards the previous vertex
+(including next event estimation), divided by the path throughput. These estimates
+are averaged in the cells of a regular grid over the scene's bounding box, per color
+channel (or per wavelength bin in spectral modes). During rendering, paths reaching
+such a scattering event in a cell that received estimates terminate and add the
+cached radiance instead. The cache assumes that the in-scattered radiance varies
+slowly with the position and the direction, which makes it most accurate for deep
+scattering orders in media with a low anisotropy. A larger depth reduces the bias.
+
 .. warning:: This integrator does not support forward-mode differentiation.
 
 .. tabs::
@@ -73,15 +146,57 @@ template <typename Float, typename Spectrum>
 class VolumetricPathIntegrator : public MonteCarloIntegrator<Float, Spectrum> {
 
 public:
-    MI_IMPORT_BASE(MonteCarloIntegrator, m_max_depth, m_rr_depth, m_hide_emitters)
-    MI_IMPORT_TYPES(Scene, Sampler, Emitter, EmitterPtr, BSDF, BSDFPtr,
+    MI_IMPORT_BASE(MonteCarloIntegrator, eval_transmittance, m_max_depth, m_rr_depth,
+                    m_hide_emitters, m_samples_per_pass)
+    MI_IMPORT_TYPES(Scene, Sampler, Sensor, Emitter, EmitterPtr, BSDF, BSDFPtr,
                      Medium, MediumPtr, PhaseFunctionContext)
 
     VolumetricPathIntegrator(const Properties &props) : Base(props) {
+        m_spectral_tracking = props.get<bool>("spectral_tracking", false);
+        m_volume_lod = props.get<bool>("volume_lod", false);
+        m_sort_rays = props.get<bool>("sort_rays", false);
+
+        m_cache_depth = props.get<int>("cache_depth", -1);
+        if (m_cache_depth == 0 || m_cache_depth < -1)
+            Throw("\"cache_depth\" must be set to -1 (disabled) or a value >= 1");
+
+        int cache_resolution = props.get<int>("cache_resolution", 32);
+        if (cache_resolution < 1)
+            Throw("\"cache_resolution\" must be a positive integer");
+        m_cache_resolution = (uint32_t) cache_resolution;
+
+        int cache_passes = props.get<int>("cache_passes", 4);
+        if (cache_passes < 1)
+            Throw("\"cache_passes\" must be a positive integer");
+        m_cache_passes = (uint32_t) cache_passes;
+    }
+
+    using Base::render;
+
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        // The training pass changes the sample count of the sensor's sampler
+        if (spp == 0)
+            spp = sensor->sampler()->sample_count();
+        if (m_cache_depth > 0)
+            update_radiance_cache(scene, sensor, seed);
+        return Base::render(scene, sensor, seed, spp, develop, evaluate);
+    }
+
+    /// Intersect the rays of a bounce, optionally reordering them for coherence
+    SurfaceInteraction3f ray_intersect(const Scene *scene, const Ray3f &ray,
+                                       Mask active, bool sort_rays) const {
+        if (sort_rays)
+            return scene->ray_intersect_sorted(ray, +RayFlags::All, active);
+        return scene->ray_intersect(ray, active);
     }
 
     MI_INLINE
     Float index_spectrum(const UnpolarizedSpectrum &spec, const UInt32 &idx) const {
+        // Spectral tracking samples against the maximum over all channels
+        if (m_spectral_tracking)
+            return dr::max(spec);
+
         Float m = spec[0];
         if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
             dr::masked(m, dr::eq(idx, 1u)) = spec[1];
@@ -116,8 +231,13 @@ public:
         Mask specular_chain = active && !m_hide_emitters;
         UInt32 depth = 0;
 
+        // Path footprint width at the ray origin and its growth per unit distance
+        Float footprint = 0.f, spread = 0.f;
+
         UInt32 channel = 0;
-        if (is_rgb_v<Spectrum>) {
+        if (m_spectral_tracking) {
+            channel = Medium::MaxMajorantChannel;
+        } else if (is_rgb_v<Spectrum>) {
             uint32_t n_channels = (uint32_t) dr::array_size_v<Spectrum>;
             channel = (UInt32) dr::minimum(sampler->next_1d(active) * n_channels, n_channels - 1);
         }
@@ -127,6 +247,13 @@ public:
         Interaction3f last_scatter_event = dr::zeros<Interaction3f>();
         Float last_scatter_direction_pdf = 1.f;
 
+        // Radiance cache: lookups while rendering, or the vertex being recorded
+        bool cache_lookup = m_cache_depth > 0 && !m_cache_training &&
+                            dr::width(m_cache_count) > 0;
+        Point3f cache_p = 0.f;
+        UnpolarizedSpectrum cache_throughput(0.f), cache_result(0.f);
+        Mask cache_recorded = false;
+
         /* Set up a Dr.Jit loop (optimizes away to a normal loop in scalar mode,
            generates wavefront or megakernel renderer based on configuration).
            Register everything that changes as part of the loop here */
@@ -134,9 +261,17 @@ public:
                             /* loop state: */ active, depth, ray, throughput,
                             result, si, mei, medium, eta, last_scatter_event,
                             last_scatter_direction_pdf, needs_intersection,
-                            specular_chain, valid_ray, sampler);
+                            specular_chain, valid_ray, footprint, spread,
+                            cache_p, cache_throughput, cache_result,
+                            cache_recorded, sampler);
+
+        // Number of executed iterations (only meaningful in wavefront mode)
+        uint32_t iteration = 0;
 
         while (loop(active)) {
+            // Camera rays are already coherent
+            bool sort_rays = m_sort_rays && iteration++ > 0;
+
             // ----------------- Handle termination of paths ------------------
             // Russian roulette: try to keep path weights equal to one, while accounting for the
             // solid angle compression at refractive index boundaries. Stop with at least some
@@ -156,6 +291,7 @@ public:
             Mask active_surface = active && !active_medium;
             Mask act_null_scatter = false, act_medium_scatter = false,
                  escaped_medium = false;
+            Float p_scatter = 0.f;
 
             // If the medium does not have a spectrally varying extinction,
             // we can perform a few optimizations to speed up rendering
@@ -167,11 +303,19 @@ public:
             }
 
             if (dr::any_or<true>(active_medium)) {
-                mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
-                dr::masked(ray.maxt, active_medium && medium->is_homogeneous() && mei.is_valid()) = mei.t;
+                mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel,
+                                                 active_medium, footprint, spread);
+                /* Collisions in homogeneous media are real, hence the surface
+                   behind them need not be found. This does not hold when
+                   spectral tracking samples a chromatic medium against its
+                   largest extinction: null collisions continue the ray. */
+                Mask shorten_ray = active_medium && medium->is_homogeneous() && mei.is_valid();
+                if (m_spectral_tracking)
+                    shorten_ray &= !is_spectral;
+                dr::masked(ray.maxt, shorten_ray) = mei.t;
                 Mask intersect = needs_intersection && active_medium;
                 if (dr::any_or<true>(intersect))
-                    dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
+                    dr::masked(si, intersect) = ray_intersect(scene, ray, intersect, sort_rays);
                 needs_intersection &= !active_medium;
 
                 dr::masked(mei.t, active_medium && (si.t < mei.t)) = dr::Infinity<Float>;
@@ -184,16 +328,61 @@ public:
                 escaped_medium = active_medium && !mei.is_valid();
                 active_medium &= mei.is_valid();
 
+                // ---------------------- Medium emission ---------------------
+                // Emission is accounted for at every (real or null) collision
+                Mask active_emission = active_medium && medium->is_emitter();
+                if (dr::any_or<true>(active_emission)) {
+                    UnpolarizedSpectrum emission =
+                        (mei.sigma_t - mei.sigma_s) * medium->get_radiance(mei, active_emission);
+                    Float majorant = index_spectrum(mei.combined_extinction, channel);
+                    dr::masked(emission, not_spectral) /= majorant;
+
+                    // Combine with sampling of the medium's volume emitter at
+                    // the previous scattering event
+                    Mask count_direct = dr::eq(depth, 0u) || specular_chain;
+                    EmitterPtr emitter = medium->emitter();
+                    Mask use_mis = active_emission && !count_direct &&
+                                   dr::neq(emitter, nullptr);
+                    if (dr::any_or<true>(use_mis)) {
+                        DirectionSample3f ds = dr::zeros<DirectionSample3f>();
+                        ds.p       = mei.p;
+                        ds.emitter = emitter;
+                        Float emitter_pdf =
+                            scene->pdf_emitter_direction(last_scatter_event, ds, use_mis);
+                        dr::masked(emission, use_mis) *=
+                            mis_weight(last_scatter_direction_pdf * majorant, emitter_pdf);
+                    }
+                    dr::masked(result, active_emission) +=
+                        throughput * depolarizer<Spectrum>(emission);
+                }
+
                 // Handle null and real scatter events
-                Mask null_scatter = sampler->next_1d(active_medium) >= index_spectrum(mei.sigma_t, channel) / index_spectrum(mei.combined_extinction, channel);
+                p_scatter = index_spectrum(mei.sigma_t, channel) /
+                            index_spectrum(mei.combined_extinction, channel);
+                if (m_spectral_tracking) {
+                    /* History-aware spectral tracking: pick the collision
+                       type according to the channel averages of the
+                       coefficients weighted by the path throughput */
+                    UnpolarizedSpectrum w = dr::abs(unpolarized_spectrum(throughput));
+                    Float p_s = dr::mean(dr::abs(mei.sigma_s) * w),
+                          p_n = dr::mean(dr::abs(mei.sigma_n) * w);
+                    dr::masked(p_scatter, is_spectral) =
+                        dr::select(p_s + p_n > 0.f, p_s / (p_s + p_n), 0.f);
+                }
+                Mask null_scatter = sampler->next_1d(active_medium) >= p_scatter;
 
                 act_null_scatter |= null_scatter && active_medium;
                 act_medium_scatter |= !act_null_scatter && active_medium;
 
-                if (dr::any_or<true>(is_spectral && act_null_scatter))
-                    dr::masked(throughput, is_spectral && act_null_scatter) *=
-                        mei.sigma_n * index_spectrum(mei.combined_extinction, channel) /
-                        index_spectrum(mei.sigma_n, channel);
+                if (dr::any_or<true>(is_spectral && act_null_scatter)) {
+                    if (m_spectral_tracking)
+                        dr::masked(throughput, is_spectral && act_null_scatter) *=
+                            mei.sigma_n / (1.f - p_scatter);
+                    else
+                        dr::masked(throughput, is_spectral && act_null_scatter) *=
+                            mei.sigma_n * index_spectrum(mei.combined_extinction, channel) /
+                            index_spectrum(mei.sigma_n, channel);
+                }
 
                 dr::masked(depth, act_medium_scatter) += 1;
                 dr::masked(last_scatter_event, act_medium_scatter) = mei;
@@ -206,15 +395,40 @@ public:
             if (dr::any_or<true>(act_null_scatter)) {
                 dr::masked(ray.o, act_null_scatter) = mei.p;
                 dr::masked(si.t, act_null_scatter) = si.t - mei.t;
+                dr::masked(footprint, act_null_scatter) = mei.footprint;
             }
 
             if (dr::any_or<true>(act_medium_scatter)) {
-                if (dr::any_or<true>(is_spectral))
-                    dr::masked(throughput, is_spectral && act_medium_scatter) *=
-                        mei.sigma_s * index_spectrum(mei.combined_extinction, channel) / index_spectrum(mei.sigma_t, channel);
+                if (dr::any_or<true>(is_spectral)) {
+                    if (m_spectral_tracking)
+                        dr::masked(throughput, is_spectral && act_medium_scatter) *=
+                            mei.sigma_s / p_scatter;
+                    else
+                        dr::masked(throughput, is_spectral && act_medium_scatter) *=
+                            mei.sigma_s * index_spectrum(mei.combined_extinction, channel) / index_spectrum(mei.sigma_t, channel);
+                }
                 if (dr::any_or<true>(not_spectral))
                     dr::masked(throughput, not_spectral && act_medium_scatter) *= mei.sigma_s / mei.sigma_t;
 
+                // ---------------------- Radiance cache ----------------------
+                Mask at_cache = act_medium_scatter && m_cache_depth > 0 &&
+                                depth >= (uint32_t) m_cache_depth;
+                if (m_cache_training) {
+                    // Remember the first cache vertex of the path
+                    Mask record = at_cache && !cache_recorded;
+                    dr::masked(cache_p, record) = mei.p;
+                    dr::masked(cache_throughput, record) = unpolarized_spectrum(throughput);
+                    dr::masked(cache_result, record) = unpolarized_spectrum(result);
+                    cache_recorded |= record;
+                } else if (cache_lookup && dr::any_or<true>(at_cache)) {
+                    // Terminate into the cached in-scattered radiance
+                    auto [cached, found] =
+                        lookup_radiance_cache(mei.p, ray.wavelengths, at_cache);
+                    dr::masked(result, found) += throughput * depolarizer<Spectrum>(cached);
+                    act_medium_scatter &= !found;
+                    active &= !found;
+                }
+
                 PhaseFunctionContext phase_ctx(sampler);
                 auto phase = mei.medium->phase_function();
 
@@ -224,10 +438,14 @@ public:
                 specular_chain &= !act_medium_scatter;
                 specular_chain |= act_medium_scatter && !sample_emitters;
 
+                dr::masked(footprint, act_medium_scatter) = mei.footprint;
+
                 Mask active_e = act_medium_scatter && sample_emitters;
                 if (dr::any_or<true>(active_e)) {
-                    auto [emitted, ds] = sample_emitter(mei, scene, sampler, medium, channel, active_e);
+                    auto [emitted, ds] = sample_emitter(mei, scene, sampler, medium, channel,
+                                                        footprint, active_e);
                     auto [phase_val, phase_pdf] = phase->eval_pdf(phase_ctx, mei, ds.d, active_e);
+                    phase_pdf = unidirectional_pdf(ds, phase_pdf, channel, active_e);
                     dr::masked(result, active_e) += throughput * phase_val * emitted *
                                                     mis_weight(ds.pdf, dr::select(ds.delta, 0.f, phase_pdf));
                 }
@@ -244,13 +462,15 @@ public:
                 needs_intersection |= act_medium_scatter;
                 dr::masked(last_scatter_direction_pdf, act_medium_scatter) = phase_pdf;
                 dr::masked(throughput, act_medium_scatter) *= phase_weight;
+                if (m_volume_lod)
+                    dr::masked(spread, act_medium_scatter) = dr::rsqrt(phase_pdf);
             }
 
             // --------------------- Surface Interactions ---------------------
             active_surface |= escaped_medium;
             Mask intersect = active_surface && needs_intersection;
             if (dr::any_or<true>(intersect))
-                dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
+                dr::masked(si, intersect) = ray_intersect(scene, ray, intersect, sort_rays);
 
             if (dr::any_or<true>(active_surface)) {
                 // ---------------- Intersection with emitters ----------------
@@ -274,13 +494,16 @@ public:
             }
             active_surface &= si.is_valid();
             if (dr::any_or<true>(active_surface)) {
+                dr::masked(footprint, active_surface) = dr::fmadd(spread, si.t, footprint);
+
                 // --------------------- Emitter sampling ---------------------
                 BSDFContext ctx;
                 BSDFPtr bsdf  = si.bsdf(ray);
                 Mask active_e = active_surface && has_flag(bsdf->flags(), BSDFFlags::Smooth) && (depth + 1 < (uint32_t) m_max_depth);
 
                 if (likely(dr::any_or<true>(active_e))) {
-                    auto [emitted, ds] = sample_emitter(si, scene, sampler, medium, channel, active_e);
+                    auto [emitted, ds] = sample_emitter(si, scene, sampler, medium, channel,
+                                                        footprint, active_e);
 
                     // Query the BSDF for that emitter-sampled direction
                     Vector3f wo       = si.to_local(ds.d);
@@ -290,6 +513,7 @@ public:
                     // Determine probability of having sampled that same
                     // direction using BSDF sampling.
                     Float bsdf_pdf = bsdf->pdf(ctx, si, wo, active_e);
+                    bsdf_pdf = unidirectional_pdf(ds, bsdf_pdf, channel, active_e);
                     result[active_e] += throughput * bsdf_val * mis_weight(ds.pdf, dr::select(ds.delta, 0.f, bsdf_pdf)) * emitted;
                 }
 
@@ -312,6 +536,11 @@ public:
                 dr::masked(last_scatter_event, non_null_bsdf) = si;
                 dr::masked(last_scatter_direction_pdf, non_null_bsdf) = bs.pdf;
 
+                // Glossy and diffuse scattering widens the footprint
+                if (m_volume_lod)
+                    dr::masked(spread, non_null_bsdf && !has_flag(bs.sampled_type, BSDFFlags::Delta)) =
+                        dr::rsqrt(bs.pdf);
+
                 valid_ray |= non_null_bsdf;
                 specular_chain |= non_null_bsdf && has_flag(bs.sampled_type, BSDFFlags::Delta);
                 specular_chain &= !(active_surface && has_flag(bs.sampled_type, BSDFFlags::Smooth));
@@ -321,6 +550,12 @@ public:
             }
             active &= (active_surface | active_medium);
         }
+
+        if (m_cache_training)
+            record_radiance_cache(cache_p, cache_throughput,
+                                  unpolarized_spectrum(result) - cache_result,
+                                  ray.wavelengths, cache_recorded);
+
         return { result, valid_ray };
     }
 
@@ -330,9 +565,7 @@ public:
     std::tuple<Spectrum, DirectionSample3f>
     sample_emitter(const Interaction &ref_interaction, const Scene *scene,
                    Sampler *sampler, MediumPtr medium,
-                   UInt32 channel, Mask active) const {
-        Spectrum transmittance(1.0f);
-
+                   UInt32 channel, Float footprint, Mask active) const {
         auto [ds, emitter_val] = scene->sample_emitter_direction(ref_interaction, sampler->next_2d(active), false, active);
         dr::masked(emitter_val, dr::eq(ds.pdf, 0.f)) = 0.f;
         active &= dr::neq(ds.pdf, 0.f);
@@ -341,118 +574,171 @@ public:
             return { emitter_val, ds };
         }
 
-        Ray3f ray = ref_interaction.spawn_ray_to(ds.p);
-        Float max_dist = ray.maxt;
-
-        // Potentially escaping the medium if this is the current medium's boundary
-        if constexpr (std::is_convertible_v<Interaction, SurfaceInteraction3f>)
-            dr::masked(medium, ref_interaction.is_medium_transition()) =
-                ref_interaction.target_medium(ray.d);
-
-        Float total_dist = 0.f;
-        SurfaceInteraction3f si = dr::zeros<SurfaceInteraction3f>();
-        Mask needs_intersection = true;
-
-        dr::Loop<Mask> loop("Volpath integrator emitter sampling");
-        loop.put(active, ray, total_dist, needs_intersection, medium, si,
-                 transmittance);
-        sampler->loop_put(loop);
-        loop.init();
-        while (loop(dr::detach(active))) {
-            Float remaining_dist = max_dist - total_dist;
-            ray.maxt = remaining_dist;
-            active &= remaining_dist > 0.f;
-            if (dr::none_or<false>(active))
-                break;
-
-            Mask escaped_medium = false;
-            Mask active_medium  = active && dr::neq(medium, nullptr);
-            Mask active_surface = active && !active_medium;
-
-            if (dr::any_or<true>(active_medium)) {
-                auto mei = medium->sample_interaction(ray, sampler->next_1d(active_medium), channel, active_medium);
-                dr::masked(ray.maxt, active_medium && medium->is_homogeneous() && mei.is_valid()) = dr::minimum(mei.t, remaining_dist);
-                Mask intersect = needs_intersection && active_medium;
-                if (dr::any_or<true>(intersect))
-                    dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
-
-                dr::masked(mei.t, active_medium && (si.t < mei.t)) = dr::Infinity<Float>;
-                needs_intersection &= !active_medium;
+        Spectrum transmittance =
+            eval_transmittance(scene, ref_interaction, ds.p, medium, sampler,
+                               channel, footprint, active);
+        return { transmittance * emitter_val, ds };
+    }
 
-                Mask is_spectral = medium->has_spectral_extinction() && active_medium;
-                Mask not_spectral = !is_spectral && active_medium;
-                if (dr::any_or<true>(is_spectral)) {
-                    Float t      = dr::minimum(remaining_dist, dr::minimum(mei.t, si.t)) - mei.mint;
-                    UnpolarizedSpectrum tr  = dr::exp(-t * mei.combined_extinction);
-                    UnpolarizedSpectrum free_flight_pdf = dr::select(si.t < mei.t || mei.t > remaining_dist, tr, tr * mei.combined_extinction);
-                    Float tr_pdf = index_spectrum(free_flight_pdf, channel);
-                    dr::masked(transmittance, is_spectral) *= dr::select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
-                }
+    /**
+     * \brief Converts the directional density of reaching the endpoint of
+     * an emitter sample by BSDF or phase function sampling into the measure
+     * of that sample
+     *
+     * Points of volume emitters are reached through free-flight sampling,
+     * whose density per unit length is the majorant at that point. Samples of
+     * other emitters are left unchanged.
+     */
+    Float unidirectional_pdf(const DirectionSample3f &ds, Float pdf,
+                             UInt32 channel, Mask active) const {
+        Mask is_volume = active && dr::neq(ds.emitter, nullptr) &&
+                         has_flag(ds.emitter->flags(active), EmitterFlags::Volume);
+        if (dr::none_or<false>(is_volume))
+            return pdf;
+
+        MediumPtr medium = ds.emitter->medium();
+        MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
+        mei.p = ds.p;
+        Float majorant =
+            index_spectrum(medium->get_majorant(mei, is_volume), channel);
+        return dr::select(is_volume, pdf * majorant, pdf);
+    }
 
-                // Handle exceeding the maximum distance by medium sampling
-                dr::masked(total_dist, active_medium && (mei.t > remaining_dist) && mei.is_valid()) = ds.dist;
-                dr::masked(mei.t, active_medium && (mei.t > remaining_dist)) = dr::Infinity<Float>;
+    //! @}
+    // =============================================================
 
-                escaped_medium = active_medium && !mei.is_valid();
-                active_medium &= mei.is_valid();
-                is_spectral &= active_medium;
-                not_spectral &= active_medium;
+    // =============================================================
+    //! @{ \name Radiance cache
+    // =============================================================
 
-                dr::masked(total_dist, active_medium) += mei.t;
+    /**
+     * \brief Fill the radiance cache by tracing \c m_cache_passes samples per
+     * pixel, during which paths record their first cache vertex instead of
+     * terminating there
+     */
+    void update_radiance_cache(Scene *scene, Sensor *sensor, uint32_t seed) {
+        ScalarBoundingBox3f bbox = scene->bbox();
+        ScalarVector3f extents = bbox.extents();
+        m_cache_offset = bbox.min;
+        m_cache_scale = dr::select(extents > 0.f,
+                                   ScalarFloat(m_cache_resolution) / extents, 0.f);
+
+        size_t size = (size_t) m_cache_resolution * m_cache_resolution *
+                      m_cache_resolution * CacheChannels;
+        m_cache_sum = dr::zeros<FloatStorage>(size);
+        m_cache_count = dr::zeros<FloatStorage>(size);
+
+        /* Decorrelate the training samples from those of the final image.
+           All of them are traced in a single pass, whose sample count need
+           not be a multiple of 'samples_per_pass'. */
+        Sampler *sampler = sensor->sampler();
+        uint32_t sample_count = sampler->sample_count(),
+                 samples_per_pass = m_samples_per_pass;
+        m_samples_per_pass = (uint32_t) -1;
+        m_cache_training = true;
+        Base::render(scene, sensor, seed ^ 0x5bd1e995u, m_cache_passes, false, true);
+        m_cache_training = false;
+        m_samples_per_pass = samples_per_pass;
+        sampler->set_sample_count(sample_count);
+
+        dr::eval(m_cache_sum, m_cache_count);
+    }
 
-                if (dr::any_or<true>(active_medium)) {
-                    dr::masked(ray.o, active_medium)    = mei.p;
-                    dr::masked(si.t, active_medium) = si.t - mei.t;
+    /// Index of the cache cell containing \c p
+    UInt32 cache_cell(const Point3f &p) const {
+        int32_t res = (int32_t) m_cache_resolution;
+        Vector3i cell = dr::clamp(
+            dr::floor2int<Vector3i>((p - m_cache_offset) * m_cache_scale), 0, res - 1);
+        return UInt32((cell.z() * res + cell.y()) * res + cell.x());
+    }
 
-                    if (dr::any_or<true>(is_spectral))
-                        dr::masked(transmittance, is_spectral) *= mei.sigma_n;
-                    if (dr::any_or<true>(not_spectral))
-                        dr::masked(transmittance, not_spectral) *= mei.sigma_n / mei.combined_extinction;
-                }
-            }
+    /**
+     * \brief Index of the cache entry storing channel \c i of a spectrum in
+     * the given cell
+     *
+     * Spectral variants store a fixed number of wavelength bins per cell.
+     */
+    UInt32 cache_index(const UInt32 &cell, size_t i,
+                       const Wavelength &wavelengths) const {
+        if constexpr (is_spectral_v<Spectrum>) {
+            Float bin = (wavelengths[i] - MI_CIE_MIN) *
+                        (CacheChannels / (MI_CIE_MAX - MI_CIE_MIN));
+            return cell * CacheChannels +
+                   UInt32(dr::clamp(bin, 0.f, CacheChannels - 1.f));
+        } else {
+            DRJIT_MARK_USED(wavelengths);
+            return cell * CacheChannels + (uint32_t) i;
+        }
+    }
 
-            // Handle interactions with surfaces
-            Mask intersect = active_surface && needs_intersection;
-            if (dr::any_or<true>(intersect))
-                dr::masked(si, intersect)    = scene->ray_intersect(ray, intersect);
-            needs_intersection &= !intersect;
-            active_surface |= escaped_medium;
-            dr::masked(total_dist, active_surface) += si.t;
+    /// Average cached in-scattered radiance at \c p, and whether all channels have estimates
+    std::pair<UnpolarizedSpectrum, Mask>
+    lookup_radiance_cache(const Point3f &p, const Wavelength &wavelengths,
+                          Mask active) const {
+        UInt32 cell = cache_cell(p);
+        UnpolarizedSpectrum value(0.f);
+        for (size_t i = 0; i < dr::array_size_v<UnpolarizedSpectrum>; ++i) {
+            UInt32 index = cache_index(cell, i, wavelengths);
+            Float count = dr::gather<Float>(m_cache_count, index, active);
+            active &= count > 0.f;
+            value[i] = dr::select(
+                active, dr::gather<Float>(m_cache_sum, index, active) / count, 0.f);
+        }
+        return { value, active };
+    }
 
-            active_surface &= si.is_valid() && active && !active_medium;
-            if (dr::any_or<true>(active_surface)) {
-                auto bsdf         = si.bsdf(ray);
-                Spectrum bsdf_val = bsdf->eval_null_transmission(si, active_surface);
-                bsdf_val = si.to_world_mueller(bsdf_val, si.wi, si.wi);
-                dr::masked(transmittance, active_surface) *= bsdf_val;
+    /**
+     * \brief Add the radiance that a path gathered after its cache vertex to
+     * the cache
+     *
+     * The radiance is divided by the path throughput at the vertex, which
+     * yields an estimate of the in-scattered radiance there.
+     */
+    void record_radiance_cache(const Point3f &p,
+                               const UnpolarizedSpectrum &throughput,
+                               const UnpolarizedSpectrum &radiance,
+                               const Wavelength &wavelengths,
+                               Mask active) const {
+        active &= dr::all(dr::neq(throughput, 0.f));
+        UnpolarizedSpectrum value = dr::detach(radiance / throughput);
+        active &= dr::all(dr::isfinite(value));
+
+        UInt32 cell = cache_cell(p);
+        auto scatter = [&]() {
+            for (size_t i = 0; i < dr::array_size_v<UnpolarizedSpectrum>; ++i) {
+                UInt32 index = cache_index(cell, i, wavelengths);
+                dr::scatter_reduce(ReduceOp::Add, m_cache_sum, value[i], index, active);
+                dr::scatter_reduce(ReduceOp::Add, m_cache_count, Float(1.f), index, active);
             }
+        };
 
-            // Update the ray with new origin & t parameter
-            dr::masked(ray, active_surface) = si.spawn_ray(ray.d);
-            ray.maxt = remaining_dist;
-            needs_intersection |= active_surface;
-
-            // Continue tracing through scene if non-zero weights exist
-            active &= (active_medium || active_surface) && dr::any(dr::neq(unpolarized_spectrum(transmittance), 0.f));
-
-            // If a medium transition is taking place: Update the medium pointer
-            Mask has_medium_trans = active_surface && si.is_medium_transition();
-            if (dr::any_or<true>(has_medium_trans)) {
-                dr::masked(medium, has_medium_trans) = si.target_medium(ray.d);
-            }
+        if constexpr (dr::is_jit_v<Float>) {
+            scatter();
+        } else {
+            // Image blocks are rendered in parallel in scalar mode
+            std::lock_guard<std::mutex> guard(m_cache_mutex);
+            scatter();
         }
-        return { transmittance * emitter_val, ds };
     }
 
     //! @}
     // =============================================================
 
+    bool supports_volume_emitters() const override { return true; }
+
     std::string to_string() const override {
-        return tfm::format("VolumetricSimplePathIntegrator[\n"
+        return tfm::format("VolumetricPathIntegrator[\n"
                            "  max_depth = %i,\n"
-                           "  rr_depth = %i\n"
+                           "  rr_depth = %i,\n"
+                           "  spectral_tracking = %s,\n"
+                           "  volume_lod = %s,\n"
+                           "  cache_depth = %i,\n"
+                           "  cache_resolution = %u,\n"
+                           "  cache_passes = %u\n"
                            "]",
-                           m_max_depth, m_rr_depth);
+                           m_max_depth, m_rr_depth, m_spectral_tracking,
+                           m_volume_lod, m_cache_depth, m_cache_resolution,
+                           m_cache_passes);
     }
 
     Float mis_weight(Float pdf_a, Float pdf_b) const {
@@ -463,6 +749,24 @@ public:
     };
 
     MI_DECLARE_CLASS()
+private:
+    /// Number of channels per cell of the radiance cache
+    static constexpr uint32_t CacheChannels =
+        is_spectral_v<Spectrum> ? 16u : (uint32_t) dr::array_size_v<UnpolarizedSpectrum>;
+
+    bool m_spectral_tracking;
+    bool m_volume_lod;
+    bool m_sort_rays;
+
+    int m_cache_depth;
+    uint32_t m_cache_resolution;
+    uint32_t m_cache_passes;
+    bool m_cache_training = false;
+    ScalarPoint3f m_cache_offset;
+    ScalarVector3f m_cache_scale;
+    /// Sums and counts of the radiance estimates per cell and channel
+    mutable FloatStorage m_cache_sum, m_cache_count;
+    mutable std::mutex m_cache_mutex;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(VolumetricPathIntegrator, MonteCarloIntegrator);
@@ -50,6 +50,11 @@ and is only marginally slower than the :ref:`simple volumetric path tracer <inte
 Similar to the simple volumetric path tracer, this integrator has special
 support for index-matched transmission events.
 
+Media that emit light are accounted for at every real and null collision. Unlike the
+:ref:`simple volumetric path tracer <integrator-volpath>`, this integrator does not sample
+:ref:`volume emitters <emitter-volumelight>` during next event estimation, hence the scene
+does not create them when it is used.
+
 .. warning:: This integrator does not support forward-mode differentiation.
 
 .. tabs::
@@ -225,6 +230,18 @@ public:
                 active_medium &= mei.is_valid();
                 is_spectral &= active_medium;
                 not_spectral &= active_medium;
+
+                // ---------------------- Medium emission ---------------------
+                // Emission is accounted for at every (real or null) collision
+                Mask active_emission = active_medium && medium->is_emitter();
+                if (dr::any_or<true>(active_emission)) {
+                    UnpolarizedSpectrum emission =
+                        (mei.sigma_t - mei.sigma_s) * medium->get_radiance(mei, active_emission);
+                    dr::masked(emission, not_spectral) /=
+                        index_spectrum(mei.combined_extinction, channel);
+                    dr::masked(result, active_emission) +=
+                        mis_weight(p_over_f) * depolarizer<Spectrum>(emission);
+                }
             }
 
             if (dr::any_or<true>(active_medium)) {
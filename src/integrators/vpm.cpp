@@ -0,0 +1,742 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/ray.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
+#include <mitsuba/render/integrator.h>
+#include <mitsuba/render/medium.h>
+#include <mitsuba/render/phase.h>
+#include <mitsuba/render/records.h>
+#include <mitsuba/render/sampler.h>
+#include <nanothread/nanothread.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+
+.. _integrator-vpm:
+
+Volumetric photon mapper (:monosp:`vpm`)
+----------------------------------------
+
+.. pluginparameters::
+
+ * - max_depth
+   - |int|
+   - Specifies the longest path depth of camera paths (where -1 corresponds to
+     :math:`\infty`). (Default: -1)
+
+ * - rr_depth
+   - |int|
+   - Specifies the minimum path depth, after which the implementation will start to use the
+     *russian roulette* path termination criterion. (Default: 5)
+
+ * - hide_emitters
+   - |bool|
+   - Hide directly visible emitters. (Default: no, i.e. |false|)
+
+ * - photon_count
+   - |int|
+   - Number of photon paths traced from the light sources in every pass.
+     (Default: 100000)
+
+ * - photon_max_depth
+   - |int|
+   - Longest photon path depth. Every photon path stores at most one photon
+     per depth. (Default: 16)
+
+ * - passes
+   - |int|
+   - Number of progressive passes. Every pass traces a new set of photons
+     and renders an equal share of the sample count. (Default: 4)
+
+ * - radius
+   - |float|
+   - Initial radius of the photon lookups. A value of zero selects 1% of the
+     diagonal of the scene's bounding box. (Default: 0)
+
+ * - alpha
+   - |float|
+   - Fraction of photons kept by the progressive radius reduction, within
+     :math:`(0, 1)`. (Default: 0.7)
+
+This integrator renders participating media using volumetric photon mapping
+(Jensen and Christensen, 1998). Photons are traced from the light sources using the
+same free-flight sampling and phase functions as the :ref:`particle tracer
+<integrator-ptracer>`, and a photon is stored at every real scattering event
+in a medium. Camera paths then trace through the scene until their first real
+scattering event in a medium, where the in-scattered radiance is estimated
+from the nearby photons and the path terminates. Radiance emitted by the media
+along the way is accounted for as in the :ref:`volumetric path tracer
+<integrator-volpath>`.
+
+This is particularly useful for dense, highly scattering media and caustics
+seen through media, where path tracing converges slowly. Photons are stored
+in a hash grid whose cells match the lookup diameter, which is rebuilt for
+every pass. Following progressive photon mapping (Knaus and Zwicker, 2011), the
+lookup radius shrinks after every pass so that the average of the passes
+converges to the correct solution: :math:`r_{i+1}^3 = r_i^3 (i + \alpha)/(i + 1)`.
+
+.. note:: Direct illumination at surfaces combines emitter and BSDF sampling
+   using multiple importance sampling, as in the :ref:`path tracer
+   <integrator-path>`. This integrator only supports RGB and monochromatic
+   variants.
+
+.. tabs::
+    .. code-tab:: xml
+
+        <integrator type="vpm">
+            <integer name="photon_count" value="1000000"/>
+            <integer name="passes" value="16"/>
+        </integrator>
+
+    .. code-tab:: python
+
+        'type': 'vpm',
+        'photon_count': 1000000,
+        'passes': 16
+
+ */
+
+template <typename Float, typename Spectrum>
+class VolumetricPhotonMapper final : public MonteCarloIntegrator<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(MonteCarloIntegrator, eval_transmittance, sample_light_collision,
+                    sample_light_phase, sample_light_bsdf, m_max_depth,
+                    m_rr_depth, m_hide_emitters)
+    MI_IMPORT_TYPES(Scene, Sampler, Sensor, Emitter, EmitterPtr, BSDF, BSDFPtr,
+                     Medium, MediumPtr, PhaseFunctionContext)
+
+    using UInt32Storage = DynamicBuffer<UInt32>;
+
+    VolumetricPhotonMapper(const Properties &props) : Base(props) {
+        if constexpr (is_spectral_v<Spectrum> || is_polarized_v<Spectrum>)
+            Throw("This integrator only supports RGB and monochromatic variants!");
+
+        int photon_count = props.get<int>("photon_count", 100000);
+        if (photon_count < 1)
+            Throw("\"photon_count\" must be a positive integer");
+        m_photon_count = (uint32_t) photon_count;
+
+        int photon_max_depth = props.get<int>("photon_max_depth", 16);
+        if (photon_max_depth < 1)
+            Throw("\"photon_max_depth\" must be a positive integer");
+        m_photon_max_depth = (uint32_t) photon_max_depth;
+
+        int passes = props.get<int>("passes", 4);
+        if (passes < 1)
+            Throw("\"passes\" must be a positive integer");
+        m_passes = (uint32_t) passes;
+
+        m_initial_radius = props.get<ScalarFloat>("radius", 0.f);
+        if (m_initial_radius < 0.f)
+            Throw("\"radius\" must be non-negative");
+
+        m_alpha = props.get<ScalarFloat>("alpha", 0.7f);
+        if (!(m_alpha > 0.f && m_alpha < 1.f))
+            Throw("\"alpha\" must be within (0, 1)");
+    }
+
+    using Base::render;
+
+    TensorXf render(Scene *scene, Sensor *sensor, uint32_t seed, uint32_t spp,
+                    bool develop, bool evaluate) override {
+        Sampler *sampler = sensor->sampler();
+        if (spp == 0)
+            spp = sampler->sample_count();
+        if (spp % m_passes != 0)
+            Throw("The sample count (%u) must be a multiple of \"passes\" (%u).",
+                  spp, m_passes);
+        if (m_passes > 1 && !develop)
+            Throw("Rendering multiple passes requires developing the film.");
+
+        ScalarFloat radius = m_initial_radius;
+        if (radius == 0.f)
+            radius = .01f * dr::norm(scene->bbox().extents());
+        if (!(radius > 0.f))
+            Throw("Could not determine the photon radius from the scene bounds, "
+                  "please specify \"radius\".");
+
+        TensorXf image;
+        for (uint32_t i = 0; i < m_passes; ++i) {
+            // Decorrelate the photons from the camera samples of the pass
+            update_photon_map(scene, sensor, (seed + i) ^ 0x9e3779b9u, radius);
+
+            TensorXf pass = Base::render(scene, sensor, seed + i,
+                                         spp / m_passes, develop, evaluate);
+            if (i == 0)
+                image = pass;
+            else
+                image = image + (pass - image) * (1.f / (i + 1));
+
+            if constexpr (dr::is_jit_v<Float>)
+                dr::eval(image);
+
+            // Progressive radius reduction [Knaus and Zwicker 2011]
+            radius *= dr::cbrt((i + m_alpha) / (i + 1.f));
+        }
+
+        sampler->set_sample_count(spp);
+        return image;
+    }
+
+    std::pair<Spectrum, Mask> sample(const Scene *scene,
+                                     Sampler *sampler,
+                                     const RayDifferential3f &ray_,
+                                     const Medium *initial_medium,
+                                     Float * /* aovs */,
+                                     Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::SamplingIntegratorSample, active);
+
+        // If there is an environment emitter and emitters are visible: all rays will be valid
+        // Otherwise, it will depend on whether a valid interaction is sampled
+        Mask valid_ray = !m_hide_emitters && dr::neq(scene->environment(), nullptr);
+
+        Ray3f ray = ray_;
+
+        // Tracks radiance scaling due to index of refraction changes
+        Float eta(1.f);
+
+        Spectrum throughput(1.f), result(0.f);
+        MediumPtr medium = initial_medium;
+        MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
+        UInt32 depth = 0;
+        bool has_media = scene->has_media();
+
+        // Previous surface vertex and BSDF sample, for MIS of emitter hits
+        Interaction3f prev_si = dr::zeros<Interaction3f>();
+        Float prev_bsdf_pdf = 1.f;
+        Mask prev_bsdf_delta = true;
+
+        // Medium vertex at which the photon map is queried, and its weight
+        MediumInteraction3f gather_mei = dr::zeros<MediumInteraction3f>();
+        Spectrum gather_weight(0.f);
+        Mask gather = false;
+
+        SurfaceInteraction3f si = scene->ray_intersect(ray, active);
+
+        /* Set up a Dr.Jit loop (optimizes away to a normal loop in scalar mode,
+           generates wavefront or megakernel renderer based on configuration).
+           Register everything that changes as part of the loop here */
+        dr::Loop<Mask> loop("Volumetric Photon Mapper",
+                            /* loop state: */ active, depth, ray, throughput,
+                            result, si, mei, medium, eta, prev_si,
+                            prev_bsdf_pdf, prev_bsdf_delta, gather_mei,
+                            gather_weight, gather, valid_ray, sampler);
+
+        while (loop(active)) {
+            /* -------------------- Free-flight sampling -------------------- */
+            Mask active_medium = false, act_medium_scatter = false;
+            if (has_media) {
+                active_medium = active && dr::neq(medium, nullptr);
+                if (dr::any_or<true>(active_medium)) {
+                    mei = medium->sample_interaction(
+                        ray, sampler->next_1d(active_medium),
+                        UInt32(Medium::MaxMajorantChannel), active_medium);
+                    dr::masked(mei.t, active_medium && (si.t < mei.t)) =
+                        dr::Infinity<Float>;
+
+                    Mask is_spectral = active_medium && medium->has_spectral_extinction(),
+                         not_spectral = active_medium && !is_spectral;
+                    if (dr::any_or<true>(is_spectral)) {
+                        auto [tr, free_flight_pdf] =
+                            medium->transmittance_eval_pdf(mei, si, is_spectral);
+                        Float tr_pdf = dr::max(free_flight_pdf);
+                        dr::masked(throughput, is_spectral) *=
+                            dr::select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
+                    }
+
+                    active_medium &= mei.is_valid();
+                    is_spectral &= active_medium;
+                    not_spectral &= active_medium;
+
+                    // Emission is accounted for at every (real or null) collision
+                    Mask active_emission = active_medium && medium->is_emitter();
+                    if (dr::any_or<true>(active_emission)) {
+                        UnpolarizedSpectrum emission =
+                            (mei.sigma_t - mei.sigma_s) *
+                            medium->get_radiance(mei, active_emission);
+                        dr::masked(emission, not_spectral) /=
+                            dr::max(mei.combined_extinction);
+                        dr::masked(result, active_emission) +=
+                            throughput * depolarizer<Spectrum>(emission);
+                    }
+
+                    // Real collisions are chosen according to the largest extinction
+                    Float p_scatter = dr::max(mei.sigma_t) /
+                                      dr::max(mei.combined_extinction);
+                    Mask null_scatter = sampler->next_1d(active_medium) >= p_scatter;
+                    Mask act_null_scatter = active_medium && null_scatter;
+                    act_medium_scatter = active_medium && !null_scatter;
+
+                    dr::masked(throughput, is_spectral && act_null_scatter) *=
+                        mei.sigma_n / (1.f - p_scatter);
+
+                    /* The photon density estimates the in-scattered radiance
+                       multiplied by the scattering coefficient, which leaves
+                       the inverse collision density as the weight */
+                    dr::masked(gather_weight, is_spectral && act_medium_scatter) =
+                        throughput / p_scatter;
+                    dr::masked(gather_weight, not_spectral && act_medium_scatter) =
+                        throughput / depolarizer<Spectrum>(mei.sigma_t);
+                    dr::masked(gather_mei, act_medium_scatter) = mei;
+                    gather |= act_medium_scatter;
+                    valid_ray |= act_medium_scatter;
+
+                    // Null collisions resume the flight from the sampled position
+                    dr::masked(ray.o, act_null_scatter) = mei.p;
+                    dr::masked(si.t, act_null_scatter) = si.t - mei.t;
+                }
+            }
+
+            /* ---------------------- Emitter hits -------------------------- */
+            Mask active_surface = active && !active_medium;
+            EmitterPtr emitter = si.emitter(scene);
+            Mask active_e = active_surface && dr::neq(emitter, nullptr) &&
+                            !(dr::eq(depth, 0u) && m_hide_emitters);
+            if (dr::any_or<true>(active_e)) {
+                // Compute MIS weight for the emitter sample from the previous bounce
+                DirectionSample3f ds(scene, si, prev_si);
+                Float em_pdf = scene->pdf_emitter_direction(
+                    prev_si, ds, active_e && !prev_bsdf_delta);
+                Float mis_bsdf = mis_weight(prev_bsdf_pdf, em_pdf);
+
+                dr::masked(result, active_e) +=
+                    throughput * emitter->eval(si, active_e) * mis_bsdf;
+            }
+
+            /* -------------------- Surface interactions -------------------- */
+            active_surface &= si.is_valid();
+            Mask non_null_bsdf = false;
+            if (dr::any_or<true>(active_surface)) {
+                BSDFContext ctx;
+                BSDFPtr bsdf = si.bsdf(ray);
+
+                /* ------------------- Emitter sampling -------------------- */
+                // Emission of the media is collected by the free-flight sampling
+                Mask active_em = active_surface &&
+                                 has_flag(bsdf->flags(), BSDFFlags::Smooth);
+                if (dr::any_or<true>(active_em)) {
+                    auto [ds, em_weight] = scene->sample_emitter_direction(
+                        si, sampler->next_2d(active_em), false, active_em);
+                    active_em &= dr::neq(ds.pdf, 0.f) &&
+                                 !has_flag(ds.emitter->flags(), EmitterFlags::Volume);
+
+                    if (dr::any_or<true>(active_em)) {
+                        Spectrum transmittance = eval_transmittance(
+                            scene, si, ds.p, medium, sampler,
+                            UInt32(Medium::MaxMajorantChannel), 0.f, active_em);
+
+                        Vector3f wo = si.to_local(ds.d);
+                        auto [bsdf_val, bsdf_pdf] =
+                            bsdf->eval_pdf(ctx, si, wo, active_em);
+                        Float mis_em =
+                            dr::select(ds.delta, 1.f, mis_weight(ds.pdf, bsdf_pdf));
+
+                        dr::masked(result, active_em) +=
+                            throughput * bsdf_val * em_weight * transmittance * mis_em;
+                    }
+                }
+
+                /* --------------------- BSDF sampling ---------------------- */
+                auto [bs, bsdf_val] =
+                    bsdf->sample(ctx, si, sampler->next_1d(active_surface),
+                                 sampler->next_2d(active_surface), active_surface);
+
+                dr::masked(throughput, active_surface) *= bsdf_val;
+                dr::masked(eta, active_surface) *= bs.eta;
+                dr::masked(ray, active_surface) = si.spawn_ray(si.to_world(bs.wo));
+
+                // Passing through a null BSDF does not count as a bounce
+                non_null_bsdf = active_surface && !has_flag(bs.sampled_type, BSDFFlags::Null);
+                valid_ray |= non_null_bsdf;
+
+                // Only non-null vertices can be sampled by emitter sampling
+                dr::masked(prev_si, non_null_bsdf) = si;
+                dr::masked(prev_bsdf_pdf, non_null_bsdf) = bs.pdf;
+                dr::masked(prev_bsdf_delta, non_null_bsdf) =
+                    has_flag(bs.sampled_type, BSDFFlags::Delta);
+
+                // Enter or leave media at their boundaries
+                if (has_media) {
+                    Mask has_medium_trans = active_surface && si.is_medium_transition();
+                    dr::masked(medium, has_medium_trans) = si.target_medium(ray.d);
+                }
+            }
+
+            // Paths end at their first real scattering event in a medium
+            active &= (active_surface || active_medium) && !act_medium_scatter;
+            active &= dr::any(dr::neq(unpolarized_spectrum(throughput), 0.f));
+            if (dr::none_or<false>(active))
+                break;
+
+            dr::masked(si, active_surface) = scene->ray_intersect(ray, active_surface);
+
+            dr::masked(depth, non_null_bsdf) += 1;
+            active &= depth < m_max_depth;
+
+            // Russian Roulette
+            Mask use_rr = non_null_bsdf && depth > m_rr_depth;
+            if (dr::any_or<true>(use_rr)) {
+                Float q = dr::minimum(
+                    dr::max(unpolarized_spectrum(throughput)) * dr::sqr(eta), .95f);
+                dr::masked(active, use_rr) &= sampler->next_1d(active) < q;
+                dr::masked(throughput, use_rr) *= dr::rcp(q);
+            }
+        }
+
+        if (dr::any_or<true>(gather))
+            dr::masked(result, gather) +=
+                gather_weight * query_photons(gather_mei, sampler, gather);
+
+        return { result, valid_ray };
+    }
+
+    Float mis_weight(Float pdf_a, Float pdf_b) const {
+        pdf_a *= pdf_a;
+        pdf_b *= pdf_b;
+        Float w = pdf_a / (pdf_a + pdf_b);
+        return dr::select(dr::isfinite(w), w, 0.f);
+    }
+
+    // =============================================================
+    //! @{ \name Photon map
+    // =============================================================
+
+    /**
+     * \brief Trace \c m_photon_count photon paths and store them in a new
+     * photon map with lookup radius \c radius
+     */
+    void update_photon_map(const Scene *scene, const Sensor *sensor,
+                           uint32_t seed, ScalarFloat radius) {
+        size_t n_slots = (size_t) m_photon_count * m_photon_max_depth;
+        FloatStorage positions  = dr::zeros<FloatStorage>(n_slots * 3),
+                     directions = dr::zeros<FloatStorage>(n_slots * 3),
+                     power      = dr::zeros<FloatStorage>(n_slots * Channels);
+
+        if (!scene->emitters().empty()) {
+            if constexpr (dr::is_jit_v<Float>) {
+                ref<Sampler> sampler = sensor->sampler()->fork();
+                sampler->set_samples_per_wavefront(1);
+                sampler->seed(seed, m_photon_count);
+
+                trace_photon(scene, sensor, sampler,
+                             dr::arange<UInt32>(m_photon_count), positions,
+                             directions, power);
+                dr::eval(positions, directions, power);
+            } else {
+                uint32_t n_threads = (uint32_t) Thread::thread_count(),
+                         grain_size = std::max(m_photon_count / (4 * n_threads), 1u);
+
+                ThreadEnvironment env;
+                dr::parallel_for(
+                    dr::blocked_range<uint32_t>(0, m_photon_count, grain_size),
+                    [&](const dr::blocked_range<uint32_t> &range) {
+                        ScopedSetThreadEnvironment set_env(env);
+
+                        // Fork a non-overlapping sampler for the current worker
+                        ref<Sampler> sampler = sensor->sampler()->clone();
+                        sampler->seed(seed + range.begin() / grain_size);
+
+                        for (uint32_t i = range.begin(); i != range.end(); ++i) {
+                            trace_photon(scene, sensor, sampler, i, positions,
+                                         directions, power);
+                            sampler->advance();
+                        }
+                    }
+                );
+            }
+        }
+
+        build_photon_grid(positions, directions, power, n_slots, radius);
+    }
+
+    /**
+     * \brief Trace a photon path from the light sources and store a photon
+     * at each real scattering event in a medium
+     *
+     * The photon of depth \c d is written to slot <tt>(d - 1) * m_photon_count
+     * + index</tt> of the output buffers. Free-flight distances are sampled
+     * against the largest majorant over all channels, and the stored power
+     * includes the scattering albedo.
+     */
+    void trace_photon(const Scene *scene, const Sensor *sensor,
+                      Sampler *sampler, const UInt32 &index,
+                      FloatStorage &positions, FloatStorage &directions,
+                      FloatStorage &power) const {
+        Float time = sensor->shutter_open();
+        if (sensor->shutter_open_time() > 0)
+            time += sampler->next_1d() * sensor->shutter_open_time();
+
+        Float wavelength_sample  = sampler->next_1d();
+        Point2f direction_sample = sampler->next_2d(),
+                position_sample  = sampler->next_2d();
+
+        auto [ray, throughput, emitter] = scene->sample_emitter_ray(
+            time, wavelength_sample, direction_sample, position_sample);
+
+        MediumPtr medium = nullptr;
+        bool has_media = scene->has_media();
+        if (has_media)
+            medium = emitter->medium();
+
+        // Tracks radiance scaling due to index of refraction changes
+        Float eta(1.f);
+        UInt32 depth = 1;
+
+        SurfaceInteraction3f si = scene->ray_intersect(ray);
+        MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
+
+        Mask active = dr::any(dr::neq(unpolarized_spectrum(throughput), 0.f)) &&
+                      (si.is_valid() || dr::neq(medium, nullptr));
+
+        dr::Loop<Mask> loop("Photon Tracer", active, depth, ray, throughput,
+                            si, mei, medium, eta, sampler);
+
+        while (loop(active)) {
+            /* -------------------- Free-flight sampling -------------------- */
+            Mask active_medium = false, act_medium_scatter = false;
+            if (has_media) {
+                active_medium = active && dr::neq(medium, nullptr);
+                if (dr::any_or<true>(active_medium))
+                    std::tie(mei, active_medium, act_medium_scatter) =
+                        sample_light_collision(ray, si, medium, sampler,
+                                               throughput, active_medium);
+            }
+
+            /* ------------------- Medium interactions ---------------------- */
+            if (has_media && dr::any_or<true>(act_medium_scatter)) {
+                UInt32 slot = (depth - 1) * m_photon_count + index;
+                dr::scatter(positions, mei.p, slot, act_medium_scatter);
+                dr::scatter(directions, ray.d, slot, act_medium_scatter);
+                dr::scatter(power, unpolarized_spectrum(throughput), slot,
+                            act_medium_scatter);
+
+                // Sample the phase function (adjoint of itself)
+                sample_light_phase(mei, ray, sampler, throughput, act_medium_scatter);
+            }
+
+            /* -------------------- Surface interactions -------------------- */
+            Mask active_surface = active && !active_medium && si.is_valid();
+            Mask non_null_bsdf = false;
+            if (dr::any_or<true>(active_surface))
+                std::tie(active_surface, non_null_bsdf) =
+                    sample_light_bsdf(si, ray, medium, sampler, throughput, eta,
+                                      active_surface);
+
+            active &= active_surface || active_medium;
+            active &= dr::any(dr::neq(unpolarized_spectrum(throughput), 0.f));
+            if (dr::none_or<false>(active))
+                break;
+
+            // Intersect the new ray against scene geometry (next vertex).
+            Mask scattered = active && (active_surface || act_medium_scatter);
+            dr::masked(si, scattered) = scene->ray_intersect(ray, scattered);
+
+            dr::masked(depth, non_null_bsdf || act_medium_scatter) += 1;
+            active &= depth <= m_photon_max_depth;
+            active &= si.is_valid() || dr::neq(medium, nullptr);
+
+            // Russian Roulette
+            Mask use_rr = (non_null_bsdf || act_medium_scatter) && depth > m_rr_depth;
+            if (dr::any_or<true>(use_rr)) {
+                Float q = dr::minimum(
+                    dr::max(unpolarized_spectrum(throughput)) * dr::sqr(eta), 0.95f);
+                dr::masked(active, use_rr) &= sampler->next_1d(active) < q;
+                dr::masked(throughput, use_rr) *= dr::rcp(q);
+            }
+        }
+    }
+
+    /**
+     * \brief Sort the stored photons into a hash grid
+     *
+     * The grid cells have the size of the lookup diameter, so that lookups
+     * visit at most 8 cells. The photons of each hash table bucket are stored
+     * contiguously starting at \c m_cell_begin[bucket].
+     */
+    void build_photon_grid(const FloatStorage &positions_,
+                           const FloatStorage &directions_,
+                           const FloatStorage &power_, size_t n_slots,
+                           ScalarFloat radius) {
+        auto &&positions  = dr::migrate(positions_, AllocType::Host);
+        auto &&directions = dr::migrate(directions_, AllocType::Host);
+        auto &&power      = dr::migrate(power_, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+
+        const ScalarFloat *p_ptr = (const ScalarFloat *) positions.data(),
+                          *d_ptr = (const ScalarFloat *) directions.data(),
+                          *w_ptr = (const ScalarFloat *) power.data();
+
+        m_radius = radius;
+        m_inv_cell_size = .5f / radius;
+        m_photon_scale =
+            1.f / (m_photon_count * (4.f / 3.f) * dr::Pi<ScalarFloat> *
+                   radius * radius * radius);
+
+        // Only keep the slots in which a photon was stored
+        std::vector<uint32_t> stored;
+        for (size_t i = 0; i < n_slots; ++i) {
+            bool valid = false;
+            for (size_t c = 0; c < Channels; ++c)
+                valid |= w_ptr[i * Channels + c] != 0.f;
+            if (valid)
+                stored.push_back((uint32_t) i);
+        }
+
+        uint32_t n = (uint32_t) stored.size();
+        m_stored_photons = n;
+        m_table_size = math::round_to_power_of_two(std::max(n, 1u));
+        Log(Debug, "Photon map: %u photons, radius %f", n, radius);
+        if (n == 0)
+            return;
+
+        // Counting sort of the photons by bucket
+        std::vector<uint32_t> bucket(n), begin(m_table_size + 1, 0);
+        for (uint32_t j = 0; j < n; ++j) {
+            const ScalarFloat *p = p_ptr + 3 * stored[j];
+            ScalarVector3i cell = dr::floor2int<ScalarVector3i>(
+                ScalarPoint3f(p[0], p[1], p[2]) * m_inv_cell_size);
+            bucket[j] = grid_hash(cell.x(), cell.y(), cell.z(), m_table_size - 1);
+            begin[bucket[j] + 1]++;
+        }
+        for (uint32_t b = 0; b < m_table_size; ++b)
+            begin[b + 1] += begin[b];
+
+        std::vector<uint32_t> offset(begin.begin(), begin.end() - 1);
+        std::vector<ScalarFloat> sorted_p(3 * n), sorted_d(3 * n),
+            sorted_power(Channels * n);
+        for (uint32_t j = 0; j < n; ++j) {
+            uint32_t k = offset[bucket[j]]++, i = stored[j];
+            for (size_t c = 0; c < 3; ++c) {
+                sorted_p[3 * k + c] = p_ptr[3 * i + c];
+                sorted_d[3 * k + c] = d_ptr[3 * i + c];
+            }
+            for (size_t c = 0; c < Channels; ++c)
+                sorted_power[Channels * k + c] = w_ptr[Channels * i + c];
+        }
+
+        m_cell_begin = dr::load<UInt32Storage>(begin.data(), begin.size());
+        m_photon_p = dr::load<FloatStorage>(sorted_p.data(), sorted_p.size());
+        m_photon_d = dr::load<FloatStorage>(sorted_d.data(), sorted_d.size());
+        m_photon_power =
+            dr::load<FloatStorage>(sorted_power.data(), sorted_power.size());
+    }
+
+    /**
+     * \brief Density estimate of the in-scattered radiance (multiplied by the
+     * scattering coefficient) at a medium interaction from the photon map
+     */
+    Spectrum query_photons(const MediumInteraction3f &mei, Sampler *sampler,
+                           Mask active) const {
+        if (m_stored_photons == 0)
+            return 0.f;
+
+        PhaseFunctionContext phase_ctx(sampler);
+        auto phase = mei.medium->phase_function();
+        dr::masked(phase, !active) = nullptr;
+
+        // Lowest of the (up to) 2x2x2 cells overlapped by the lookup sphere
+        Vector3i base = dr::floor2int<Vector3i>((mei.p - m_radius) * m_inv_cell_size);
+        Vector3i cell = base;
+        UInt32 k = 0, index = 0, end = 0;
+        Spectrum result(0.f);
+
+        dr::Loop<Mask> loop("Photon Lookup", active, k, index, end, cell, result);
+
+        while (loop(active)) {
+            // Move on to the next cell once all photons of its bucket are visited
+            Mask next_cell = index >= end;
+            dr::masked(cell, next_cell) =
+                base + Vector3i(Int32(k & 1u), Int32((k >> 1) & 1u), Int32((k >> 2) & 1u));
+            UInt32 bucket = grid_hash(cell.x(), cell.y(), cell.z(), m_table_size - 1);
+            dr::masked(index, next_cell) =
+                dr::gather<UInt32>(m_cell_begin, bucket, next_cell);
+            dr::masked(end, next_cell) =
+                dr::gather<UInt32>(m_cell_begin, bucket + 1, next_cell);
+            dr::masked(k, next_cell) += 1;
+
+            /* Buckets are shared by colliding cells: skip photons of other
+               cells, which also avoids counting them twice */
+            Mask valid = active && index < end;
+            Point3f p = dr::gather<Point3f>(m_photon_p, index, valid);
+            valid &= dr::all(dr::eq(
+                dr::floor2int<Vector3i>(p * m_inv_cell_size), cell));
+            valid &= dr::squared_norm(p - mei.p) < dr::sqr(m_radius);
+
+            if (dr::any_or<true>(valid)) {
+                Vector3f d = dr::gather<Vector3f>(m_photon_d, index, valid);
+                UnpolarizedSpectrum photon_power =
+                    dr::gather<UnpolarizedSpectrum>(m_photon_power, index, valid);
+                auto [phase_val, phase_pdf] =
+                    phase->eval_pdf(phase_ctx, mei, -d, valid);
+                DRJIT_MARK_USED(phase_pdf);
+                dr::masked(result, valid) +=
+                    phase_val * depolarizer<Spectrum>(photon_power);
+            }
+
+            dr::masked(index, active && index < end) += 1;
+            active &= index < end || k < 8u;
+        }
+
+        return result * m_photon_scale;
+    }
+
+    /// Spatial hash of a grid cell
+    template <typename Int>
+    static dr::uint32_array_t<Int> grid_hash(const Int &x, const Int &y,
+                                             const Int &z, uint32_t mask) {
+        using UInt = dr::uint32_array_t<Int>;
+        return ((UInt(x) * 73856093u) ^ (UInt(y) * 19349663u) ^
+                (UInt(z) * 83492791u)) & mask;
+    }
+
+    //! @}
+    // =============================================================
+
+    bool supports_volume_emitters() const override { return true; }
+
+    std::string to_string() const override {
+        return tfm::format("VolumetricPhotonMapper[\n"
+                           "  max_depth = %u,\n"
+                           "  rr_depth = %u,\n"
+                           "  photon_count = %u,\n"
+                           "  photon_max_depth = %u,\n"
+                           "  passes = %u,\n"
+                           "  radius = %f,\n"
+                           "  alpha = %f\n"
+                           "]",
+                           m_max_depth, m_rr_depth, m_photon_count,
+                           m_photon_max_depth, m_passes, m_initial_radius,
+                           m_alpha);
+    }
+
+    MI_DECLARE_CLASS()
+private:
+    /// Number of channels of the stored photon power
+    static constexpr size_t Channels = dr::array_size_v<UnpolarizedSpectrum>;
+
+    uint32_t m_photon_count;
+    uint32_t m_photon_max_depth;
+    uint32_t m_passes;
+    ScalarFloat m_initial_radius;
+    ScalarFloat m_alpha;
+
+    /// Lookup radius of the current pass and inverse size of the grid cells
+    ScalarFloat m_radius = 0.f;
+    ScalarFloat m_inv_cell_size = 0.f;
+    /// Normalization of the density estimate (photon paths and lookup volume)
+    ScalarFloat m_photon_scale = 0.f;
+
+    uint32_t m_stored_photons = 0;
+    uint32_t m_table_size = 1;
+    /// First photon of each hash table bucket (with a final sentinel)
+    UInt32Storage m_cell_begin;
+    /// Positions, travel directions and power of the photons, sorted by bucket
+    FloatStorage m_photon_p, m_photon_d, m_photon_power;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(VolumetricPhotonMapper, MonteCarloIntegrator);
+MI_EXPORT_PLUGIN(VolumetricPhotonMapper, "Volumetric Photon Mapper integrator");
+NAMESPACE_END(mitsuba)
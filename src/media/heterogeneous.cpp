@@ -1,7 +1,10 @@
+#include <mitsuba/core/distr_1d.h>
 #include <mitsuba/core/frame.h>
 #include <mitsuba/core/properties.h>
 #include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/util.h>
 #include <mitsuba/core/warp.h>
+#include <mitsuba/render/emitter.h>
 #include <mitsuba/render/interaction.h>
 #include <mitsuba/render/medium.h>
 #include <mitsuba/render/phase.h>
@@ -38,6 +41,37 @@ Heterogeneous medium (:monosp:`heterogeneous`)
      units, or to simply tweak the density of the medium. (Default: 1)
    - |exposed|
 
+ * - radiance
+   - |float|, |spectrum| or |volume|
+   - Optional radiance emitted by the medium. The emission term of the
+     radiative transfer equation is the product of this radiance and the
+     absorption coefficient :math:`\sigma_a = \sigma_t (1 - \alpha)`. When
+     specified, the medium precomputes an emission-weighted distribution over
+     the voxels of :paramtype:`sigma_t`, and the scene samples points inside
+     the emitting region directly through a :ref:`volume emitter
+     <emitter-volumelight>`. (Default: none)
+   - |exposed|, |differentiable|
+
+ * - majorant_resolution_factor
+   - |int|
+   - When set to a value :math:`k > 0`, the medium builds a coarse supergrid of
+     local majorants in which each cell bounds :math:`k^3` voxels of
+     :paramtype:`sigma_t`. Free-flight distances are then sampled by walking
+     the supergrid with a 3D-DDA, which strongly reduces the number of null
+     collisions in sparse volumes. Blocks of :math:`4^3` empty supergrid cells
+     are skipped in a single traversal step. A value of 0 uses a single global
+     majorant. (Default: the block size of the empty space tracked by
+     :paramtype:`sigma_t`, see below)
+
+ * - fuse_volumes
+   - |bool|
+   - Pack :paramtype:`sigma_t`, :paramtype:`albedo` and :paramtype:`radiance`
+     into a single texture when they are grids of matching resolution,
+     placement and interpolation modes. The packed texture is a copy of the
+     voxel data, since the nested volumes keep their own storage (e.g. for
+     differentiation), hence disabling this option halves the memory used by
+     these grids at the cost of slower lookups. (Default: |true|)
+
  * - sample_emitters
    - |bool|
    - Flag to specify whether shadow rays should be cast from inside the volume (Default: |true|)
@@ -68,6 +102,27 @@ meters and the coefficients are in inverse millimeters, set scale to 1000.
 Both the albedo and the extinction coefficient can either be constant or textured,
 and both parameters are allowed to be spectrally varying.
 
+When :paramtype:`sigma_t`, :paramtype:`albedo` and (if present)
+:paramtype:`radiance` are :ref:`grid volumes <volume-gridvolume>` with the same
+resolution, transformation and filter/wrap modes, the medium interleaves their
+channels in one texture. A single fetch then returns the extinction, the albedo
+and the emission at a collision, which roughly halves the memory traffic of
+evaluating the medium. The nested volumes remain the source of truth: the
+packed texture is rebuilt (differentiably) whenever their parameters change.
+The packing is skipped for data that is converted during lookups, e.g.
+spectrally upsampled RGB volumes.
+
+Rays are clipped to the region where the extinction volume is nonzero (see
+``Volume::occupied_bbox()``). For instance, a :ref:`grid volume <volume-gridvolume>`
+that clamps lookups at its boundary tracks this region in an occupancy bitmask,
+so that empty margins around sparse data never cause null collisions. Empty
+space between disjoint regions is only skipped by the majorant supergrid: when
+:paramtype:`majorant_resolution_factor` is not specified and the extinction
+volume contains empty bricks (see ``Volume::empty_space_block_size()``, e.g.
+:math:`8^3` voxels of a :ref:`grid <volume-gridvolume>` or :ref:`sparse grid
+<volume-sparsegridvolume>` volume), the supergrid is built with one cell per
+brick. Setting the factor to 0 explicitly disables it.
+
 .. tabs::
     .. code-tab:: xml
         :name: lst-heterogeneous
@@ -149,8 +204,11 @@ template <typename Float, typename Spectrum>
 class HeterogeneousMedium final : public Medium<Float, Spectrum> {
 public:
     MI_IMPORT_BASE(Medium, m_is_homogeneous, m_has_spectral_extinction,
-                    m_phase_function)
+                    m_is_emitter, m_phase_function, has_majorant_grid,
+                    update_majorant_grid, eval_majorant_grid, m_id, m_emitter)
     MI_IMPORT_TYPES(Scene, Sampler, Texture, Volume)
+    using FloatStorage = DynamicBuffer<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
 
     HeterogeneousMedium(const Properties &props) : Base(props) {
         m_is_homogeneous = false;
@@ -161,64 +219,397 @@ public:
         m_has_spectral_extinction = props.get<bool>("has_spectral_extinction", true);
 
         m_max_density = dr::opaque<Float>(m_scale * m_sigmat->max());
+        m_min_density = dr::opaque<Float>(m_scale * m_sigmat->min());
+
+        // By default, the supergrid follows the empty space of the volume
+        m_auto_majorant_factor = !props.has_property("majorant_resolution_factor");
+        int majorant_factor = props.get<int>("majorant_resolution_factor", 0);
+        if (majorant_factor < 0)
+            Throw("\"majorant_resolution_factor\" must be non-negative!");
+        m_majorant_factor = (uint32_t) majorant_factor;
+        update_majorant_grid(m_sigmat.get(), m_scale, majorant_factor());
+        m_occupied_bbox = m_sigmat->occupied_bbox();
+
+        if (props.has_property("radiance")) {
+            m_radiance = props.volume<Volume>("radiance");
+            m_is_emitter = true;
+            update_emission_distribution();
+        }
+
+        m_fuse_volumes = props.get<bool>("fuse_volumes", true);
+        update_fused_volume();
 
         dr::set_attr(this, "is_homogeneous", m_is_homogeneous);
         dr::set_attr(this, "has_spectral_extinction", m_has_spectral_extinction);
+        dr::set_attr(this, "is_emitter", m_is_emitter);
     }
 
     void traverse(TraversalCallback *callback) override {
         callback->put_parameter("scale", m_scale,        +ParamFlags::NonDifferentiable);
         callback->put_object("albedo",   m_albedo.get(), +ParamFlags::Differentiable);
         callback->put_object("sigma_t",  m_sigmat.get(), +ParamFlags::Differentiable);
+        if (m_radiance)
+            callback->put_object("radiance", m_radiance.get(), +ParamFlags::Differentiable);
         Base::traverse(callback);
     }
 
     void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
         m_max_density = dr::opaque<Float>(m_scale * m_sigmat->max());
+        m_min_density = dr::opaque<Float>(m_scale * m_sigmat->min());
+        update_majorant_grid(m_sigmat.get(), m_scale, majorant_factor());
+        m_occupied_bbox = m_sigmat->occupied_bbox();
+        if (m_radiance) {
+            update_emission_distribution();
+            // Let the volume emitter refresh its power-based sampling weight
+            if (m_emitter)
+                m_emitter->parameters_changed({ "medium" });
+        }
+        update_fused_volume();
     }
 
     UnpolarizedSpectrum
-    get_majorant(const MediumInteraction3f & /* mi */,
+    get_majorant(const MediumInteraction3f &mi,
                  Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+        if (has_majorant_grid())
+            return eval_majorant_grid(mi.p, active);
         return m_max_density;
     }
 
+    UnpolarizedSpectrum
+    get_control_extinction(const MediumInteraction3f & /* mi */,
+                           Mask /* active */) const override {
+        return m_min_density;
+    }
+
     std::tuple<UnpolarizedSpectrum, UnpolarizedSpectrum, UnpolarizedSpectrum>
     get_scattering_coefficients(const MediumInteraction3f &mi,
                                 Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
 
-        auto sigmat = m_scale * m_sigmat->eval(mi, active);
+        UnpolarizedSpectrum sigmat, albedo;
+        if (m_fused) {
+            Float values[MaxFusedChannels];
+            eval_fused(mi.p, values, active);
+            sigmat = m_scale * fused_spectrum(values, 0);
+            albedo = fused_spectrum(values, 1);
+        } else {
+            sigmat = m_scale * m_sigmat->eval_filtered(mi, mi.footprint, active);
+            albedo = m_albedo->eval_filtered(mi, mi.footprint, active);
+        }
+
         if (has_flag(m_phase_function->flags(), PhaseFunctionFlags::Microflake))
             sigmat *= m_phase_function->projected_area(mi, active);
 
-        auto sigmas = sigmat * m_albedo->eval(mi, active);
+        auto sigmas = sigmat * albedo;
         auto sigman = m_max_density - sigmat;
         return { sigmas, sigman, sigmat };
     }
 
+    UnpolarizedSpectrum get_radiance(const MediumInteraction3f &mi,
+                                     Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+        if (!m_radiance)
+            return 0.f;
+
+        // Emission is restricted to the support of the extinction volume
+        active &= m_sigmat->bbox().contains(mi.p);
+        if (m_fused) {
+            Float values[MaxFusedChannels];
+            eval_fused(mi.p, values, active);
+            return fused_spectrum(values, 2) & active;
+        }
+        return m_radiance->eval(mi, active) & active;
+    }
+
+    std::pair<Point3f, Float> sample_emission(const Point3f &sample,
+                                              Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::MediumSample, active);
+        if (m_emission_distr.empty())
+            return { dr::zeros<Point3f>(), 0.f };
+
+        auto [index, u] = m_emission_distr.sample_reuse(sample.x(), active);
+
+        uint32_t res_x = (uint32_t) m_emission_res.x(),
+                 res_y = (uint32_t) m_emission_res.y();
+        UInt32 ix = index % res_x,
+               iy = (index / res_x) % res_y,
+               iz = index / (res_x * res_y);
+
+        Point3f p_local = Point3f(Float(ix) + u, Float(iy) + sample.y(),
+                                  Float(iz) + sample.z()) /
+                          ScalarVector3f(m_emission_res);
+
+        Float pdf = m_emission_distr.eval_pmf_normalized(index, active) *
+                    m_emission_pdf_scale;
+
+        return { m_emission_to_world * p_local, pdf & active };
+    }
+
+    Float pdf_emission(const Point3f &p, Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::MediumEvaluate, active);
+        if (m_emission_distr.empty())
+            return 0.f;
+
+        Point3f p_local = m_emission_to_local * p;
+        active &= dr::all((p_local >= 0.f) && (p_local <= 1.f));
+
+        Vector3i cell = dr::clamp(
+            dr::floor2int<Vector3i>(p_local * ScalarVector3f(m_emission_res)),
+            0, m_emission_res - 1);
+        UInt32 index = UInt32(
+            (cell.z() * m_emission_res.y() + cell.y()) * m_emission_res.x() +
+            cell.x());
+
+        return m_emission_distr.eval_pmf_normalized(index, active) *
+               m_emission_pdf_scale & active;
+    }
+
+    ScalarFloat emission_power() const override { return m_emission_power; }
+
     std::tuple<Mask, Float, Float>
     intersect_aabb(const Ray3f &ray) const override {
-        return m_sigmat->bbox().ray_intersect(ray);
+        if (m_occupied_bbox == ScalarBoundingBox3f(ScalarPoint3f(0.f), ScalarPoint3f(1.f)))
+            return m_sigmat->bbox().ray_intersect(ray);
+
+        /* Clip the ray to the region where the extinction is nonzero. The
+           affine transformation preserves the ray parameterization. */
+        return BoundingBox3f(m_occupied_bbox).ray_intersect(m_sigmat->to_local() * ray);
     }
 
     std::string to_string() const override {
         std::ostringstream oss;
         oss << "HeterogeneousMedium[" << std::endl
-            << "  albedo  = " << string::indent(m_albedo) << std::endl
-            << "  sigma_t = " << string::indent(m_sigmat) << std::endl
-            << "  scale   = " << string::indent(m_scale) << std::endl
+            << "  albedo   = " << string::indent(m_albedo) << std::endl
+            << "  sigma_t  = " << string::indent(m_sigmat) << std::endl
+            << "  radiance = " << string::indent(m_radiance) << std::endl
+            << "  scale    = " << string::indent(m_scale) << "," << std::endl
+            << "  majorant_resolution_factor = " << majorant_factor() << std::endl
             << "]";
         return oss.str();
     }
 
     MI_DECLARE_CLASS()
+private:
+    /// Resolution factor of the majorant supergrid (zero: global majorant)
+    uint32_t majorant_factor() const {
+        return m_auto_majorant_factor ? m_sigmat->empty_space_block_size()
+                                      : m_majorant_factor;
+    }
+
+    /**
+     * \brief Pack the nested volumes into a single texture if they are grids
+     * with compatible layouts
+     *
+     * The channels of \c sigma_t, \c albedo and \c radiance are interleaved
+     * per voxel. The texture is assembled with gathers from the volume data,
+     * so that gradients propagate back to the nested volumes.
+     */
+    void update_fused_volume() {
+        m_fused = false;
+        m_fused_texture = Texture3f();
+        if (!m_fuse_volumes)
+            return;
+
+        const Volume *volumes[3] = { m_sigmat.get(), m_albedo.get(),
+                                     m_radiance.get() };
+        const TensorXf *data[3] = { nullptr, nullptr, nullptr };
+        dr::FilterMode filter_mode = dr::FilterMode::Linear;
+        dr::WrapMode wrap_mode = dr::WrapMode::Clamp;
+        bool accel = true;
+        size_t count = m_radiance ? 3 : 2, channels = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            dr::FilterMode filter_mode_i;
+            dr::WrapMode wrap_mode_i;
+            bool accel_i = true;
+            data[i] = volumes[i]->voxel_data(filter_mode_i, wrap_mode_i, accel_i);
+            if (!data[i] || data[i]->ndim() != 4)
+                return;
+
+            // Spectral variants only support single-channel grids here
+            size_t c = data[i]->shape(3);
+            if (c != 1 && (c != 3 || is_spectral_v<Spectrum>))
+                return;
+
+            if (i == 0) {
+                filter_mode = filter_mode_i;
+                wrap_mode = wrap_mode_i;
+            } else if (filter_mode_i != filter_mode || wrap_mode_i != wrap_mode ||
+                       !(volumes[i]->to_local() == volumes[0]->to_local()) ||
+                       data[i]->shape(0) != data[0]->shape(0) ||
+                       data[i]->shape(1) != data[0]->shape(1) ||
+                       data[i]->shape(2) != data[0]->shape(2)) {
+                return;
+            }
+
+            // Hardware interpolation is only used if all volumes allow it
+            accel &= accel_i;
+            m_fused_offset[i] = (uint32_t) channels;
+            m_fused_channels[i] = (uint32_t) c;
+            channels += c;
+        }
+
+        size_t voxels = data[0]->shape(0) * data[0]->shape(1) * data[0]->shape(2);
+        UInt32Storage index = dr::arange<UInt32Storage>(voxels * channels),
+                      voxel = index / (uint32_t) channels,
+                      channel = index - voxel * (uint32_t) channels;
+
+        FloatStorage values = dr::zeros<FloatStorage>(voxels * channels);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t offset = m_fused_offset[i], c = m_fused_channels[i];
+            auto mask = (channel >= offset) && (channel < offset + c);
+            dr::masked(values, mask) = dr::gather<FloatStorage>(
+                data[i]->array(), voxel * c + (channel - offset), mask);
+        }
+
+        size_t shape[4] = { data[0]->shape(0), data[0]->shape(1),
+                            data[0]->shape(2), channels };
+        m_fused_texture = Texture3f(TensorXf(values, 4, shape), accel, accel,
+                                    filter_mode, wrap_mode);
+        m_fused_to_local = m_sigmat->to_local();
+        m_fused = true;
+
+        Log(Debug, "Medium \"%s\": packed %u volumes into a %u-channel texture (%s)",
+            m_id, (uint32_t) count, (uint32_t) channels,
+            util::mem_string(voxels * channels * sizeof(ScalarFloat)));
+    }
+
+    /// Fetch all channels of the packed texture at \c p
+    MI_INLINE void eval_fused(const Point3f &p, Float *out, Mask active) const {
+        m_fused_texture.eval(m_fused_to_local * p, out, active);
+    }
+
+    /// Extract the value of the i-th packed volume from the fetched channels
+    MI_INLINE UnpolarizedSpectrum fused_spectrum(const Float *values,
+                                                 size_t i) const {
+        const Float *v = values + m_fused_offset[i];
+        if (m_fused_channels[i] == 1)
+            return v[0];
+
+        if constexpr (is_monochromatic_v<Spectrum>)
+            return luminance(Color3f(v[0], v[1], v[2]));
+        else if constexpr (!is_spectral_v<Spectrum>)
+            return Color3f(v[0], v[1], v[2]);
+        else
+            return v[0]; // unreachable: not packed in spectral variants
+    }
+
+    /**
+     * \brief Precompute the discrete distribution used to sample emission
+     *
+     * Voxels are laid out in the local frame of \c sigma_t and weighted by
+     * the largest neighboring value of <tt>sigma_a * radiance</tt>, so that
+     * every region reached by the trilinear interpolant has nonzero density.
+     */
+    void update_emission_distribution() {
+        m_emission_res = dr::maximum(m_sigmat->resolution(), m_radiance->resolution());
+        m_emission_to_local = m_sigmat->to_local();
+        m_emission_to_world = m_emission_to_local.inverse();
+
+        ScalarVector3i res = m_emission_res;
+        size_t size = (size_t) dr::prod(res);
+
+        // Evaluate the emission at all voxel centers
+        std::vector<ScalarFloat> values(size);
+        if constexpr (dr::is_jit_v<Float>) {
+            uint32_t res_x = (uint32_t) res.x(), res_y = (uint32_t) res.y();
+            UInt32 index = dr::arange<UInt32>((uint32_t) size);
+            Point3f p(Float(index % res_x), Float((index / res_x) % res_y),
+                      Float(index / (res_x * res_y)));
+            Float weights = emission_weight(p + .5f);
+            auto &&data = dr::migrate(weights, AllocType::Host);
+            dr::sync_thread();
+            memcpy(values.data(), data.data(), size * sizeof(ScalarFloat));
+        } else {
+            size_t index = 0;
+            for (int z = 0; z < res.z(); ++z)
+                for (int y = 0; y < res.y(); ++y)
+                    for (int x = 0; x < res.x(); ++x)
+                        values[index++] = emission_weight(
+                            Point3f((ScalarFloat) x, (ScalarFloat) y, (ScalarFloat) z) + .5f);
+        }
+
+        // Dilate by one voxel to cover the footprint of trilinear lookups
+        std::vector<ScalarFloat> weights(size, 0.f);
+        double total = 0.0, emitted = 0.0;
+        for (int z = 0; z < res.z(); ++z) {
+            for (int y = 0; y < res.y(); ++y) {
+                for (int x = 0; x < res.x(); ++x) {
+                    ScalarFloat value = 0.f;
+                    for (int dz = std::max(z - 1, 0); dz <= std::min(z + 1, res.z() - 1); ++dz)
+                        for (int dy = std::max(y - 1, 0); dy <= std::min(y + 1, res.y() - 1); ++dy)
+                            for (int dx = std::max(x - 1, 0); dx <= std::min(x + 1, res.x() - 1); ++dx)
+                                value = dr::maximum(
+                                    value, values[(dz * res.y() + dy) * res.x() + dx]);
+                    weights[(z * res.y() + y) * res.x() + x] = value;
+                    total += value;
+                    emitted += values[(z * res.y() + y) * res.x() + x];
+                }
+            }
+        }
+
+        if (total == 0.0) {
+            Log(Warn, "HeterogeneousMedium: the \"radiance\" volume does not "
+                      "produce any emission, disabling emission sampling.");
+            m_emission_distr = DiscreteDistribution<Float>();
+            m_emission_power = 0.f;
+            return;
+        }
+
+        m_emission_distr = DiscreteDistribution<Float>(weights.data(), size);
+
+        // Converts a voxel probability into a density per unit volume
+        m_emission_pdf_scale = (ScalarFloat) size *
+                               dr::abs(dr::det(m_emission_to_local.matrix));
+
+        // Isotropic emission integrated over all voxels and directions
+        m_emission_power = (ScalarFloat) (4.0 * dr::Pi<double> * emitted /
+                                          m_emission_pdf_scale);
+    }
+
+    /// Largest channel of <tt>sigma_a * radiance</tt> at a voxel of the emission grid
+    Float emission_weight(const Point3f &p_voxel) const {
+        MediumInteraction3f mi = dr::zeros<MediumInteraction3f>();
+        mi.p = m_emission_to_world * (p_voxel / ScalarVector3f(m_emission_res));
+        if constexpr (is_spectral_v<Spectrum>) {
+            // Probe the visible range at a few representative wavelengths
+            for (size_t i = 0; i < dr::array_size_v<UnpolarizedSpectrum>; ++i)
+                mi.wavelengths[i] =
+                    MI_CIE_MIN + (MI_CIE_MAX - MI_CIE_MIN) *
+                    (i + .5f) / dr::array_size_v<UnpolarizedSpectrum>;
+        }
+
+        UnpolarizedSpectrum sigmat = m_scale * m_sigmat->eval(mi),
+                            sigmaa = sigmat * (1.f - m_albedo->eval(mi));
+        return dr::max(dr::maximum(sigmaa * m_radiance->eval(mi), 0.f));
+    }
+
 private:
     ref<Volume> m_sigmat, m_albedo;
     ScalarFloat m_scale;
-
-    Float m_max_density;
+    uint32_t m_majorant_factor;
+    bool m_auto_majorant_factor;
+
+    /// Region of the extinction volume (in local coordinates) that is not empty
+    ScalarBoundingBox3f m_occupied_bbox;
+
+    /// Packed texture interleaving sigma_t, albedo and radiance
+    static constexpr size_t MaxFusedChannels = 9;
+    bool m_fuse_volumes, m_fused = false;
+    Texture3f m_fused_texture;
+    ScalarTransform4f m_fused_to_local;
+    uint32_t m_fused_offset[3] = { 0, 0, 0 }, m_fused_channels[3] = { 0, 0, 0 };
+
+    Float m_max_density, m_min_density;
+
+    /// Emission and the distribution used to sample it
+    ref<Volume> m_radiance;
+    DiscreteDistribution<Float> m_emission_distr;
+    ScalarVector3i m_emission_res;
+    ScalarTransform4f m_emission_to_local, m_emission_to_world;
+    ScalarFloat m_emission_pdf_scale = 0.f;
+    ScalarFloat m_emission_power = 0.f;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(HeterogeneousMedium, Medium)
@@ -0,0 +1,471 @@
+import math
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def create_medium(majorant_resolution_factor=0):
+    # Sparse density: a dense blob in one corner, empty space elsewhere
+    grid = dr.zeros(mi.TensorXf, [16, 16, 16, 1])
+    grid[2:6, 2:6, 2:6, 0] = 8.0
+    grid[10:12, 8:14, 3:5, 0] = 2.0
+
+    return mi.load_dict({
+        'type': 'heterogeneous',
+        'albedo': 0.8,
+        'sigma_t': {
+            'type': 'gridvolume',
+            'data': grid,
+            'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+        },
+        'majorant_resolution_factor': majorant_resolution_factor,
+    })
+
+
+def create_cube_scene(medium, integrator, emitter=None, origin=(0, 0, 4),
+                      target=(0, 0, 0), to_world=None, **kwargs):
+    """
+    Scene with a cube of ``medium`` inside a null boundary, seen by a
+    low-resolution perspective camera and lit by ``emitter`` (a constant
+    environment by default). Further shapes can be passed as keyword arguments.
+    """
+    cube = {'type': 'cube', 'bsdf': {'type': 'null'}, 'interior': medium}
+    if to_world is not None:
+        cube['to_world'] = to_world
+
+    return mi.load_dict({
+        'type': 'scene',
+        'integrator': integrator,
+        'sensor': {
+            'type': 'perspective',
+            'to_world': mi.ScalarTransform4f.look_at(
+                origin=origin, target=target, up=(0, 1, 0)),
+            'film': {'type': 'hdrfilm', 'width': 8, 'height': 8,
+                     'rfilter': {'type': 'box'}},
+        },
+        'emitter': emitter if emitter is not None else {'type': 'constant'},
+        'cube': cube,
+        **kwargs
+    })
+
+
+def test01_majorant_grid_bounds(variants_all_rgb):
+    medium = create_medium(majorant_resolution_factor=4)
+    assert medium.has_majorant_grid()
+
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, 4096)
+
+    # Rays from random origins towards the volume center
+    o = 3 * mi.warp.square_to_uniform_sphere(sampler.next_2d())
+    ray = mi.Ray3f(o, dr.normalize(mi.Vector3f(sampler.next_2d().x - 0.5, 0, 0) - o))
+    mei = medium.sample_interaction(ray, sampler.next_1d(), 0, True)
+
+    valid = mei.is_valid()
+    assert dr.any(valid)
+
+    # Local majorants bound the extinction and never exceed the global one
+    sigma_t = mei.sigma_t[0]
+    majorant = mei.combined_extinction[0]
+    assert dr.all(~valid | (sigma_t <= majorant + 1e-5))
+    assert dr.all(~valid | (majorant <= 8.0 + 1e-5))
+    assert dr.allclose(dr.select(valid, mei.sigma_n[0], 0),
+                       dr.select(valid, majorant - sigma_t, 0))
+
+
+@pytest.mark.slow
+def test02_majorant_grid_unbiased(variants_vec_backends_once_rgb):
+    def render(factor):
+        scene = create_cube_scene(create_medium(factor),
+                                  {'type': 'volpath', 'max_depth': 8})
+        return mi.render(scene, spp=1024, seed=factor)
+
+    reference = render(0)
+    image = render(4)
+    assert dr.allclose(dr.mean(image.array), dr.mean(reference.array), rtol=2e-2)
+
+
+def create_emissive_medium(albedo=0.0, sample_emitters=True):
+    radiance = dr.zeros(mi.TensorXf, [8, 8, 8, 1])
+    radiance[3:5, 3:5, 3:5, 0] = 4.0
+
+    return mi.load_dict({
+        'type': 'heterogeneous',
+        'albedo': albedo,
+        'sigma_t': 0.5,
+        'radiance': {
+            'type': 'gridvolume',
+            'data': radiance,
+            'filter_type': 'nearest',
+        },
+        'sample_emitters': sample_emitters,
+    })
+
+
+def test03_emission_sampling(variants_vec_backends_once_rgb):
+    medium = create_emissive_medium()
+    assert medium.is_emitter()
+
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, 1024)
+    sample = mi.Point3f(sampler.next_1d(), sampler.next_1d(), sampler.next_1d())
+    p, pdf = medium.sample_emission(sample)
+
+    # Samples land in (or next to) the emitting voxels and match pdf_emission()
+    assert dr.all(pdf > 0)
+    assert dr.all((p >= 2 / 8) & (p <= 6 / 8))
+    assert dr.allclose(medium.pdf_emission(p), pdf)
+
+    mei = dr.zeros(mi.MediumInteraction3f)
+    mei.p = mi.Point3f(0.5)
+    assert dr.allclose(medium.get_radiance(mei)[0], 4.0)
+    mei.p = mi.Point3f(0.1)
+    assert dr.allclose(medium.get_radiance(mei)[0], 0.0)
+
+
+@pytest.mark.slow
+def test04_emission_render(variants_vec_backends_once_rgb):
+    def render(albedo, sample_emitters):
+        scene = mi.load_dict({
+            'type': 'scene',
+            'integrator': {'type': 'volpath', 'max_depth': 16},
+            'sensor': {
+                'type': 'orthographic',
+                'to_world': mi.ScalarTransform4f.look_at(
+                    origin=(0.5, 0.5, 4), target=(0.5, 0.5, 0), up=(0, 1, 0)
+                ).scale(0.1),
+                'film': {'type': 'hdrfilm', 'width': 4, 'height': 4,
+                         'rfilter': {'type': 'box'}},
+            },
+            'cube': {
+                'type': 'cube',
+                'to_world': mi.ScalarTransform4f.translate(0.5).scale(0.5),
+                'bsdf': {'type': 'null'},
+                'interior': create_emissive_medium(albedo, sample_emitters),
+            },
+        })
+        return dr.mean(mi.render(scene, spp=1024).array)
+
+    # Purely absorbing: emission of a slab of thickness 1/4 in the center,
+    # attenuated by the remaining 3/8 of the medium towards the sensor
+    expected = 4.0 * (1.0 - math.exp(-0.5 * 0.25)) * math.exp(-0.5 * 0.375)
+    assert dr.allclose(render(0.0, False), expected, rtol=2e-2)
+
+    # Emission sampling at scattering events must not change the estimate
+    assert dr.allclose(render(0.8, True), render(0.8, False), rtol=2e-2)
+
+
+def test05_volume_emitter(variants_vec_backends_once_rgb):
+    medium = create_emissive_medium()
+    scene = mi.load_dict({
+        'type': 'scene',
+        'integrator': {'type': 'volpath'},
+        'cube': {
+            'type': 'cube',
+            'to_world': mi.ScalarTransform4f.translate(0.5).scale(0.5),
+            'bsdf': {'type': 'null'},
+            'interior': medium,
+        },
+    })
+
+    # The scene samples the medium through a volume emitter weighted by its
+    # power: sigma_a * radiance = 2 over 8 voxels of volume 1 / 512
+    emitters = scene.emitters()
+    assert len(emitters) == 1
+    emitter = emitters[0]
+    assert mi.has_flag(emitter.flags(), mi.EmitterFlags.Volume)
+    assert medium.emitter() is not None
+    assert dr.allclose(emitter.sampling_weight(), math.pi / 8, rtol=1e-4)
+
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, 1024)
+    it = dr.zeros(mi.Interaction3f)
+    it.p = mi.Point3f(0.5, 0.5, 3)
+    ds, weight = scene.sample_emitter_direction(it, sampler.next_2d(), False)
+
+    assert dr.all(ds.pdf > 0)
+    assert dr.allclose(scene.pdf_emitter_direction(it, ds), ds.pdf)
+
+    # Emitted radiance is 2 inside the emitting voxels (and zero in the
+    # dilated border of the sampling distribution)
+    value = weight[0] * ds.pdf
+    assert dr.any(value > 0)
+    assert dr.allclose(dr.select(value > 0, value, 2.0), 2.0)
+
+
+@pytest.mark.slow
+def test06_volume_emitter_render(variants_vec_backends_once_rgb):
+    def render(dummy_weight):
+        scene = create_cube_scene(
+            create_emissive_medium(albedo=0.5),
+            {'type': 'volpath', 'max_depth': 8},
+            # Does not emit, but changes how often the volume emitter is sampled
+            emitter={
+                'type': 'point',
+                'position': [0, 10, 0],
+                'intensity': 0.0,
+                'sampling_weight': dummy_weight,
+            },
+            origin=(2, 3, 4), target=(0.5, 0, 0.5),
+            to_world=mi.ScalarTransform4f.translate(0.5).scale(0.5),
+            floor={
+                'type': 'rectangle',
+                'to_world': mi.ScalarTransform4f.translate([0.5, -0.1, 0.5])
+                                                .rotate([1, 0, 0], -90).scale(2),
+                'bsdf': {'type': 'diffuse'},
+            })
+        return dr.mean(mi.render(scene, spp=1024).array)
+
+    # Next event estimation and free-flight sampling of the emission are
+    # combined consistently regardless of the emitter selection probability
+    assert dr.allclose(render(1e-3), render(8.0), rtol=3e-2)
+
+
+def test07_control_extinction(variants_all_rgb):
+    # Homogeneous media use their extinction: shadow rays become exact
+    homogeneous = mi.load_dict({'type': 'homogeneous', 'sigma_t': 1.5})
+    mei = dr.zeros(mi.MediumInteraction3f)
+    mei.wi = mi.Vector3f(0, 0, 1)
+    assert dr.allclose(homogeneous.get_control_extinction(mei)[0], 1.5)
+
+    # Heterogeneous media use the minimum density of 'sigma_t'
+    grid = dr.full(mi.TensorXf, 0.5, [4, 4, 4, 1])
+    grid[1:3, 1:3, 1:3, 0] = 3.0
+    heterogeneous = mi.load_dict({
+        'type': 'heterogeneous',
+        'sigma_t': {'type': 'gridvolume', 'data': grid},
+        'scale': 2.0,
+    })
+    assert dr.allclose(heterogeneous.get_control_extinction(mei)[0], 1.0)
+
+
+@pytest.mark.slow
+def test08_shadow_ray_transmittance(variants_vec_backends_once_rgb):
+    def render(medium):
+        scene = create_cube_scene(
+            medium, {'type': 'volpath', 'max_depth': 4},
+            emitter={'type': 'point', 'position': [0, 0, 0.5], 'intensity': 1.0})
+        return dr.mean(mi.render(scene, spp=1024).array)
+
+    # Closed-form (homogeneous) and residual ratio tracking (heterogeneous)
+    # estimates of the same medium agree
+    homogeneous = mi.load_dict({
+        'type': 'homogeneous', 'albedo': 0.8, 'sigma_t': 1.5
+    })
+    heterogeneous = mi.load_dict({
+        'type': 'heterogeneous', 'albedo': 0.8,
+        'sigma_t': {
+            'type': 'gridvolume',
+            'data': dr.full(mi.TensorXf, 1.5, [4, 4, 4, 1]),
+            'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+        },
+    })
+    assert dr.allclose(render(heterogeneous), render(homogeneous), rtol=2e-2)
+
+
+def test09_occupied_bbox_clipping(variants_all_rgb):
+    medium = create_medium()
+
+    # The blobs occupy voxels [2, 5] along x: clip to their dilated bounds
+    ray = mi.Ray3f(mi.Point3f(-2, -0.5, -0.5), mi.Vector3f(1, 0, 0))
+    active, mint, maxt = medium.intersect_aabb(ray)
+    assert dr.all(active)
+    assert dr.allclose(mint, 1 + 1.5 / 8)
+    assert dr.allclose(maxt, 1 + 6.5 / 8)
+
+    # Rays that only cross empty space miss the medium entirely
+    ray = mi.Ray3f(mi.Point3f(-2, 0.9, 0.9), mi.Vector3f(1, 0, 0))
+    active, _, _ = medium.intersect_aabb(ray)
+    assert dr.none(active)
+
+
+def test10_fused_volumes(variants_all_rgb):
+    density = mi.TensorXf(dr.linspace(mi.Float, 0, 4, 64), [4, 4, 4, 1])
+    albedo = mi.TensorXf(dr.linspace(mi.Float, 0.2, 0.9, 192), [4, 4, 4, 3])
+    radiance = mi.TensorXf(dr.linspace(mi.Float, 1, 2, 64), [4, 4, 4, 1])
+
+    def load(fuse_volumes):
+        return mi.load_dict({
+            'type': 'heterogeneous',
+            'sigma_t': {'type': 'gridvolume', 'data': density},
+            'albedo': {'type': 'gridvolume', 'data': albedo},
+            'radiance': {'type': 'gridvolume', 'data': radiance},
+            'fuse_volumes': fuse_volumes,
+        })
+
+    fused, reference = load(True), load(False)
+
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, 256)
+    mei = dr.zeros(mi.MediumInteraction3f, 256)
+    mei.p = mi.Point3f(sampler.next_1d(), sampler.next_1d(), sampler.next_1d())
+    mei.wi = mi.Vector3f(0, 0, 1)
+    mei.sh_frame = mi.Frame3f(mei.wi)
+
+    def evaluate(medium):
+        sigma_s, _, sigma_t = medium.get_scattering_coefficients(mei)
+        return sigma_s, sigma_t, medium.get_radiance(mei)
+
+    # The packed texture reproduces the individual volume lookups
+    for a, b in zip(evaluate(fused), evaluate(reference)):
+        assert dr.allclose(a, b, rtol=1e-4, atol=1e-5)
+
+    # It follows updates of the nested volumes
+    params = mi.traverse(fused)
+    params['sigma_t.data'] = density * 2
+    params.update()
+    _, sigma_t, _ = fused.get_scattering_coefficients(mei)
+    assert dr.allclose(sigma_t, evaluate(reference)[1] * 2, rtol=1e-4, atol=1e-5)
+
+
+def test11_max_majorant_sampling(variants_all_rgb):
+    medium = mi.load_dict({
+        'type': 'homogeneous',
+        'sigma_t': {'type': 'rgb', 'value': [0.5, 2.0, 8.0]},
+        'albedo': 0.5,
+    })
+
+    # Channels beyond the channel count sample against the maximum majorant
+    ray = mi.Ray3f(mi.Point3f(0, 0, 0), mi.Vector3f(0, 0, 1))
+    mei = medium.sample_interaction(ray, 0.5, 0xFFFFFFFF, True)
+    assert dr.allclose(mei.combined_extinction, 8.0)
+    assert dr.allclose(mei.t, math.log(2) / 8.0)
+    assert dr.allclose(mei.sigma_n, [7.5, 6.0, 0.0])
+
+
+@pytest.mark.slow
+def test12_spectral_tracking(variants_vec_backends_once_rgb):
+    def render(spectral_tracking):
+        scene = create_cube_scene({
+            'type': 'heterogeneous',
+            'albedo': {'type': 'rgb', 'value': [0.9, 0.5, 0.2]},
+            'sigma_t': {
+                'type': 'gridvolume',
+                'data': mi.TensorXf(
+                    dr.tile(mi.Float(0.5, 2.0, 8.0), 64), [4, 4, 4, 3]),
+                'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+            },
+        }, {'type': 'volpath', 'max_depth': 16,
+            'spectral_tracking': spectral_tracking})
+        return mi.render(scene, spp=1024)
+
+    # Both collision estimators converge to the same image
+    reference, image = render(False), render(True)
+    index = dr.arange(mi.UInt32, 64) * 3
+    for c in range(3):
+        assert dr.allclose(dr.mean(dr.gather(mi.Float, image.array, index + c)),
+                           dr.mean(dr.gather(mi.Float, reference.array, index + c)),
+                           rtol=3e-2)
+
+
+def test13_footprint(variants_all_rgb):
+    medium = create_medium()
+
+    # The footprint grows linearly with the sampled distance
+    ray = mi.Ray3f(mi.Point3f(-2, -0.5, -0.5), mi.Vector3f(1, 0, 0))
+    mei = medium.sample_interaction(ray, 0.5, 0, True, footprint=0.1, spread=0.25)
+    assert dr.all(mei.is_valid())
+    assert dr.allclose(mei.footprint, 0.1 + 0.25 * mei.t)
+
+
+@pytest.mark.slow
+def test14_radiance_cache(variants_vec_backends_once_rgb):
+    def render(**kwargs):
+        scene = create_cube_scene({
+            'type': 'heterogeneous',
+            'albedo': 0.95,
+            'sigma_t': {
+                'type': 'gridvolume',
+                'data': mi.TensorXf(dr.full(mi.Float, 4.0, 64), [4, 4, 4, 1]),
+                'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+            },
+        }, {'type': 'volpath', 'max_depth': 64, **kwargs})
+        return mi.render(scene, spp=1024)
+
+    # Terminating deep paths into the cache only introduces a small bias
+    reference = render()
+    image = render(cache_depth=4, cache_resolution=8, cache_passes=64)
+    assert dr.allclose(dr.mean(image.array), dr.mean(reference.array), rtol=5e-2)
+
+
+def test15_volume_emitter_opt_in(variants_vec_backends_once_rgb):
+    def create(integrator, **kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'integrator': {'type': integrator},
+            'cube': {
+                'type': 'cube',
+                'to_world': mi.ScalarTransform4f.translate(0.5).scale(0.5),
+                'bsdf': {'type': 'null'},
+                'interior': create_emissive_medium(),
+            },
+            **kwargs
+        })
+
+    # Only integrators that collect the emission of media sample it
+    assert len(create('volpath').emitters()) == 1
+    assert len(create('volpathmis').emitters()) == 0
+    assert len(create('path').emitters()) == 0
+    assert len(create('volpath', volume_emitters=False).emitters()) == 0
+
+    # The sampling weight follows the emitted power of the medium
+    scene = create('volpath')
+    emitter = scene.emitters()[0]
+    params = mi.traverse(scene)
+    key = 'cube.interior_medium.radiance.data'
+    params[key] = params[key] * 2
+    params.update()
+    assert dr.allclose(emitter.sampling_weight(), math.pi / 4, rtol=1e-4)
+
+
+def test16_radiance_cache_sample_count(variants_vec_backends_once_rgb):
+    scene = mi.load_dict({
+        'type': 'scene',
+        'integrator': {'type': 'volpath', 'cache_depth': 2, 'cache_passes': 3,
+                       'samples_per_pass': 2},
+        'sensor': {
+            'type': 'perspective',
+            'film': {'type': 'hdrfilm', 'width': 4, 'height': 4},
+            'sampler': {'type': 'independent', 'sample_count': 4},
+        },
+        'cube': {
+            'type': 'cube',
+            'to_world': mi.ScalarTransform4f.translate([0, 0, 4]),
+            'bsdf': {'type': 'null'},
+            'interior': {'type': 'homogeneous', 'albedo': 0.9, 'sigma_t': 1.0},
+        },
+    })
+
+    # The training pass leaves the sample count of the sensor untouched
+    sampler = scene.sensors()[0].sampler()
+    for _ in range(2):
+        mi.render(scene)
+        assert sampler.sample_count() == 4
+
+
+def test17_empty_space_supergrid(variants_all_rgb):
+    # Two blobs in opposite corners: the occupied bounding box spans the grid
+    grid = dr.zeros(mi.TensorXf, [32, 32, 32, 1])
+    grid[2:6, 2:6, 2:6, 0] = 8.0
+    grid[26:30, 26:30, 26:30, 0] = 8.0
+
+    def load(**kwargs):
+        return mi.load_dict({
+            'type': 'heterogeneous',
+            'sigma_t': {
+                'type': 'gridvolume',
+                'data': grid,
+                'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+            },
+            **kwargs
+        })
+
+    # By default, the supergrid has one cell per brick of 8^3 voxels
+    medium, reference = load(), load(majorant_resolution_factor=0)
+    assert medium.has_majorant_grid() and not reference.has_majorant_grid()
+
+    # A ray through the empty bricks between the blobs only finds null
+    # collisions against the global majorant, and none with the supergrid
+    ray = mi.Ray3f(mi.Point3f(-2, 0.03, 0.03), mi.Vector3f(1, 0, 0))
+    assert dr.all(reference.sample_interaction(ray, 0.5, 0, True).is_valid())
+    assert dr.none(medium.sample_interaction(ray, 0.5, 0, True).is_valid())
@@ -0,0 +1,126 @@
+import math
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+from mitsuba.test.media import SCENES, create_scene, model_collision_statistics
+
+
+def channel_means(image):
+    index = dr.arange(mi.UInt32, dr.prod(image.shape[:2])) * image.shape[2]
+    return [dr.mean(dr.gather(mi.Float, image.array, index + c))[0]
+            for c in range(image.shape[2])]
+
+
+def create_absorbing_slab(integrator, heterogeneous):
+    if heterogeneous:
+        # Denser voxels outside of the view raise the majorant, so that
+        # free-flight sampling goes through null collisions
+        grid = dr.full(mi.TensorXf, 8.0, [1, 4, 4, 1])
+        grid[0, 1:3, 1:3, 0] = 2.0
+        sigma_t = {
+            'type': 'gridvolume',
+            'data': grid,
+            'filter_type': 'nearest',
+            'to_world': mi.ScalarTransform4f.translate([-2, -2, -0.25]).scale([4, 4, 0.5]),
+        }
+    else:
+        sigma_t = 2.0
+
+    return mi.load_dict({
+        'type': 'scene',
+        'integrator': {'type': integrator},
+        'sensor': {
+            'type': 'orthographic',
+            'to_world': mi.ScalarTransform4f.look_at(
+                origin=(0, 0, 4), target=(0, 0, 0), up=(0, 1, 0)).scale([0.9, 0.9, 1]),
+            'film': {'type': 'hdrfilm', 'width': 8, 'height': 8,
+                     'rfilter': {'type': 'box'}},
+        },
+        'emitter': {'type': 'constant'},
+        'slab': {
+            'type': 'cube',
+            'to_world': mi.ScalarTransform4f.scale([2, 2, 0.25]),
+            'bsdf': {'type': 'null'},
+            'interior': {
+                'type': 'heterogeneous' if heterogeneous else 'homogeneous',
+                'albedo': 0.0,
+                'sigma_t': sigma_t,
+            },
+        },
+    })
+
+
+def test01_model_collision_statistics(variants_vec_backends_once_rgb):
+    # The majorant of a homogeneous medium is tight
+    scene = mi.load_dict(create_scene('slab'))
+    real, null = model_collision_statistics(scene)
+    assert real > 0 and null == 0
+
+    # Null collisions fill the empty space around the cloud
+    scene = mi.load_dict(create_scene('cloud'))
+    real, null = model_collision_statistics(scene)
+    assert real > 0 and null > 0
+
+
+@pytest.mark.parametrize('integrator', ['volpath', 'volpathmis'])
+@pytest.mark.parametrize('heterogeneous', [False, True])
+def test02_slab_transmittance(variants_vec_backends_once_rgb, integrator,
+                              heterogeneous):
+    scene = create_absorbing_slab(integrator, heterogeneous)
+    image = mi.render(scene, spp=1024)
+
+    # Beer-Lambert law through the slab (thickness 0.5). Every camera sample
+    # is either 0 or 1, hence the 64 * 1024 samples leave a relative standard
+    # deviation of sqrt((1 - ref) / (ref * 65536)) ~= 0.5% on the means.
+    ref = math.exp(-2.0 * 0.5)
+    for mean in channel_means(image):
+        assert abs(mean - ref) < 2e-2 * ref
+
+
+@pytest.mark.slow
+@pytest.mark.parametrize('name', SCENES)
+def test03_volpath_volpathmis(variants_vec_backends_once_rgb, name):
+    # Both integrators converge to the same image
+    reference = mi.render(mi.load_dict(create_scene(name, 'volpath')), spp=2048)
+    image = mi.render(mi.load_dict(create_scene(name, 'volpathmis')), spp=2048)
+
+    for a, b in zip(channel_means(image), channel_means(reference)):
+        assert abs(a - b) < 3e-2 * max(b, 1e-2)
+
+
+@pytest.mark.slow
+@pytest.mark.parametrize('name', ['cloud', 'subsurface'])
+def test04_spectral_tracking(variants_vec_backends_once_rgb, name):
+    # Sampling against the maximum majorant does not change the result
+    reference = mi.render(mi.load_dict(create_scene(name)), spp=2048)
+    image = mi.render(mi.load_dict(
+        create_scene(name, spectral_tracking=True)), spp=2048)
+
+    for a, b in zip(channel_means(image), channel_means(reference)):
+        assert abs(a - b) < 3e-2 * max(b, 1e-2)
+
+
+def test05_emissive_medium(variants_vec_backends_once_rgb):
+    # Next event estimation of the volume emitter (volpath) and collision
+    # estimates of the emission alone (volpathmis) converge to the same image
+    reference = mi.render(mi.load_dict(
+        create_scene('emissive', 'volpath', resolution=4)), spp=512)
+    image = mi.render(mi.load_dict(
+        create_scene('emissive', 'volpathmis', resolution=4)), spp=512)
+
+    for a, b in zip(channel_means(image), channel_means(reference)):
+        assert abs(a - b) < 5e-2 * max(b, 1e-2)
+
+
+def test06_spectral_tracking_chromatic(variants_vec_backends_once_rgb):
+    # Low-resolution version of test04 on the chromatic homogeneous medium
+    # inside a closed dielectric boundary
+    reference = mi.render(mi.load_dict(
+        create_scene('subsurface', resolution=4)), spp=1024)
+    image = mi.render(mi.load_dict(
+        create_scene('subsurface', resolution=4, spectral_tracking=True)),
+        spp=1024)
+
+    for a, b in zip(channel_means(image), channel_means(reference)):
+        assert abs(a - b) < 5e-2 * max(b, 1e-2)
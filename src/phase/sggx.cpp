@@ -34,6 +34,10 @@ Due to it's symmetry, the matrix :math:`S` is fully specified by providing the e
 :math:`S_{xx}`, :math:`S_{yy}`, :math:`S_{zz}`, :math:`S_{xy}`, :math:`S_{xz}` and :math:`S_{yz}`.
 It is the responsibility of the user to ensure that these parameters describe a valid positive definite matrix.
 
+When a medium samples an interaction, it evaluates the parameter volume once and caches the matrix
+in the interaction record. The medium's projected area term as well as later calls to ``eval_pdf()``
+and ``sample()`` at the same interaction reuse this matrix instead of interpolating the volume again.
+
 .. tabs::
     .. code-tab:: xml
 
@@ -77,13 +81,35 @@ public:
         return m_ndf_params->eval_6(mi, active);
     }
 
+    /**
+     * Return the SGGX parameters at the interaction, reusing those cached in
+     * <tt>mi.phase_params</tt> by the medium. A valid matrix is positive
+     * definite and thus has a positive S_xx, which distinguishes it from an
+     * empty cache.
+     */
+    MI_INLINE
+    dr::Array<Float, 6> ndf_params(const MediumInteraction3f &mi,
+                                   Mask active) const {
+        dr::Array<Float, 6> s = mi.phase_params;
+        Mask missing = active && !(s[0] > 0.f);
+        if (dr::any_or<true>(missing))
+            dr::masked(s, missing) = eval_ndf_params(mi, missing);
+        return s;
+    }
+
+    dr::Array<Float, 6> eval_params(const MediumInteraction3f &mi,
+                                    Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::PhaseFunctionEvaluate, active);
+        return eval_ndf_params(mi, active);
+    }
+
     std::tuple<Vector3f, Spectrum, Float> sample(const PhaseFunctionContext & /* ctx */,
                                                  const MediumInteraction3f &mi,
                                                  const Float /* sample1 */,
                                                  const Point2f &sample2,
                                                  Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::PhaseFunctionSample, active);
-        auto s         = eval_ndf_params(mi, active);
+        auto s         = ndf_params(mi, active);
         auto sampled_n = sggx_sample(mi.sh_frame, sample2, s);
 
         // The diffuse variant of the SGGX is currently not supported and
@@ -109,7 +135,7 @@ public:
                                         const Vector3f &wo,
                                         Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::PhaseFunctionEvaluate, active);
-        auto s = eval_ndf_params(mi, active);
+        auto s = ndf_params(mi, active);
         /* if (m_diffuse) {
            auto sampled_n = sggx_sample(mi.sh_frame,
            ctx.sampler->next_2d(active), s); return dr::InvPi<Float> *
@@ -123,7 +149,7 @@ public:
 
     virtual Float projected_area(const MediumInteraction3f &mi,
                                  Mask active = true) const override {
-        return sggx_projected_area(mi.wi, eval_ndf_params(mi, active));
+        return sggx_projected_area(mi.wi, ndf_params(mi, active));
     }
 
     std::string to_string() const override {
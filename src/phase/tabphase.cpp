@@ -33,6 +33,8 @@ function of the cosine of the scattering angle.
      scattering.
    * Lookup table points are regularly spaced between -1 and 1.
    * Phase function values are automatically normalized.
+   * Sampling first selects an interval of the lookup table in constant time
+     using an alias table, then inverts the linear interpolant within it.
 */
 
 template <typename Float, typename Spectrum>
@@ -40,6 +42,8 @@ class TabulatedPhaseFunction final : public PhaseFunction<Float, Spectrum> {
 public:
     MI_IMPORT_BASE(PhaseFunction, m_flags, m_components)
     MI_IMPORT_TYPES(PhaseFunctionContext)
+    using FloatStorage  = DynamicBuffer<Float>;
+    using UInt32Storage = DynamicBuffer<UInt32>;
 
     TabulatedPhaseFunction(const Properties &props) : Base(props) {
         if (props.type("values") == Properties::Type::String) {
@@ -58,6 +62,7 @@ public:
 
             m_distr = ContinuousDistribution<Float>(ScalarVector2f(-1.f, 1.f),
                                                     data.data(), data.size());
+            update_interval_distribution();
         } else {
             Throw("'values' must be a string");
         }
@@ -73,6 +78,7 @@ public:
 
     void parameters_changed(const std::vector<std::string> & /*keys*/) override {
         m_distr.update();
+        update_interval_distribution();
     }
 
     std::tuple<Vector3f, Spectrum, Float> sample(const PhaseFunctionContext & /* ctx */,
@@ -84,7 +90,18 @@ public:
 
         // Sample a direction in physics convention.
         // We sample cos θ' = cos(π - θ) = -cos θ.
-        Float cos_theta_prime = m_distr.sample(sample2.x());
+        auto [index, sample_t] = m_interval_distr.sample_reuse(sample2.x(), active);
+        Float y0 = dr::gather<Float>(m_distr.pdf(), index, active),
+              y1 = dr::gather<Float>(m_distr.pdf(), index + 1u, active);
+
+        // Invert the CDF of the linear interpolant within the selected interval
+        Float mass     = sample_t * .5f * (y0 + y1),
+              t_linear = (y0 - dr::safe_sqrt(dr::fmadd(y0, y0, 2.f * mass * (y1 - y0)))) *
+                         dr::rcp(y0 - y1),
+              t_const  = mass * dr::rcp(y0),
+              t        = dr::select(dr::eq(y0, y1), t_const, t_linear);
+        Float cos_theta_prime =
+            dr::fmadd(Float(index) + t, m_distr.interval_resolution(), -1.f);
         Float sin_theta_prime =
             dr::safe_sqrt(1.f - cos_theta_prime * cos_theta_prime);
         auto [sin_phi, cos_phi] =
@@ -127,8 +144,19 @@ public:
     }
 
     MI_DECLARE_CLASS()
+private:
+    /// Build the alias table over the probability mass of each interval
+    void update_interval_distribution() {
+        const FloatStorage &pdf = m_distr.pdf();
+        UInt32Storage index = dr::arange<UInt32Storage>((uint32_t) pdf.size() - 1);
+        FloatStorage mass = dr::detach(dr::gather<FloatStorage>(pdf, index) +
+                                       dr::gather<FloatStorage>(pdf, index + 1u));
+        m_interval_distr = AliasDistribution<Float>(mass);
+    }
+
 private:
     ContinuousDistribution<Float> m_distr;
+    AliasDistribution<Float> m_interval_distr;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(TabulatedPhaseFunction, PhaseFunction)
@@ -61,3 +61,70 @@ def test03_chi2_skewed(variants_vec_backends_once_rgb, tmpdir):
     )
 
     assert chi2.run()
+
+
+def test04_cached_params(variants_vec_backends_once_rgb, tmpdir):
+    tmp_file = os.path.join(str(tmpdir), "sggx.vol")
+    grid = mi.TensorXf([1.0, 0.35, 0.32, 0.52, 0.44, 0.2], [1, 1, 1, 6])
+    mi.VolumeGrid(grid).write(tmp_file)
+
+    p = mi.load_dict({
+        'type': 'sggx',
+        'S': { 'type': 'gridvolume', 'filename': tmp_file }
+    })
+
+    ctx = mi.PhaseFunctionContext(None)
+    mei = dr.zeros(mi.MediumInteraction3f)
+    mei.p = mi.Point3f(0.5, 0.5, 0.5)
+    mei.wi = dr.normalize(mi.Vector3f(0.2, -0.4, 0.9))
+    mei.sh_frame = mi.Frame3f(mei.wi)
+    wo = dr.normalize(mi.Vector3f(-0.3, 0.5, 0.1))
+
+    params = p.eval_params(mei)
+    for i in range(6):
+        assert dr.allclose(params[i], grid.array[i])
+
+    pdf_ref = p.eval_pdf(ctx, mei, wo)[1]
+    area_ref = p.projected_area(mei)
+
+    # A cached matrix takes precedence over the parameter volume
+    s = [0.15, 1.0, 0.8, 0.0, 0.0, 0.0]
+    ref_file = os.path.join(str(tmpdir), "sggx_ref.vol")
+    mi.VolumeGrid(mi.TensorXf(s, [1, 1, 1, 6])).write(ref_file)
+    p_ref = mi.load_dict({
+        'type': 'sggx',
+        'S': { 'type': 'gridvolume', 'filename': ref_file }
+    })
+    pdf_s = p_ref.eval_pdf(ctx, mei, wo)[1]
+    area_s = p_ref.projected_area(mei)
+
+    mei.phase_params = [mi.Float(v) for v in s]
+    assert dr.allclose(p.eval_pdf(ctx, mei, wo)[1], pdf_s)
+    assert dr.allclose(p.projected_area(mei), area_s)
+
+    # Caching the volume lookup does not change the result
+    mei.phase_params = params
+    assert dr.allclose(p.eval_pdf(ctx, mei, wo)[1], pdf_ref)
+    assert dr.allclose(p.projected_area(mei), area_ref)
+
+
+def test05_medium_caches_params(variants_vec_backends_once_rgb, tmpdir):
+    tmp_file = os.path.join(str(tmpdir), "sggx.vol")
+    grid = mi.TensorXf([1.0, 0.35, 0.32, 0.52, 0.44, 0.2], [1, 1, 1, 6])
+    mi.VolumeGrid(grid).write(tmp_file)
+
+    medium = mi.load_dict({
+        'type': 'homogeneous',
+        'sigma_t': 1.0,
+        'phase': {
+            'type': 'sggx',
+            'S': { 'type': 'gridvolume', 'filename': tmp_file }
+        }
+    })
+
+    # Samples a position inside the parameter grid (t = -log(1 - 0.3) ~ 0.36)
+    ray = mi.Ray3f(mi.Point3f(0.5, 0.5, 0.1), mi.Vector3f(0, 0, 1))
+    mei = medium.sample_interaction(ray, mi.Float(0.3), mi.UInt32(0), True)
+    assert dr.all(mei.is_valid())
+    for i in range(6):
+        assert dr.allclose(mei.phase_params[i], grid.array[i])
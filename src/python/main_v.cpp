@@ -63,6 +63,7 @@ MI_PY_DECLARE(Frame);
 MI_PY_DECLARE(Ray);
 MI_PY_DECLARE(DiscreteDistribution);
 MI_PY_DECLARE(DiscreteDistribution2D);
+MI_PY_DECLARE(AliasDistribution);
 MI_PY_DECLARE(ContinuousDistribution);
 MI_PY_DECLARE(IrregularContinuousDistribution);
 MI_PY_DECLARE(Hierarchical2D);
@@ -159,6 +160,7 @@ PYBIND11_MODULE(MODULE_NAME, m) {
     MI_PY_IMPORT(Frame);
     MI_PY_IMPORT(DiscreteDistribution);
     MI_PY_IMPORT(DiscreteDistribution2D);
+    MI_PY_IMPORT(AliasDistribution);
     MI_PY_IMPORT(ContinuousDistribution);
     MI_PY_IMPORT(IrregularContinuousDistribution);
     MI_PY_IMPORT_SUBMODULE(math);
@@ -0,0 +1,289 @@
+"""
+Canonical participating media scenes and a small benchmark harness.
+
+The scenes are shared by the medium tests (see ``src/media/tests``), which
+compare the volumetric integrators against converged references, and by the
+benchmark, which reports the throughput and the variance at equal time of
+each integrator, along with a model of the collisions that free-flight
+sampling generates in each scene:
+
+.. code-block:: bash
+
+    python -m mitsuba.test.media --variant llvm_ad_rgb --time 10
+
+The scenes are:
+
+- ``slab``: a thin homogeneous slab in front of a constant environment,
+- ``cloud``: a heterogeneous cloud with a majorant grid,
+- ``fabric``: a heterogeneous medium with an SGGX phase function modeling
+  fibers aligned with the X axis,
+- ``subsurface``: a chromatic medium (spectrally varying extinction) inside a
+  dielectric cube,
+- ``emissive``: a scattering cloud that emits light.
+
+The scenes and the benchmark require a vectorized (LLVM or CUDA) variant.
+"""
+
+import time
+
+import drjit as dr
+
+SCENES = ['slab', 'cloud', 'fabric', 'subsurface', 'emissive']
+INTEGRATORS = ['volpath', 'volpathmis']
+
+
+def create_cloud_density(resolution=16):
+    """
+    Density grid of a spherical cloud with a wavy boundary (values within
+    [0, 8]), for use as the ``data`` of a grid volume
+    """
+    import mitsuba as mi
+
+    n = resolution
+    index = dr.arange(mi.UInt32, n * n * n)
+    x = (mi.Float(index % n) + 0.5) / n
+    y = (mi.Float((index // n) % n) + 0.5) / n
+    z = (mi.Float(index // (n * n)) + 0.5) / n
+
+    r = dr.sqrt(dr.sqr(x - 0.5) + dr.sqr(y - 0.5) + dr.sqr(z - 0.5))
+    wave = 0.08 * dr.sin(7 * x) * dr.sin(9 * y + 1) * dr.sin(5 * z + 2)
+    density = 8 * dr.clamp((0.42 + wave - r) / 0.12, 0, 1)
+    return mi.TensorXf(density, [n, n, n, 1])
+
+
+def create_medium(name):
+    """Medium (and boundary BSDF) of one of the canonical scenes"""
+    import mitsuba as mi
+
+    if name == 'slab':
+        return {'type': 'null'}, {
+            'type': 'homogeneous',
+            'albedo': 0.8,
+            'sigma_t': 4.0,
+        }
+    elif name == 'cloud':
+        return {'type': 'null'}, {
+            'type': 'heterogeneous',
+            'albedo': 0.95,
+            'sigma_t': {
+                'type': 'gridvolume',
+                'data': create_cloud_density(),
+                'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+            },
+            'majorant_resolution_factor': 4,
+        }
+    elif name == 'fabric':
+        return {'type': 'null'}, {
+            'type': 'heterogeneous',
+            'albedo': 0.9,
+            'sigma_t': {
+                'type': 'gridvolume',
+                'data': create_cloud_density(8),
+                'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+            },
+            'phase': {
+                'type': 'sggx',
+                'S': {
+                    'type': 'gridvolume',
+                    'data': mi.TensorXf(
+                        mi.Float(0.05, 1.0, 1.0, 0.0, 0.0, 0.0), [1, 1, 1, 6]),
+                    'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+                },
+            },
+        }
+    elif name == 'subsurface':
+        return {'type': 'dielectric', 'int_ior': 1.33}, {
+            'type': 'homogeneous',
+            'albedo': {'type': 'rgb', 'value': [0.99, 0.9, 0.6]},
+            'sigma_t': {'type': 'rgb', 'value': [1.0, 4.0, 16.0]},
+        }
+    elif name == 'emissive':
+        return {'type': 'null'}, {
+            'type': 'heterogeneous',
+            'albedo': 0.8,
+            'sigma_t': {
+                'type': 'gridvolume',
+                'data': create_cloud_density(8),
+                'to_world': mi.ScalarTransform4f.translate(-1).scale(2),
+            },
+            'radiance': {'type': 'rgb', 'value': [1.0, 0.5, 0.25]},
+        }
+    else:
+        raise ValueError('Unknown medium scene "%s"' % name)
+
+
+def create_scene(name, integrator='volpath', resolution=8, **kwargs):
+    """
+    Scene dictionary of a canonical medium scene
+
+    Parameter ``integrator`` specifies the integrator type, and any other
+    keyword arguments are passed on to the integrator.
+    """
+    import mitsuba as mi
+
+    bsdf, medium = create_medium(name)
+
+    to_world = mi.ScalarTransform4f.scale(1)
+    if name == 'slab':
+        to_world = mi.ScalarTransform4f.scale([2, 2, 0.25])
+    elif name == 'subsurface':
+        to_world = mi.ScalarTransform4f.rotate([1, 1, 0], 30)
+
+    return {
+        'type': 'scene',
+        'integrator': {'type': integrator, 'max_depth': 64, **kwargs},
+        'sensor': {
+            'type': 'perspective',
+            'to_world': mi.ScalarTransform4f.look_at(
+                origin=(0, 0, 4), target=(0, 0, 0), up=(0, 1, 0)),
+            'film': {'type': 'hdrfilm', 'width': resolution,
+                     'height': resolution, 'rfilter': {'type': 'box'}},
+        },
+        'emitter': {'type': 'constant'},
+        'light': {
+            'type': 'sphere',
+            'center': [2, 3, 2],
+            'radius': 0.5,
+            'emitter': {'type': 'area', 'radiance': 10.0},
+        },
+        'medium': {
+            'type': 'cube',
+            'to_world': to_world,
+            'bsdf': bsdf,
+            'interior': medium,
+        },
+    }
+
+
+def model_collision_statistics(scene, spp=4, seed=0):
+    """
+    Model of the average numbers of real and null collisions that free-flight
+    sampling generates along the camera rays entering a medium
+
+    This does not instrument any integrator: it replays delta tracking with
+    ``Medium.sample_interaction()`` against the largest majorant over all
+    channels, from the first medium boundary until the first real collision
+    or until the ray leaves the medium. The counts hence characterize the
+    majorants of the scene, not the work of a specific integrator (e.g. its
+    shadow rays or the segments after the first scattering event).
+
+    Returns a tuple ``(real, null)``.
+    """
+    import mitsuba as mi
+
+    sensor = scene.sensors()[0]
+    film_size = sensor.film().crop_size()
+    n = dr.prod(film_size) * spp
+
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(seed, n)
+
+    ray, _ = sensor.sample_ray(0.0, 0.5, sampler.next_2d(), mi.Point2f(0.5))
+    si = scene.ray_intersect(ray)
+    active = si.is_valid() & si.is_medium_transition()
+    medium = si.target_medium(ray.d)
+    entered = dr.sum(dr.select(active, mi.Float(1), mi.Float(0)))[0]
+    if entered == 0:
+        return 0.0, 0.0
+
+    ray = si.spawn_ray(ray.d)
+    si = scene.ray_intersect(ray, active)
+    real, null = mi.UInt32(0), mi.UInt32(0)
+
+    while dr.any(active):
+        mei = medium.sample_interaction(ray, sampler.next_1d(active),
+                                        0xFFFFFFFF, active)
+        active &= mei.is_valid() & (mei.t < si.t)
+
+        p_real = dr.max(mei.sigma_t) / dr.max(mei.combined_extinction)
+        is_real = active & (sampler.next_1d(active) < p_real)
+        is_null = active & ~is_real
+        real = dr.select(is_real, real + 1, real)
+        null = dr.select(is_null, null + 1, null)
+
+        # Null collisions resume the flight from the sampled position
+        active = is_null
+        ray.o = dr.select(active, mei.p, ray.o)
+        si.t = dr.select(active, si.t - mei.t, si.t)
+        dr.eval(active, ray, si, real, null)
+
+    return dr.sum(mi.Float(real))[0] / entered, dr.sum(mi.Float(null))[0] / entered
+
+
+def benchmark(name, integrator='volpath', spp=16, time_budget=5.0,
+              resolution=32, **kwargs):
+    """
+    Benchmark an integrator on a canonical medium scene
+
+    The scene is rendered with different seeds until the time budget is
+    exhausted (at least twice).
+
+    Returns a dictionary with the rendering throughput (``samples_per_second``),
+    the variance of the average of the images rendered within the budget
+    (``variance``, averaged over the pixels and channels) and the modeled
+    collisions of the camera rays in the scene, which do not depend on the
+    integrator (``real_collisions`` and ``null_collisions``, see
+    :py:func:`model_collision_statistics`).
+    """
+    import mitsuba as mi
+
+    scene = mi.load_dict(create_scene(name, integrator, resolution, **kwargs))
+
+    # Warm-up render (kernel compilation)
+    image = mi.render(scene, spp=spp, seed=0)
+    dr.eval(image)
+    dr.sync_thread()
+
+    images, elapsed = [], 0.0
+    while elapsed < time_budget or len(images) < 2:
+        start = time.perf_counter()
+        image = mi.render(scene, spp=spp, seed=len(images) + 1)
+        dr.eval(image)
+        dr.sync_thread()
+        elapsed += time.perf_counter() - start
+        images.append(image.array)
+
+    k = len(images)
+    mean = sum(images, mi.Float(0)) / k
+    var = sum((dr.sqr(img - mean) for img in images), mi.Float(0)) / (k - 1)
+
+    real, null = model_collision_statistics(scene)
+    return {
+        'samples_per_second': k * resolution * resolution * spp / elapsed,
+        'real_collisions': real,
+        'null_collisions': null,
+        'variance': dr.mean(var)[0] / k,
+        'renders': k,
+    }
+
+
+if __name__ == '__main__':
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description='Benchmark the volumetric integrators on canonical medium scenes.')
+    parser.add_argument('--variant', default='llvm_ad_rgb',
+                        help='Mitsuba variant (default: llvm_ad_rgb)')
+    parser.add_argument('--scenes', nargs='+', default=SCENES, choices=SCENES)
+    parser.add_argument('--integrators', nargs='+', default=INTEGRATORS)
+    parser.add_argument('--spp', type=int, default=16,
+                        help='Samples per pixel of each render (default: 16)')
+    parser.add_argument('--time', type=float, default=5.0,
+                        help='Time budget per scene and integrator in seconds (default: 5)')
+    parser.add_argument('--resolution', type=int, default=32,
+                        help='Image resolution (default: 32)')
+    args = parser.parse_args()
+
+    import mitsuba as mi
+    mi.set_variant(args.variant)
+
+    print('%-12s %-12s %14s %10s %10s %14s' % (
+        'scene', 'integrator', 'samples/s', 'real/ray', 'null/ray',
+        'var@time'))
+    for name in args.scenes:
+        for integrator in args.integrators:
+            r = benchmark(name, integrator, spp=args.spp, time_budget=args.time,
+                          resolution=args.resolution)
+            print('%-12s %-12s %14.4g %10.3f %10.3f %14.4g' % (
+                name, integrator, r['samples_per_second'],
+                r['real_collisions'], r['null_collisions'], r['variance']))
@@ -0,0 +1,317 @@
+#include <mitsuba/render/bvh.h>
+#include <mitsuba/render/mesh.h>
+#include <mitsuba/core/properties.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+MI_VARIANT ShapeBVH<Float, Spectrum>::ShapeBVH(const Properties &props) {
+    /* BVH construction: Nodes with more primitives are always split */
+    m_max_leaf_size = (Size) props.get<int>("bvh_max_leaf_size", 4);
+    if (m_max_leaf_size == 0)
+        Throw("The maximum BVH leaf size must be positive!");
+
+    /* BVH construction: Relative cost of a node traversal with respect to a
+       primitive intersection in the surface area heuristic. */
+    m_traversal_cost = props.get<ScalarFloat>("bvh_traversal_cost", 1.f);
+    if (m_traversal_cost < 0.f)
+        Throw("The BVH traversal cost must be non-negative!");
+
+    m_primitive_map.push_back(0);
+}
+
+MI_VARIANT void ShapeBVH<Float, Spectrum>::clear() {
+    m_shapes.clear();
+    m_primitive_map.clear();
+    m_primitive_map.push_back(0);
+    m_bbox.reset();
+    m_nodes.reset();
+    m_indices.reset();
+    m_node_count = 0;
+    m_index_count = 0;
+}
+
+MI_VARIANT void ShapeBVH<Float, Spectrum>::add_shape(Shape *shape) {
+    Assert(!ready());
+    m_primitive_map.push_back(m_primitive_map.back() +
+                              shape->primitive_count());
+    m_shapes.push_back(shape);
+    m_bbox.expand(shape->bbox());
+}
+
+MI_VARIANT void ShapeBVH<Float, Spectrum>::build() {
+    Timer timer;
+    Size prim_count = primitive_count();
+    Log(Info, "Building a SAH BVH (%i primitives) ..", prim_count);
+
+    BuildContext ctx;
+    ctx.prim_bbox.resize(prim_count);
+    ctx.prim_center.resize(prim_count);
+
+    // Compute the bounding boxes of all primitives
+    dr::parallel_for(
+        dr::blocked_range<Size>(0u, prim_count, MI_BVH_GRAIN_SIZE),
+        [&](const dr::blocked_range<Size> &range) {
+            for (Size i = range.begin(); i != range.end(); ++i) {
+                Index prim_index = i;
+                Index shape_index = find_shape(prim_index);
+                ScalarBoundingBox3f bbox = m_shapes[shape_index]->bbox(prim_index);
+                ctx.prim_bbox[i] = bbox;
+                ctx.prim_center[i] = bbox.center();
+            }
+        }
+    );
+
+    // Skip primitives with an invalid bounding box (e.g. empty shapes)
+    std::vector<Index> indices;
+    indices.reserve(prim_count);
+    for (Size i = 0; i < prim_count; ++i) {
+        if (ctx.prim_bbox[i].valid())
+            indices.push_back(i);
+    }
+
+    m_index_count = Size(indices.size());
+    m_indices.reset(new Index[std::max(m_index_count, 1u)]);
+    std::copy(indices.begin(), indices.end(), m_indices.get());
+
+    std::vector<Node> nodes;
+    if (m_index_count > 0) {
+        ctx.nodes.resize(2 * m_index_count - 1);
+        build_node(ctx, 0, 0, m_index_count, 0);
+        collapse(ctx, 0, nodes);
+    } else {
+        // Empty scene: a root node without children
+        nodes.resize(1);
+        Node &root = nodes[0];
+        for (size_t i = 0; i < Width; ++i) {
+            for (size_t k = 0; k < 3; ++k) {
+                root.bounds[k][i]     =  dr::Infinity<ScalarFloat>;
+                root.bounds[k + 3][i] = -dr::Infinity<ScalarFloat>;
+            }
+            root.child[i] = 0;
+            root.count[i] = 0;
+        }
+    }
+
+    m_node_count = Size(nodes.size());
+    m_nodes.reset(new Node[m_node_count]);
+    std::copy(nodes.begin(), nodes.end(), m_nodes.get());
+
+    Log(Info, "Finished. (%s of storage, %i nodes, took %s)",
+        util::mem_string(m_index_count * sizeof(Index) +
+                         m_node_count * sizeof(Node)),
+        m_node_count,
+        util::time_string((float) timer.value())
+    );
+}
+
+MI_VARIANT void ShapeBVH<Float, Spectrum>::build_node(BuildContext &ctx,
+                                                      Index node_index,
+                                                      Index begin, Index end,
+                                                      Size depth) const {
+    ScopedSetThreadEnvironment env(ctx.env);
+
+    Index *indices = m_indices.get();
+    Size count = end - begin;
+
+    ScalarBoundingBox3f bbox, center_bbox;
+    for (Index i = begin; i < end; ++i) {
+        bbox.expand(ctx.prim_bbox[indices[i]]);
+        center_bbox.expand(ctx.prim_center[indices[i]]);
+    }
+
+    BuildNode &node = ctx.nodes[node_index];
+    node.bbox = bbox;
+
+    if (count == 1 || depth + 1 >= MI_BVH_MAXDEPTH) {
+        node.offset = begin;
+        node.count = count;
+        return;
+    }
+
+    /* ==================================================================== */
+    /*            Binned surface area heuristic over all three axes         */
+    /* ==================================================================== */
+
+    struct Bin {
+        ScalarBoundingBox3f bbox;
+        Size count = 0;
+    };
+
+    ScalarVector3f extents = center_bbox.extents();
+    ScalarFloat best_cost = dr::Infinity<ScalarFloat>;
+    int best_axis = -1;
+    Size best_bin = 0;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (!(extents[axis] > 0.f))
+            continue;
+
+        ScalarFloat scale = MI_BVH_BINS / extents[axis];
+        auto bin_index = [&](Index prim) {
+            ScalarFloat rel = (ctx.prim_center[prim][axis] - center_bbox.min[axis]) * scale;
+            return std::min(Size(rel), MI_BVH_BINS - 1u);
+        };
+
+        Bin bins[MI_BVH_BINS];
+        for (Index i = begin; i < end; ++i) {
+            Bin &bin = bins[bin_index(indices[i])];
+            bin.bbox.expand(ctx.prim_bbox[indices[i]]);
+            bin.count++;
+        }
+
+        // Sweep from the right to accumulate the costs of the right halves
+        ScalarFloat right_cost[MI_BVH_BINS];
+        ScalarBoundingBox3f right_bbox;
+        Size right_count = 0;
+        for (Size i = MI_BVH_BINS - 1; i > 0; --i) {
+            right_bbox.expand(bins[i].bbox);
+            right_count += bins[i].count;
+            right_cost[i] = right_count > 0
+                ? right_bbox.surface_area() * right_count : 0.f;
+        }
+
+        // Sweep from the left, splitting after bin 'i'
+        ScalarBoundingBox3f left_bbox;
+        Size left_count = 0;
+        for (Size i = 0; i < MI_BVH_BINS - 1; ++i) {
+            left_bbox.expand(bins[i].bbox);
+            left_count += bins[i].count;
+            if (left_count == 0 || left_count == count)
+                continue;
+
+            ScalarFloat cost = left_bbox.surface_area() * left_count + right_cost[i + 1];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = i;
+            }
+        }
+    }
+
+    ScalarFloat area = bbox.surface_area();
+    ScalarFloat leaf_cost = area * count,
+                split_cost = m_traversal_cost * area + best_cost;
+
+    if (count <= m_max_leaf_size && (best_axis < 0 || leaf_cost <= split_cost)) {
+        node.offset = begin;
+        node.count = count;
+        return;
+    }
+
+    /* ==================================================================== */
+    /*                  Partition the primitives and recurse                */
+    /* ==================================================================== */
+
+    Index mid;
+    if (best_axis >= 0) {
+        ScalarFloat scale = MI_BVH_BINS / extents[best_axis];
+        ScalarFloat min = center_bbox.min[best_axis];
+        mid = Index(std::partition(indices + begin, indices + end,
+            [&](Index prim) {
+                ScalarFloat rel = (ctx.prim_center[prim][best_axis] - min) * scale;
+                return std::min(Size(rel), MI_BVH_BINS - 1u) <= best_bin;
+            }) - indices);
+    } else {
+        // All centroids coincide: split the primitives into two halves
+        mid = begin + count / 2;
+    }
+
+    Index left = ctx.node_count.fetch_add(2);
+    node.offset = left;
+    node.count = 0;
+
+    if (count > MI_BVH_GRAIN_SIZE) {
+        Task *left_task = dr::do_async([&, left, begin, mid, depth]() {
+            build_node(ctx, left, begin, mid, depth + 1);
+        });
+        build_node(ctx, left + 1, mid, end, depth + 1);
+        task_wait_and_release(left_task);
+    } else {
+        build_node(ctx, left, begin, mid, depth + 1);
+        build_node(ctx, left + 1, mid, end, depth + 1);
+    }
+}
+
+MI_VARIANT typename ShapeBVH<Float, Spectrum>::Index
+ShapeBVH<Float, Spectrum>::collapse(const BuildContext &ctx, Index node_index,
+                                    std::vector<Node> &nodes) const {
+    const BuildNode &node = ctx.nodes[node_index];
+
+    // Gather up to 'Width' children by opening the largest inner nodes
+    Index children[Width];
+    size_t child_count = 0;
+    if (node.count > 0) {
+        children[child_count++] = node_index;
+    } else {
+        children[child_count++] = node.offset;
+        children[child_count++] = node.offset + 1;
+    }
+
+    while (child_count < Width) {
+        ScalarFloat largest_area = -1.f;
+        size_t largest = Width;
+        for (size_t i = 0; i < child_count; ++i) {
+            const BuildNode &child = ctx.nodes[children[i]];
+            ScalarFloat area = child.bbox.surface_area();
+            if (child.count == 0 && area > largest_area) {
+                largest_area = area;
+                largest = i;
+            }
+        }
+
+        if (largest == Width)
+            break;
+
+        Index offset = ctx.nodes[children[largest]].offset;
+        children[largest] = offset;
+        children[child_count++] = offset + 1;
+    }
+
+    Index result = Index(nodes.size());
+    nodes.emplace_back();
+
+    for (size_t i = 0; i < Width; ++i) {
+        ScalarBoundingBox3f bbox;
+        Index child = 0;
+        Size count = 0;
+
+        if (i < child_count) {
+            const BuildNode &c = ctx.nodes[children[i]];
+            bbox = c.bbox;
+            if (c.count > 0) {
+                child = c.offset;
+                count = c.count;
+            } else {
+                // 'nodes' may be reallocated by the recursion
+                child = collapse(ctx, children[i], nodes);
+            }
+        }
+
+        Node &n = nodes[result];
+        for (size_t k = 0; k < 3; ++k) {
+            n.bounds[k][i]     = bbox.min[k];
+            n.bounds[k + 3][i] = bbox.max[k];
+        }
+        n.child[i] = child;
+        n.count[i] = count;
+    }
+
+    return result;
+}
+
+MI_VARIANT std::string ShapeBVH<Float, Spectrum>::to_string() const {
+    std::ostringstream oss;
+    oss << "ShapeBVH[" << std::endl
+        << "  width = " << Width << "," << std::endl
+        << "  node_count = " << m_node_count << "," << std::endl
+        << "  shapes = [" << std::endl;
+    for (auto shape : m_shapes)
+        oss << "    " << string::indent(shape, 4)
+            << "," << std::endl;
+    oss << "  ]" << std::endl << "]";
+    return oss.str();
+}
+
+MI_IMPLEMENT_CLASS_VARIANT(ShapeBVH, Object)
+MI_INSTANTIATE_CLASS(ShapeBVH)
+NAMESPACE_END(mitsuba)
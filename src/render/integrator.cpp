@@ -8,8 +8,12 @@
 #include <mitsuba/core/timer.h>
 #include <mitsuba/core/util.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/render/bsdf.h>
+#include <mitsuba/render/emitter.h>
 #include <mitsuba/render/film.h>
 #include <mitsuba/render/integrator.h>
+#include <mitsuba/render/medium.h>
+#include <mitsuba/render/phase.h>
 #include <mitsuba/render/sampler.h>
 #include <mitsuba/render/sensor.h>
 #include <mitsuba/render/spiral.h>
@@ -83,6 +87,241 @@ Integrator<Float, Spectrum>::render_backward(Scene* scene,
     }
 }
 
+MI_VARIANT void Integrator<Float, Spectrum>::check_volume_emitters(const Scene *scene) const {
+    if (supports_volume_emitters())
+        return;
+    for (const auto &emitter : scene->emitters()) {
+        if (has_flag(emitter->flags(), EmitterFlags::Volume)) {
+            Log(Warn, "The scene samples emissive media through volume "
+                      "emitters, which this integrator does not support. The "
+                      "rendering will be biased, set the scene's "
+                      "\"volume_emitters\" parameter to false.");
+            break;
+        }
+    }
+}
+
+MI_VARIANT Spectrum
+Integrator<Float, Spectrum>::eval_transmittance(const Scene *scene, Ray3f ray,
+                                                MediumPtr medium, Sampler *sampler,
+                                                UInt32 channel, Float footprint,
+                                                Mask active) const {
+    Spectrum transmittance(1.0f);
+    Float max_dist = ray.maxt, total_dist = 0.f;
+    SurfaceInteraction3f si = dr::zeros<SurfaceInteraction3f>();
+    Mask needs_intersection = true;
+
+    dr::Loop<Mask> loop("Integrator transmittance");
+    loop.put(active, ray, total_dist, needs_intersection, medium, si,
+             transmittance);
+    sampler->loop_put(loop);
+    loop.init();
+    while (loop(dr::detach(active))) {
+        Float remaining_dist = max_dist - total_dist;
+        ray.maxt = remaining_dist;
+        active &= remaining_dist > 0.f;
+        if (dr::none_or<false>(active))
+            break;
+
+        Mask escaped_medium = false;
+        Mask active_medium  = active && dr::neq(medium, nullptr);
+        Mask active_surface = active && !active_medium;
+
+        if (dr::any_or<true>(active_medium)) {
+            /* Homogeneous media are handled in closed form, others by
+               residual ratio tracking: sampled collisions only need to
+               account for the difference between the extinction and the
+               medium's control extinction. */
+            Mask tracking = active_medium && !medium->is_homogeneous();
+            MediumInteraction3f mei = dr::zeros<MediumInteraction3f>();
+            if (dr::any_or<true>(tracking))
+                mei = medium->sample_interaction(ray, sampler->next_1d(tracking),
+                                                 channel, tracking, footprint);
+            dr::masked(mei.t, !tracking) = dr::Infinity<Float>;
+
+            Mask intersect = needs_intersection && active_medium;
+            if (dr::any_or<true>(intersect))
+                dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
+
+            dr::masked(mei.t, active_medium && (si.t < mei.t)) = dr::Infinity<Float>;
+            needs_intersection &= !active_medium;
+
+            // Analytic transmittance of the control extinction up to the
+            // next collision, surface or the end of the ray
+            MediumInteraction3f mei_c = dr::zeros<MediumInteraction3f>();
+            mei_c.p           = ray.o;
+            mei_c.wi          = -ray.d;
+            mei_c.sh_frame    = Frame3f(mei_c.wi);
+            mei_c.time        = ray.time;
+            mei_c.wavelengths = ray.wavelengths;
+            mei_c.medium      = medium;
+            UnpolarizedSpectrum control =
+                medium->get_control_extinction(mei_c, active_medium);
+
+            auto [aabb_its, mint, maxt] = medium->intersect_aabb(ray);
+            Float t_end = dr::minimum(remaining_dist, dr::minimum(mei.t, si.t));
+            Float segment = dr::maximum(
+                0.f, dr::minimum(t_end, maxt) - dr::maximum(mint, 0.f));
+            dr::masked(segment, !aabb_its) = 0.f;
+            dr::masked(transmittance, active_medium) *= dr::exp(-control * segment);
+
+            // Handle exceeding the maximum distance by medium sampling
+            dr::masked(total_dist, active_medium && (mei.t > remaining_dist) && mei.is_valid()) = max_dist;
+            dr::masked(mei.t, active_medium && (mei.t > remaining_dist)) = dr::Infinity<Float>;
+
+            escaped_medium = active_medium && !mei.is_valid();
+            active_medium &= mei.is_valid();
+
+            dr::masked(total_dist, active_medium) += mei.t;
+
+            if (dr::any_or<true>(active_medium)) {
+                dr::masked(ray.o, active_medium) = mei.p;
+                dr::masked(si.t, active_medium)  = si.t - mei.t;
+
+                // Majorant of the sampled channel (spectrally constant when
+                // sampling against the maximum majorant)
+                Float majorant = mei.combined_extinction[0];
+                if constexpr (is_rgb_v<Spectrum>) {
+                    dr::masked(majorant, dr::eq(channel, 1u)) = mei.combined_extinction[1];
+                    dr::masked(majorant, dr::eq(channel, 2u)) = mei.combined_extinction[2];
+                }
+                dr::masked(transmittance, active_medium) *=
+                    1.f - (mei.sigma_t - control) / majorant;
+            }
+        }
+
+        // Handle interactions with surfaces
+        Mask intersect = active_surface && needs_intersection;
+        if (dr::any_or<true>(intersect))
+            dr::masked(si, intersect) = scene->ray_intersect(ray, intersect);
+        needs_intersection &= !intersect;
+        active_surface |= escaped_medium;
+        dr::masked(total_dist, active_surface) += si.t;
+
+        active_surface &= si.is_valid() && active && !active_medium;
+        if (dr::any_or<true>(active_surface)) {
+            auto bsdf         = si.bsdf(ray);
+            Spectrum bsdf_val = bsdf->eval_null_transmission(si, active_surface);
+            bsdf_val = si.to_world_mueller(bsdf_val, si.wi, si.wi);
+            dr::masked(transmittance, active_surface) *= bsdf_val;
+        }
+
+        // Update the ray with new origin & t parameter
+        dr::masked(ray, active_surface) = si.spawn_ray(ray.d);
+        ray.maxt = remaining_dist;
+        needs_intersection |= active_surface;
+
+        // Continue tracing through scene if non-zero weights exist
+        active &= (active_medium || active_surface) &&
+                  dr::any(dr::neq(unpolarized_spectrum(transmittance), 0.f));
+
+        // If a medium transition is taking place: Update the medium pointer
+        Mask has_medium_trans = active_surface && si.is_medium_transition();
+        if (dr::any_or<true>(has_medium_trans))
+            dr::masked(medium, has_medium_trans) = si.target_medium(ray.d);
+    }
+    return transmittance;
+}
+
+MI_VARIANT std::tuple<typename Integrator<Float, Spectrum>::MediumInteraction3f,
+                      typename Integrator<Float, Spectrum>::Mask,
+                      typename Integrator<Float, Spectrum>::Mask>
+Integrator<Float, Spectrum>::sample_light_collision(Ray3f &ray, SurfaceInteraction3f &si,
+                                                    MediumPtr medium, Sampler *sampler,
+                                                    Spectrum &throughput,
+                                                    Mask active) const {
+    MediumInteraction3f mei = medium->sample_interaction(
+        ray, sampler->next_1d(active), UInt32(Medium::MaxMajorantChannel), active);
+    dr::masked(mei.t, active && (si.t < mei.t)) = dr::Infinity<Float>;
+
+    Mask is_spectral = active && medium->has_spectral_extinction(),
+         not_spectral = active && !is_spectral;
+    if (dr::any_or<true>(is_spectral)) {
+        auto [tr, free_flight_pdf] =
+            medium->transmittance_eval_pdf(mei, si, is_spectral);
+        Float tr_pdf = dr::max(free_flight_pdf);
+        dr::masked(throughput, is_spectral) *=
+            dr::select(tr_pdf > 0.f, tr / tr_pdf, 0.f);
+    }
+
+    active &= mei.is_valid();
+    is_spectral &= active;
+    not_spectral &= active;
+
+    // Real collisions are chosen according to the largest extinction
+    Float p_scatter = dr::max(mei.sigma_t) / dr::max(mei.combined_extinction);
+    Mask null_scatter = sampler->next_1d(active) >= p_scatter;
+    Mask act_null_scatter = active && null_scatter,
+         act_medium_scatter = active && !null_scatter;
+
+    dr::masked(throughput, is_spectral && act_null_scatter) *=
+        mei.sigma_n / (1.f - p_scatter);
+    dr::masked(throughput, is_spectral && act_medium_scatter) *=
+        mei.sigma_s / p_scatter;
+    dr::masked(throughput, not_spectral && act_medium_scatter) *=
+        mei.sigma_s / mei.sigma_t;
+
+    // Null collisions resume the flight from the sampled position
+    dr::masked(ray.o, act_null_scatter) = mei.p;
+    dr::masked(si.t, act_null_scatter) = si.t - mei.t;
+
+    return { mei, active, act_medium_scatter };
+}
+
+MI_VARIANT void
+Integrator<Float, Spectrum>::sample_light_phase(const MediumInteraction3f &mei,
+                                                Ray3f &ray, Sampler *sampler,
+                                                Spectrum &throughput,
+                                                Mask active) const {
+    PhaseFunctionContext phase_ctx(sampler, TransportMode::Importance);
+    auto phase = mei.medium->phase_function();
+    dr::masked(phase, !active) = nullptr;
+    auto [wo, phase_weight, phase_pdf] = phase->sample(
+        phase_ctx, mei, sampler->next_1d(active), sampler->next_2d(active), active);
+
+    dr::masked(throughput, active) *= dr::select(phase_pdf > 0.f, phase_weight, 0.f);
+    dr::masked(ray, active) = mei.spawn_ray(wo);
+}
+
+MI_VARIANT std::pair<typename Integrator<Float, Spectrum>::Mask,
+                     typename Integrator<Float, Spectrum>::Mask>
+Integrator<Float, Spectrum>::sample_light_bsdf(const SurfaceInteraction3f &si,
+                                               Ray3f &ray, MediumPtr &medium,
+                                               Sampler *sampler,
+                                               Spectrum &throughput, Float &eta,
+                                               Mask active) const {
+    BSDFPtr bsdf = si.bsdf(ray);
+    BSDFContext ctx(TransportMode::Importance);
+    auto [bs, bsdf_val] = bsdf->sample(ctx, si, sampler->next_1d(active),
+                                       sampler->next_2d(active), active);
+
+    // Using geometric normals (wo points to the camera)
+    Float wi_dot_geo_n = dr::dot(si.n, -ray.d),
+          wo_dot_geo_n = dr::dot(si.n, si.to_world(bs.wo));
+
+    // Prevent light leaks due to shading normals
+    active &= (wi_dot_geo_n * Frame3f::cos_theta(si.wi) > 0.f) &&
+              (wo_dot_geo_n * Frame3f::cos_theta(bs.wo) > 0.f);
+
+    // Adjoint BSDF for shading normals -- [Veach, p. 155]
+    Float correction = dr::abs((Frame3f::cos_theta(si.wi) * wo_dot_geo_n) /
+                               (Frame3f::cos_theta(bs.wo) * wi_dot_geo_n));
+    dr::masked(throughput, active) *= bsdf_val * correction;
+    dr::masked(eta, active) *= bs.eta;
+
+    // Passing through a null BSDF does not count as a bounce
+    Mask non_null_bsdf = active && !has_flag(bs.sampled_type, BSDFFlags::Null);
+
+    dr::masked(ray, active) = si.spawn_ray(si.to_world(bs.wo));
+
+    // Enter or leave media at their boundaries
+    Mask has_medium_trans = active && si.is_medium_transition();
+    if (dr::any_or<true>(has_medium_trans))
+        dr::masked(medium, has_medium_trans) = si.target_medium(ray.d);
+
+    return { active, non_null_bsdf };
+}
+
 MI_VARIANT std::vector<std::string> Integrator<Float, Spectrum>::aov_names() const {
     return { };
 }
@@ -126,6 +365,7 @@ SamplingIntegrator<Float, Spectrum>::render(Scene *scene,
                                             bool evaluate) {
     ScopedPhase sp(ProfilerPhase::Render);
     m_stop = false;
+    check_volume_emitters(scene);
 
     // Render on a larger film if the 'high quality edges' feature is enabled
     Film *film = sensor->film();
@@ -550,6 +790,7 @@ AdjointIntegrator<Float, Spectrum>::render(Scene *scene,
                                            bool evaluate) {
     ScopedPhase sp(ProfilerPhase::Render);
     m_stop = false;
+    check_volume_emitters(scene);
 
     Film *film = sensor->film();
     ScalarVector2u film_size = film->size(),
@@ -1,9 +1,65 @@
 #include <mitsuba/render/kdtree.h>
 #include <mitsuba/render/mesh.h>
+#include <mitsuba/core/fstream.h>
+#include <mitsuba/core/mmap.h>
 #include <mitsuba/core/properties.h>
+#include <random>
 
 NAMESPACE_BEGIN(mitsuba)
 
+/// Version of the file format of the kd-tree cache (bump on layout changes)
+static constexpr uint32_t KDTreeCacheVersion = 2;
+
+/// Header of a kd-tree cache file, followed by the node and index lists
+struct KDTreeCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t hash;
+    /// Hash of the node and index lists, to detect corrupted files
+    uint64_t checksum;
+    uint32_t scalar_size;
+    uint32_t node_size;
+    uint32_t node_count;
+    uint32_t index_count;
+    double bbox_min[3];
+    double bbox_max[3];
+};
+
+static uint64_t hash_mix(uint64_t h, uint64_t v) {
+    return h ^ (v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+/// 64-bit hash of a memory region (large regions are hashed in parallel)
+static uint64_t hash_buffer(uint64_t h, const void *ptr, size_t size) {
+    constexpr size_t ChunkSize = 1024 * 1024;
+    const uint8_t *data = (const uint8_t *) ptr;
+    size_t chunk_count = (size + ChunkSize - 1) / ChunkSize;
+    std::vector<uint64_t> chunk_hash(chunk_count);
+
+    dr::parallel_for(
+        dr::blocked_range<size_t>(0, chunk_count, 1),
+        [&](const dr::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                const uint8_t *start = data + i * ChunkSize;
+                size_t n = std::min(ChunkSize, size - i * ChunkSize);
+                uint64_t value = 0xcbf29ce484222325ull ^ i;
+                for (size_t j = 0; j < n; j += 8) {
+                    uint64_t word = 0;
+                    std::memcpy(&word, start + j, std::min(n - j, (size_t) 8));
+                    value = (value ^ word) * 0x100000001b3ull;
+                    value ^= value >> 29;
+                }
+                chunk_hash[i] = value;
+            }
+        }
+    );
+
+    h = hash_mix(h, size);
+    for (uint64_t value : chunk_hash)
+        h = hash_mix(h, value);
+    return h;
+}
+
 template <typename B, typename I, typename C, typename D>
 thread_local typename TShapeKDTree<B, I, C, D>::LocalBuildContext
     TShapeKDTree<B, I, C, D>::BuildTask::m_local = {};
@@ -48,6 +104,31 @@ MI_VARIANT ShapeKDTree<Float, Spectrum>::ShapeKDTree(const Properties &props)
     if (props.has_property("kd_exact_primitive_threshold"))
         set_exact_primitive_threshold(props.get<int>("kd_exact_primitive_threshold"));
 
+    /* kd-tree construction: Directory of an on-disk cache of built trees */
+    if (props.has_property("kd_cache_dir")) {
+        m_cache_dir = props.string("kd_cache_dir");
+        if (!fs::exists(m_cache_dir) && !fs::create_directory(m_cache_dir)) {
+            Log(Warn, "Unable to create the kd-tree cache directory \"%s\", "
+                "caching is disabled.", m_cache_dir);
+            m_cache_dir = fs::path();
+        }
+    }
+
+    /* kd-tree update: Fraction of the primitives that may change before an
+       incremental update falls back to rebuilding the kd-tree. */
+    m_rebuild_fraction = props.get<ScalarFloat>("kd_rebuild_fraction", .25f);
+    if (m_rebuild_fraction < 0.f || m_rebuild_fraction > 1.f)
+        Throw("The kd-tree rebuild fraction must be in [0, 1]!");
+
+    /* kd-tree traversal: Trace the rays of an LLVM kernel as packets (as
+       opposed to one ray at a time). */
+    m_packet_traversal = props.get<bool>("kd_packet_traversal", true);
+
+    m_primitive_map.push_back(0);
+}
+
+MI_VARIANT ShapeKDTree<Float, Spectrum>::ShapeKDTree(const SurfaceAreaHeuristic3f &model)
+    : Base(model), m_rebuild_fraction(0.f), m_packet_traversal(false) {
     m_primitive_map.push_back(0);
 }
 
@@ -60,9 +141,25 @@ MI_VARIANT void ShapeKDTree<Float, Spectrum>::clear() {
     m_indices.release();
     m_node_count = 0;
     m_index_count = 0;
+    m_dynamic = nullptr;
+    m_dynamic_shapes.clear();
+    m_shape_outdated.clear();
 }
 
 MI_VARIANT void ShapeKDTree<Float, Spectrum>::build() {
+    m_dynamic = nullptr;
+    m_dynamic_shapes.clear();
+    m_shape_outdated.assign(m_shapes.size(), 0);
+
+    fs::path cache_file;
+    uint64_t hash = 0;
+    if (!m_cache_dir.empty()) {
+        hash = geometry_hash();
+        cache_file = m_cache_dir / tfm::format("kdtree_%016x.bin", hash);
+        if (load_cache(cache_file, hash))
+            return;
+    }
+
     Timer timer;
     Log(Info, "Building a SAH kd-tree (%i primitives) ..",
         primitive_count());
@@ -74,6 +171,229 @@ MI_VARIANT void ShapeKDTree<Float, Spectrum>::build() {
                         m_node_count * sizeof(KDNode)),
         util::time_string((float) timer.value())
     );
+
+    if (!cache_file.empty())
+        save_cache(cache_file, hash);
+}
+
+MI_VARIANT uint64_t ShapeKDTree<Float, Spectrum>::geometry_hash() const {
+    uint64_t h = hash_mix(KDTreeCacheVersion, sizeof(ScalarFloat));
+
+    // Build-related parameters
+    const SurfaceAreaHeuristic3f &model = Base::cost_model();
+    ScalarFloat costs[3] = { model.query_cost(), model.traversal_cost(),
+                             model.empty_space_bonus() };
+    h = hash_buffer(h, costs, sizeof(costs));
+    h = hash_mix(h, Base::stop_primitives());
+    h = hash_mix(h, Base::max_depth());
+    h = hash_mix(h, Base::min_max_bins());
+    h = hash_mix(h, Base::clip_primitives());
+    h = hash_mix(h, Base::retract_bad_splits());
+    h = hash_mix(h, Base::exact_primitive_threshold());
+
+    // Geometry: the kd-tree only depends on the primitive bounding boxes
+    for (const Shape *shape : m_shapes) {
+        const std::string &name = shape->class_()->name();
+        h = hash_buffer(h, name.data(), name.size());
+        h = hash_mix(h, shape->primitive_count());
+        ScalarBoundingBox3f bbox = shape->bbox();
+        h = hash_buffer(h, &bbox, sizeof(bbox));
+
+        if (shape->is_mesh()) {
+            const Mesh *mesh = (const Mesh *) shape;
+            auto &&vertices = dr::migrate(mesh->vertex_positions_buffer(), AllocType::Host);
+            auto &&faces = dr::migrate(mesh->faces_buffer(), AllocType::Host);
+            if constexpr (dr::is_jit_v<Float>)
+                dr::sync_thread();
+
+            h = hash_buffer(h, vertices.data(), vertices.size() * sizeof(ScalarFloat));
+            h = hash_buffer(h, faces.data(), faces.size() * sizeof(uint32_t));
+        } else {
+            // Other shapes may consist of several primitives (e.g. instances)
+            for (Index i = 0; i < shape->primitive_count(); ++i) {
+                ScalarBoundingBox3f prim_bbox = shape->bbox(i);
+                h = hash_buffer(h, &prim_bbox, sizeof(prim_bbox));
+            }
+        }
+    }
+
+    return h;
+}
+
+MI_VARIANT bool ShapeKDTree<Float, Spectrum>::load_cache(const fs::path &filename,
+                                                          uint64_t hash) {
+    if (!fs::exists(filename))
+        return false;
+
+    Timer timer;
+    try {
+        ref<MemoryMappedFile> mmap = new MemoryMappedFile(filename);
+        const uint8_t *data = (const uint8_t *) mmap->data();
+
+        KDTreeCacheHeader header;
+        if (mmap->size() < sizeof(KDTreeCacheHeader))
+            Throw("truncated file");
+        std::memcpy(&header, data, sizeof(KDTreeCacheHeader));
+
+        if (std::memcmp(header.magic, "MIKD", 4) != 0 ||
+            header.version != KDTreeCacheVersion)
+            Throw("invalid file format");
+        if (header.hash != hash || header.scalar_size != sizeof(ScalarFloat) ||
+            header.node_size != sizeof(KDNode))
+            Throw("the file belongs to a different kd-tree");
+
+        size_t node_bytes  = (size_t) header.node_count * sizeof(KDNode),
+               index_bytes = (size_t) header.index_count * sizeof(Index);
+        if (mmap->size() != sizeof(KDTreeCacheHeader) + node_bytes + index_bytes)
+            Throw("truncated file");
+
+        data += sizeof(KDTreeCacheHeader);
+        uint64_t checksum = hash_buffer(hash_buffer(0, data, node_bytes),
+                                        data + node_bytes, index_bytes);
+        if (header.node_count == 0 || checksum != header.checksum)
+            Throw("checksum mismatch");
+
+        m_nodes.reset(new KDNode[header.node_count]);
+        std::memcpy(m_nodes.get(), data, node_bytes);
+        m_indices.reset(new Index[header.index_count]);
+        std::memcpy(m_indices.get(), data + node_bytes, index_bytes);
+
+        // Traversal trusts the node offsets and primitive indices
+        for (size_t i = 0; i < header.node_count; ++i) {
+            const KDNode &node = m_nodes[i];
+            bool valid;
+            if (node.leaf())
+                valid = (size_t) node.primitive_offset() + node.primitive_count() <=
+                        header.index_count;
+            else
+                valid = node.axis() < 3 && node.left_offset() > 0 &&
+                        i + node.left_offset() + 1 < header.node_count;
+            if (!valid)
+                Throw("invalid node %zu", i);
+        }
+
+        Size prim_count = primitive_count();
+        for (size_t i = 0; i < header.index_count; ++i) {
+            if (m_indices[i] >= prim_count)
+                Throw("invalid primitive index %zu", i);
+        }
+
+        m_node_count = header.node_count;
+        m_index_count = header.index_count;
+        for (size_t i = 0; i < 3; ++i) {
+            m_bbox.min[i] = (ScalarFloat) header.bbox_min[i];
+            m_bbox.max[i] = (ScalarFloat) header.bbox_max[i];
+        }
+    } catch (const std::exception &e) {
+        Log(Warn, "Unable to load the kd-tree cache file \"%s\" (%s), "
+            "rebuilding the kd-tree.", filename, e.what());
+        m_nodes.reset();
+        m_indices.reset();
+        m_node_count = m_index_count = 0;
+        return false;
+    }
+
+    Log(Info, "Loaded the kd-tree from \"%s\" (%s, took %s)", filename,
+        util::mem_string(m_index_count * sizeof(Index) +
+                         m_node_count * sizeof(KDNode)),
+        util::time_string((float) timer.value()));
+    return true;
+}
+
+MI_VARIANT void ShapeKDTree<Float, Spectrum>::save_cache(const fs::path &filename,
+                                                         uint64_t hash) const {
+    KDTreeCacheHeader header;
+    std::memcpy(header.magic, "MIKD", 4);
+    header.version = KDTreeCacheVersion;
+    header.hash = hash;
+    header.checksum = hash_buffer(
+        hash_buffer(0, m_nodes.get(), m_node_count * sizeof(KDNode)),
+        m_indices.get(), m_index_count * sizeof(Index));
+    header.scalar_size = (uint32_t) sizeof(ScalarFloat);
+    header.node_size = (uint32_t) sizeof(KDNode);
+    header.node_count = m_node_count;
+    header.index_count = m_index_count;
+    for (size_t i = 0; i < 3; ++i) {
+        header.bbox_min[i] = (double) m_bbox.min[i];
+        header.bbox_max[i] = (double) m_bbox.max[i];
+    }
+
+    /* Write to a temporary file first, so that concurrent processes never
+       observe a partially written cache file */
+    fs::path temp = filename;
+    temp.replace_extension(tfm::format(".%08x.tmp", std::random_device()()));
+
+    try {
+        ref<FileStream> stream = new FileStream(temp, FileStream::ETruncReadWrite);
+        stream->write(&header, sizeof(KDTreeCacheHeader));
+        stream->write(m_nodes.get(), m_node_count * sizeof(KDNode));
+        stream->write(m_indices.get(), m_index_count * sizeof(Index));
+        stream->close();
+
+        if (!fs::rename(temp, filename))
+            Throw("unable to rename \"%s\"", temp);
+        Log(Debug, "Stored the kd-tree in \"%s\"", filename);
+    } catch (const std::exception &e) {
+        Log(Warn, "Unable to store the kd-tree cache file \"%s\": %s",
+            filename, e.what());
+        fs::remove(temp);
+    }
+}
+
+MI_VARIANT bool ShapeKDTree<Float, Spectrum>::update(const std::vector<Index> &dirty) {
+    if (!ready())
+        return false;
+
+    // Validate the changes before touching the current state of the tree
+    std::vector<uint8_t> outdated = m_shape_outdated;
+    for (Index i : dirty) {
+        if (i >= shape_count() ||
+            m_shapes[i]->primitive_count() != m_primitive_map[i + 1] - m_primitive_map[i])
+            return false;
+        outdated[i] = 1;
+    }
+
+    size_t outdated_prims = 0;
+    for (Size i = 0; i < shape_count(); ++i) {
+        if (outdated[i])
+            outdated_prims += m_primitive_map[i + 1] - m_primitive_map[i];
+    }
+
+    if (outdated_prims > m_rebuild_fraction * primitive_count()) {
+        Log(Debug, "kd-tree update: %i of %i primitives changed, rebuilding instead.",
+            outdated_prims, primitive_count());
+        return false;
+    }
+
+    Timer timer;
+    ref<ShapeKDTree> dynamic = new ShapeKDTree(Base::cost_model());
+    dynamic->set_stop_primitives(Base::stop_primitives());
+    dynamic->set_max_depth(Base::max_depth());
+    dynamic->set_min_max_bins(Base::min_max_bins());
+    dynamic->set_clip_primitives(Base::clip_primitives());
+    dynamic->set_retract_bad_splits(Base::retract_bad_splits());
+    dynamic->set_exact_primitive_threshold(Base::exact_primitive_threshold());
+    dynamic->set_log_level(Base::log_level());
+
+    std::vector<Index> dynamic_shapes;
+    for (Size i = 0; i < shape_count(); ++i) {
+        if (outdated[i]) {
+            dynamic->add_shape(m_shapes[i]);
+            dynamic_shapes.push_back(i);
+        }
+    }
+    if (!dynamic_shapes.empty())
+        dynamic->build();
+
+    m_dynamic = dynamic_shapes.empty() ? nullptr : dynamic;
+    m_dynamic_shapes = std::move(dynamic_shapes);
+    m_shape_outdated = std::move(outdated);
+
+    Log(Info, "Updated the kd-tree (%i shapes with %i primitives in the "
+        "secondary tree, took %s)", m_dynamic_shapes.size(), outdated_prims,
+        util::time_string((float) timer.value()));
+
+    return true;
 }
 
 MI_VARIANT void ShapeKDTree<Float, Spectrum>::add_shape(Shape *shape) {
@@ -4,12 +4,13 @@
 #include <mitsuba/render/phase.h>
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/texture.h>
+#include <mitsuba/render/volume.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
-MI_VARIANT Medium<Float, Spectrum>::Medium() : m_is_homogeneous(false), m_has_spectral_extinction(true) {}
+MI_VARIANT Medium<Float, Spectrum>::Medium() : m_is_homogeneous(false), m_has_spectral_extinction(true), m_is_emitter(false) {}
 
-MI_VARIANT Medium<Float, Spectrum>::Medium(const Properties &props) : m_id(props.id()) {
+MI_VARIANT Medium<Float, Spectrum>::Medium(const Properties &props) : m_is_emitter(false), m_id(props.id()) {
 
     for (auto &[name, obj] : props.objects(false)) {
         auto *phase = dynamic_cast<PhaseFunction *>(obj.get());
@@ -29,6 +30,8 @@ MI_VARIANT Medium<Float, Spectrum>::Medium(const Properties &props) : m_id(props
     m_sample_emitters = props.get<bool>("sample_emitters", true);
     dr::set_attr(this, "use_emitter_sampling", m_sample_emitters);
     dr::set_attr(this, "phase_function", m_phase_function.get());
+    dr::set_attr(this, "is_emitter", m_is_emitter);
+    dr::set_attr(this, "emitter", (const Emitter *) m_emitter);
 }
 
 MI_VARIANT Medium<Float, Spectrum>::~Medium() {}
@@ -40,7 +43,9 @@ MI_VARIANT void Medium<Float, Spectrum>::traverse(TraversalCallback *callback) {
 MI_VARIANT
 typename Medium<Float, Spectrum>::MediumInteraction3f
 Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
-                                            UInt32 channel, Mask active) const {
+                                            UInt32 channel, Mask active,
+                                            Float footprint,
+                                            Float spread) const {
     MI_MASKED_FUNCTION(ProfilerPhase::MediumSample, active);
 
     // initialize basic medium interaction fields
@@ -59,25 +64,61 @@ Medium<Float, Spectrum>::sample_interaction(const Ray3f &ray, Float sample,
     mint = dr::maximum(0.f, mint);
     maxt = dr::minimum(ray.maxt, maxt);
 
-    auto combined_extinction = get_majorant(mei, active);
-    Float m                  = combined_extinction[0];
-    if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
-        dr::masked(m, dr::eq(channel, 1u)) = combined_extinction[1];
-        dr::masked(m, dr::eq(channel, 2u)) = combined_extinction[2];
-    } else {
+    UnpolarizedSpectrum combined_extinction;
+    Float sampled_t;
+    Mask use_max = false;
+    if (has_majorant_grid()) {
+        auto [t, majorant] = sample_majorant_grid(
+            ray, mint, maxt, -dr::log(1 - sample), active);
+        combined_extinction = majorant;
+        sampled_t = t;
         DRJIT_MARK_USED(channel);
+    } else {
+        combined_extinction = get_majorant(mei, active);
+        Float m             = combined_extinction[0];
+        if constexpr (is_rgb_v<Spectrum>) { // Handle RGB rendering
+            dr::masked(m, dr::eq(channel, 1u)) = combined_extinction[1];
+            dr::masked(m, dr::eq(channel, 2u)) = combined_extinction[2];
+        } else {
+            DRJIT_MARK_USED(channel);
+        }
+
+        // Sample against the maximum majorant over all channels (see MaxMajorantChannel)
+        use_max = channel >= (uint32_t) dr::array_size_v<UnpolarizedSpectrum>;
+        dr::masked(m, use_max) = dr::max(combined_extinction);
+        dr::masked(combined_extinction, use_max) = UnpolarizedSpectrum(m);
+
+        sampled_t = mint + (-dr::log(1 - sample) / m);
     }
 
-    Float sampled_t = mint + (-dr::log(1 - sample) / m);
     Mask valid_mi   = active && (sampled_t <= maxt);
     mei.t           = dr::select(valid_mi, sampled_t, dr::Infinity<Float>);
-    mei.p           = ray(sampled_t);
+    /* As with a global majorant, lanes without an interaction report the
+       position at the sampled distance. The supergrid traversal does not
+       produce a finite distance for them: use the entry point instead. */
+    Float p_t = sampled_t;
+    if (has_majorant_grid())
+        dr::masked(p_t, !valid_mi) = mint;
+    mei.p           = ray(p_t);
     mei.medium      = this;
     mei.mint        = mint;
+    mei.footprint   = dr::fmadd(spread, dr::select(valid_mi, sampled_t, mint), footprint);
+
+    // Cache spatially varying phase function parameters, which are then
+    // shared by the projected area below and all later phase function queries
+    if (has_flag(m_phase_function->flags(), PhaseFunctionFlags::Microflake))
+        mei.phase_params = m_phase_function->eval_params(mei, valid_mi);
 
     std::tie(mei.sigma_s, mei.sigma_n, mei.sigma_t) =
         get_scattering_coefficients(mei, valid_mi);
     mei.combined_extinction = combined_extinction;
+
+    // The null-collision coefficient is relative to the local majorant
+    if (has_majorant_grid())
+        mei.sigma_n = dr::select(valid_mi, combined_extinction - mei.sigma_t, 0.f);
+    else
+        dr::masked(mei.sigma_n, use_max) =
+            dr::select(valid_mi, combined_extinction - mei.sigma_t, 0.f);
     return mei;
 }
 
@@ -95,6 +136,200 @@ Medium<Float, Spectrum>::transmittance_eval_pdf(const MediumInteraction3f &mi,
     return { tr, pdf };
 }
 
+MI_VARIANT typename Medium<Float, Spectrum>::UnpolarizedSpectrum
+Medium<Float, Spectrum>::get_control_extinction(const MediumInteraction3f & /* mi */,
+                                                Mask /* active */) const {
+    return 0.f;
+}
+
+MI_VARIANT typename Medium<Float, Spectrum>::UnpolarizedSpectrum
+Medium<Float, Spectrum>::get_radiance(const MediumInteraction3f & /* mi */,
+                                      Mask /* active */) const {
+    return 0.f;
+}
+
+MI_VARIANT std::pair<typename Medium<Float, Spectrum>::Point3f, Float>
+Medium<Float, Spectrum>::sample_emission(const Point3f & /* sample */,
+                                         Mask /* active */) const {
+    return { dr::zeros<Point3f>(), 0.f };
+}
+
+MI_VARIANT Float
+Medium<Float, Spectrum>::pdf_emission(const Point3f & /* p */,
+                                      Mask /* active */) const {
+    return 0.f;
+}
+
+MI_VARIANT typename Medium<Float, Spectrum>::ScalarFloat
+Medium<Float, Spectrum>::emission_power() const {
+    return 0.f;
+}
+
+MI_VARIANT void Medium<Float, Spectrum>::set_emitter(Emitter *emitter) {
+    m_emitter = emitter;
+    dr::set_attr(this, "emitter", (const Emitter *) m_emitter);
+}
+
+MI_VARIANT void
+Medium<Float, Spectrum>::update_majorant_grid(const Volume *volume,
+                                              ScalarFloat scale,
+                                              uint32_t factor) {
+    if (factor == 0) {
+        m_majorant_grid = FloatStorage();
+        m_majorant_occupancy = UInt32Storage();
+        return;
+    }
+
+    ScalarVector3i res = volume->resolution();
+    m_majorant_resolution =
+        dr::maximum((res + (int32_t) factor - 1) / (int32_t) factor, 1);
+    m_majorant_to_local = volume->to_local();
+
+    size_t size = (size_t) dr::prod(m_majorant_resolution);
+    std::unique_ptr<ScalarFloat[]> majorants(new ScalarFloat[size]);
+    volume->local_majorants(m_majorant_resolution, majorants.get());
+    for (size_t i = 0; i < size; ++i)
+        majorants[i] *= scale;
+
+    m_majorant_grid = dr::load<FloatStorage>(majorants.get(), size);
+
+    // Mark blocks of cells that contain a nonzero majorant
+    const ScalarVector3i &mres = m_majorant_resolution;
+    m_majorant_block_resolution =
+        (mres + ((1 << MajorantBlockShift) - 1)) >> MajorantBlockShift;
+    const ScalarVector3i &bres = m_majorant_block_resolution;
+    std::vector<uint32_t> occupancy(((size_t) dr::prod(bres) + 31) / 32, 0u);
+    const ScalarFloat *ptr = majorants.get();
+    for (int z = 0; z < mres.z(); ++z) {
+        for (int y = 0; y < mres.y(); ++y) {
+            for (int x = 0; x < mres.x(); ++x) {
+                if (*ptr++ == 0.f)
+                    continue;
+                ScalarVector3i b = ScalarVector3i(x, y, z) >> MajorantBlockShift;
+                size_t index = ((size_t) b.z() * bres.y() + b.y()) * bres.x() + b.x();
+                occupancy[index / 32] |= 1u << (index % 32);
+            }
+        }
+    }
+    m_majorant_occupancy =
+        dr::load<UInt32Storage>(occupancy.data(), occupancy.size());
+
+    Log(Debug, "Medium \"%s\": built a %s majorant supergrid (factor %u)",
+        m_id, m_majorant_resolution, factor);
+}
+
+MI_VARIANT Float
+Medium<Float, Spectrum>::eval_majorant_grid(const Point3f &p, Mask active) const {
+    ScalarVector3f res(m_majorant_resolution);
+    Point3f p_grid = (m_majorant_to_local * p) * res;
+    Vector3i cell  = dr::clamp(dr::floor2int<Vector3i>(p_grid), 0,
+                               m_majorant_resolution - 1);
+    UInt32 index = UInt32(
+        (cell.z() * m_majorant_resolution.y() + cell.y()) *
+            m_majorant_resolution.x() + cell.x());
+    return dr::gather<Float>(m_majorant_grid, index, active);
+}
+
+MI_VARIANT std::pair<Float, Float>
+Medium<Float, Spectrum>::sample_majorant_grid(const Ray3f &ray, Float mint,
+                                              Float maxt, Float tau,
+                                              Mask active) const {
+    MI_MASK_ARGUMENT(active);
+
+    // Express the ray in the index space of the supergrid. The mapping is
+    // affine, so distances along the ray are preserved.
+    ScalarVector3f res(m_majorant_resolution);
+    Point3f o  = (m_majorant_to_local * ray.o) * res;
+    Vector3f d = (m_majorant_to_local * ray.d) * res;
+
+    Float t = mint;
+    Point3f p_start = o + d * t;
+    Vector3i cell = dr::clamp(dr::floor2int<Vector3i>(p_start), 0,
+                              m_majorant_resolution - 1);
+
+    auto positive = d >= 0.f;
+    Vector3i step = dr::select(positive, Vector3i(1), Vector3i(-1));
+    Vector3f inv_d = dr::rcp(d);
+    Vector3f t_delta = dr::abs(inv_d);
+
+    // Distance to the next cell boundary along each axis
+    Vector3f t_next = dr::select(
+        dr::neq(d, 0.f),
+        (Vector3f(cell + dr::select(positive, Vector3i(1), Vector3i(0))) - o) * inv_d,
+        dr::Infinity<Float>);
+
+    Float tau_acc = 0.f, majorant = 0.f,
+          sampled_t = dr::Infinity<Float>;
+    Mask active_dda = active;
+
+    dr::Loop<Mask> loop("Medium majorant grid traversal", active_dda, t,
+                        cell, t_next, tau_acc, majorant, sampled_t);
+    while (loop(active_dda)) {
+        // Jump to the exit of the current block if it is entirely empty
+        const ScalarVector3i &bres = m_majorant_block_resolution;
+        Vector3i block = cell >> MajorantBlockShift;
+        UInt32 block_index =
+            UInt32((block.z() * bres.y() + block.y()) * bres.x() + block.x());
+        UInt32 word = dr::gather<UInt32>(m_majorant_occupancy,
+                                         block_index >> 5, active_dda);
+        Mask empty = active_dda && dr::eq((word >> (block_index & 31u)) & 1u, 0u);
+
+        Vector3i block_lo = block << MajorantBlockShift,
+                 block_hi = block_lo + ((1 << MajorantBlockShift) - 1);
+        Vector3f t_face = dr::select(
+            dr::neq(d, 0.f),
+            (Vector3f(dr::select(positive, block_hi + 1, block_lo)) - o) * inv_d,
+            dr::Infinity<Float>);
+        Float t_block = dr::min(t_face);
+
+        // The cell entered across the closest face of the block
+        auto exit_axis = dr::eq(t_face, t_block);
+        Vector3i cell_block = dr::select(
+            exit_axis, dr::select(positive, block_hi + 1, block_lo - 1),
+            dr::clamp(dr::floor2int<Vector3i>(o + d * t_block), block_lo, block_hi));
+        Vector3f t_next_block = dr::select(
+            dr::neq(d, 0.f),
+            (Vector3f(cell_block + dr::select(positive, Vector3i(1), Vector3i(0))) - o) * inv_d,
+            dr::Infinity<Float>);
+
+        dr::masked(cell, empty) = cell_block;
+        dr::masked(t_next, empty) = dr::maximum(t_next_block, t_block);
+        dr::masked(t, empty) = dr::minimum(t_block, maxt);
+        dr::masked(majorant, empty) = 0.f;
+
+        // Otherwise, process the current cell
+        Mask active_cell = active_dda && !empty;
+        UInt32 index = UInt32(
+            (cell.z() * m_majorant_resolution.y() + cell.y()) *
+                m_majorant_resolution.x() + cell.x());
+        Float m = dr::gather<Float>(m_majorant_grid, index, active_cell);
+        dr::masked(majorant, active_cell) = m;
+
+        Float t_min  = dr::min(t_next),
+              t_exit = dr::minimum(t_min, maxt),
+              tau_seg = m * (t_exit - t);
+
+        // The target optical depth is reached inside the current cell
+        Mask done = active_cell && (m > 0.f) && (tau_acc + tau_seg >= tau);
+        dr::masked(sampled_t, done) = t + (tau - tau_acc) / m;
+        active_dda &= !done;
+        active_cell &= !done;
+
+        dr::masked(tau_acc, active_cell) += tau_seg;
+        dr::masked(t, active_cell) = t_exit;
+
+        // Step into the neighboring cell(s) across the closest boundary
+        auto axis = active_cell && dr::eq(t_next, t_min);
+        dr::masked(cell, axis) += step;
+        dr::masked(t_next, axis) += t_delta;
+
+        active_dda &= (t < maxt) && dr::all((cell >= 0) &&
+                                            (cell < m_majorant_resolution));
+    }
+
+    return { sampled_t, majorant };
+}
+
 MI_IMPLEMENT_CLASS_VARIANT(Medium, Object, "medium")
 MI_INSTANTIATE_CLASS(Medium)
 NAMESPACE_END(mitsuba)
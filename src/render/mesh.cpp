@@ -456,7 +456,7 @@ MI_VARIANT void Mesh<Float, Spectrum>::build_pmf() {
             table[i] = .5f * dr::norm(dr::cross(p1 - p0, p2 - p0));
         }
 
-        m_area_pmf = DiscreteDistribution<Float>(table.data(), m_face_count);
+        m_area_pmf = AliasDistribution<Float>(table.data(), m_face_count);
     } else {
         Vector3u v_idx = face_indices(dr::arange<UInt32>(m_face_count));
         Point3f p0 = vertex_position(v_idx[0]), p1 = vertex_position(v_idx[1]),
@@ -464,7 +464,7 @@ MI_VARIANT void Mesh<Float, Spectrum>::build_pmf() {
 
         Float face_surface_area = .5f * dr::norm(dr::cross(p1 - p0, p2 - p0));
 
-        m_area_pmf = DiscreteDistribution<Float>(dr::detach(face_surface_area));
+        m_area_pmf = AliasDistribution<Float>(dr::detach(face_surface_area));
     }
 }
 
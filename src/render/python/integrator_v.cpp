@@ -117,6 +117,10 @@ public:
         PYBIND11_OVERRIDE(std::vector<std::string>, SamplingIntegrator, aov_names, );
     }
 
+    bool supports_volume_emitters() const override {
+        PYBIND11_OVERRIDE(bool, SamplingIntegrator, supports_volume_emitters, );
+    }
+
     std::string to_string() const override {
         PYBIND11_OVERRIDE(std::string, SamplingIntegrator, to_string, );
     }
@@ -165,6 +169,10 @@ public:
         PYBIND11_OVERRIDE(std::vector<std::string>, AdjointIntegrator, aov_names, );
     }
 
+    bool supports_volume_emitters() const override {
+        PYBIND11_OVERRIDE(bool, AdjointIntegrator, supports_volume_emitters, );
+    }
+
     std::string to_string() const override {
         PYBIND11_OVERRIDE(std::string, AdjointIntegrator, to_string, );
     }
@@ -279,6 +287,10 @@ public:
         PYBIND11_OVERRIDE(std::vector<std::string>, Base, aov_names, );
     }
 
+    bool supports_volume_emitters() const override {
+        PYBIND11_OVERRIDE(bool, Base, supports_volume_emitters, );
+    }
+
     std::string to_string() const override {
         PYBIND11_OVERRIDE(std::string, Base, to_string, );
     }
@@ -319,7 +331,8 @@ MI_PY_EXPORT(Integrator) {
             "seed"_a = 0, "spp"_a = 0, "develop"_a = true, "evaluate"_a = true)
         .def_method(Integrator, cancel)
         .def_method(Integrator, should_stop)
-        .def_method(Integrator, aov_names);
+        .def_method(Integrator, aov_names)
+        .def_method(Integrator, supports_volume_emitters);
 
     MI_PY_TRAMPOLINE_CLASS(PySamplingIntegrator, SamplingIntegrator, Integrator)
         .def(py::init<const Properties &>())
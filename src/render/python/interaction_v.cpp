@@ -108,6 +108,18 @@ MI_PY_EXPORT(MediumInteraction) {
         .def_field(MediumInteraction3f, sigma_t,    D(MediumInteraction, sigma_t))
         .def_field(MediumInteraction3f, combined_extinction, D(MediumInteraction, combined_extinction))
         .def_field(MediumInteraction3f, mint, D(MediumInteraction, mint))
+        .def_field(MediumInteraction3f, footprint, D(MediumInteraction, footprint))
+        .def_property("phase_params",
+            [](const MediumInteraction3f &mi) {
+                std::array<Float, 6> output;
+                for (size_t i = 0; i < 6; ++i)
+                    output[i] = mi.phase_params[i];
+                return output;
+            },
+            [](MediumInteraction3f &mi, const std::array<Float, 6> &value) {
+                for (size_t i = 0; i < 6; ++i)
+                    mi.phase_params[i] = value[i];
+            }, D(MediumInteraction, phase_params))
 
         // Methods
         .def(py::init<>(), D(MediumInteraction, MediumInteraction))
@@ -118,7 +130,7 @@ MI_PY_EXPORT(MediumInteraction) {
 
     MI_PY_DRJIT_STRUCT(mi, MediumInteraction3f, t, time, wavelengths, p, n,
                        medium, sh_frame, wi, sigma_s, sigma_n, sigma_t,
-                       combined_extinction, mint)
+                       combined_extinction, mint, footprint)
 }
 
 MI_PY_EXPORT(PreliminaryIntersection) {
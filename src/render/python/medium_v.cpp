@@ -58,20 +58,34 @@ template <typename Ptr, typename Cls> void bind_medium_generic(Cls &cls) {
        .def("has_spectral_extinction",
             [](Ptr ptr) { return ptr->has_spectral_extinction(); },
             D(Medium, has_spectral_extinction))
+       .def("is_emitter",
+            [](Ptr ptr) { return ptr->is_emitter(); },
+            D(Medium, is_emitter))
+       .def("emitter",
+            [](Ptr ptr) { return ptr->emitter(); },
+            D(Medium, emitter))
        .def("get_majorant",
             [](Ptr ptr, const MediumInteraction3f &mi, Mask active) {
                 return ptr->get_majorant(mi, active); },
             "mi"_a, "active"_a=true,
             D(Medium, get_majorant))
+       .def("get_control_extinction",
+            [](Ptr ptr, const MediumInteraction3f &mi, Mask active) {
+                return ptr->get_control_extinction(mi, active); },
+            "mi"_a, "active"_a=true,
+            D(Medium, get_control_extinction))
        .def("intersect_aabb",
             [](Ptr ptr, const Ray3f &ray) {
                 return ptr->intersect_aabb(ray); },
             "ray"_a,
             D(Medium, intersect_aabb))
        .def("sample_interaction",
-            [](Ptr ptr, const Ray3f &ray, Float sample, UInt32 channel, Mask active) {
-                return ptr->sample_interaction(ray, sample, channel, active); },
+            [](Ptr ptr, const Ray3f &ray, Float sample, UInt32 channel,
+               Mask active, Float footprint, Float spread) {
+                return ptr->sample_interaction(ray, sample, channel, active,
+                                               footprint, spread); },
             "ray"_a, "sample"_a, "channel"_a, "active"_a,
+            "footprint"_a = 0.f, "spread"_a = 0.f,
             D(Medium, sample_interaction))
        .def("transmittance_eval_pdf",
             [](Ptr ptr, const MediumInteraction3f &mi,
@@ -83,7 +97,22 @@ template <typename Ptr, typename Cls> void bind_medium_generic(Cls &cls) {
             [](Ptr ptr, const MediumInteraction3f &mi, Mask active = true) {
                 return ptr->get_scattering_coefficients(mi, active); },
             "mi"_a, "active"_a=true,
-            D(Medium, get_scattering_coefficients));
+            D(Medium, get_scattering_coefficients))
+       .def("get_radiance",
+            [](Ptr ptr, const MediumInteraction3f &mi, Mask active = true) {
+                return ptr->get_radiance(mi, active); },
+            "mi"_a, "active"_a=true,
+            D(Medium, get_radiance))
+       .def("sample_emission",
+            [](Ptr ptr, const Point3f &sample, Mask active = true) {
+                return ptr->sample_emission(sample, active); },
+            "sample"_a, "active"_a=true,
+            D(Medium, sample_emission))
+       .def("pdf_emission",
+            [](Ptr ptr, const Point3f &p, Mask active = true) {
+                return ptr->pdf_emission(p, active); },
+            "p"_a, "active"_a=true,
+            D(Medium, pdf_emission));
 
     if constexpr (dr::is_array_v<Ptr>)
         bind_drjit_ptr_array(cls);
@@ -96,6 +125,8 @@ MI_PY_EXPORT(Medium) {
     auto medium = MI_PY_TRAMPOLINE_CLASS(PyMedium, Medium, Object)
             .def(py::init<const Properties &>())
             .def_method(Medium, id)
+            .def_method(Medium, has_majorant_grid)
+            .def_method(Medium, emission_power)
             .def_property("m_sample_emitters",
                 [](PyMedium &medium){ return medium.m_sample_emitters; },
                 [](PyMedium &medium, bool value){
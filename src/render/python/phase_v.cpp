@@ -34,6 +34,11 @@ public:
         PYBIND11_OVERRIDE(Float, PhaseFunction, max_projected_area);
     }
 
+    dr::Array<Float, 6> eval_params(const MediumInteraction3f &mi, Mask active) const override {
+        using Return = dr::Array<Float, 6>;
+        PYBIND11_OVERRIDE(Return, PhaseFunction, eval_params, mi, active);
+    }
+
     std::string to_string() const override {
         PYBIND11_OVERRIDE_PURE(std::string, PhaseFunction, to_string);
     }
@@ -73,6 +78,16 @@ template <typename Ptr, typename Cls> void bind_phase_generic(Cls &cls) {
        .def("max_projected_area",
             [](Ptr ptr) { return ptr->max_projected_area(); },
             D(PhaseFunction, max_projected_area))
+       .def("eval_params",
+            [](Ptr ptr, const MediumInteraction3f &mi, Mask active) {
+                dr::Array<Float, 6> result = ptr->eval_params(mi, active);
+                std::array<Float, 6> output;
+                for (size_t i = 0; i < 6; ++i)
+                    output[i] = std::move(result[i]);
+                return output;
+            },
+            "mi"_a, "active"_a = true,
+            D(PhaseFunction, eval_params))
        .def("flags", [](Ptr ptr, Mask active) { return ptr->flags(active); },
             "active"_a = true, D(PhaseFunction, flags))
        .def("component_count", [](Ptr ptr, Mask active) { return ptr->component_count(active); },
@@ -53,6 +53,9 @@ MI_PY_EXPORT(Scene) {
         .def("ray_intersect",
              py::overload_cast<const Ray3f &, uint32_t, Mask, Mask>(&Scene::ray_intersect, py::const_),
              "ray"_a, "ray_flags"_a, "coherent"_a, "active"_a = true, D(Scene, ray_intersect, 2))
+        .def("ray_intersect_sorted", &Scene::ray_intersect_sorted,
+             "ray"_a, "ray_flags"_a = +RayFlags::All, "active"_a = true,
+             D(Scene, ray_intersect_sorted))
         .def("ray_test",
              py::overload_cast<const Ray3f &, Mask>(&Scene::ray_test, py::const_),
              "ray"_a, "active"_a = true, D(Scene, ray_test))
@@ -146,5 +149,6 @@ MI_PY_EXPORT(Scene) {
              },
              D(Scene, integrator))
         .def_method(Scene, shapes_grad_enabled)
+        .def_method(Scene, has_media)
         .def("__repr__", &Scene::to_string);
 }
@@ -39,10 +39,22 @@ public:
         PYBIND11_OVERRIDE_PURE(ScalarFloat, Volume, max);
     }
 
+    ScalarFloat min() const override {
+        PYBIND11_OVERRIDE(ScalarFloat, Volume, min);
+    }
+
     ScalarVector3i resolution() const override {
         PYBIND11_OVERRIDE(ScalarVector3i, Volume, resolution);
     }
 
+    ScalarBoundingBox3f occupied_bbox() const override {
+        PYBIND11_OVERRIDE(ScalarBoundingBox3f, Volume, occupied_bbox);
+    }
+
+    uint32_t empty_space_block_size() const override {
+        PYBIND11_OVERRIDE(uint32_t, Volume, empty_space_block_size);
+    }
+
     std::string to_string() const override {
         PYBIND11_OVERRIDE(std::string, Volume, to_string);
     }
@@ -56,8 +68,11 @@ MI_PY_EXPORT(Volume) {
         .def(py::init<const Properties &>(), "props"_a)
         .def_method(Volume, resolution)
         .def_method(Volume, bbox)
+        .def_method(Volume, occupied_bbox)
+        .def_method(Volume, empty_space_block_size)
         .def_method(Volume, channel_count)
         .def_method(Volume, max)
+        .def_method(Volume, min)
         .def("max_per_channel",
             [] (const Volume *volume) {
                 std::vector<ScalarFloat> max_values(volume->channel_count());
@@ -78,6 +93,7 @@ MI_PY_EXPORT(Volume) {
                 }, "it"_a, "active"_a = true, D(Volume, eval_6))
         .def("eval_gradient", &Volume::eval_gradient, "it"_a, "active"_a = true,
              D(Volume, eval_gradient))
+        .def_method(Volume, eval_filtered, "it"_a, "width"_a, "active"_a = true)
         .def("eval_n",
             [] (const Volume *volume, const Interaction3f &it, Mask active = true) {
                 std::vector<Float> evaluation(volume->channel_count());
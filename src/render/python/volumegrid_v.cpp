@@ -22,19 +22,13 @@ MI_PY_EXPORT(VolumeGrid) {
             auto volumegrid = new VolumeGrid(size, (uint32_t) channel_count);
             memcpy(volumegrid->data(), obj.data(), volumegrid->buffer_size());
 
-            ScalarFloat max = 0.f;
-            std::vector<ScalarFloat> max_per_channel(channel_count, -dr::Infinity<ScalarFloat>);
             if (compute_max) {
-                size_t ch_index = 0;
-                for (size_t i = 0; i < dr::prod(size) * channel_count; ++i) {
-                    max = dr::maximum(max, volumegrid->data()[i]);
-                    ch_index = i % channel_count;
-                    max_per_channel[ch_index] = dr::maximum(max_per_channel[ch_index], volumegrid->data()[i]);
-                }
+                volumegrid->update_max();
+            } else {
+                std::vector<ScalarFloat> max_per_channel(channel_count, -dr::Infinity<ScalarFloat>);
+                volumegrid->set_max(0.f);
+                volumegrid->set_max_per_channel(max_per_channel.data());
             }
-
-            volumegrid->set_max(max);
-            volumegrid->set_max_per_channel(max_per_channel.data());
             return volumegrid;
         }), "array"_a, "compute_max"_a = true, "Initialize a VolumeGrid from a NumPy array")
 
@@ -49,6 +43,8 @@ MI_PY_EXPORT(VolumeGrid) {
             },
             D(VolumeGrid, max_per_channel))
         .def_method(VolumeGrid, set_max)
+        .def_method(VolumeGrid, update_max, py::call_guard<py::gil_scoped_release>())
+        .def_method(VolumeGrid, is_mapped)
         .def("set_max_per_channel",
             [] (VolumeGrid *volgrid, std::vector<ScalarFloat> &max_values) {
                 volgrid->set_max_per_channel(max_values.data());
@@ -62,7 +58,7 @@ MI_PY_EXPORT(VolumeGrid) {
                 &VolumeGrid::write, py::const_), "path"_a, D(VolumeGrid, write, 2),
                 py::call_guard<py::gil_scoped_release>())
 
-        .def(py::init<const fs::path &>(), "path"_a,
+        .def(py::init<const fs::path &, bool>(), "path"_a, "use_mmap"_a = true,
             py::call_guard<py::gil_scoped_release>())
         .def(py::init<Stream *>(), "stream"_a,
             py::call_guard<py::gil_scoped_release>())
@@ -89,7 +85,9 @@ MI_PY_EXPORT(VolumeGrid) {
                 result["typestr"] = py::bytes(code);
             #endif
 
-            result["data"] = py::make_tuple(size_t(grid.data()), false);
+            // Memory-mapped grids are exposed without a copy, but read-only
+            const VolumeGrid &grid_const = grid;
+            result["data"] = py::make_tuple(size_t(grid_const.data()), grid.is_mapped());
             result["version"] = 3;
             return py::object(result);
         });
@@ -5,11 +5,13 @@
 #include <mitsuba/render/mesh.h>
 #include <mitsuba/render/scene.h>
 #include <mitsuba/render/integrator.h>
+#include <drjit/morton.h>
 
 #if defined(MI_ENABLE_EMBREE)
 #  include "scene_embree.inl"
 #else
 #  include <mitsuba/render/kdtree.h>
+#  include <mitsuba/render/bvh.h>
 #  include "scene_native.inl"
 #endif
 
@@ -20,6 +22,17 @@
 NAMESPACE_BEGIN(mitsuba)
 
 MI_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
+    // Emissive media referenced by the scene (each listed only once)
+    std::vector<Medium *> emissive_media;
+    m_has_media = false;
+    auto add_medium = [&](const Medium *medium) {
+        m_has_media |= medium != nullptr;
+        if (medium && medium->is_emitter() &&
+            std::find(emissive_media.begin(), emissive_media.end(), medium) ==
+                emissive_media.end())
+            emissive_media.push_back(const_cast<Medium *>(medium));
+    };
+
     for (auto &[k, v] : props.objects()) {
         Scene *scene           = dynamic_cast<Scene *>(v.get());
         Shape *shape           = dynamic_cast<Shape *>(v.get());
@@ -27,6 +40,7 @@ MI_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
         Emitter *emitter       = dynamic_cast<Emitter *>(v.get());
         Sensor *sensor         = dynamic_cast<Sensor *>(v.get());
         Integrator *integrator = dynamic_cast<Integrator *>(v.get());
+        Medium *medium         = dynamic_cast<Medium *>(v.get());
 
         if (!scene)
             m_children.push_back(v.get());
@@ -44,10 +58,13 @@ MI_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
             }
             if (mesh)
                 mesh->set_scene(this);
+            add_medium(shape->interior_medium());
+            add_medium(shape->exterior_medium());
         } else if (emitter) {
             // Surface emitters will be added to the list when attached to a shape
             if (!has_flag(emitter->flags(), EmitterFlags::Surface))
                 m_emitters.push_back(emitter);
+            add_medium(emitter->medium());
 
             if (emitter->is_environment()) {
                 if (m_environment)
@@ -56,13 +73,34 @@ MI_VARIANT Scene<Float, Spectrum>::Scene(const Properties &props) {
             }
         } else if (sensor) {
             m_sensors.push_back(sensor);
+            add_medium(sensor->medium());
         } else if (integrator) {
             if (m_integrator)
                 Throw("Only one integrator can be specified per scene.");
             m_integrator = integrator;
+        } else if (medium) {
+            add_medium(medium);
         }
     }
 
+    /* Expose the emission of participating media to next event estimation
+       through volume emitters. Their sampling weight defaults to the power
+       emitted by the medium. Integrators that do not collect the emission of
+       media along their paths cannot combine these samples with their other
+       strategies, hence volume emitters are only created on request. */
+    bool volume_emitters = props.get<bool>(
+        "volume_emitters", m_integrator && m_integrator->supports_volume_emitters());
+    for (Medium *medium : emissive_media) {
+        if (!volume_emitters || medium->emission_power() <= 0.f)
+            continue;
+        Properties props_emitter("volumelight");
+        props_emitter.set_object("medium", medium);
+        ref<Emitter> emitter =
+            PluginManager::instance()->create_object<Emitter>(props_emitter);
+        medium->set_emitter(emitter.get());
+        m_emitters.push_back(emitter);
+    }
+
     // Create sensors' shapes (environment sensors)
     for (Sensor *sensor: m_sensors)
         sensor->set_scene(this);
@@ -110,7 +148,7 @@ void Scene<Float, Spectrum>::update_emitter_sampling_distribution() {
         std::unique_ptr<ScalarFloat[]> sample_weights(new ScalarFloat[n_emitters]);
         for (size_t i = 0; i < n_emitters; ++i)
             sample_weights[i] = m_emitters[i]->sampling_weight();
-        m_emitter_distr = std::make_unique<DiscreteDistribution<Float>>(
+        m_emitter_distr = std::make_unique<AliasDistribution<Float>>(
             sample_weights.get(), n_emitters);
     } else {
         // By default use uniform sampling with constant PMF
@@ -161,6 +199,15 @@ MI_VARIANT Scene<Float, Spectrum>::~Scene() {
     else
         accel_release_cpu();
 
+    // Volume emitters are owned by the scene, detach them from their media
+    for (Emitter *emitter : m_emitters) {
+        if (!has_flag(emitter->flags(), EmitterFlags::Volume))
+            continue;
+        Medium *medium = emitter->medium();
+        if (medium && medium->emitter() == emitter)
+            medium->set_emitter(nullptr);
+    }
+
     // Trigger deallocation of all instances
     m_emitters.clear();
     m_shapes.clear();
@@ -209,6 +256,126 @@ Scene<Float, Spectrum>::ray_test(const Ray3f &ray, Mask coherent, Mask active) c
         return ray_test_cpu(ray, coherent, active);
 }
 
+/**
+ * \brief One pass of a parallel LSD radix sort over 8-bit digits
+ *
+ * Stably reorders the indices \c in by the digit of <tt>keys[in[i]]</tt>
+ * starting at bit \c shift, and writes the result to \c out.
+ */
+static void radix_sort_pass(const uint32_t *keys, const uint32_t *in,
+                            uint32_t *out, uint32_t size, uint32_t shift) {
+    constexpr uint32_t Bins = 256, BlockSize = 16384;
+    uint32_t block_count = (size + BlockSize - 1) / BlockSize;
+
+    // Per-block histogram of the digits
+    std::vector<uint32_t> offsets(block_count * Bins, 0);
+    dr::parallel_for(
+        dr::blocked_range<uint32_t>(0u, block_count, 1u),
+        [&](const dr::blocked_range<uint32_t> &range) {
+            for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                uint32_t *hist = offsets.data() + b * Bins,
+                         end   = std::min(size, (b + 1) * BlockSize);
+                for (uint32_t i = b * BlockSize; i < end; ++i)
+                    hist[(keys[in[i]] >> shift) & (Bins - 1)]++;
+            }
+        }
+    );
+
+    // Exclusive prefix sum ordered by digit, then by block
+    uint32_t sum = 0;
+    for (uint32_t d = 0; d < Bins; ++d) {
+        for (uint32_t b = 0; b < block_count; ++b) {
+            uint32_t &offset = offsets[b * Bins + d],
+                     count   = offset;
+            offset = sum;
+            sum += count;
+        }
+    }
+
+    // Scatter the indices to their sorted position
+    dr::parallel_for(
+        dr::blocked_range<uint32_t>(0u, block_count, 1u),
+        [&](const dr::blocked_range<uint32_t> &range) {
+            for (uint32_t b = range.begin(); b != range.end(); ++b) {
+                uint32_t *offset = offsets.data() + b * Bins,
+                         end     = std::min(size, (b + 1) * BlockSize);
+                for (uint32_t i = b * BlockSize; i < end; ++i)
+                    out[offset[(keys[in[i]] >> shift) & (Bins - 1)]++] = in[i];
+            }
+        }
+    );
+}
+
+MI_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
+Scene<Float, Spectrum>::ray_intersect_sorted(const Ray3f &ray, uint32_t ray_flags,
+                                             Mask active) const {
+    MI_MASKED_FUNCTION(ProfilerPhase::RayIntersect, active);
+
+    if constexpr (dr::is_llvm_v<Float>) {
+        uint32_t size = (uint32_t) std::max(dr::width(ray), dr::width(active));
+
+        if (!jit_flag(JitFlag::Recording) && size > 1 && m_bbox.valid()) {
+            /* Sort key: direction octant (3 bits) followed by the Morton code
+               of the origin cell in a 16^3 grid (12 bits). Inactive rays have
+               bit 15 set so that they come last. */
+            constexpr uint32_t Resolution = 16, Inactive = 1u << 15;
+
+            ScalarVector3f extents = m_bbox.extents(),
+                           scale   = dr::select(extents > 0.f,
+                                                ScalarFloat(Resolution) / extents, 0.f);
+            Point3f o = dr::detach(ray.o);
+            Vector3f d = dr::detach(ray.d);
+            Vector3u cell = Vector3u(dr::clamp((o - m_bbox.min) * scale, 0.f,
+                                               Resolution - 1.f));
+
+            UInt32 octant = dr::select(d.x() < 0.f, 1u, 0u) |
+                            dr::select(d.y() < 0.f, 2u, 0u) |
+                            dr::select(d.z() < 0.f, 4u, 0u);
+            UInt32 key = dr::select(
+                active,
+                (octant << 12) | dr::morton_encode(dr::Array<UInt32, 3>(cell)),
+                Inactive) + dr::zeros<UInt32>(size);
+
+            dr::eval(key);
+            dr::sync_thread();
+            const uint32_t *keys = key.data();
+
+            std::unique_ptr<uint32_t[]> identity(new uint32_t[size]),
+                                        slots(new uint32_t[size]),
+                                        order(new uint32_t[size]),
+                                        perm(new uint32_t[size]),
+                                        inv(new uint32_t[size]);
+            for (uint32_t i = 0; i < size; ++i)
+                identity[i] = i;
+
+            /* 'slots': indices of the active rays (in increasing order), which
+               is where the sorted active rays are placed. 'order': indices of
+               the active rays sorted by key. Both are followed by the indices
+               of the inactive rays, which thus keep their position. */
+            radix_sort_pass(keys, identity.get(), slots.get(), size, 15);
+            radix_sort_pass(keys, identity.get(), perm.get(), size, 0);
+            radix_sort_pass(keys, perm.get(), order.get(), size, 8);
+
+            for (uint32_t i = 0; i < size; ++i) {
+                perm[slots[i]] = order[i];
+                inv[order[i]] = slots[i];
+            }
+
+            UInt32 perm_v = dr::load<UInt32>(perm.get(), size),
+                   inv_v  = dr::load<UInt32>(inv.get(), size);
+
+            Ray3f ray_sorted = dr::gather<Ray3f>(dr::detach(ray), perm_v, active);
+            PreliminaryIntersection3f pi = dr::gather<PreliminaryIntersection3f>(
+                ray_intersect_preliminary(ray_sorted, false, active), inv_v, active);
+            pi.t = dr::select(active, pi.t, dr::Infinity<Float>);
+
+            return pi.compute_surface_interaction(ray, ray_flags, active);
+        }
+    }
+
+    return ray_intersect(ray, ray_flags, false, active);
+}
+
 MI_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect_naive(const Ray3f &ray, Mask active) const {
     MI_MASKED_FUNCTION(ProfilerPhase::RayIntersect, active);
@@ -287,6 +454,7 @@ Scene<Float, Spectrum>::sample_emitter_ray(Float time, Float sample1,
     } else if (emitter_count == 1) {
         std::tie(ray, weight) =
             m_emitters[0]->sample_ray(time, sample1, sample2, sample3, active);
+        emitter = EmitterPtr(m_emitters[0].get());
     } else {
         ray = dr::zeros<Ray3f>();
         weight = dr::zeros<Spectrum>();
@@ -3,19 +3,29 @@ NAMESPACE_BEGIN(mitsuba)
 template <typename Float, typename Spectrum>
 struct NativeState {
     MI_IMPORT_CORE_TYPES()
-    ShapeKDTree<Float, Spectrum> *accel;
+    /// Either a kd-tree or a wide BVH, depending on the 'accel' parameter
+    ShapeKDTree<Float, Spectrum> *accel = nullptr;
+    ShapeBVH<Float, Spectrum> *bvh = nullptr;
     DynamicBuffer<UInt32> shapes_registry_ids;
 };
 
 MI_VARIANT void Scene<Float, Spectrum>::accel_init_cpu(const Properties &props) {
-    ShapeKDTree *kdtree = new ShapeKDTree(props);
-    kdtree->inc_ref();
+    m_accel = new NativeState<Float, Spectrum>();
+    NativeState<Float, Spectrum> &s = *(NativeState<Float, Spectrum> *) m_accel;
+
+    std::string accel = props.string("accel", "kdtree");
+    if (accel == "kdtree") {
+        s.accel = new ShapeKDTree(props);
+        s.accel->inc_ref();
+    } else if (accel == "bvh") {
+        s.bvh = new ShapeBVH(props);
+        s.bvh->inc_ref();
+    } else {
+        Throw("Invalid acceleration data structure \"%s\", must be one of: "
+              "\"kdtree\", \"bvh\"!", accel);
+    }
 
     if constexpr (dr::is_llvm_v<Float>) {
-        m_accel = new NativeState<Float, Spectrum>();
-        NativeState<Float, Spectrum> &s = *(NativeState<Float, Spectrum> *) m_accel;
-        s.accel = kdtree;
-
         // Get shapes registry ids
         if (!m_shapes.empty()) {
             std::unique_ptr<uint32_t[]> data(new uint32_t[m_shapes.size()]);
@@ -26,8 +36,6 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_init_cpu(const Properties &props)
         } else {
             s.shapes_registry_ids = dr::zeros<DynamicBuffer<UInt32>>();
         }
-    } else {
-        m_accel = kdtree;
     }
 
     accel_parameters_changed_cpu();
@@ -38,17 +46,42 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu() {
     if constexpr (dr::is_llvm_v<Float>)
         dr::sync_thread();
 
-    ShapeKDTree *kdtree;
-    if constexpr (dr::is_llvm_v<Float>)
-        kdtree = ((NativeState<Float, Spectrum> *) m_accel)->accel;
-    else
-        kdtree = (ShapeKDTree *) m_accel;
-
-    kdtree->clear();
-    for (Shape *shape : m_shapes)
-        kdtree->add_shape(shape);
+    NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) m_accel;
     ScopedPhase phase(ProfilerPhase::InitAccel);
-    kdtree->build();
+
+    if (s->bvh) {
+        s->bvh->clear();
+        for (Shape *shape : m_shapes)
+            s->bvh->add_shape(shape);
+        s->bvh->build();
+    } else {
+        ShapeKDTree *kdtree = s->accel;
+
+        /* When only a few shapes changed, move them into a secondary kd-tree
+           instead of rebuilding everything (see ShapeKDTree::update()) */
+        bool updated = false;
+        if (kdtree->ready() && kdtree->shape_count() == m_shapes.size()) {
+            bool shapegroups_dirty = false;
+            for (auto &sg : m_shapegroups)
+                shapegroups_dirty |= sg->dirty();
+
+            if (!shapegroups_dirty) {
+                std::vector<uint32_t> dirty;
+                for (size_t i = 0; i < m_shapes.size(); ++i) {
+                    if (m_shapes[i]->dirty())
+                        dirty.push_back((uint32_t) i);
+                }
+                updated = kdtree->update(dirty);
+            }
+        }
+
+        if (!updated) {
+            kdtree->clear();
+            for (Shape *shape : m_shapes)
+                kdtree->add_shape(shape);
+            kdtree->build();
+        }
+    }
 
     /* Set up a callback on the handle variable to release the Embree
        acceleration data structure (IAS) when this variable is freed. This
@@ -59,7 +92,7 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu() {
         // Prevents the IAS to be released when updating the scene parameters
         if (m_accel_handle.index())
             jit_var_set_callback(m_accel_handle.index(), nullptr, nullptr);
-        m_accel_handle = dr::opaque<UInt64>(kdtree);
+        m_accel_handle = dr::opaque<UInt64>(m_accel);
         jit_var_set_callback(
             m_accel_handle.index(),
             [](uint32_t /* index */, int free, void *payload) {
@@ -69,8 +102,14 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_parameters_changed_cpu() {
                         Log(Debug, "Free KDTree..");
                         NativeState<Float, Spectrum> *s =
                             (NativeState<Float, Spectrum> *) payload;
-                        s->accel->clear();
-                        s->accel->dec_ref();
+                        if (s->accel) {
+                            s->accel->clear();
+                            s->accel->dec_ref();
+                        }
+                        if (s->bvh) {
+                            s->bvh->clear();
+                            s->bvh->dec_ref();
+                        }
                         delete s;
                     });
                     Thread::register_task(task);
@@ -93,7 +132,12 @@ MI_VARIANT void Scene<Float, Spectrum>::accel_release_cpu() {
            ray tracing calls are pending. */
         m_accel_handle = 0;
     } else {
-        ((ShapeKDTree *) m_accel)->dec_ref();
+        NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) m_accel;
+        if (s->accel)
+            s->accel->dec_ref();
+        if (s->bvh)
+            s->bvh->dec_ref();
+        delete s;
     }
 
     m_accel = nullptr;
@@ -116,17 +160,68 @@ template <typename ScalarFloat> struct RayHitT {
 #  pragma pack(pop)
 #endif
 
-template <typename Float, typename Spectrum, bool ShadowRay, size_t Width>
-void kdtree_trace_func_wrapper(const int *valid, void *ptr,
-                               void* /* context */, uint8_t *args) {
+template <typename Float, typename Spectrum, typename Accel, bool ShadowRay, size_t Width>
+void native_trace_func_wrapper(const int *valid, void *ptr,
+                              void* /* context */, uint8_t *args) {
     MI_IMPORT_TYPES()
     using ScalarRay3f = Ray<ScalarPoint3f, Spectrum>;
-    using ShapeKDTree = ShapeKDTree<Float, Spectrum>;
 
     NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) ptr;
-    const ShapeKDTree *kdtree = s->accel;
+    const Accel *accel;
+    if constexpr (std::is_same_v<Accel, ShapeBVH<Float, Spectrum>>)
+        accel = s->bvh;
+    else
+        accel = s->accel;
     using RayHit = RayHitT<ScalarFloat>;
 
+    if constexpr (std::is_same_v<Accel, ShapeKDTree<Float, Spectrum>> && Width > 1) {
+        if (accel->packet_traversal()) {
+            using FloatP  = dr::Packet<ScalarFloat, Width>;
+            using UInt32P = dr::Packet<uint32_t, Width>;
+            using MaskP   = dr::mask_t<FloatP>;
+            using Ray3fP  = Ray<Point<FloatP, 3>, Spectrum>;
+
+            auto field = [&](size_t offset) {
+                return (ScalarFloat *) &args[offset * Width];
+            };
+
+            MaskP active = dr::neq(dr::load<UInt32P>(valid), 0u);
+
+            Ray3fP ray;
+            ray.o = Point<FloatP, 3>(dr::load<FloatP>(field(offsetof(RayHit, o_x))),
+                                     dr::load<FloatP>(field(offsetof(RayHit, o_y))),
+                                     dr::load<FloatP>(field(offsetof(RayHit, o_z))));
+            ray.d = Vector<FloatP, 3>(dr::load<FloatP>(field(offsetof(RayHit, d_x))),
+                                      dr::load<FloatP>(field(offsetof(RayHit, d_y))),
+                                      dr::load<FloatP>(field(offsetof(RayHit, d_z))));
+            ray.maxt = dr::load<FloatP>(field(offsetof(RayHit, tfar)));
+            ray.time = dr::load<FloatP>(field(offsetof(RayHit, time)));
+
+            auto [t, prim_uv, prim_index, shape_index, inst_index] =
+                accel->template ray_intersect_packet<ShadowRay, FloatP>(ray, active);
+            MaskP hit = active && dr::isfinite(t);
+
+            // Write outputs
+            auto update = [&](size_t offset, const auto &value) {
+                using T = std::decay_t<decltype(value)>;
+                auto *ptr = (dr::scalar_t<T> *) &args[offset * Width];
+                dr::store(ptr, dr::select(hit, value, dr::load<T>(ptr)));
+            };
+
+            if constexpr (ShadowRay) {
+                update(offsetof(RayHit, tfar), FloatP(0.f));
+            } else {
+                update(offsetof(RayHit, tfar), t);
+                update(offsetof(RayHit, u), prim_uv.x());
+                update(offsetof(RayHit, v), prim_uv.y());
+                update(offsetof(RayHit, prim_id), prim_index);
+                update(offsetof(RayHit, geom_id), shape_index);
+                update(offsetof(RayHit, inst_id), inst_index);
+            }
+            return;
+        }
+    }
+
     for (size_t i = 0; i < Width; i++) {
         if (valid[i] == 0)
             continue;
@@ -147,11 +242,11 @@ void kdtree_trace_func_wrapper(const int *valid, void *ptr,
         ScalarRay3f ray = ScalarRay3f(ray_o, ray_d, ray_maxt, ray_time, wavelength_t<Spectrum>());
 
         if constexpr (ShadowRay) {
-            bool hit = kdtree->template ray_intersect_scalar<true>(ray).is_valid();
+            bool hit = accel->template ray_intersect_scalar<true>(ray).is_valid();
             if (hit)
                 ray_maxt = 0.f;
         } else {
-            auto pi = kdtree->template ray_intersect_scalar<false>(ray);
+            auto pi = accel->template ray_intersect_scalar<false>(ray);
             if (pi.is_valid()) {
                 ScalarFloat& prim_u = ((ScalarFloat*) &args[offsetof(RayHit, u) * Width])[i];
                 ScalarFloat& prim_v = ((ScalarFloat*) &args[offsetof(RayHit, v) * Width])[i];
@@ -172,30 +267,41 @@ void kdtree_trace_func_wrapper(const int *valid, void *ptr,
     }
 }
 
+/// Return the ray tracing function for the given accelerator and vector width
+template <typename Float, typename Spectrum, typename Accel, bool ShadowRay>
+void *native_trace_func(int jit_width) {
+    switch (jit_width) {
+        case 1:  return (void *) native_trace_func_wrapper<Float, Spectrum, Accel, ShadowRay, 1>;
+        case 4:  return (void *) native_trace_func_wrapper<Float, Spectrum, Accel, ShadowRay, 4>;
+        case 8:  return (void *) native_trace_func_wrapper<Float, Spectrum, Accel, ShadowRay, 8>;
+        case 16: return (void *) native_trace_func_wrapper<Float, Spectrum, Accel, ShadowRay, 16>;
+        default: return nullptr;
+    }
+}
+
 MI_VARIANT typename Scene<Float, Spectrum>::PreliminaryIntersection3f
 Scene<Float, Spectrum>::ray_intersect_preliminary_cpu(const Ray3f &ray,
                                                       Mask coherent,
                                                       Mask active) const {
+    NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) m_accel;
     if constexpr (!dr::is_array_v<Float>) {
         DRJIT_MARK_USED(coherent);
-        const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
-        return kdtree->template ray_intersect_preliminary<false>(ray, active);
+        if (s->bvh)
+            return s->bvh->template ray_intersect_preliminary<false>(ray, active);
+        return s->accel->template ray_intersect_preliminary<false>(ray, active);
     } else {
-        NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) m_accel;
         void *func_ptr = nullptr,
              *scene_ptr = m_accel;
 
         int jit_width = jit_llvm_vector_width();
-        switch (jit_width) {
-            case 1:  func_ptr = (void *) kdtree_trace_func_wrapper<Float, Spectrum, false, 1>; break;
-            case 4:  func_ptr = (void *) kdtree_trace_func_wrapper<Float, Spectrum, false, 4>; break;
-            case 8:  func_ptr = (void *) kdtree_trace_func_wrapper<Float, Spectrum, false, 8>; break;
-            case 16: func_ptr = (void *) kdtree_trace_func_wrapper<Float, Spectrum, false, 16>; break;
-            default:
-                Throw("ray_intersect_preliminary_cpu(): Dr.Jit is "
-                      "configured for vectors of width %u, which is not "
-                      "supported by the kd-tree ray tracing backend!", jit_width);
-        }
+        if (s->bvh)
+            func_ptr = native_trace_func<Float, Spectrum, ShapeBVH, false>(jit_width);
+        else
+            func_ptr = native_trace_func<Float, Spectrum, ShapeKDTree, false>(jit_width);
+        if (!func_ptr)
+            Throw("ray_intersect_preliminary_cpu(): Dr.Jit is "
+                  "configured for vectors of width %u, which is not "
+                  "supported by the native ray tracing backend!", jit_width);
 
         UInt64 func_v = UInt64::steal(
                    jit_var_pointer(JitBackend::LLVM, func_ptr, m_accel_handle.index(), 0)),
@@ -264,24 +370,24 @@ Scene<Float, Spectrum>::ray_intersect_cpu(const Ray3f &ray, uint32_t ray_flags,
 MI_VARIANT typename Scene<Float, Spectrum>::Mask
 Scene<Float, Spectrum>::ray_test_cpu(const Ray3f &ray,
                                      Mask coherent, Mask active) const {
+    NativeState<Float, Spectrum> *s = (NativeState<Float, Spectrum> *) m_accel;
     if constexpr (!dr::is_jit_v<Float>) {
         DRJIT_MARK_USED(coherent);
-        const ShapeKDTree *kdtree = (const ShapeKDTree *) m_accel;
-        return kdtree->template ray_intersect_preliminary<true>(ray, active).is_valid();
+        if (s->bvh)
+            return s->bvh->template ray_intersect_preliminary<true>(ray, active).is_valid();
+        return s->accel->template ray_intersect_preliminary<true>(ray, active).is_valid();
     } else {
         void *func_ptr = nullptr, *scene_ptr = m_accel;
 
         int jit_width = jit_llvm_vector_width();
-        switch (jit_width) {
-            case 1:  func_ptr = (void *) kdtree_trace_func_wrapper<Float, Spectrum, true, 1>; break;
-            case 4:  func_ptr = (void *) kdtree_trace_func_wrapper<Float, Spectrum, true, 4>; break;
-            case 8:  func_ptr = (void *) kdtree_trace_func_wrapper<Float, Spectrum, true, 8>; break;
-            case 16: func_ptr = (void *) kdtree_trace_func_wrapper<Float, Spectrum, true, 16>; break;
-            default:
-                Throw("ray_test_cpu(): Dr.Jit is configured for vectors of "
-                      "width %u, which is not supported by the kd-tree ray "
-                      "tracing backend!", jit_width);
-        }
+        if (s->bvh)
+            func_ptr = native_trace_func<Float, Spectrum, ShapeBVH, true>(jit_width);
+        else
+            func_ptr = native_trace_func<Float, Spectrum, ShapeKDTree, true>(jit_width);
+        if (!func_ptr)
+            Throw("ray_test_cpu(): Dr.Jit is configured for vectors of "
+                  "width %u, which is not supported by the native ray "
+                  "tracing backend!", jit_width);
 
         UInt64 func_v = UInt64::steal(
                    jit_var_pointer(JitBackend::LLVM, func_ptr, m_accel_handle.index(), 0)),
@@ -308,14 +414,11 @@ Scene<Float, Spectrum>::ray_test_cpu(const Ray3f &ray,
 
 MI_VARIANT typename Scene<Float, Spectrum>::SurfaceInteraction3f
 Scene<Float, Spectrum>::ray_intersect_naive_cpu(const Ray3f &ray, Mask active) const {
-    const ShapeKDTree *kdtree;
-    if constexpr (dr::is_llvm_v<Float>)
-        kdtree = ((NativeState<Float, Spectrum> *) m_accel)->accel;
-    else
-        kdtree = (const ShapeKDTree *) m_accel;
+    const NativeState<Float, Spectrum> *s = (const NativeState<Float, Spectrum> *) m_accel;
 
     PreliminaryIntersection3f pi =
-        kdtree->template ray_intersect_naive<false>(ray, active);
+        s->bvh ? s->bvh->template ray_intersect_naive<false>(ray, active)
+               : s->accel->template ray_intersect_naive<false>(ray, active);
 
     return pi.compute_surface_interaction(ray, +RayFlags::All, active);
 }
@@ -0,0 +1,96 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+from mitsuba.scalar_rgb.test.util import fresolver_append_path
+
+
+def create_scene(accel):
+    scene_dict = {
+        'type': 'scene',
+        'accel': accel,
+        'bunny': {
+            'type': 'ply',
+            'filename': 'resources/data/common/meshes/bunny_lowres.ply',
+        },
+        'sphere': {
+            'type': 'sphere',
+            'center': [0, 0.1, 0],
+            'radius': 0.02,
+        },
+    }
+    for i in range(4):
+        scene_dict[f'rect_{i}'] = {
+            'type': 'rectangle',
+            'to_world': mi.ScalarTransform4f.translate([0.1 * i - 0.15, 0.05, 0.05]).scale(0.02),
+        }
+    return mi.load_dict(scene_dict)
+
+
+def test01_invalid_accel(variant_scalar_rgb):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    with pytest.raises(RuntimeError, match='acceleration data structure'):
+        mi.load_dict({'type': 'scene', 'accel': 'octree'})
+
+
+@fresolver_append_path
+def test02_matches_naive(variants_vec_backends_once_rgb):
+    if mi.MI_ENABLE_EMBREE or dr.is_cuda_v(mi.Float):
+        pytest.skip("Native ray tracing backend only")
+
+    scene = create_scene('bvh')
+    b = scene.bbox()
+
+    # Grid of rays through the bounding box, along all three axes
+    n = 32
+    for axis in range(3):
+        idx = dr.arange(mi.UInt32, n * n)
+        u = (mi.Float(idx % n) + 0.5) / n
+        v = (mi.Float(idx // n) + 0.5) / n
+
+        o = mi.Point3f(b.min)
+        o[(axis + 1) % 3] = dr.lerp(b.min[(axis + 1) % 3], b.max[(axis + 1) % 3], u)
+        o[(axis + 2) % 3] = dr.lerp(b.min[(axis + 2) % 3], b.max[(axis + 2) % 3], v)
+        o[axis] -= 1
+        d = mi.Vector3f(0)
+        d[axis] = 1
+
+        ray = mi.Ray3f(o, d)
+        si_naive = scene.ray_intersect_naive(ray)
+        si = scene.ray_intersect(ray)
+
+        assert dr.all(si.is_valid() == si_naive.is_valid())
+        assert dr.all(scene.ray_test(ray) == si_naive.is_valid())
+        assert dr.any(si.is_valid())
+        assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                           dr.select(si_naive.is_valid(), si_naive.t, 0))
+        assert dr.all(dr.eq(si.prim_index, si_naive.prim_index) | ~si.is_valid())
+
+
+@fresolver_append_path
+def test03_matches_kdtree(variant_scalar_rgb):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    scene_bvh = create_scene('bvh')
+    scene_kd = create_scene('kdtree')
+    sampler = mi.load_dict({'type': 'independent'})
+
+    # Random rays starting inside of the bounding box
+    b = scene_bvh.bbox()
+    for i in range(1000):
+        o = b.min + (b.max - b.min) * mi.Vector3f(sampler.next_1d(),
+                                                  sampler.next_1d(),
+                                                  sampler.next_1d())
+        d = mi.warp.square_to_uniform_sphere(sampler.next_2d())
+        ray = mi.Ray3f(o, d)
+
+        si_bvh = scene_bvh.ray_intersect(ray)
+        si_kd = scene_kd.ray_intersect(ray)
+        assert si_bvh.is_valid() == si_kd.is_valid()
+        assert scene_bvh.ray_test(ray) == si_kd.is_valid()
+        if si_kd.is_valid():
+            assert dr.allclose(si_bvh.t, si_kd.t)
+            assert si_bvh.shape.id() == si_kd.shape.id()
@@ -113,3 +113,131 @@ def test02_depth_scalar_bunny(variant_scalar_rgb):
             res_shadow = scene.ray_test(r)
             assert dr.all(res_shadow == res_naive.is_valid())
             compare_results(res_naive, res)
+
+
+def test03_incremental_update(variant_scalar_rgb):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    scene_dict = {'type': 'scene'}
+    for i in range(8):
+        scene_dict[f'rect_{i}'] = {
+            'type': 'rectangle',
+            'to_world': mi.ScalarTransform4f.translate([3 * i, 0, 0]),
+        }
+    scene = mi.load_dict(scene_dict)
+
+    # Move a single shape: the kd-tree is updated instead of rebuilt
+    params = mi.traverse(scene)
+    params['rect_3.to_world'] = mi.ScalarTransform4f.translate([9, 5, 1])
+    params.update()
+
+    def trace(x, y):
+        r = mi.Ray3f([x, y, 5], [0, 0, -1])
+        si, si_naive = scene.ray_intersect(r), scene.ray_intersect_naive(r)
+        assert dr.all(scene.ray_test(r) == si.is_valid())
+        compare_results(si_naive, si)
+        return si
+
+    assert not trace(9, 0).is_valid()
+
+    si = trace(9, 5)
+    assert si.is_valid() and dr.allclose(si.t, 4)
+    assert si.shape.id() == 'rect_3'
+
+    si = trace(6, 0)
+    assert si.is_valid() and dr.allclose(si.t, 5)
+    assert si.shape.id() == 'rect_2'
+
+
+@fresolver_append_path
+def test04_cache(variant_scalar_rgb, tmp_path):
+    if mi.MI_ENABLE_EMBREE:
+        pytest.skip("EMBREE enabled")
+
+    def load(**kwargs):
+        return mi.load_dict({
+            'type': 'scene',
+            'shape': {
+                'type': 'ply',
+                'filename': 'resources/data/common/meshes/bunny_lowres.ply',
+            },
+            **kwargs
+        })
+
+    cache_dir = tmp_path / 'kdtree_cache'
+    scene_ref = load()
+
+    # The first load stores the tree, the second one reads it back
+    for i in range(2):
+        scene = load(kd_cache_dir=str(cache_dir))
+        files = list(cache_dir.iterdir())
+        assert len(files) == 1 and files[0].suffix == '.bin'
+
+        b = scene.bbox()
+        for x in range(20):
+            for y in range(20):
+                o = [b.min[0] + (b.max[0] - b.min[0]) * (x + 0.5) / 20,
+                     b.min[1] + (b.max[1] - b.min[1]) * (y + 0.5) / 20,
+                     b.min[2] - 1]
+                r = mi.Ray3f(o, [0, 0, 1])
+                compare_results(scene_ref.ray_intersect(r), scene.ray_intersect(r))
+                assert scene.ray_test(r) == scene_ref.ray_test(r)
+
+    # Corrupted files are detected, and replaced by the rebuilt tree
+    data = files[0].read_bytes()
+    corrupted = bytearray(data)
+    corrupted[-1] ^= 0xff
+    files[0].write_bytes(corrupted)
+    load(kd_cache_dir=str(cache_dir))
+    assert files[0].read_bytes() == data
+
+    # Different build parameters lead to a different cache file
+    load(kd_cache_dir=str(cache_dir), kd_stop_prims=2)
+    assert len(list(cache_dir.iterdir())) == 2
+
+
+@fresolver_append_path
+def test05_packet_traversal(variants_vec_backends_once_rgb):
+    if mi.MI_ENABLE_EMBREE or dr.is_cuda_v(mi.Float):
+        pytest.skip("Native ray tracing backend only")
+
+    def load(packet):
+        return mi.load_dict({
+            'type': 'scene',
+            'kd_packet_traversal': packet,
+            'bunny': {
+                'type': 'ply',
+                'filename': 'resources/data/common/meshes/bunny_lowres.ply',
+            },
+            'sphere': {
+                'type': 'sphere',
+                'center': [0, 0.1, 0],
+                'radius': 0.02,
+            },
+        })
+
+    scene_packet, scene_ref = load(True), load(False)
+
+    # Random rays starting inside of the bounding box: neighboring lanes
+    # traverse the tree along different paths
+    b = scene_packet.bbox()
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, 4096)
+    o = b.min + (b.max - b.min) * mi.Vector3f(sampler.next_1d(),
+                                              sampler.next_1d(),
+                                              sampler.next_1d())
+    d = mi.warp.square_to_uniform_sphere(sampler.next_2d())
+    ray = mi.Ray3f(o, d)
+
+    si = scene_packet.ray_intersect(ray)
+    si_ref = scene_ref.ray_intersect(ray)
+    si_naive = scene_packet.ray_intersect_naive(ray)
+
+    assert dr.any(si.is_valid())
+    assert dr.all(si.is_valid() == si_ref.is_valid())
+    assert dr.all(si.is_valid() == si_naive.is_valid())
+    assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                       dr.select(si_ref.is_valid(), si_ref.t, 0))
+    assert dr.all(dr.eq(si.prim_index, si_ref.prim_index) | ~si.is_valid())
+    assert dr.all(scene_packet.ray_test(ray) == si_ref.is_valid())
@@ -207,7 +207,7 @@ def test08_test_nonuniform_emitter_sampling(variants_all_backends_once):
         'emitter_1': {'type':'constant', 'sampling_weight': weights[2]},
     })
     index, weight, reused_sample = scene.sample_emitter(sample)
-    distr = mi.DiscreteDistribution([emitter.sampling_weight() for emitter in scene.emitters()])
+    distr = mi.AliasDistribution([emitter.sampling_weight() for emitter in scene.emitters()])
     ref_index, ref_reused_sample, ref_pmf = distr.sample_reuse_pmf(sample)
     assert dr.allclose(index, ref_index)
     assert dr.allclose(weight, 1.0 / ref_pmf)
@@ -233,7 +233,7 @@ def test09_test_emitter_sampling_weight_update(variants_all_backends_once):
 
     sample = 0.75
     weights = [emitter.sampling_weight() for emitter in scene.emitters()]
-    distr = mi.DiscreteDistribution(weights)
+    distr = mi.AliasDistribution(weights)
     index, weight, reused_sample = scene.sample_emitter(sample)
     ref_index, ref_reused_sample, ref_pmf = distr.sample_reuse_pmf(sample)
     assert dr.allclose(index, ref_index)
@@ -315,3 +315,62 @@ def test11_sample_silhouette_bijective(variants_vec_rgb):
     out = scene.invert_silhouette_sample(ss)
     assert dr.all(dr.neq(ss.discontinuity_type, mi.DiscontinuityFlags.Empty.value))
     assert dr.allclose(valid_samples, valid_out, atol=1e-6)
+
+
+def test12_ray_intersect_sorted(variants_vec_backends_once_rgb):
+    scene = mi.load_dict({
+        'type': 'scene',
+        'sphere': {'type': 'sphere'},
+        'rectangle': {
+            'type': 'rectangle',
+            'to_world': mi.ScalarTransform4f.translate([0, 0, -2]).scale(4),
+        },
+    })
+
+    # Random rays, a few of which are disabled
+    n = 10000
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, n)
+    o = 4 * (mi.Vector3f(sampler.next_1d(), sampler.next_1d(),
+                         sampler.next_1d()) - 0.5)
+    d = mi.warp.square_to_uniform_sphere(sampler.next_2d())
+    ray = mi.Ray3f(o, d)
+    active = sampler.next_1d() < 0.9
+
+    si_ref = scene.ray_intersect(ray, active)
+    si = scene.ray_intersect_sorted(ray, active=active)
+
+    assert dr.any(si.is_valid())
+    assert dr.all(si.is_valid() == si_ref.is_valid())
+    assert dr.all(~si.is_valid() | active)
+    assert dr.allclose(dr.select(si.is_valid(), si.t, 0),
+                       dr.select(si_ref.is_valid(), si_ref.t, 0))
+    assert dr.allclose(dr.select(si.is_valid(), si.p, 0),
+                       dr.select(si_ref.is_valid(), si_ref.p, 0))
+    assert dr.all(dr.eq(si.prim_index, si_ref.prim_index) | ~si.is_valid())
+
+
+@pytest.mark.parametrize('integrator', ['path', 'volpath'])
+def test13_sort_rays_wavefront(variants_vec_backends_once_rgb, integrator):
+    def render(sort_rays):
+        scene = mi.load_dict({
+            'type': 'scene',
+            'integrator': {'type': integrator, 'sort_rays': sort_rays},
+            'sensor': {
+                'type': 'perspective',
+                'to_world': mi.ScalarTransform4f.look_at(
+                    origin=(0, 0, 4), target=(0, 0, 0), up=(0, 1, 0)),
+                'film': {'type': 'hdrfilm', 'width': 16, 'height': 16},
+            },
+            'emitter': {'type': 'constant'},
+            'sphere': {'type': 'sphere'},
+            'floor': {
+                'type': 'rectangle',
+                'to_world': mi.ScalarTransform4f.translate([0, 0, -1]).scale(4),
+            },
+        })
+        return mi.render(scene, spp=4, seed=0)
+
+    # Reordering the rays does not change the result of any path
+    with dr.scoped_set_flag(dr.JitFlag.LoopRecord, False):
+        assert dr.allclose(render(True), render(False))
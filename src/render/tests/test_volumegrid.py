@@ -46,3 +46,24 @@ def test03_max_per_channel(variants_all_scalar, tmpdir, np_rng):
     grid = mi.VolumeGrid(tmp_file)
     mi_max_per_channel = grid.max_per_channel()
     assert dr.allclose(np_max_per_channel, mi_max_per_channel)
+
+
+def test04_memory_mapped(variants_all_scalar, tmpdir, np_rng):
+    tmp_file = os.path.join(str(tmpdir), "out.vol")
+    data = np_rng.random((4, 8, 16, 3)) - 0.5
+    mi.VolumeGrid(data).write(tmp_file)
+
+    mapped = mi.VolumeGrid(tmp_file)
+    loaded = mi.VolumeGrid(tmp_file, use_mmap=False)
+    assert not loaded.is_mapped()
+    if 'double' not in mi.variant():
+        assert mapped.is_mapped()
+
+    for grid in [mapped, loaded]:
+        assert dr.allclose(np.array(grid), data)
+        assert dr.allclose(grid.max(), np.max(data))
+        assert dr.allclose(grid.max_per_channel(), np.max(data, axis=(0, 1, 2)))
+
+    # Overwriting the mapped file must not invalidate the grid
+    mapped.write(tmp_file)
+    assert dr.allclose(np.array(mi.VolumeGrid(tmp_file)), data)
@@ -48,14 +48,47 @@ Volume<Float, Spectrum>::eval_gradient(const Interaction3f & /*it*/, Mask /*acti
     NotImplementedError("eval_gradient");
 }
 
+MI_VARIANT typename Volume<Float, Spectrum>::UnpolarizedSpectrum
+Volume<Float, Spectrum>::eval_filtered(const Interaction3f &it, Float /*width*/,
+                                       Mask active) const {
+    return eval(it, active);
+}
+
 MI_VARIANT typename Volume<Float, Spectrum>::ScalarFloat
 Volume<Float, Spectrum>::max() const { NotImplementedError("max"); }
 
+MI_VARIANT typename Volume<Float, Spectrum>::ScalarFloat
+Volume<Float, Spectrum>::min() const { return 0.f; }
+
 MI_VARIANT void
 Volume<Float, Spectrum>::max_per_channel(ScalarFloat * /*out*/) const {
     NotImplementedError("max_per_channel");
 }
 
+MI_VARIANT void
+Volume<Float, Spectrum>::local_majorants(const ScalarVector3i &resolution,
+                                         ScalarFloat *out) const {
+    ScalarFloat value = max();
+    for (size_t i = 0; i < (size_t) dr::prod(resolution); ++i)
+        out[i] = value;
+}
+
+MI_VARIANT typename Volume<Float, Spectrum>::ScalarBoundingBox3f
+Volume<Float, Spectrum>::occupied_bbox() const {
+    return ScalarBoundingBox3f(ScalarPoint3f(0.f), ScalarPoint3f(1.f));
+}
+
+MI_VARIANT uint32_t Volume<Float, Spectrum>::empty_space_block_size() const {
+    return 0;
+}
+
+MI_VARIANT const typename Volume<Float, Spectrum>::TensorXf *
+Volume<Float, Spectrum>::voxel_data(dr::FilterMode & /* filter_mode */,
+                                    dr::WrapMode & /* wrap_mode */,
+                                    bool & /* accel */) const {
+    return nullptr;
+}
+
 MI_VARIANT typename Volume<Float, Spectrum>::ScalarVector3i
 Volume<Float, Spectrum>::resolution() const {
     return ScalarVector3i(1, 1, 1);
@@ -2,7 +2,9 @@
 #include <mitsuba/core/stream.h>
 #include <mitsuba/core/logger.h>
 #include <mitsuba/core/fstream.h>
+#include <mitsuba/core/mstream.h>
 #include <mitsuba/core/util.h>
+#include <nanothread/nanothread.h>
 
 NAMESPACE_BEGIN(mitsuba)
 
@@ -10,9 +12,34 @@ MI_VARIANT
 VolumeGrid<Float, Spectrum>::VolumeGrid(Stream *stream) { read(stream); }
 
 MI_VARIANT
-VolumeGrid<Float, Spectrum>::VolumeGrid(const fs::path &filename) {
-    ref<FileStream> fs = new FileStream(filename);
-    read(fs);
+VolumeGrid<Float, Spectrum>::VolumeGrid(const fs::path &filename, bool use_mmap) {
+    /* The payload of a volume file can be used in place when it stores
+       values exactly as they are represented in memory */
+    bool can_map = std::is_same_v<ScalarFloat, float> &&
+                   Stream::host_byte_order() == Stream::ELittleEndian;
+
+    if (!use_mmap || !can_map) {
+        ref<FileStream> fs = new FileStream(filename);
+        read(fs);
+        return;
+    }
+
+    m_mmap = new MemoryMappedFile(filename);
+    ref<MemoryStream> ms = new MemoryStream(m_mmap->data(), m_mmap->size());
+    size_t count = read_header(ms);
+
+    size_t offset = ms->tell();
+    if (m_mmap->size() < offset + count * sizeof(float))
+        Throw("Volume file \"%s\" is truncated: expected %s of voxel data, "
+              "found %s!", filename.string(),
+              util::mem_string(count * sizeof(float)),
+              util::mem_string(m_mmap->size() - offset));
+
+    m_data_ptr = (const ScalarFloat *) ((const uint8_t *) m_mmap->data() + offset);
+    update_max();
+
+    Log(Debug, "Mapped grid volume data from file: dimensions %s, max value %f",
+        m_size, m_max);
 }
 
 MI_VARIANT
@@ -23,10 +50,25 @@ VolumeGrid<Float, Spectrum>::VolumeGrid(ScalarVector3u size,
       m_max_per_channel(channel_count, 0.f) {
     m_data = std::unique_ptr<ScalarFloat[]>(
         new ScalarFloat[dr::prod(m_size) * m_channel_count]);
+    m_data_ptr = m_data.get();
 }
 
 MI_VARIANT
-void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
+typename VolumeGrid<Float, Spectrum>::ScalarFloat *
+VolumeGrid<Float, Spectrum>::data() {
+    if (m_mmap) {
+        // Copy-on-write: never modify the file backing the mapping
+        size_t count = dr::prod(m_size) * m_channel_count;
+        m_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[count]);
+        memcpy(m_data.get(), m_data_ptr, count * sizeof(ScalarFloat));
+        m_data_ptr = m_data.get();
+        m_mmap = nullptr;
+    }
+    return m_data.get();
+}
+
+MI_VARIANT
+size_t VolumeGrid<Float, Spectrum>::read_header(Stream *stream) {
     char header[3];
     stream->read(header, 3);
 
@@ -52,7 +94,6 @@ void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
     m_size.y() = uint32_t(size_y);
     m_size.z() = uint32_t(size_z);
 
-    size_t size = dr::prod(m_size);
     int32_t channel_count;
     stream->read(channel_count);
     m_channel_count = channel_count;
@@ -63,25 +104,70 @@ void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
     m_bbox = ScalarBoundingBox3f(ScalarPoint3f(dims[0], dims[1], dims[2]),
                                  ScalarPoint3f(dims[3], dims[4], dims[5]));
 
-    m_max = -dr::Infinity<ScalarFloat>;
-    m_max_per_channel.resize(m_channel_count, -dr::Infinity<ScalarFloat>);
-
-    m_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[size * m_channel_count]);
-    size_t k = 0;
-    for (size_t i = 0; i < size; ++i) {
-        for (size_t j = 0; j < m_channel_count; ++j) {
-            float val;
-            stream->read(val);
-            m_data[k] = val;
-            m_max     = dr::maximum(m_max, val);
-            m_max_per_channel[j] = dr::maximum(m_max_per_channel[j], val);
-            ++k;
-        }
+    return dr::prod(m_size) * (size_t) m_channel_count;
+}
+
+MI_VARIANT
+void VolumeGrid<Float, Spectrum>::read(Stream *stream) {
+    size_t count = read_header(stream);
+
+    m_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[count]);
+    m_data_ptr = m_data.get();
+
+    if constexpr (std::is_same_v<ScalarFloat, float>) {
+        stream->read_array(m_data.get(), count);
+    } else {
+        // Need to convert the single precision data stored on disk
+        std::unique_ptr<float[]> values(new float[count]);
+        stream->read_array(values.get(), count);
+        for (size_t i = 0; i < count; ++i)
+            m_data[i] = (ScalarFloat) values[i];
     }
+
+    update_max();
+
     Log(Debug, "Loaded grid volume data from file: dimensions %s, max value %f",
         m_size, m_max);
 }
 
+MI_VARIANT
+void VolumeGrid<Float, Spectrum>::update_max() {
+    size_t voxel_count   = dr::prod(m_size),
+           channel_count = m_channel_count,
+           block_size    = 16384,
+           block_count   = (voxel_count + block_size - 1) / block_size;
+
+    // Per-block partial maxima, reduced sequentially (deterministic result)
+    std::vector<ScalarFloat> block_max(block_count * channel_count,
+                                       -dr::Infinity<ScalarFloat>);
+
+    dr::parallel_for(
+        dr::blocked_range<size_t>(0, block_count, 1),
+        [&](const dr::blocked_range<size_t> &range) {
+            for (size_t block = range.begin(); block != range.end(); ++block) {
+                size_t start = block * block_size,
+                       end   = std::min(start + block_size, voxel_count);
+                const ScalarFloat *ptr = m_data_ptr + start * channel_count;
+                ScalarFloat *result = block_max.data() + block * channel_count;
+
+                for (size_t i = start; i < end; ++i)
+                    for (size_t j = 0; j < channel_count; ++j)
+                        result[j] = dr::maximum(result[j], *ptr++);
+            }
+        }
+    );
+
+    m_max = -dr::Infinity<ScalarFloat>;
+    m_max_per_channel.assign(channel_count, -dr::Infinity<ScalarFloat>);
+    for (size_t block = 0; block < block_count; ++block) {
+        for (size_t j = 0; j < channel_count; ++j) {
+            ScalarFloat value = block_max[block * channel_count + j];
+            m_max_per_channel[j] = dr::maximum(m_max_per_channel[j], value);
+            m_max = dr::maximum(m_max, value);
+        }
+    }
+}
+
 MI_VARIANT
 void VolumeGrid<Float, Spectrum>::max_per_channel(ScalarFloat *out) const {
     for (size_t i=0; i<m_channel_count; ++i)
@@ -90,6 +176,16 @@ void VolumeGrid<Float, Spectrum>::max_per_channel(ScalarFloat *out) const {
 
 MI_VARIANT
 void VolumeGrid<Float, Spectrum>::write(const fs::path &path) const {
+    if (m_mmap && fs::exists(path) && fs::equivalent(path, m_mmap->filename())) {
+        /* Truncating the file would invalidate the mapping that the voxel
+           values are read from: serialize to memory first */
+        ref<MemoryStream> ms = new MemoryStream(buffer_size() + 48);
+        write(ms);
+        ref<FileStream> fs = new FileStream(path, FileStream::ETruncReadWrite);
+        fs->write(ms->raw_buffer(), ms->size());
+        return;
+    }
+
     ref<FileStream> fs = new FileStream(path, FileStream::ETruncReadWrite);
     write(fs);
 }
@@ -112,12 +208,12 @@ void VolumeGrid<Float, Spectrum>::write(Stream *stream) const {
     stream->write(float(m_bbox.max.z()));
 
     if constexpr (std::is_same<ScalarFloat, float>::value)
-        stream->write_array(m_data.get(), dr::prod(m_size) * m_channel_count);
+        stream->write_array(m_data_ptr, dr::prod(m_size) * m_channel_count);
     else {
         // Need to convert data to single precision before writing to disk
         std::vector<float> output(dr::prod(m_size) * m_channel_count);
         for (size_t i = 0; i < dr::prod(m_size) * m_channel_count; ++i)
-            output[i] = m_data[i];
+            output[i] = (float) m_data_ptr[i];
         stream->write_array(output.data(), dr::prod(m_size) * m_channel_count);
     }
 }
@@ -135,7 +231,8 @@ std::string VolumeGrid<Float, Spectrum>::to_string() const {
     oss << std::endl;
     oss << "  ],"  << std::endl
         << "  data = [ " << util::mem_string(buffer_size())
-        << " of volume data ]" << std::endl
+        << " of volume data" << (m_mmap ? ", memory-mapped" : "")
+        << " ]" << std::endl
         << "]";
     return oss.str();
 }
@@ -148,7 +148,7 @@ public:
             fs::path file_path = fs->resolve(props.string("filename"));
             if (!fs::exists(file_path))
                 Log(Error, "\"%s\": file does not exist!", file_path);
-            VolumeGrid<float, Color<float, 3>> vol_grid(file_path);
+            const VolumeGrid<float, Color<float, 3>> vol_grid(file_path);
             ScalarVector3i res = vol_grid.size();
             size_t shape[4]    = { (size_t) res.z(), (size_t) res.y(),
                                    (size_t) res.x(), 1 };
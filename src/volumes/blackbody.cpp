@@ -0,0 +1,310 @@
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/render/volume.h>
+#include <drjit/texture.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+.. _volume-blackbodyvolume:
+
+Blackbody emission volume (:monosp:`blackbodyvolume`)
+-----------------------------------------------------
+
+.. pluginparameters::
+
+ * - temperature
+   - |volume|
+   - Single-channel volume providing the temperature in Kelvins (e.g. a
+     :ref:`gridvolume <volume-gridvolume>` exported from a fire simulation).
+
+ * - temperature_scale
+   - |float|
+   - Factor applied to the values of :paramtype:`temperature`, e.g. to convert
+     normalized simulation data to Kelvins. (Default: 1)
+   - |exposed|
+
+ * - temperature_max
+   - |float|
+   - Highest temperature covered by the lookup table. Higher temperatures
+     are clamped to it. (Default: largest value of the scaled temperature
+     volume)
+
+ * - resolution
+   - |int|
+   - Number of temperature samples of the lookup table (Default: 1024)
+
+ * - scale
+   - |float|
+   - Factor applied to the emitted radiance. (Default: 1)
+   - |exposed|
+
+This plugin converts a temperature volume into the spectral radiance emitted
+by a black body (Planck's law), so that fire and explosion simulations can be
+rendered as the ``radiance`` volume of a :ref:`heterogeneous <medium-heterogeneous>`
+medium. Instead of evaluating Planck's law at every lookup, the plugin precomputes
+a table over temperature and wavelength, which lookups interpolate bilinearly:
+
+- In spectral variants, the table samples the visible range at the
+  resolution of the CIE 1931 color matching functions (5 nm).
+- In RGB variants, each temperature stores the linear sRGB color of the
+  black body spectrum, i.e. its response to the color matching functions
+  (clamped to non-negative values).
+- In monochromatic variants, each temperature stores the luminance of the
+  black body spectrum.
+
+Like the :ref:`blackbody <spectrum-blackbody>` spectrum, the radiance has units of
+:math:`W m^{-2} sr^{-1} nm^{-1}`, and the :paramtype:`scale` parameter can be used
+to bring it into the range of the other light sources of a scene. Since the
+radiance increases with temperature, the maximum of the volume is the largest
+entry of the table, and the local majorants of the temperature volume map
+directly to local majorants of the radiance.
+
+.. tabs::
+    .. code-tab:: xml
+
+        <medium type="heterogeneous">
+            <volume type="blackbodyvolume" name="radiance">
+                <volume type="gridvolume" name="temperature">
+                    <string name="filename" value="temperature.vol"/>
+                </volume>
+                <float name="scale" value="1e-4"/>
+            </volume>
+            <!-- ... -->
+        </medium>
+
+    .. code-tab:: python
+
+        'type': 'heterogeneous',
+        'radiance': {
+            'type': 'blackbodyvolume',
+            'temperature': {
+                'type': 'gridvolume',
+                'filename': 'temperature.vol'
+            },
+            'scale': 1e-4
+        }
+        # ...
+
+*/
+
+template <typename Float, typename Spectrum>
+class BlackBodyVolume final : public Volume<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Volume, m_to_local, update_bbox)
+    MI_IMPORT_TYPES()
+
+    // A few natural constants
+    constexpr static double c = 2.99792458e+8;   /// Speed of light
+    constexpr static double h = 6.62607004e-34;  /// Planck constant
+    constexpr static double k = 1.38064852e-23;  /// Boltzmann constant
+
+    /// First and second radiation static constants
+    constexpr static double c0 = 2 * h * c * c;
+    constexpr static double c1 = h * c / k;
+
+    BlackBodyVolume(const Properties &props) : Base(props) {
+        m_temperature = props.volume<Volume>("temperature");
+        m_temperature_scale = props.get<ScalarFloat>("temperature_scale", 1.f);
+        m_temperature_max = props.get<ScalarFloat>("temperature_max", 0.f);
+        m_scale = props.get<ScalarFloat>("scale", 1.f);
+
+        int resolution = props.get<int>("resolution", 1024);
+        if (resolution < 2)
+            Throw("BlackBodyVolume: the lookup table resolution must be at least 2!");
+        m_resolution = (uint32_t) resolution;
+
+        if (m_temperature_max < 0.f)
+            Throw("BlackBodyVolume: \"temperature_max\" must be non-negative!");
+
+        // The volume shares the domain of the temperature data
+        m_to_local = m_temperature->to_local();
+        update_bbox();
+
+        update_lut();
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_object("temperature", m_temperature.get(), +ParamFlags::NonDifferentiable);
+        callback->put_parameter("temperature_scale", m_temperature_scale, +ParamFlags::NonDifferentiable);
+        callback->put_parameter("scale", m_scale, +ParamFlags::NonDifferentiable);
+    }
+
+    void parameters_changed(const std::vector<std::string> &/*keys*/ = {}) override {
+        update_lut();
+    }
+
+    UnpolarizedSpectrum eval(const Interaction3f &it, Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        // Texel centers of the temperature axis span [0, m_lut_temperature]
+        Float temperature = m_temperature->eval_1(it, active) * m_temperature_scale;
+        Float v = dr::fmadd(temperature, m_temperature_to_lut, .5f / m_resolution);
+
+        UnpolarizedSpectrum result;
+        if constexpr (is_spectral_v<Spectrum>) {
+            const ScalarFloat width = (ScalarFloat) MI_CIE_SAMPLES;
+            for (size_t i = 0; i < dr::array_size_v<UnpolarizedSpectrum>; ++i) {
+                Float u = dr::fmadd(
+                    it.wavelengths[i] - (ScalarFloat) MI_CIE_MIN,
+                    (width - 1.f) / (width * ((ScalarFloat) MI_CIE_MAX - (ScalarFloat) MI_CIE_MIN)),
+                    .5f / width);
+                m_lut.eval(Point2f(u, v), &result[i], active);
+            }
+
+            result &= it.wavelengths >= (ScalarFloat) MI_CIE_MIN &&
+                      it.wavelengths <= (ScalarFloat) MI_CIE_MAX;
+        } else {
+            m_lut.eval(Point2f(.5f, v), result.data(), active);
+        }
+
+        return result & (active && temperature > 0.f);
+    }
+
+    ScalarFloat max() const override { return m_max; }
+
+    void local_majorants(const ScalarVector3i &resolution,
+                         ScalarFloat *out) const override {
+        // The radiance increases with the temperature
+        m_temperature->local_majorants(resolution, out);
+        for (size_t i = 0; i < (size_t) dr::prod(resolution); ++i)
+            out[i] = max_radiance(out[i] * m_temperature_scale);
+    }
+
+    ScalarBoundingBox3f occupied_bbox() const override {
+        return m_temperature->occupied_bbox();
+    }
+
+    uint32_t empty_space_block_size() const override {
+        return m_temperature->empty_space_block_size();
+    }
+
+    ScalarVector3i resolution() const override {
+        return m_temperature->resolution();
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "BlackBodyVolume[" << std::endl
+            << "  to_local = " << string::indent(m_to_local, 13) << "," << std::endl
+            << "  temperature = " << string::indent(m_temperature) << "," << std::endl
+            << "  temperature_scale = " << m_temperature_scale << "," << std::endl
+            << "  temperature_max = " << m_lut_temperature << "," << std::endl
+            << "  resolution = " << m_resolution << "," << std::endl
+            << "  scale = " << m_scale << "," << std::endl
+            << "  max = " << m_max << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+protected:
+    /// Spectral radiance of a black body per unit wavelength (in nm)
+    static double planck(double lambda_nm, double temperature) {
+        if (temperature <= 0.0)
+            return 0.0;
+        double lambda  = lambda_nm * 1e-9,
+               lambda2 = lambda * lambda,
+               lambda5 = lambda2 * lambda2 * lambda;
+        return 1e-9 * c0 / (lambda5 * (std::exp(c1 / (lambda * temperature)) - 1.0));
+    }
+
+    /**
+     * \brief Precompute the radiance lookup table
+     *
+     * The table has one row per temperature, evenly spaced over
+     * <tt>[0, m_lut_temperature]</tt>, with one column per wavelength
+     * (spectral variants) or a single column with one channel per color
+     * component (RGB and monochromatic variants).
+     */
+    void update_lut() {
+        m_lut_temperature = m_temperature_max > 0.f
+                                ? m_temperature_max
+                                : m_temperature->max() * m_temperature_scale;
+        if (!(m_lut_temperature > 0.f))
+            m_lut_temperature = 1.f;
+        m_temperature_to_lut =
+            (m_resolution - 1.f) / (m_resolution * m_lut_temperature);
+
+        constexpr size_t width = is_spectral_v<Spectrum> ? MI_CIE_SAMPLES : 1,
+                         channels = is_rgb_v<Spectrum> ? 3 : 1;
+
+        std::vector<ScalarFloat> data(m_resolution * width * channels);
+        m_max_radiance.resize(m_resolution);
+
+        for (uint32_t i = 0; i < m_resolution; ++i) {
+            double temperature = (double) m_lut_temperature * i / (m_resolution - 1);
+            ScalarFloat *row = data.data() + i * width * channels;
+
+            if constexpr (is_spectral_v<Spectrum>) {
+                for (size_t j = 0; j < width; ++j) {
+                    double lambda = MI_CIE_MIN + (MI_CIE_MAX - MI_CIE_MIN) * j / (width - 1);
+                    row[j] = (ScalarFloat) (m_scale * planck(lambda, temperature));
+                }
+            } else {
+                // Integrate against the color matching functions at 1 nm steps
+                double xyz[3] = { 0.0, 0.0, 0.0 };
+                for (int j = 0; j < (int) (MI_CIE_MAX - MI_CIE_MIN); ++j) {
+                    ScalarFloat lambda = MI_CIE_MIN + j + .5f;
+                    Color<ScalarFloat, 3> cmf = cie1931_xyz(lambda);
+                    double value = planck(lambda, temperature);
+                    for (size_t c = 0; c < 3; ++c)
+                        xyz[c] += value * cmf[c];
+                }
+
+                Color<ScalarFloat, 3> xyz_n(
+                    (ScalarFloat) (xyz[0] * m_scale * MI_CIE_Y_NORMALIZATION),
+                    (ScalarFloat) (xyz[1] * m_scale * MI_CIE_Y_NORMALIZATION),
+                    (ScalarFloat) (xyz[2] * m_scale * MI_CIE_Y_NORMALIZATION));
+
+                if constexpr (is_rgb_v<Spectrum>) {
+                    Color<ScalarFloat, 3> rgb = dr::maximum(xyz_to_srgb(xyz_n), 0.f);
+                    for (size_t c = 0; c < 3; ++c)
+                        row[c] = rgb[c];
+                } else {
+                    row[0] = xyz_n.y();
+                }
+            }
+
+            ScalarFloat row_max = 0.f;
+            for (size_t j = 0; j < width * channels; ++j)
+                row_max = dr::maximum(row_max, row[j]);
+            m_max_radiance[i] = row_max;
+        }
+
+        m_max = m_max_radiance.back();
+
+        size_t shape[3] = { m_resolution, width, channels };
+        m_lut = Texture2f(TensorXf(dr::load<FloatStorage>(data.data(), data.size()), 3, shape),
+                          true, true, dr::FilterMode::Linear, dr::WrapMode::Clamp);
+    }
+
+    /// Largest radiance over all wavelengths at a temperature (interpolated)
+    ScalarFloat max_radiance(ScalarFloat temperature) const {
+        ScalarFloat x = dr::clamp(temperature / m_lut_temperature, 0.f, 1.f) *
+                        (m_resolution - 1);
+        uint32_t i0 = dr::minimum((uint32_t) x, m_resolution - 2);
+        ScalarFloat w = x - i0;
+        return dr::fmadd(w, m_max_radiance[i0 + 1], (1.f - w) * m_max_radiance[i0]);
+    }
+
+protected:
+    ref<Volume> m_temperature;
+    ScalarFloat m_temperature_scale;
+    ScalarFloat m_temperature_max;
+    ScalarFloat m_scale;
+    uint32_t m_resolution;
+
+    /// Highest temperature of the lookup table and mapping to texture coordinates
+    ScalarFloat m_lut_temperature;
+    ScalarFloat m_temperature_to_lut;
+
+    Texture2f m_lut;
+    std::vector<ScalarFloat> m_max_radiance;
+    ScalarFloat m_max;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(BlackBodyVolume, Volume)
+MI_EXPORT_PLUGIN(BlackBodyVolume, "Blackbody emission volume")
+NAMESPACE_END(mitsuba)
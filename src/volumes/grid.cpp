@@ -3,10 +3,12 @@
 #include <mitsuba/core/spectrum.h>
 #include <mitsuba/core/string.h>
 #include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
 #include <mitsuba/render/srgb.h>
 #include <mitsuba/render/volume.h>
 #include <mitsuba/render/volumegrid.h>
 #include <drjit/dynamic.h>
+#include <drjit/half.h>
 #include <drjit/texture.h>
 
 NAMESPACE_BEGIN(mitsuba)
@@ -66,6 +68,23 @@ Grid-based volume data source (:monosp:`gridvolume`)
      with non-color, 3-channel volume data. Currently, no plugin needs this option
      to be set to true (Default: false)
 
+ * - interpolate_coefficients
+   - |bool|
+   - In spectral variants, interpolate the spectral upsampling model
+     coefficients of the voxels instead of the spectra they describe. Lookups
+     then evaluate the model once instead of at every interpolated voxel, at
+     the cost of a small approximation error where the color changes between
+     neighboring voxels. (Default: false)
+
+ * - mipmap
+   - |bool|
+   - Precompute a pyramid of box-filtered (mean) versions of the grid, each
+     with half the resolution of the previous one. Media then select a
+     level based on the footprint of the path at each lookup (see
+     ``Volume::eval_filtered()``). Requires :paramtype:`storage` to be
+     ``float32`` and, for spectrally upsampled data,
+     :paramtype:`interpolate_coefficients`. (Default: false)
+
  * - to_world
    - |transform|
    - Specifies an optional 4x4 transformation matrix that will be applied to volume coordinates.
@@ -76,10 +95,51 @@ Grid-based volume data source (:monosp:`gridvolume`)
      cause small differences as hardware interpolation methods typically have a
      loss of precision (not exactly 32-bit arithmetic). (Default: true)
 
+ * - storage
+   - |string|
+   - Specifies how voxel values are stored in memory. The following options are
+     currently available:
+
+     - ``float32`` (default): single precision values in a texture.
+
+     - ``float16``: half precision values (half the memory).
+
+     - ``uint8``: 8-bit quantized values (a quarter of the memory).
+
 This class implements access to volume data stored on a 3D grid using a
 simple binary exchange format (compatible with Mitsuba 0.6). When appropriate,
 spectral upsampling is applied at loading time to convert RGB values to
 spectra that can be used in the renderer.
+
+Spectral upsampling stores the coefficients of the sRGB-to-spectrum model and
+a scale factor per voxel. By default, trilinear lookups evaluate the model at
+each of the eight surrounding voxels and interpolate the resulting spectra,
+which is exact but costly. With :paramtype:`interpolate_coefficients`, the
+coefficients are premultiplied by the scale factor at loading time. A lookup
+then performs a single (possibly hardware-accelerated) interpolation of the
+four channels, divides by the interpolated scale factor and evaluates the
+model once. Regions of constant color are reproduced exactly, and voxels of
+low density have little influence on the interpolated color.
+
+With :paramtype:`mipmap` enabled, footprint-based lookups select a level of
+the pyramid as the base-2 logarithm of the ratio between the footprint width
+and the world-space voxel size, and interpolate linearly between the two
+closest levels. Integrators such as :ref:`volpath <integrator-volpath>` widen
+the footprint of paths after each scattering event, so that distant and
+multiply-scattered lookups fetch from small, cache-friendly levels. Since the
+levels hold averages, the maximum and minimum of the volume still bound every
+level; local majorants and the occupied region take all levels into account.
+
+The reduced precision :paramtype:`storage` modes map the values of every
+channel to the unit interval using a per-channel scale and offset (the range of
+the channel), which are applied again when the voxels are fetched. Since the
+values are then interpolated in software, :paramtype:`accel` has no effect and
+the grid data is neither exposed nor differentiable in these modes. All
+statistics of the volume (maximum, per-channel maxima, local majorants) are
+computed from the decoded values and hence bound lookups exactly. Half
+precision is usually sufficient for densities and colors, while 8-bit
+quantization is best reserved for smooth data with a moderate dynamic range.
+
 We provide a small `helper utility <https://github.com/mitsuba-renderer/mitsuba2-vdb-converter>`_
 to convert OpenVDB files to this format. The format uses a
 little endian encoding and is specified as follows:
@@ -153,6 +213,11 @@ public:
     MI_IMPORT_BASE(Volume, update_bbox, m_to_local, m_bbox, m_channel_count)
     MI_IMPORT_TYPES(VolumeGrid)
 
+    using UInt32Storage = DynamicBuffer<UInt32>;
+
+    /// In-memory representation of the voxel values
+    enum class StorageType { Float32, Float16, UInt8 };
+
     GridVolume(const Properties &props) : Base(props) {
         std::string filter_type_str = props.string("filter_type", "trilinear");
         dr::FilterMode filter_mode;
@@ -178,10 +243,23 @@ public:
                   wrap_mode_st);
 
         m_raw = props.get<bool>("raw", false);
+        m_interpolate_coeffs = props.get<bool>("interpolate_coefficients", false);
+        m_mipmap = props.get<bool>("mipmap", false);
         m_accel = props.get<bool>("accel", true);
 
+        std::string storage_str = props.string("storage", "float32");
+        if (storage_str == "float32")
+            m_storage = StorageType::Float32;
+        else if (storage_str == "float16")
+            m_storage = StorageType::Float16;
+        else if (storage_str == "uint8")
+            m_storage = StorageType::UInt8;
+        else
+            Throw("Invalid storage type \"%s\", must be one of: \"float32\", "
+                  "\"float16\", or \"uint8\"!", storage_str);
+
         // Load volume data
-        ref<VolumeGrid> volume_grid = nullptr;
+        ref<const VolumeGrid> volume_grid = nullptr;
         TensorXf* tensor = nullptr;
         {
             ScalarVector3u res;
@@ -194,7 +272,7 @@ public:
                 Log(Debug, "Loading volume grid from memory...");
                 // Note: ref-counted, so we don't have to worry about lifetime
                 ref<Object> other = props.object("grid");
-                volume_grid = dynamic_cast<VolumeGrid *>(other.get());
+                volume_grid = dynamic_cast<const VolumeGrid *>(other.get());
                 if (!volume_grid)
                     Throw("Property \"grid\" must be a VolumeGrid instance.");
                 res = volume_grid->size();
@@ -228,7 +306,7 @@ public:
                     Throw("Spectral conversion of tensor input is not supported "
                           "and requires a volume grid");
 
-                ScalarFloat *ptr = volume_grid->data();
+                const ScalarFloat *ptr = volume_grid->data();
 
                 auto scaled_data =
                     std::unique_ptr<ScalarFloat[]>(new ScalarFloat[size * 4]);
@@ -242,6 +320,8 @@ public:
                     ScalarColor3f rgb_norm =
                         rgb / dr::maximum((ScalarFloat) 1e-8, scale);
                     ScalarVector3f coeff = srgb_model_fetch(rgb_norm);
+                    if (m_interpolate_coeffs)
+                        coeff *= scale;
                     max = dr::maximum(max, scale);
                     dr::store(scaled_data_ptr,
                               dr::concat(coeff, dr::Array<ScalarFloat, 1>(scale)));
@@ -256,8 +336,8 @@ public:
                     (size_t) res.x(),
                     4
                 };
-                m_texture = Texture3f(TensorXf(scaled_data.get(), 4, shape),
-                                      m_accel, m_accel, filter_mode, wrap_mode);
+                set_storage(TensorXf(scaled_data.get(), 4, shape),
+                            filter_mode, wrap_mode);
             } else if (volume_grid) {
                 size_t shape[4] = {
                     (size_t) res.z(),
@@ -265,12 +345,13 @@ public:
                     (size_t) res.x(),
                     channel_count
                 };
-                m_texture = Texture3f(TensorXf(volume_grid->data(), 4, shape),
-                                      m_accel, m_accel, filter_mode, wrap_mode);
+                TensorXf data(volume_grid->data(), 4, shape);
                 m_max = volume_grid->max();
+                m_min = (float) dr::min_nested(dr::detach(data.array()));
                 m_max_per_channel.resize(volume_grid->channel_count());
                 volume_grid->max_per_channel(m_max_per_channel.data());
                 m_channel_count = channel_count;
+                set_storage(data, filter_mode, wrap_mode);
             } else if (tensor) {
                 size_t shape[4] = {
                     (size_t) res.z(),
@@ -278,10 +359,11 @@ public:
                     (size_t) res.x(),
                     channel_count
                 };
-                m_texture = Texture3f(TensorXf(tensor->array(), 4, shape),
-                                      m_accel, m_accel, filter_mode, wrap_mode);
-                m_max = (float) dr::max_nested(dr::detach(m_texture.value()));
+                TensorXf data(tensor->array(), 4, shape);
+                m_max = (float) dr::max_nested(dr::detach(data.array()));
+                m_min = (float) dr::min_nested(dr::detach(data.array()));
                 m_channel_count = channel_count;
+                set_storage(data, filter_mode, wrap_mode);
             }
         }
 
@@ -296,14 +378,30 @@ public:
             m_fixed_max = true;
             m_max = props.get<ScalarFloat>("max_value");
         }
+
+        if (m_mipmap) {
+            if (m_storage != StorageType::Float32)
+                Throw("Mipmapping requires the \"float32\" storage type!");
+            if (nchannels() != shape()[3] && !m_interpolate_coeffs)
+                Throw("Mipmapping spectrally upsampled data requires "
+                      "\"interpolate_coefficients\" to be enabled!");
+        }
+
+        update_occupancy();
+        update_mipmaps();
     }
 
     void traverse(TraversalCallback *callback) override {
-        callback->put_parameter("data", m_texture.tensor(), +ParamFlags::Differentiable);
+        // Quantized voxels cannot be updated or differentiated
+        if (m_storage == StorageType::Float32)
+            callback->put_parameter("data", m_texture.tensor(), +ParamFlags::Differentiable);
         Base::traverse(callback);
     }
 
     void parameters_changed(const std::vector<std::string> &keys) override {
+        if (m_storage != StorageType::Float32)
+            return;
+
         if (keys.empty() || string::contains(keys, "data")) {
             const size_t channels = nchannels();
             if (channels != 1 && channels != 3 && channels != 6)
@@ -315,9 +413,43 @@ public:
 
             if (!m_fixed_max)
                 m_max = (float) dr::max_nested(dr::detach(m_texture.value()));
+            m_min = (float) dr::min_nested(dr::detach(m_texture.value()));
+            update_occupancy();
+            update_mipmaps();
         }
     }
 
+    UnpolarizedSpectrum eval_filtered(const Interaction3f &it, Float width,
+                                      Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_mips.empty())
+            return eval(it, active);
+
+        // Level of detail and linear interpolation weight between levels
+        Float lod = dr::clamp(dr::log2(dr::maximum(width / m_voxel_width, 1.f)),
+                              0.f, (ScalarFloat) m_mips.size());
+        UInt32 level = UInt32(dr::floor(lod));
+        Float f = lod - Float(level);
+
+        Point3f p = m_to_local * it.p;
+        UnpolarizedSpectrum result(0.f);
+        for (uint32_t l = 0; l <= (uint32_t) m_mips.size(); ++l) {
+            Mask lower = active && dr::eq(level, l),
+                 upper = active && dr::eq(level + 1u, l) && (f > 0.f),
+                 fetch = lower || upper;
+            if (dr::none_or<false>(fetch))
+                continue;
+
+            UnpolarizedSpectrum value =
+                l == 0 ? eval(it, fetch) : eval_mip(m_mips[l - 1], p, it, fetch);
+            Float weight = dr::select(lower, 1.f - f, f);
+            dr::masked(result, fetch) = dr::fmadd(value, weight, result);
+        }
+
+        return result;
+    }
+
     UnpolarizedSpectrum eval(const Interaction3f &it,
                              Mask active) const override {
         MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
@@ -421,13 +553,52 @@ public:
 
     ScalarFloat max() const override { return m_max; }
 
+    ScalarFloat min() const override { return m_min; }
+
     void max_per_channel(ScalarFloat *out) const override {
         for (size_t i=0; i<m_max_per_channel.size(); ++i)
             out[i] = m_max_per_channel[i];
     }
 
+    void local_majorants(const ScalarVector3i &grid_res,
+                         ScalarFloat *out) const override {
+        std::vector<ScalarFloat> data = host_values();
+        level_majorants(data.data(), resolution(), grid_res, out, false);
+
+        // Lookups from coarser levels must be bounded as well
+        for (const Texture3f &mip : m_mips) {
+            auto &&level = dr::migrate(mip.tensor().array(), AllocType::Host);
+            if constexpr (dr::is_jit_v<Float>)
+                dr::sync_thread();
+            const TensorXf &tensor = mip.tensor();
+            ScalarVector3i res((int) tensor.shape(2), (int) tensor.shape(1),
+                               (int) tensor.shape(0));
+            level_majorants((const ScalarFloat *) level.data(), res, grid_res,
+                            out, true);
+        }
+    }
+
+    ScalarBoundingBox3f occupied_bbox() const override { return m_occupied_bbox; }
+
+    uint32_t empty_space_block_size() const override {
+        return m_has_empty_bricks ? (1u << OccupancyShift) : 0u;
+    }
+
+    const TensorXf *voxel_data(dr::FilterMode &filter_mode,
+                               dr::WrapMode &wrap_mode,
+                               bool &accel) const override {
+        // Quantized and spectrally upsampled voxels are decoded by lookups
+        if (m_storage != StorageType::Float32 || nchannels() != shape()[3] ||
+            !m_mips.empty())
+            return nullptr;
+        filter_mode = m_texture.filter_mode();
+        wrap_mode = m_texture.wrap_mode();
+        accel = m_accel;
+        return &m_texture.tensor();
+    }
+
     ScalarVector3i resolution() const override {
-        const size_t *shape = m_texture.shape();
+        const size_t *shape = this->shape();
         return { (int) shape[2], (int) shape[1], (int) shape[0] };
     };
 
@@ -438,7 +609,8 @@ public:
             << "  bbox = " << string::indent(m_bbox) << "," << std::endl
             << "  dimensions = " << resolution() << "," << std::endl
             << "  max = " << m_max << "," << std::endl
-            << "  channels = " << m_texture.shape()[3] << std::endl
+            << "  channels = " << shape()[3] << "," << std::endl
+            << "  storage = " << storage_name() << std::endl
             << "]";
         return oss.str();
     }
@@ -453,7 +625,7 @@ protected:
      * holds all scaling coefficients is omitted.
      */
     MI_INLINE size_t nchannels() const {
-        const size_t channels = m_texture.shape()[3];
+        const size_t channels = shape()[3];
         // When spectral upsampling is requested, a fourth channel is added to
         // the internal texture data to handle scaling coefficients.
         if (is_spectral_v<Spectrum> && channels == 4 && !m_raw)
@@ -472,6 +644,35 @@ protected:
 
         Point3f p = m_to_local * it.p;
 
+        if (m_interpolate_coeffs) {
+            // Interpolate the premultiplied coefficients and evaluate the model once
+            dr::Array<Float, 4> v;
+            if (m_storage != StorageType::Float32)
+                v = interpolate_quantized<4>(p, active);
+            else if (m_accel)
+                m_texture.eval(p, v.data(), active);
+            else
+                m_texture.eval_nonaccel(p, v.data(), active);
+
+            Float scale = dr::maximum(v.w(), 0.f);
+            dr::Array<Float, 3> coeff =
+                dr::head<3>(v) / dr::select(scale > 0.f, scale, Float(1.f));
+            return scale * srgb_model_eval<UnpolarizedSpectrum>(coeff, it.wavelengths);
+        }
+
+        if (m_storage != StorageType::Float32) {
+            UnpolarizedSpectrum result(0.f);
+            Float scale(0.f);
+            for_each_voxel<4>(p, active,
+                [&](const dr::Array<Float, 4> &value, const Float &weight) {
+                    result = dr::fmadd(
+                        srgb_model_eval<UnpolarizedSpectrum>(dr::head<3>(value), it.wavelengths),
+                        weight, result);
+                    scale = dr::fmadd(value.w(), weight, scale);
+                });
+            return result * scale;
+        }
+
         if (m_texture.filter_mode() == dr::FilterMode::Linear) {
             dr::Array<Float, 4> d000, d100, d010, d110, d001, d101, d011, d111;
             dr::Array<Float *, 8> fetch_values;
@@ -546,6 +747,9 @@ protected:
         MI_MASK_ARGUMENT(active);
 
         Point3f p = m_to_local * it.p;
+        if (m_storage != StorageType::Float32)
+            return interpolate_quantized<1>(p, active).x();
+
         Float result;
         if (m_accel)
             m_texture.eval(p, &result, active);
@@ -565,6 +769,9 @@ protected:
         MI_MASK_ARGUMENT(active);
 
         Point3f p = m_to_local * it.p;
+        if (m_storage != StorageType::Float32)
+            return Color3f(interpolate_quantized<3>(p, active));
+
         Color3f result;
         if (m_accel)
             m_texture.eval(p, result.data(), active);
@@ -584,6 +791,9 @@ protected:
         MI_MASK_ARGUMENT(active);
 
         Point3f p = m_to_local * it.p;
+        if (m_storage != StorageType::Float32)
+            return interpolate_quantized<6>(p, active);
+
         dr::Array<Float, 6> result;
         if (m_accel)
             m_texture.eval(p, result.data(), active);
@@ -604,19 +814,551 @@ protected:
         MI_MASK_ARGUMENT(active);
 
         Point3f p = m_to_local * it.p;
+        if (m_storage != StorageType::Float32) {
+            switch (m_shape[3]) {
+                case 1: store_n(interpolate_quantized<1>(p, active), out); break;
+                case 3: store_n(interpolate_quantized<3>(p, active), out); break;
+                case 4: store_n(interpolate_quantized<4>(p, active), out); break;
+                default: store_n(interpolate_quantized<6>(p, active), out); break;
+            }
+            return;
+        }
+
         if (m_accel)
             m_texture.eval(p, out, active);
         else
             m_texture.eval_nonaccel(p, out, active);
     }
 
+    /**
+     * \brief Rebuild the occupancy bitmask and the occupied bounding box
+     *
+     * The first level of the bitmask holds one bit per brick of \f$8^3\f$
+     * voxels, the second level one bit per group of \f$8^3\f$ bricks. A bit
+     * is set when one of the covered voxels is nonzero.
+     */
+    void update_occupancy() {
+        ScalarVector3i res = resolution();
+        const size_t channels = shape()[3];
+
+        // With spectral upsampling, a zero scale factor implies a zero spectrum
+        size_t ch_begin = nchannels() != channels ? 3 : 0;
+
+        for (int level = 0; level < 2; ++level) {
+            int shift = OccupancyShift * (level + 1);
+            m_occupancy_res[level] = (res + ((1 << shift) - 1)) >> shift;
+            m_occupancy[level].assign(
+                ((size_t) dr::prod(m_occupancy_res[level]) + 31) / 32, 0u);
+        }
+
+        std::vector<ScalarFloat> data = host_values();
+        ScalarVector3i lo(res), hi(-1);
+        const ScalarFloat *ptr = data.data();
+        for (int z = 0; z < res.z(); ++z) {
+            for (int y = 0; y < res.y(); ++y) {
+                for (int x = 0; x < res.x(); ++x, ptr += channels) {
+                    bool nonzero = false;
+                    for (size_t c = ch_begin; c < channels; ++c)
+                        nonzero |= ptr[c] != 0.f;
+                    if (!nonzero)
+                        continue;
+
+                    ScalarVector3i v(x, y, z);
+                    lo = dr::minimum(lo, v);
+                    hi = dr::maximum(hi, v);
+                    for (int level = 0; level < 2; ++level) {
+                        ScalarVector3i b = v >> (OccupancyShift * (level + 1)),
+                                       r = m_occupancy_res[level];
+                        size_t index = ((size_t) b.z() * r.y() + b.y()) * r.x() + b.x();
+                        m_occupancy[level][index / 32] |= 1u << (index % 32);
+                    }
+                }
+            }
+        }
+
+        // Are there bricks of zeros, which free-flight sampling could skip?
+        size_t brick_count = (size_t) dr::prod(m_occupancy_res[0]), occupied = 0;
+        for (uint32_t word : m_occupancy[0])
+            occupied += (size_t) dr::popcnt(word);
+        m_has_empty_bricks = occupied < brick_count;
+
+        if (dr::any(hi < lo)) {
+            m_occupied_bbox = ScalarBoundingBox3f();
+        } else if (wrap_mode() != dr::WrapMode::Clamp) {
+            // Voxels on one side of the grid also influence the other one
+            m_occupied_bbox = Base::occupied_bbox();
+        } else {
+            /* Interpolated lookups are nonzero less than one voxel away from
+               the center of a nonzero voxel */
+            ScalarVector3f res_f(res);
+            m_occupied_bbox = ScalarBoundingBox3f(
+                dr::maximum((ScalarVector3f(lo) - .5f) / res_f, 0.f),
+                dr::minimum((ScalarVector3f(hi) + 1.5f) / res_f, 1.f));
+        }
+    }
+
+    /**
+     * \brief Accumulate the local majorants of voxel data with resolution
+     * \c res into \c out
+     *
+     * When \c accumulate is \c false, \c out is overwritten and empty
+     * regions of the full-resolution grid are skipped using the occupancy
+     * bitmask. Otherwise, the maximum with the existing values is stored.
+     */
+    void level_majorants(const ScalarFloat *ptr, const ScalarVector3i &res,
+                         const ScalarVector3i &grid_res, ScalarFloat *out,
+                         bool accumulate) const {
+        const size_t channels = shape()[3];
+
+        // With spectral upsampling, the fourth channel bounds the spectrum
+        bool upsampled = nchannels() != channels;
+        size_t ch_begin = upsampled ? 3 : 0;
+        bool repeat = wrap_mode() == dr::WrapMode::Repeat;
+
+        /* A lookup inside a supergrid cell can interpolate all voxels whose
+           centers lie less than one voxel away from the cell */
+        auto voxel_range = [&](int i, int axis) {
+            ScalarFloat scale = (ScalarFloat) res[axis] / grid_res[axis];
+            int lo = (int) dr::floor(i * scale - .5f),
+                hi = (int) dr::floor((i + 1) * scale - .5f) + 1;
+            return std::make_pair(lo, hi);
+        };
+
+        auto wrap = [&](int v, int axis) {
+            if (repeat)
+                return (v % res[axis] + res[axis]) % res[axis];
+            return dr::clamp(v, 0, res[axis] - 1);
+        };
+
+        for (int z = 0; z < grid_res.z(); ++z) {
+            auto [z0, z1] = voxel_range(z, 2);
+            for (int y = 0; y < grid_res.y(); ++y) {
+                auto [y0, y1] = voxel_range(y, 1);
+                for (int x = 0; x < grid_res.x(); ++x) {
+                    auto [x0, x1] = voxel_range(x, 0);
+
+                    // Skip empty regions using the occupancy bitmask
+                    bool inside = x0 >= 0 && y0 >= 0 && z0 >= 0 && x1 < res.x() &&
+                                  y1 < res.y() && z1 < res.z();
+                    if (!accumulate && inside &&
+                        is_empty(ScalarVector3i(x0, y0, z0),
+                                 ScalarVector3i(x1, y1, z1))) {
+                        *out++ = 0.f;
+                        continue;
+                    }
+
+                    ScalarFloat value = 0.f;
+                    for (int vz = z0; vz <= z1; ++vz) {
+                        size_t iz = (size_t) wrap(vz, 2);
+                        for (int vy = y0; vy <= y1; ++vy) {
+                            size_t iy = (size_t) wrap(vy, 1);
+                            for (int vx = x0; vx <= x1; ++vx) {
+                                size_t ix = (size_t) wrap(vx, 0),
+                                       offset = ((iz * res.y() + iy) * res.x() + ix) * channels;
+                                for (size_t c = ch_begin; c < channels; ++c)
+                                    value = dr::maximum(value, ptr[offset + c]);
+                            }
+                        }
+                    }
+
+                    *out = accumulate ? dr::maximum(*out, value) : value;
+                    ++out;
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Rebuild the pyramid of box-filtered levels (if enabled)
+     *
+     * Each level halves the resolution of the previous one (rounding up)
+     * and stores the mean of the corresponding \f$2^3\f$ voxels. The
+     * occupied bounding box is widened to the reach of the coarser levels.
+     */
+    void update_mipmaps() {
+        m_mips.clear();
+        if (!m_mipmap)
+            return;
+
+        // World-space size of a voxel of the full-resolution grid
+        ScalarVector3i res = resolution();
+        ScalarTransform4f to_world = m_to_local.inverse();
+        m_voxel_width = 0.f;
+        for (int i = 0; i < 3; ++i) {
+            ScalarVector3f axis(0.f);
+            axis[i] = 1.f;
+            m_voxel_width += dr::norm(to_world * axis) / (3.f * res[i]);
+        }
+
+        const size_t channels = shape()[3];
+        size_t ch_begin = nchannels() != channels ? 3 : 0;
+        bool clamp = wrap_mode() == dr::WrapMode::Clamp;
+        std::vector<ScalarFloat> fine = host_values();
+
+        while (dr::max(res) > 1) {
+            ScalarVector3i res_c = dr::maximum((res + 1) / 2, 1);
+            std::vector<ScalarFloat> coarse(
+                (size_t) dr::prod(res_c) * channels, 0.f);
+            ScalarVector3i lo(res_c), hi(-1);
+
+            ScalarFloat *out = coarse.data();
+            for (int z = 0; z < res_c.z(); ++z) {
+                for (int y = 0; y < res_c.y(); ++y) {
+                    for (int x = 0; x < res_c.x(); ++x, out += channels) {
+                        // Average the (up to 8) voxels of the finer level
+                        int count = 0;
+                        for (int vz = 2 * z; vz < dr::minimum(2 * z + 2, res.z()); ++vz)
+                            for (int vy = 2 * y; vy < dr::minimum(2 * y + 2, res.y()); ++vy)
+                                for (int vx = 2 * x; vx < dr::minimum(2 * x + 2, res.x()); ++vx) {
+                                    const ScalarFloat *in = fine.data() +
+                                        (((size_t) vz * res.y() + vy) * res.x() + vx) * channels;
+                                    for (size_t c = 0; c < channels; ++c)
+                                        out[c] += in[c];
+                                    count++;
+                                }
+
+                        bool nonzero = false;
+                        for (size_t c = 0; c < channels; ++c) {
+                            out[c] /= (ScalarFloat) count;
+                            nonzero |= c >= ch_begin && out[c] != 0.f;
+                        }
+
+                        if (nonzero) {
+                            lo = dr::minimum(lo, ScalarVector3i(x, y, z));
+                            hi = dr::maximum(hi, ScalarVector3i(x, y, z));
+                        }
+                    }
+                }
+            }
+
+            // Coarser voxels spread nonzero values further
+            if (clamp && dr::all(lo <= hi)) {
+                ScalarVector3f res_f(res_c);
+                m_occupied_bbox.expand(ScalarBoundingBox3f(
+                    dr::maximum((ScalarVector3f(lo) - .5f) / res_f, 0.f),
+                    dr::minimum((ScalarVector3f(hi) + 1.5f) / res_f, 1.f)));
+            }
+
+            size_t shape[4] = { (size_t) res_c.z(), (size_t) res_c.y(),
+                                (size_t) res_c.x(), channels };
+            m_mips.emplace_back(TensorXf(coarse.data(), 4, shape), m_accel,
+                                m_accel, m_texture.filter_mode(),
+                                m_texture.wrap_mode());
+
+            fine = std::move(coarse);
+            res = res_c;
+        }
+
+        Log(Debug, "GridVolume: built %u mipmap levels", (uint32_t) m_mips.size());
+    }
+
+    /// Evaluate a level of the mipmap pyramid with color processing
+    UnpolarizedSpectrum eval_mip(const Texture3f &mip, const Point3f &p,
+                                 const Interaction3f &it, Mask active) const {
+        Float v[6];
+        if (m_accel)
+            mip.eval(p, v, active);
+        else
+            mip.eval_nonaccel(p, v, active);
+
+        const size_t channels = shape()[3];
+        if (channels == 1)
+            return v[0];
+
+        if constexpr (is_spectral_v<Spectrum>) {
+            // Premultiplied spectral upsampling coefficients
+            Float scale = dr::maximum(v[3], 0.f);
+            dr::Array<Float, 3> coeff =
+                dr::Array<Float, 3>(v[0], v[1], v[2]) /
+                dr::select(scale > 0.f, scale, Float(1.f));
+            return scale * srgb_model_eval<UnpolarizedSpectrum>(coeff, it.wavelengths);
+        } else if constexpr (is_monochromatic_v<Spectrum>) {
+            DRJIT_MARK_USED(it);
+            return luminance(Color3f(v[0], v[1], v[2]));
+        } else {
+            DRJIT_MARK_USED(it);
+            return Color3f(v[0], v[1], v[2]);
+        }
+    }
+
+    /**
+     * \brief Check whether all voxels in the range <tt>[lo, hi]</tt>
+     * (inclusive, inside the grid) are zero
+     *
+     * The coarse level of the occupancy bitmask is queried first. The result
+     * is conservative, i.e. an occupied brick may contain only zeros in the
+     * range.
+     */
+    bool is_empty(const ScalarVector3i &lo, const ScalarVector3i &hi) const {
+        for (int level = 1; level >= 0; --level) {
+            int shift = OccupancyShift * (level + 1);
+            ScalarVector3i a = lo >> shift, b = hi >> shift,
+                           r = m_occupancy_res[level];
+            bool occupied = false;
+            for (int z = a.z(); z <= b.z() && !occupied; ++z) {
+                for (int y = a.y(); y <= b.y() && !occupied; ++y) {
+                    for (int x = a.x(); x <= b.x() && !occupied; ++x) {
+                        size_t index = ((size_t) z * r.y() + y) * r.x() + x;
+                        occupied = (m_occupancy[level][index / 32] >> (index % 32)) & 1u;
+                    }
+                }
+            }
+            if (!occupied)
+                return true;
+        }
+        return false;
+    }
+
+    /// Return the shape of the stored data (including the channel count)
+    const size_t *shape() const {
+        return m_storage == StorageType::Float32 ? m_texture.shape() : m_shape;
+    }
+
+    dr::WrapMode wrap_mode() const {
+        return m_storage == StorageType::Float32 ? m_texture.wrap_mode() : m_wrap_mode;
+    }
+
+    const char *storage_name() const {
+        switch (m_storage) {
+            case StorageType::Float16: return "float16";
+            case StorageType::UInt8: return "uint8";
+            default: return "float32";
+        }
+    }
+
+    /// Store the voxel values, either in a texture or in quantized form
+    void set_storage(const TensorXf &tensor, dr::FilterMode filter_mode,
+                     dr::WrapMode wrap_mode) {
+        if (m_storage == StorageType::Float32) {
+            m_texture = Texture3f(tensor, m_accel, m_accel, filter_mode, wrap_mode);
+            return;
+        }
+
+        m_filter_mode = filter_mode;
+        m_wrap_mode = wrap_mode;
+        for (size_t i = 0; i < 4; ++i)
+            m_shape[i] = tensor.shape(i);
+
+        auto &&data = dr::migrate(tensor.array(), AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+        const ScalarFloat *ptr = (const ScalarFloat *) data.data();
+
+        const size_t channels = m_shape[3],
+                     count    = tensor.array().size();
+        const bool half      = m_storage == StorageType::Float16;
+        const uint32_t bits  = half ? 16 : 8,
+                       per_word = 32 / bits;
+
+        // Map the range of every channel onto the unit interval
+        std::vector<ScalarFloat> lo(channels, dr::Infinity<ScalarFloat>),
+                                 hi(channels, -dr::Infinity<ScalarFloat>);
+        for (size_t i = 0; i < count; ++i) {
+            lo[i % channels] = dr::minimum(lo[i % channels], ptr[i]);
+            hi[i % channels] = dr::maximum(hi[i % channels], ptr[i]);
+        }
+
+        std::vector<uint32_t> packed((count + per_word - 1) / per_word, 0u);
+        for (size_t i = 0; i < count; ++i) {
+            size_t c = i % channels;
+            ScalarFloat range = hi[c] - lo[c],
+                        u = range > 0.f ? (ptr[i] - lo[c]) / range : 0.f;
+            uint32_t q = half ? (uint32_t) dr::half::float32_to_float16((float) u)
+                              : (uint32_t) (u * 255.f + .5f);
+            packed[i / per_word] |= q << ((i % per_word) * bits);
+        }
+
+        m_quant_offset = lo;
+        m_quant_scale.resize(channels);
+        for (size_t c = 0; c < channels; ++c)
+            m_quant_scale[c] = (hi[c] - lo[c]) / (half ? 1.f : 255.f);
+        m_packed = dr::load<UInt32Storage>(packed.data(), packed.size());
+
+        /* Lookups interpolate the decoded values, use them for all
+           statistics so that the maxima remain strict bounds */
+        std::vector<ScalarFloat> decoded = host_values();
+        std::vector<ScalarFloat> max_c(channels, -dr::Infinity<ScalarFloat>),
+                                 min_c(channels, dr::Infinity<ScalarFloat>);
+        for (size_t i = 0; i < count; ++i) {
+            max_c[i % channels] = dr::maximum(max_c[i % channels], decoded[i]);
+            min_c[i % channels] = dr::minimum(min_c[i % channels], decoded[i]);
+        }
+
+        if (nchannels() != channels) {
+            // Spectral upsampling: the scale factor bounds the spectrum
+            m_max = max_c[3];
+        } else {
+            m_max = *std::max_element(max_c.begin(), max_c.end());
+            m_min = *std::min_element(min_c.begin(), min_c.end());
+            m_max_per_channel = max_c;
+        }
+
+        Log(Debug, "GridVolume: stored %s of voxel data as %s (instead of %s)",
+            util::mem_string(packed.size() * sizeof(uint32_t)), storage_name(),
+            util::mem_string(count * sizeof(ScalarFloat)));
+    }
+
+    /// Return the (decoded) voxel values in host memory
+    std::vector<ScalarFloat> host_values() const {
+        if (m_storage == StorageType::Float32) {
+            auto &&data = dr::migrate(m_texture.tensor().array(), AllocType::Host);
+            if constexpr (dr::is_jit_v<Float>)
+                dr::sync_thread();
+            const ScalarFloat *ptr = (const ScalarFloat *) data.data();
+            return std::vector<ScalarFloat>(ptr, ptr + data.size());
+        }
+
+        auto &&packed = dr::migrate(m_packed, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+        const uint32_t *ptr = (const uint32_t *) packed.data();
+
+        const size_t channels = m_shape[3],
+                     count = m_shape[0] * m_shape[1] * m_shape[2] * channels;
+        std::vector<ScalarFloat> result(count);
+        for (size_t i = 0; i < count; ++i) {
+            size_t c = i % channels;
+            ScalarFloat u;
+            if (m_storage == StorageType::Float16)
+                u = (ScalarFloat) dr::half::float16_to_float32(
+                    (uint16_t) (ptr[i >> 1] >> ((i & 1) << 4)));
+            else
+                u = (ScalarFloat) ((ptr[i >> 2] >> ((i & 3) << 3)) & 0xffu);
+            result[i] = dr::fmadd(u, m_quant_scale[c], m_quant_offset[c]);
+        }
+        return result;
+    }
+
+    /**
+     * \brief Decode half precision values stored in the low 16 bits of \c h
+     *
+     * The quantized values are nonnegative and finite by construction, which
+     * reduces the conversion to a shift and an exponent rebias (the latter
+     * also takes care of denormals).
+     */
+    static Float half_to_float(const UInt32 &h) {
+        using Float32 = dr::float32_array_t<Float>;
+        Float32 value = dr::reinterpret_array<Float32>(dr::sl<13>(h & 0x7fffu));
+        return Float(value * 0x1p112f);
+    }
+
+    /// Apply the wrap mode to integer voxel coordinates
+    Vector3i wrap(const Vector3i &v) const {
+        ScalarVector3i res = resolution();
+        if (m_wrap_mode == dr::WrapMode::Repeat) {
+            return ((v % res) + res) % res;
+        } else if (m_wrap_mode == dr::WrapMode::Mirror) {
+            ScalarVector3i period = 2 * res;
+            Vector3i m = ((v % period) + period) % period;
+            return dr::select(m >= res, period - 1 - m, m);
+        } else {
+            return dr::clamp(v, 0, res - 1);
+        }
+    }
+
+    /// Fetch and decode the quantized channels of the voxel \c v
+    template <size_t Channels>
+    dr::Array<Float, Channels> fetch_quantized(const Vector3i &v_,
+                                               Mask active) const {
+        ScalarVector3i res = resolution();
+        Vector3i v = wrap(v_);
+        UInt32 index = UInt32((v.z() * res.y() + v.y()) * res.x() + v.x()) *
+                       (uint32_t) Channels;
+
+        dr::Array<Float, Channels> result;
+        for (size_t c = 0; c < Channels; ++c) {
+            UInt32 i = index + (uint32_t) c;
+            Float u;
+            if (m_storage == StorageType::Float16) {
+                UInt32 word = dr::gather<UInt32>(m_packed, dr::sr<1>(i), active);
+                u = half_to_float(word >> dr::sl<4>(i & 1u));
+            } else {
+                UInt32 word = dr::gather<UInt32>(m_packed, dr::sr<2>(i), active);
+                u = Float((word >> dr::sl<3>(i & 3u)) & 0xffu);
+            }
+            result[c] = dr::fmadd(u, m_quant_scale[c], m_quant_offset[c]);
+        }
+        return result;
+    }
+
+    /**
+     * \brief Invoke \c func on each quantized voxel of the filter footprint
+     * of the local point \c p along with its interpolation weight
+     */
+    template <size_t Channels, typename Func>
+    void for_each_voxel(const Point3f &p, Mask active, Func func) const {
+        ScalarVector3f res = resolution();
+        if (m_filter_mode == dr::FilterMode::Nearest) {
+            Vector3i v = dr::floor2int<Vector3i>(p * res);
+            func(fetch_quantized<Channels>(v, active), Float(1.f));
+            return;
+        }
+
+        Point3f pos = dr::fmadd(p, res, -.5f);
+        Vector3i v0 = dr::floor2int<Vector3i>(pos);
+        Point3f w1 = pos - Point3f(v0),
+                w0 = 1.f - w1;
+
+        for (int i = 0; i < 8; ++i) {
+            Vector3i offset((i & 1) ? 1 : 0, (i & 2) ? 1 : 0, (i & 4) ? 1 : 0);
+            Float weight = ((i & 1) ? w1.x() : w0.x()) *
+                           ((i & 2) ? w1.y() : w0.y()) *
+                           ((i & 4) ? w1.z() : w0.z());
+            func(fetch_quantized<Channels>(v0 + offset, active), weight);
+        }
+    }
+
+    /// Interpolate the quantized channels at the local point \c p
+    template <size_t Channels>
+    dr::Array<Float, Channels> interpolate_quantized(const Point3f &p,
+                                                     Mask active) const {
+        dr::Array<Float, Channels> result(0.f);
+        for_each_voxel<Channels>(p, active,
+            [&](const dr::Array<Float, Channels> &value, const Float &weight) {
+                result = dr::fmadd(value, weight, result);
+            });
+        return result;
+    }
+
+    template <size_t Channels>
+    static void store_n(const dr::Array<Float, Channels> &value, Float *out) {
+        for (size_t c = 0; c < Channels; ++c)
+            out[c] = value[c];
+    }
+
 protected:
     Texture3f m_texture;
     bool m_accel;
     bool m_raw;
+    /// Are the upsampling coefficients premultiplied by the scale factor?
+    bool m_interpolate_coeffs;
+
+    /// Box-filtered levels of detail (excluding the full-resolution grid)
+    bool m_mipmap;
+    std::vector<Texture3f> m_mips;
+    ScalarFloat m_voxel_width = 1.f;
     bool m_fixed_max = false;
+
+    /* Reduced precision storage: two half precision or four 8-bit values
+       per word, with per-channel dequantization factors */
+    StorageType m_storage;
+    UInt32Storage m_packed;
+    std::vector<ScalarFloat> m_quant_scale, m_quant_offset;
+    size_t m_shape[4] = { 0, 0, 0, 0 };
+    dr::FilterMode m_filter_mode;
+    dr::WrapMode m_wrap_mode;
+
     ScalarFloat m_max;
+    /// Minimum over the grid (zero for spectrally upsampled RGB data)
+    ScalarFloat m_min = 0.f;
     std::vector<ScalarFloat> m_max_per_channel;
+
+    /// Hierarchical occupancy bitmask (bricks and groups of bricks)
+    static constexpr int OccupancyShift = 3;
+    std::vector<uint32_t> m_occupancy[2];
+    ScalarVector3i m_occupancy_res[2];
+    ScalarBoundingBox3f m_occupied_bbox;
+    bool m_has_empty_bricks;
 };
 
 MI_IMPLEMENT_CLASS_VARIANT(GridVolume, Volume)
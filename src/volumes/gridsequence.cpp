@@ -0,0 +1,577 @@
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/thread.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/render/volume.h>
+#include <mitsuba/render/volumegrid.h>
+#include <drjit/texture.h>
+#include <nanothread/nanothread.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+.. _volume-gridsequence:
+
+Animated grid-based volume data source (:monosp:`gridsequence`)
+---------------------------------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename pattern of the frames, containing a printf-style integer
+     placeholder for the frame number (e.g. ``smoke/frame_%04d.vol``). The
+     frames use the file format of :ref:`gridvolume <volume-gridvolume>`.
+
+ * - frame_start
+   - |int|
+   - Number of the first frame of the sequence (Default: 0)
+
+ * - frame_count
+   - |int|
+   - Number of frames in the sequence (Default: all consecutive frames found
+     on disk, starting at :paramtype:`frame_start`)
+
+ * - frame
+   - |float|
+   - Current position in the sequence, in frames. The integer part selects
+     the frame, the fractional part interpolates towards the next one.
+     (Default: :paramtype:`frame_start`)
+   - |exposed|
+
+ * - fps
+   - |float|
+   - When positive, the time of every lookup advances the position in the
+     sequence by ``time * fps`` frames, which produces temporally blurred
+     volumes when the sensor has a nonzero shutter time. (Default: 0)
+
+ * - interpolate
+   - |bool|
+   - Linearly interpolate between consecutive frames. Otherwise, the nearest
+     preceding frame is used. (Default: true)
+
+ * - cache_size
+   - |int|
+   - Maximum number of decoded frames kept in memory (Default: 4)
+
+ * - prefetch
+   - |int|
+   - Number of upcoming frames that are loaded in the background whenever
+     the current frame changes. It is limited to :paramtype:`cache_size`
+     minus the two resident frames. (Default: 2)
+
+ * - filter_type
+   - |string|
+   - Specifies how voxel values are interpolated: ``trilinear`` (default) or
+     ``nearest``.
+
+ * - wrap_mode
+   - |string|
+   - Controls the behavior of volume evaluations that fall outside of the
+     :math:`[0, 1]` range: ``clamp`` (default), ``repeat`` or ``mirror``.
+
+ * - accel
+   - |bool|
+   - Use hardware accelerated texture lookups in CUDA mode (Default: true)
+
+ * - to_world
+   - |transform|
+   - Specifies an optional 4x4 transformation matrix that will be applied to volume coordinates.
+
+This plugin plays back a sequence of volume grids, e.g. the frames of a smoke
+simulation, within a single scene. Every frame is stored in a separate file
+and evaluated like a :ref:`gridvolume <volume-gridvolume>`. Changing the
+``frame`` scene parameter selects another frame without reloading the scene:
+
+.. code-block:: python
+
+    params = mi.traverse(scene)
+    for i in range(frame_count):
+        params['medium.sigma_t.frame'] = i
+        params.update()
+        image = mi.render(scene, params)
+
+Two frames, the current one and its successor, are resident at any time so
+that lookups can blend between them. Decoded frames are kept in a small cache
+of the most recently used ones, and switching to a frame immediately starts
+loading the following :paramtype:`prefetch` frames on background threads.
+During sequential playback, reading a frame from disk hence overlaps with
+rendering the previous ones.
+
+Ray times are expected to lie within one frame interval after ``frame``: the
+position in the sequence is clamped to the two resident frames. All frames
+must have the same number of channels (1, 3 or 6). Color data is not converted
+to spectra, i.e. this plugin behaves like a ``gridvolume`` with
+:paramtype:`raw` enabled in spectral variants.
+
+.. tabs::
+    .. code-tab:: xml
+
+        <medium type="heterogeneous">
+            <volume type="gridsequence" name="sigma_t">
+                <string name="filename" value="smoke/frame_%04d.vol"/>
+                <float name="frame" value="12"/>
+            </volume>
+        </medium>
+
+    .. code-tab:: python
+
+        'type': 'heterogeneous',
+        'sigma_t': {
+            'type': 'gridsequence',
+            'filename': 'smoke/frame_%04d.vol',
+            'frame': 12
+        }
+
+*/
+
+template <typename Float, typename Spectrum>
+class GridSequenceVolume final : public Volume<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Volume, m_to_local, m_bbox, m_channel_count)
+    MI_IMPORT_TYPES(VolumeGrid)
+
+    GridSequenceVolume(const Properties &props) : Base(props) {
+        std::string filter_type_str = props.string("filter_type", "trilinear");
+        if (filter_type_str == "nearest")
+            m_filter_mode = dr::FilterMode::Nearest;
+        else if (filter_type_str == "trilinear")
+            m_filter_mode = dr::FilterMode::Linear;
+        else
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\" or "
+                  "\"trilinear\"!", filter_type_str);
+
+        std::string wrap_mode_st = props.string("wrap_mode", "clamp");
+        if (wrap_mode_st == "repeat")
+            m_wrap_mode = dr::WrapMode::Repeat;
+        else if (wrap_mode_st == "mirror")
+            m_wrap_mode = dr::WrapMode::Mirror;
+        else if (wrap_mode_st == "clamp")
+            m_wrap_mode = dr::WrapMode::Clamp;
+        else
+            Throw("Invalid wrap mode \"%s\", must be one of: \"repeat\", "
+                  "\"mirror\", or \"clamp\"!", wrap_mode_st);
+
+        m_accel       = props.get<bool>("accel", true);
+        m_interpolate = props.get<bool>("interpolate", true);
+        m_fps         = props.get<ScalarFloat>("fps", 0.f);
+        m_cache_size  = std::max(props.get<uint32_t>("cache_size", 4), 2u);
+        m_prefetch    = props.get<uint32_t>("prefetch", 2);
+
+        /* Prefetched frames must fit in the cache next to the two resident
+           ones, otherwise they evict each other before they are used */
+        if (m_prefetch + 2 > m_cache_size) {
+            Log(Warn, "GridSequenceVolume: a cache of %u frames can only "
+                      "hold %u prefetched frames, reducing \"prefetch\" "
+                      "from %u.", m_cache_size, m_cache_size - 2, m_prefetch);
+            m_prefetch = m_cache_size - 2;
+        }
+
+        m_pattern = props.string("filename");
+        if (m_pattern.find('%') == std::string::npos)
+            Throw("The filename \"%s\" must contain a placeholder for the frame "
+                  "number (e.g. \"frame_%%04d.vol\")!", m_pattern);
+
+        m_frame_start = props.get<int>("frame_start", 0);
+        if (props.has_property("frame_count")) {
+            m_frame_count = props.get<int>("frame_count");
+        } else {
+            m_frame_count = 0;
+            while (fs::exists(frame_path(m_frame_start + m_frame_count)))
+                ++m_frame_count;
+        }
+        if (m_frame_count <= 0)
+            Throw("No frames found for the filename pattern \"%s\"!", m_pattern);
+
+        m_frame = props.get<ScalarFloat>("frame", (ScalarFloat) m_frame_start);
+        update_frames();
+    }
+
+    ~GridSequenceVolume() {
+        // Background loads refer to the cache entries
+        for (auto &entry : m_cache) {
+            if (entry->task) {
+                try {
+                    task_wait_and_release(entry->task);
+                } catch (...) { }
+            }
+        }
+    }
+
+    void traverse(TraversalCallback *callback) override {
+        callback->put_parameter("frame", m_frame, +ParamFlags::NonDifferentiable);
+        Base::traverse(callback);
+    }
+
+    void parameters_changed(const std::vector<std::string> &keys) override {
+        if (keys.empty() || string::contains(keys, "frame"))
+            update_frames();
+    }
+
+    UnpolarizedSpectrum eval(const Interaction3f &it,
+                             Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channel_count == 1)
+            return lookup<1>(it, active).x();
+
+        if (m_channel_count != 3 || is_spectral_v<Spectrum>)
+            Throw("The GridSequenceVolume %s was queried for a spectrum, but "
+                  "has %u channels (color data is not converted to spectra)",
+                  to_string(), m_channel_count);
+
+        if constexpr (is_monochromatic_v<Spectrum>)
+            return luminance(Color3f(lookup<3>(it, active)));
+        else
+            return Color3f(lookup<3>(it, active));
+    }
+
+    Float eval_1(const Interaction3f &it, Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channel_count == 1)
+            return lookup<1>(it, active).x();
+        else if (m_channel_count == 3)
+            return luminance(Color3f(lookup<3>(it, active)));
+        else // 6 channels
+            return dr::mean(lookup<6>(it, active));
+    }
+
+    Vector3f eval_3(const Interaction3f &it,
+                    Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channel_count != 3)
+            Throw("eval_3(): The GridSequenceVolume %s was queried for a 3D "
+                  "vector, but it has %s channel(s)", to_string(), m_channel_count);
+
+        return Vector3f(lookup<3>(it, active));
+    }
+
+    dr::Array<Float, 6> eval_6(const Interaction3f &it,
+                               Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        if (m_channel_count != 6)
+            Throw("eval_6(): The GridSequenceVolume %s was queried for a 6D "
+                  "vector, but it has %s channel(s)", to_string(), m_channel_count);
+
+        return lookup<6>(it, active);
+    }
+
+    void eval_n(const Interaction3f &it, Float *out,
+                Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        switch (m_channel_count) {
+            case 1: store_n(lookup<1>(it, active), out); break;
+            case 3: store_n(lookup<3>(it, active), out); break;
+            default: store_n(lookup<6>(it, active), out); break;
+        }
+    }
+
+    ScalarFloat max() const override {
+        ScalarFloat result = m_frames[0].max;
+        if (m_blend)
+            result = dr::maximum(result, m_frames[1].max);
+        return result;
+    }
+
+    ScalarFloat min() const override {
+        ScalarFloat result = m_frames[0].min;
+        if (m_blend)
+            result = dr::minimum(result, m_frames[1].min);
+        return result;
+    }
+
+    void max_per_channel(ScalarFloat *out) const override {
+        for (size_t i = 0; i < m_channel_count; ++i) {
+            out[i] = m_frames[0].max_per_channel[i];
+            if (m_blend)
+                out[i] = dr::maximum(out[i], m_frames[1].max_per_channel[i]);
+        }
+    }
+
+    void local_majorants(const ScalarVector3i &grid_res,
+                         ScalarFloat *out) const override {
+        size_t cell_count = (size_t) dr::prod(grid_res);
+        std::fill(out, out + cell_count, 0.f);
+
+        for (size_t f = 0; f < (m_blend ? 2 : 1); ++f) {
+            const VolumeGrid *grid = m_frames[f].grid.get();
+            ScalarVector3i res = ScalarVector3i(grid->size());
+            const size_t channels = grid->channel_count();
+            const ScalarFloat *ptr = grid->data();
+            bool repeat = m_wrap_mode == dr::WrapMode::Repeat;
+
+            /* A lookup inside a supergrid cell can interpolate all voxels
+               whose centers lie less than one voxel away from the cell */
+            auto voxel_range = [&](int i, int axis) {
+                ScalarFloat scale = (ScalarFloat) res[axis] / grid_res[axis];
+                int lo = (int) dr::floor(i * scale - .5f),
+                    hi = (int) dr::floor((i + 1) * scale - .5f) + 1;
+                return std::make_pair(lo, hi);
+            };
+
+            auto wrap = [&](int v, int axis) {
+                if (repeat)
+                    return (v % res[axis] + res[axis]) % res[axis];
+                return dr::clamp(v, 0, res[axis] - 1);
+            };
+
+            ScalarFloat *cell = out;
+            for (int z = 0; z < grid_res.z(); ++z) {
+                auto [z0, z1] = voxel_range(z, 2);
+                for (int y = 0; y < grid_res.y(); ++y) {
+                    auto [y0, y1] = voxel_range(y, 1);
+                    for (int x = 0; x < grid_res.x(); ++x) {
+                        auto [x0, x1] = voxel_range(x, 0);
+
+                        ScalarFloat value = *cell;
+                        for (int vz = z0; vz <= z1; ++vz) {
+                            size_t iz = (size_t) wrap(vz, 2);
+                            for (int vy = y0; vy <= y1; ++vy) {
+                                size_t iy = (size_t) wrap(vy, 1);
+                                for (int vx = x0; vx <= x1; ++vx) {
+                                    size_t ix = (size_t) wrap(vx, 0),
+                                           offset = ((iz * res.y() + iy) * res.x() + ix) * channels;
+                                    for (size_t c = 0; c < channels; ++c)
+                                        value = dr::maximum(value, ptr[offset + c]);
+                                }
+                            }
+                        }
+
+                        *cell++ = value;
+                    }
+                }
+            }
+        }
+    }
+
+    ScalarVector3i resolution() const override {
+        const size_t *shape = m_frames[0].texture.shape();
+        return { (int) shape[2], (int) shape[1], (int) shape[0] };
+    }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "GridSequenceVolume[" << std::endl
+            << "  to_local = " << string::indent(m_to_local, 13) << "," << std::endl
+            << "  bbox = " << string::indent(m_bbox) << "," << std::endl
+            << "  filename = \"" << m_pattern << "\"," << std::endl
+            << "  frames = [" << m_frame_start << ", "
+            << m_frame_start + m_frame_count - 1 << "]," << std::endl
+            << "  frame = " << m_frame << "," << std::endl
+            << "  fps = " << m_fps << "," << std::endl
+            << "  dimensions = " << resolution() << "," << std::endl
+            << "  channels = " << m_channel_count << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// A decoded frame in the cache, possibly still being loaded
+    struct CacheEntry {
+        int frame;
+        ref<const VolumeGrid> grid;
+        /// Pending background load (writes \c grid)
+        Task *task = nullptr;
+        uint64_t last_use = 0;
+    };
+
+    /// A frame that is resident in a texture
+    struct Frame {
+        int index = -1;
+        ref<const VolumeGrid> grid;
+        Texture3f texture;
+        ScalarFloat max = 0.f, min = 0.f;
+        std::vector<ScalarFloat> max_per_channel;
+    };
+
+    fs::path frame_path(int frame) const {
+        FileResolver *fs = Thread::thread()->file_resolver();
+        return fs->resolve(tfm::format(m_pattern.c_str(), frame));
+    }
+
+    /// Look up a frame in the cache, or create a new (empty) entry for it
+    CacheEntry *cache_entry(int frame) {
+        for (auto &entry : m_cache) {
+            if (entry->frame == frame) {
+                entry->last_use = ++m_cache_clock;
+                return entry.get();
+            }
+        }
+
+        if (m_cache.size() >= m_cache_size) {
+            // Evict the least recently used frame that is not resident
+            auto victim = m_cache.end();
+            for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+                int f = (*it)->frame;
+                if (f == m_frames[0].index || f == m_frames[1].index)
+                    continue;
+                if (victim == m_cache.end() || (*it)->last_use < (*victim)->last_use)
+                    victim = it;
+            }
+
+            if (victim != m_cache.end()) {
+                if ((*victim)->task) {
+                    try {
+                        task_wait_and_release((*victim)->task);
+                    } catch (...) { }
+                }
+                m_cache.erase(victim);
+            }
+        }
+
+        m_cache.push_back(std::make_unique<CacheEntry>());
+        CacheEntry *entry = m_cache.back().get();
+        entry->frame = frame;
+        entry->last_use = ++m_cache_clock;
+        return entry;
+    }
+
+    /// Start loading a frame on a background thread (if not cached yet)
+    void prefetch(int frame) {
+        for (auto &entry : m_cache)
+            if (entry->frame == frame)
+                return;
+
+        CacheEntry *entry = cache_entry(frame);
+        fs::path path = frame_path(frame);
+        ThreadEnvironment env;
+        entry->task = dr::do_async([entry, path, env]() mutable {
+            ScopedSetThreadEnvironment set_env(env);
+            // Read the file completely so that rendering never waits on I/O
+            entry->grid = new VolumeGrid(path, false);
+        });
+    }
+
+    /// Return the decoded grid of a frame, waiting for or performing its load
+    ref<const VolumeGrid> load(int frame) {
+        CacheEntry *entry = cache_entry(frame);
+        if (entry->task) {
+            Task *task = entry->task;
+            entry->task = nullptr;
+            task_wait_and_release(task);
+        }
+        if (!entry->grid)
+            entry->grid = new VolumeGrid(frame_path(frame), false);
+        return entry->grid;
+    }
+
+    /// Make a frame resident in a texture
+    void make_resident(Frame &slot, int frame) {
+        ref<const VolumeGrid> grid = load(frame);
+
+        uint32_t channel_count = (uint32_t) grid->channel_count();
+        if (channel_count != 1 && channel_count != 3 && channel_count != 6)
+            Throw("Frame %i of \"%s\" has %u channels, only volumes with 1, 3 "
+                  "or 6 channels are supported!", frame, m_pattern, channel_count);
+        if (m_frames[0].index >= 0 && channel_count != m_channel_count)
+            Throw("Frame %i of \"%s\" has %u channels, expected %u!", frame,
+                  m_pattern, channel_count, m_channel_count);
+        m_channel_count = channel_count;
+
+        ScalarVector3u res = grid->size();
+        size_t shape[4] = { (size_t) res.z(), (size_t) res.y(),
+                            (size_t) res.x(), channel_count };
+        slot.index   = frame;
+        slot.grid    = grid;
+        slot.texture = Texture3f(TensorXf(grid->data(), 4, shape), m_accel,
+                                 m_accel, m_filter_mode, m_wrap_mode);
+        slot.max     = grid->max();
+        slot.min     = (ScalarFloat) dr::min_nested(dr::detach(slot.texture.value()));
+        slot.max_per_channel.resize(channel_count);
+        grid->max_per_channel(slot.max_per_channel.data());
+    }
+
+    /// Update the resident frames following a change of \c m_frame
+    void update_frames() {
+        int last = m_frame_start + m_frame_count - 1,
+            base = dr::clamp((int) dr::floor(m_frame), m_frame_start, last),
+            next = std::min(base + 1, last);
+
+        if (m_frames[0].index != base) {
+            // Sequential playback: the previous successor becomes current
+            if (m_frames[1].index == base)
+                std::swap(m_frames[0], m_frames[1]);
+            else
+                make_resident(m_frames[0], base);
+        }
+
+        if (m_frames[1].index != next)
+            make_resident(m_frames[1], next);
+
+        // Overlap loading the upcoming frames with rendering this one
+        for (uint32_t i = 1; i <= m_prefetch && next + (int) i <= last; ++i)
+            prefetch(next + (int) i);
+
+        ScalarFloat offset = dr::clamp(m_frame - (ScalarFloat) base, 0.f, 1.f);
+        m_blend = next != base && (m_fps > 0.f || (m_interpolate && offset > 0.f));
+        m_frame_offset = dr::opaque<Float>(offset);
+    }
+
+    /// Evaluate the texture of a resident frame
+    template <size_t Channels>
+    dr::Array<Float, Channels> eval_frame(const Frame &frame, const Point3f &p,
+                                          Mask active) const {
+        dr::Array<Float, Channels> result;
+        if (m_accel)
+            frame.texture.eval(p, result.data(), active);
+        else
+            frame.texture.eval_nonaccel(p, result.data(), active);
+        return result;
+    }
+
+    /// Evaluate the sequence at the position and time of \c it
+    template <size_t Channels>
+    dr::Array<Float, Channels> lookup(const Interaction3f &it,
+                                      Mask active) const {
+        Point3f p = m_to_local * it.p;
+        dr::Array<Float, Channels> value = eval_frame<Channels>(m_frames[0], p, active);
+        if (!m_blend)
+            return value;
+
+        // Position relative to the current frame, clamped to the next one
+        Float t = dr::clamp(dr::fmadd(it.time, m_fps, m_frame_offset), 0.f, 1.f);
+        if (!m_interpolate)
+            t = dr::select(t >= 1.f, Float(1.f), Float(0.f));
+
+        dr::Array<Float, Channels> next =
+            eval_frame<Channels>(m_frames[1], p, active && t > 0.f);
+        return dr::fmadd(next - value, t, value);
+    }
+
+    template <size_t Channels>
+    static void store_n(const dr::Array<Float, Channels> &value, Float *out) {
+        for (size_t c = 0; c < Channels; ++c)
+            out[c] = value[c];
+    }
+
+protected:
+    std::string m_pattern;
+    int m_frame_start, m_frame_count;
+    ScalarFloat m_frame, m_fps;
+    bool m_interpolate, m_accel;
+    dr::FilterMode m_filter_mode;
+    dr::WrapMode m_wrap_mode;
+
+    /// Current and next frame, and whether lookups need to blend them
+    Frame m_frames[2];
+    bool m_blend = false;
+    Float m_frame_offset;
+
+    /// Decoded frames, most recently used ones are retained
+    std::vector<std::unique_ptr<CacheEntry>> m_cache;
+    uint32_t m_cache_size, m_prefetch;
+    uint64_t m_cache_clock = 0;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(GridSequenceVolume, Volume)
+MI_EXPORT_PLUGIN(GridSequenceVolume, "GridSequenceVolume texture")
+
+NAMESPACE_END(mitsuba)
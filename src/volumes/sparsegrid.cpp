@@ -0,0 +1,612 @@
+#include <mitsuba/core/fresolver.h>
+#include <mitsuba/core/properties.h>
+#include <mitsuba/core/spectrum.h>
+#include <mitsuba/core/string.h>
+#include <mitsuba/core/transform.h>
+#include <mitsuba/core/util.h>
+#include <mitsuba/render/srgb.h>
+#include <mitsuba/render/volume.h>
+#include <mitsuba/render/volumegrid.h>
+#include <drjit/dynamic.h>
+
+NAMESPACE_BEGIN(mitsuba)
+
+/**!
+.. _volume-sparsegridvolume:
+
+Sparse grid-based volume data source (:monosp:`sparsegridvolume`)
+-----------------------------------------------------------------
+
+.. pluginparameters::
+
+ * - filename
+   - |string|
+   - Filename of the volume to be loaded (same format as :ref:`gridvolume
+     <volume-gridvolume>`)
+
+ * - grid
+   - :monosp:`VolumeGrid object`
+   - When creating a grid volume at runtime, e.g. from Python or C++,
+     an existing ``VolumeGrid`` instance can be passed directly rather than
+     loading it from the filesystem with :paramtype:`filename`.
+
+ * - data
+   - |tensor|
+   - Tensor array containing the grid data. This parameter can only be specified
+     when building this plugin at runtime from Python or C++ and cannot be
+     specified in the XML scene description.
+
+ * - filter_type
+   - |string|
+   - Specifies how voxel values are interpolated: ``trilinear`` (default) or
+     ``nearest``.
+
+ * - wrap_mode
+   - |string|
+   - Controls the behavior of volume evaluations that fall outside of the
+     :math:`[0, 1]` range: ``clamp`` (default), ``repeat`` or ``mirror``.
+
+ * - raw
+   - |bool|
+   - Should the transformation to the stored color data (e.g. sRGB to linear,
+     spectral upsampling) be disabled? (Default: false)
+
+ * - use_grid_bbox
+   - |bool|
+   - Use the bounding box stored in the volume file (Default: false)
+
+ * - to_world
+   - |transform|
+   - Specifies an optional 4x4 transformation matrix that will be applied to volume coordinates.
+
+This plugin provides the same interface as :ref:`gridvolume <volume-gridvolume>`
+but stores the voxels in a sparse, two-level layout that is better suited to
+large simulation caches in which most of the domain is empty. The grid is
+split into bricks of :math:`8^3` voxels, and only bricks containing at least
+one nonzero value are stored. A top-level index maps every brick of the grid
+either to its data or to a single shared brick of zeros, so that lookups do
+not need to branch on occupancy.
+
+The memory footprint is thus proportional to the number of occupied bricks
+rather than to the full resolution of the grid. Lookups are slightly more
+expensive than with the dense plugin (every voxel access goes through the
+index), and hardware texture interpolation is not used. Voxels are addressed
+with 32-bit offsets, hence the occupied bricks may hold at most :math:`2^{32}`
+values (e.g. about 8 million bricks of a single-channel volume).
+
+.. tabs::
+    .. code-tab:: xml
+
+        <medium type="heterogeneous">
+            <volume type="sparsegridvolume" name="sigma_t">
+                <string name="filename" value="smoke.vol"/>
+            </volume>
+        </medium>
+
+    .. code-tab:: python
+
+        'type': 'heterogeneous',
+        'sigma_t': {
+            'type': 'sparsegridvolume',
+            'filename': 'smoke.vol'
+        }
+
+*/
+
+template <typename Float, typename Spectrum>
+class SparseGridVolume final : public Volume<Float, Spectrum> {
+public:
+    MI_IMPORT_BASE(Volume, update_bbox, m_to_local, m_bbox, m_channel_count)
+    MI_IMPORT_TYPES(VolumeGrid)
+
+    using UInt32Storage = DynamicBuffer<UInt32>;
+    using FloatStorage  = DynamicBuffer<Float>;
+
+    /// Number of voxels along each axis of a brick (as a power of two)
+    static constexpr uint32_t BrickShift = 3;
+    static constexpr uint32_t BrickSize  = 1u << BrickShift;
+    static constexpr uint32_t BrickMask  = BrickSize - 1;
+    static constexpr uint32_t BrickVoxels = BrickSize * BrickSize * BrickSize;
+
+    enum class WrapMode { Clamp, Repeat, Mirror };
+
+    SparseGridVolume(const Properties &props) : Base(props) {
+        std::string filter_type_str = props.string("filter_type", "trilinear");
+        if (filter_type_str == "nearest")
+            m_nearest = true;
+        else if (filter_type_str == "trilinear")
+            m_nearest = false;
+        else
+            Throw("Invalid filter type \"%s\", must be one of: \"nearest\" or "
+                  "\"trilinear\"!", filter_type_str);
+
+        std::string wrap_mode_st = props.string("wrap_mode", "clamp");
+        if (wrap_mode_st == "repeat")
+            m_wrap_mode = WrapMode::Repeat;
+        else if (wrap_mode_st == "mirror")
+            m_wrap_mode = WrapMode::Mirror;
+        else if (wrap_mode_st == "clamp")
+            m_wrap_mode = WrapMode::Clamp;
+        else
+            Throw("Invalid wrap mode \"%s\", must be one of: \"repeat\", "
+                  "\"mirror\", or \"clamp\"!",
+                  wrap_mode_st);
+
+        m_raw = props.get<bool>("raw", false);
+
+        // Load the dense volume data (only kept alive during construction)
+        ref<const VolumeGrid> volume_grid = nullptr;
+        std::unique_ptr<ScalarFloat[]> tensor_data;
+        const ScalarFloat *data = nullptr;
+        uint32_t channel_count = 0;
+
+        if (props.has_property("grid")) {
+            if (props.has_property("filename"))
+                Throw("Cannot specify both \"grid\" and \"filename\".");
+            ref<Object> other = props.object("grid");
+            volume_grid = dynamic_cast<const VolumeGrid *>(other.get());
+            if (!volume_grid)
+                Throw("Property \"grid\" must be a VolumeGrid instance.");
+        } else if (props.has_property("data")) {
+            TensorXf *tensor = props.tensor<TensorXf>("data");
+            if (tensor->ndim() != 3 && tensor->ndim() != 4)
+                Throw("Tensor has %lu dimensions. Expected 3 or 4", tensor->ndim());
+            m_res = ScalarVector3i((int) tensor->shape(2), (int) tensor->shape(1),
+                                   (int) tensor->shape(0));
+            channel_count = tensor->ndim() == 4 ? (uint32_t) tensor->shape(3) : 1;
+
+            size_t size = tensor->array().size();
+            tensor_data = std::unique_ptr<ScalarFloat[]>(new ScalarFloat[size]);
+            auto &&host = dr::migrate(tensor->array(), AllocType::Host);
+            if constexpr (dr::is_jit_v<Float>)
+                dr::sync_thread();
+            memcpy(tensor_data.get(), host.data(), size * sizeof(ScalarFloat));
+            data = tensor_data.get();
+        } else {
+            FileResolver *fs = Thread::thread()->file_resolver();
+            fs::path file_path = fs->resolve(props.string("filename"));
+            if (!fs::exists(file_path))
+                Log(Error, "\"%s\": file does not exist!", file_path);
+            volume_grid = new VolumeGrid(file_path);
+        }
+
+        if (volume_grid) {
+            m_res = ScalarVector3i(volume_grid->size());
+            channel_count = (uint32_t) volume_grid->channel_count();
+            data = volume_grid->data();
+        }
+
+        if (channel_count != 1 && channel_count != 3 && channel_count != 6)
+            Throw("Unsupported number of channels (%u), only volumes with 1, "
+                  "3 or 6 channels are supported!", channel_count);
+        m_channel_count = channel_count;
+
+        // RGB data is converted to spectral coefficients and a scale factor
+        m_upsampled = is_spectral_v<Spectrum> && channel_count == 3 && !m_raw;
+        m_storage_channels = m_upsampled ? 4 : channel_count;
+
+        build(data, channel_count);
+
+        if (props.get<bool>("use_grid_bbox", false)) {
+            if (!volume_grid)
+                Throw("use_grid_bbox is unsupported with tensor input and requires a volume grid");
+            m_to_local = volume_grid->bbox_transform() * m_to_local;
+            update_bbox();
+        }
+    }
+
+    UnpolarizedSpectrum eval(const Interaction3f &it,
+                             Mask active) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        const size_t channels = nchannels();
+        if (channels == 3 && is_spectral_v<Spectrum> && m_raw)
+            Throw("The SparseGridVolume %s was queried for a spectrum, but "
+                  "texture conversion into spectra was explicitly disabled! "
+                  "(raw=true)",
+                  to_string());
+        else if (channels != 3 && channels != 1)
+            Throw("The SparseGridVolume %s was queried for a spectrum, but "
+                  "has a number of channels which is not 1 or 3",
+                  to_string());
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<UnpolarizedSpectrum>();
+
+        Point3f p = m_to_local * it.p;
+        if (channels == 1)
+            return interpolate<1>(p, active).x();
+
+        if constexpr (is_monochromatic_v<Spectrum>) {
+            return luminance(Color3f(interpolate<3>(p, active)));
+        } else if constexpr (is_spectral_v<Spectrum>) {
+            return interpolate_spectral(p, it.wavelengths, active);
+        } else {
+            return Color3f(interpolate<3>(p, active));
+        }
+    }
+
+    Float eval_1(const Interaction3f &it, Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        const size_t channels = nchannels();
+        if (channels == 3 && m_upsampled)
+            Throw("eval_1(): The SparseGridVolume %s was queried for a "
+                  "scalar value, but texture conversion into spectra was "
+                  "requested! (raw=false)",
+                  to_string());
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<Float>();
+
+        Point3f p = m_to_local * it.p;
+        if (channels == 1)
+            return interpolate<1>(p, active).x();
+        else if (channels == 3)
+            return luminance(Color3f(interpolate<3>(p, active)));
+        else // 6 channels
+            return dr::mean(interpolate<6>(p, active));
+    }
+
+    void eval_n(const Interaction3f &it, Float *out,
+                Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        Point3f p = m_to_local * it.p;
+        switch (m_storage_channels) {
+            case 1: store_n(interpolate<1>(p, active), out); break;
+            case 3: store_n(interpolate<3>(p, active), out); break;
+            case 4: store_n(interpolate<4>(p, active), out); break;
+            default: store_n(interpolate<6>(p, active), out); break;
+        }
+    }
+
+    Vector3f eval_3(const Interaction3f &it,
+                    Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        const size_t channels = nchannels();
+        if (channels != 3) {
+            Throw("eval_3(): The SparseGridVolume %s was queried for a 3D "
+                  "vector, but it has %s channel(s)", to_string(), channels);
+        } else if (m_upsampled) {
+            Throw("eval_3(): The SparseGridVolume %s was queried for a 3D "
+                  "vector, but texture conversion into spectra was requested! "
+                  "(raw=false)", to_string());
+        }
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<Vector3f>();
+
+        return Vector3f(interpolate<3>(m_to_local * it.p, active));
+    }
+
+    dr::Array<Float, 6> eval_6(const Interaction3f &it,
+                               Mask active = true) const override {
+        MI_MASKED_FUNCTION(ProfilerPhase::TextureEvaluate, active);
+
+        const size_t channels = nchannels();
+        if (channels != 6)
+            Throw("eval_6(): The SparseGridVolume %s was queried for a 6D "
+                  "vector, but it has %s channel(s)", to_string(), channels);
+
+        if (dr::none_or<false>(active))
+            return dr::zeros<dr::Array<Float, 6>>();
+
+        return interpolate<6>(m_to_local * it.p, active);
+    }
+
+    ScalarFloat max() const override { return m_max; }
+
+    ScalarFloat min() const override { return m_min; }
+
+    void max_per_channel(ScalarFloat *out) const override {
+        for (size_t i = 0; i < m_max_per_channel.size(); ++i)
+            out[i] = m_max_per_channel[i];
+    }
+
+    void local_majorants(const ScalarVector3i &grid_res,
+                         ScalarFloat *out) const override {
+        auto &&index = dr::migrate(m_brick_index, AllocType::Host);
+        auto &&values = dr::migrate(m_data, AllocType::Host);
+        if constexpr (dr::is_jit_v<Float>)
+            dr::sync_thread();
+        const uint32_t *index_ptr = (const uint32_t *) index.data();
+        const ScalarFloat *data_ptr = (const ScalarFloat *) values.data();
+
+        // With spectral upsampling, the fourth channel bounds the spectrum
+        size_t ch_begin = m_upsampled ? 3 : 0;
+
+        /* A lookup inside a supergrid cell can interpolate all voxels whose
+           centers lie less than one voxel away from the cell */
+        auto voxel_range = [&](int i, int axis) {
+            ScalarFloat scale = (ScalarFloat) m_res[axis] / grid_res[axis];
+            int lo = (int) dr::floor(i * scale - .5f),
+                hi = (int) dr::floor((i + 1) * scale - .5f) + 1;
+            return std::make_pair(lo, hi);
+        };
+
+        for (int z = 0; z < grid_res.z(); ++z) {
+            auto [z0, z1] = voxel_range(z, 2);
+            for (int y = 0; y < grid_res.y(); ++y) {
+                auto [y0, y1] = voxel_range(y, 1);
+                for (int x = 0; x < grid_res.x(); ++x) {
+                    auto [x0, x1] = voxel_range(x, 0);
+
+                    ScalarFloat value = 0.f;
+                    for (int vz = z0; vz <= z1; ++vz) {
+                        for (int vy = y0; vy <= y1; ++vy) {
+                            for (int vx = x0; vx <= x1; ++vx) {
+                                ScalarVector3i v = wrap(ScalarVector3i(vx, vy, vz));
+                                uint32_t slot = index_ptr[brick_index(v)];
+                                // Skip over empty bricks
+                                if (slot == 0)
+                                    continue;
+                                size_t offset = voxel_offset(slot, v);
+                                for (size_t c = ch_begin; c < m_storage_channels; ++c)
+                                    value = dr::maximum(value, data_ptr[offset + c]);
+                            }
+                        }
+                    }
+
+                    *out++ = value;
+                }
+            }
+        }
+    }
+
+    uint32_t empty_space_block_size() const override {
+        return m_brick_count < (size_t) dr::prod(m_brick_res) ? BrickSize : 0u;
+    }
+
+    ScalarVector3i resolution() const override { return m_res; }
+
+    std::string to_string() const override {
+        std::ostringstream oss;
+        oss << "SparseGridVolume[" << std::endl
+            << "  to_local = " << string::indent(m_to_local, 13) << "," << std::endl
+            << "  bbox = " << string::indent(m_bbox) << "," << std::endl
+            << "  dimensions = " << m_res << "," << std::endl
+            << "  bricks = " << m_brick_count << " / " << dr::prod(m_brick_res)
+            << " (" << util::mem_string(m_data.size() * sizeof(ScalarFloat)) << ")," << std::endl
+            << "  max = " << m_max << "," << std::endl
+            << "  channels = " << nchannels() << std::endl
+            << "]";
+        return oss.str();
+    }
+
+    MI_DECLARE_CLASS()
+
+protected:
+    /// Number of channels exposed by the volume (3 for upsampled RGB data)
+    size_t nchannels() const { return m_upsampled ? 3 : m_storage_channels; }
+
+    /// Split the dense input into bricks and only keep the occupied ones
+    void build(const ScalarFloat *data, uint32_t channels) {
+        m_brick_res = (m_res + (int) BrickMask) / (int) BrickSize;
+        size_t n_bricks = (size_t) dr::prod(m_brick_res);
+
+        m_max = -dr::Infinity<ScalarFloat>;
+        m_min = dr::Infinity<ScalarFloat>;
+        m_max_per_channel = std::vector<ScalarFloat>(channels, -dr::Infinity<ScalarFloat>);
+
+        // Slot 0 is a brick of zeros shared by all empty regions
+        std::vector<uint32_t> index(n_bricks, 0u);
+        std::vector<ScalarFloat> storage(BrickVoxels * m_storage_channels, 0.f);
+        bool has_empty = false;
+
+        auto voxel = [&](int x, int y, int z) {
+            return data + (((size_t) z * m_res.y() + y) * m_res.x() + x) * channels;
+        };
+
+        for (int bz = 0; bz < m_brick_res.z(); ++bz) {
+            for (int by = 0; by < m_brick_res.y(); ++by) {
+                for (int bx = 0; bx < m_brick_res.x(); ++bx) {
+                    ScalarVector3i lo = ScalarVector3i(bx, by, bz) * (int) BrickSize,
+                                   hi = dr::minimum(lo + (int) BrickSize, m_res);
+
+                    bool occupied = false;
+                    for (int z = lo.z(); z < hi.z() && !occupied; ++z)
+                        for (int y = lo.y(); y < hi.y() && !occupied; ++y)
+                            for (int x = lo.x(); x < hi.x() && !occupied; ++x)
+                                for (uint32_t c = 0; c < channels; ++c)
+                                    occupied |= voxel(x, y, z)[c] != 0.f;
+
+                    has_empty |= !occupied;
+                    if (!occupied)
+                        continue;
+
+                    /* Voxel offsets are 32-bit integers, which limits the
+                       storage to 2^32 values (including the empty brick) */
+                    size_t storage_size =
+                        storage.size() + BrickVoxels * m_storage_channels;
+                    if (storage_size > (size_t) UINT32_MAX)
+                        Throw("SparseGridVolume: the occupied bricks of the "
+                              "volume require %zu values, which exceeds the "
+                              "limit of 32-bit voxel offsets.", storage_size);
+
+                    uint32_t slot = (uint32_t) (storage.size() /
+                                                (BrickVoxels * m_storage_channels));
+                    index[(bz * m_brick_res.y() + by) * m_brick_res.x() + bx] = slot;
+                    storage.resize(storage.size() + BrickVoxels * m_storage_channels, 0.f);
+
+                    for (int z = lo.z(); z < hi.z(); ++z) {
+                        for (int y = lo.y(); y < hi.y(); ++y) {
+                            for (int x = lo.x(); x < hi.x(); ++x) {
+                                const ScalarFloat *src = voxel(x, y, z);
+                                ScalarFloat *dst = storage.data() +
+                                    voxel_offset(slot, ScalarVector3i(x, y, z));
+
+                                for (uint32_t c = 0; c < channels; ++c) {
+                                    m_max = dr::maximum(m_max, src[c]);
+                                    m_min = dr::minimum(m_min, src[c]);
+                                    m_max_per_channel[c] =
+                                        dr::maximum(m_max_per_channel[c], src[c]);
+                                }
+
+                                if (m_upsampled) {
+                                    ScalarColor3f rgb = dr::load<ScalarColor3f>(src);
+                                    ScalarFloat scale = dr::max(rgb) * 2.f;
+                                    ScalarColor3f rgb_norm =
+                                        rgb / dr::maximum((ScalarFloat) 1e-8, scale);
+                                    ScalarVector3f coeff = srgb_model_fetch(rgb_norm);
+                                    dr::store(dst, dr::concat(coeff, dr::Array<ScalarFloat, 1>(scale)));
+                                } else {
+                                    memcpy(dst, src, channels * sizeof(ScalarFloat));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        m_brick_count = storage.size() / (BrickVoxels * m_storage_channels) - 1;
+        if (m_brick_count == 0) {
+            m_max = m_min = 0.f;
+            std::fill(m_max_per_channel.begin(), m_max_per_channel.end(), 0.f);
+        } else if (has_empty) {
+            m_min = dr::minimum(m_min, 0.f);
+            for (auto &value : m_max_per_channel)
+                value = dr::maximum(value, 0.f);
+            m_max = dr::maximum(m_max, 0.f);
+        }
+
+        if (m_upsampled) {
+            // As in 'gridvolume', the scale factor bounds the spectrum
+            m_max = 2.f * m_max;
+            m_min = 0.f;
+        }
+
+        m_brick_index = dr::load<UInt32Storage>(index.data(), index.size());
+        m_data = dr::load<FloatStorage>(storage.data(), storage.size());
+
+        Log(Debug, "SparseGridVolume: %u / %u bricks occupied (%s instead of %s)",
+            (uint32_t) m_brick_count, (uint32_t) n_bricks,
+            util::mem_string(storage.size() * sizeof(ScalarFloat)),
+            util::mem_string((size_t) dr::prod(m_res) * m_storage_channels *
+                             sizeof(ScalarFloat)));
+    }
+
+    /// Apply the wrap mode to integer voxel coordinates
+    template <typename Vector3i_>
+    Vector3i_ wrap(const Vector3i_ &v) const {
+        if (m_wrap_mode == WrapMode::Repeat) {
+            return ((v % m_res) + m_res) % m_res;
+        } else if (m_wrap_mode == WrapMode::Mirror) {
+            ScalarVector3i period = 2 * m_res;
+            Vector3i_ m = ((v % period) + period) % period;
+            return dr::select(m >= m_res, period - 1 - m, m);
+        } else {
+            return dr::clamp(v, 0, m_res - 1);
+        }
+    }
+
+    /// Index of the brick containing the (wrapped) voxel \c v
+    template <typename Vector3i_>
+    auto brick_index(const Vector3i_ &v) const {
+        auto b = dr::sr<BrickShift>(v);
+        return (b.z() * m_brick_res.y() + b.y()) * m_brick_res.x() + b.x();
+    }
+
+    /// Offset of the first channel of voxel \c v inside brick \c slot
+    template <typename Value, typename Vector3i_>
+    Value voxel_offset(const Value &slot, const Vector3i_ &v) const {
+        auto l = v & (int) BrickMask;
+        Value local = Value(dr::sl<2 * BrickShift>(l.z()) |
+                            dr::sl<BrickShift>(l.y()) | l.x());
+        return (slot * BrickVoxels + local) * (uint32_t) m_storage_channels;
+    }
+
+    /// Fetch the channels of the voxel \c v (integer coordinates, unwrapped)
+    template <size_t Channels>
+    dr::Array<Float, Channels> fetch(const Vector3i &v_, Mask active) const {
+        Vector3i v = wrap(v_);
+        UInt32 slot = dr::gather<UInt32>(m_brick_index, UInt32(brick_index(v)), active);
+        UInt32 offset = voxel_offset(slot, v);
+
+        dr::Array<Float, Channels> result;
+        for (size_t c = 0; c < Channels; ++c)
+            result[c] = dr::gather<Float>(m_data, offset + (uint32_t) c, active);
+        return result;
+    }
+
+    /**
+     * \brief Invoke \c func on each voxel of the filter footprint of the
+     * local point \c p along with its interpolation weight
+     */
+    template <size_t Channels, typename Func>
+    void for_each_voxel(const Point3f &p, Mask active, Func func) const {
+        if (m_nearest) {
+            Vector3i v = dr::floor2int<Vector3i>(p * ScalarVector3f(m_res));
+            func(fetch<Channels>(v, active), Float(1.f));
+            return;
+        }
+
+        Point3f pos = dr::fmadd(p, ScalarVector3f(m_res), -.5f);
+        Vector3i v0 = dr::floor2int<Vector3i>(pos);
+        Point3f w1 = pos - Point3f(v0),
+                w0 = 1.f - w1;
+
+        for (int i = 0; i < 8; ++i) {
+            Vector3i offset((i & 1) ? 1 : 0, (i & 2) ? 1 : 0, (i & 4) ? 1 : 0);
+            Float weight = ((i & 1) ? w1.x() : w0.x()) *
+                           ((i & 2) ? w1.y() : w0.y()) *
+                           ((i & 4) ? w1.z() : w0.z());
+            func(fetch<Channels>(v0 + offset, active), weight);
+        }
+    }
+
+    /// Interpolate the stored channels at the local point \c p
+    template <size_t Channels>
+    dr::Array<Float, Channels> interpolate(const Point3f &p, Mask active) const {
+        dr::Array<Float, Channels> result(0.f);
+        for_each_voxel<Channels>(p, active,
+            [&](const dr::Array<Float, Channels> &value, const Float &weight) {
+                result = dr::fmadd(value, weight, result);
+            });
+        return result;
+    }
+
+    /// Interpolate spectrally upsampled RGB data (see 'gridvolume')
+    UnpolarizedSpectrum interpolate_spectral(const Point3f &p,
+                                             const Wavelength &wavelengths,
+                                             Mask active) const {
+        UnpolarizedSpectrum result(0.f);
+        Float scale(0.f);
+        for_each_voxel<4>(p, active,
+            [&](const dr::Array<Float, 4> &value, const Float &weight) {
+                result = dr::fmadd(
+                    srgb_model_eval<UnpolarizedSpectrum>(dr::head<3>(value), wavelengths),
+                    weight, result);
+                scale = dr::fmadd(value.w(), weight, scale);
+            });
+        return result * scale;
+    }
+
+    template <size_t Channels>
+    static void store_n(const dr::Array<Float, Channels> &value, Float *out) {
+        for (size_t c = 0; c < Channels; ++c)
+            out[c] = value[c];
+    }
+
+protected:
+    /// Top-level index: one storage slot per brick (0 = shared empty brick)
+    UInt32Storage m_brick_index;
+    /// Voxel data of the occupied bricks (channels interleaved)
+    FloatStorage m_data;
+
+    ScalarVector3i m_res, m_brick_res;
+    size_t m_brick_count;
+    uint32_t m_storage_channels;
+    bool m_nearest, m_raw, m_upsampled;
+    WrapMode m_wrap_mode;
+
+    ScalarFloat m_max, m_min;
+    std::vector<ScalarFloat> m_max_per_channel;
+};
+
+MI_IMPLEMENT_CLASS_VARIANT(SparseGridVolume, Volume)
+MI_EXPORT_PLUGIN(SparseGridVolume, "SparseGridVolume texture")
+
+NAMESPACE_END(mitsuba)
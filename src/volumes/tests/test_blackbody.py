@@ -0,0 +1,63 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+import os
+
+
+def load_blackbody_volume(tmpdir, temperatures, **kwargs):
+    tmp_file = os.path.join(str(tmpdir), "temperature.vol")
+    grid = mi.TensorXf(temperatures, [1, 1, len(temperatures), 1])
+    mi.VolumeGrid(grid).write(tmp_file)
+    return mi.load_dict({
+        'type': 'blackbodyvolume',
+        'temperature': { 'type': 'gridvolume', 'filename': tmp_file },
+        **kwargs
+    })
+
+
+def test01_spectral_matches_planck(variants_all_spectral, tmpdir):
+    vol = load_blackbody_volume(tmpdir, [1500.0])
+    spec = mi.load_dict({ 'type': 'blackbody', 'temperature': 1500.0 })
+
+    # Wavelengths on table nodes, at the highest tabulated temperature
+    it = dr.zeros(mi.Interaction3f, 1)
+    it.p = mi.Point3f(0.5)
+    it.wavelengths = mi.UnpolarizedSpectrum([400.0, 500.0, 600.0, 700.0])
+
+    si = dr.zeros(mi.SurfaceInteraction3f, 1)
+    si.wavelengths = it.wavelengths
+    ref = spec.eval(si)
+
+    assert dr.allclose(vol.eval(it), ref, rtol=1e-3)
+    assert dr.all(vol.max() >= dr.max(vol.eval(it)))
+
+
+def test02_rgb_color(variants_all_rgb, tmpdir):
+    vol = load_blackbody_volume(tmpdir, [1000.0, 2000.0], scale=1e-3)
+
+    it = dr.zeros(mi.Interaction3f, 1)
+    it.p = mi.Point3f(0.25, 0.5, 0.5)
+    cold = vol.eval(it)
+    it.p = mi.Point3f(0.75, 0.5, 0.5)
+    hot = vol.eval(it)
+
+    # Glowing matter is red, and becomes brighter and whiter when heated
+    assert dr.all((cold.x > cold.y) & (cold.y > cold.z))
+    assert dr.all((hot.x > cold.x) & (hot.y > cold.y) & (hot.z > cold.z))
+    assert dr.all(hot.z / hot.x > cold.z / cold.x)
+
+    assert dr.allclose(vol.max(), dr.max(hot), rtol=1e-3)
+
+
+def test03_scales(variants_all_rgb, tmpdir):
+    vol = load_blackbody_volume(tmpdir, [1.0], temperature_scale=1800.0)
+    ref = load_blackbody_volume(tmpdir, [1800.0], scale=2.0)
+
+    it = dr.zeros(mi.Interaction3f, 1)
+    it.p = mi.Point3f(0.5)
+    assert dr.allclose(2.0 * vol.eval(it), ref.eval(it), rtol=1e-3)
+
+    # Temperatures beyond the table are clamped
+    clamped = load_blackbody_volume(tmpdir, [1800.0], temperature_max=900.0)
+    low = load_blackbody_volume(tmpdir, [900.0])
+    assert dr.allclose(clamped.eval(it), low.eval(it), rtol=1e-3)
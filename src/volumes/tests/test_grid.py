@@ -114,3 +114,128 @@ def test06_eval_per_channel(variants_all_rgb, tmpdir):
     it.p = mi.Point3f(1.0)
     print(vol.eval_n(it))
     assert dr.allclose(vol.eval_n(it), [1.0, 2.0, 3.0, 4.0, 5.0, 6.0])
+
+
+@pytest.mark.parametrize('storage', ['float16', 'uint8'])
+@pytest.mark.parametrize('filter_type', ['nearest', 'trilinear'])
+def test07_reduced_precision_storage(variants_all_rgb, storage, filter_type):
+    n = 4 * 5 * 6 * 3
+    grid = dr.linspace(mi.Float, 0.25, 2.0, n)
+    grid = mi.TensorXf(grid, [4, 5, 6, 3])
+
+    def load(storage):
+        return mi.load_dict({
+            'type': 'gridvolume',
+            'data': grid,
+            'raw': True,
+            'filter_type': filter_type,
+            'storage': storage,
+            'accel': False,
+        })
+
+    reference, vol = load('float32'), load(storage)
+    assert dr.all(vol.resolution() == reference.resolution())
+
+    rng = mi.PCG32(size=256)
+    it = dr.zeros(mi.Interaction3f, 256)
+    it.p = mi.Point3f(rng.next_float32(), rng.next_float32(), rng.next_float32())
+
+    # 8-bit quantization of the [0.25, 2] range loses about 3.4e-3
+    atol = 1e-3 if storage == 'float16' else 4e-3
+    assert dr.allclose(vol.eval_3(it), reference.eval_3(it), atol=atol)
+
+    # Statistics describe the decoded values and thus bound all lookups
+    value = vol.eval_3(it)
+    assert dr.allclose(vol.max(), 2.0, atol=atol)
+    assert dr.allclose(vol.min(), 0.25, atol=atol)
+    for c in range(3):
+        assert dr.all((value[c] <= vol.max()) & (value[c] >= vol.min()))
+
+    step = 1.75 / (n - 1)
+    expected = [2.0 - (2 - c) * step for c in range(3)]
+    assert dr.allclose(vol.max_per_channel(), expected, atol=atol)
+
+
+def test08_occupied_bbox(variants_all_rgb):
+    grid = dr.zeros(mi.TensorXf, [16, 16, 16, 1])
+    grid[2:6, 4:8, 8:12, 0] = 1.0
+
+    vol = mi.load_dict({'type': 'gridvolume', 'data': grid})
+
+    # Dilated by the half-voxel reach of trilinear interpolation
+    bbox = vol.occupied_bbox()
+    assert dr.allclose(bbox.min, mi.ScalarPoint3f(7.5, 3.5, 1.5) / 16)
+    assert dr.allclose(bbox.max, mi.ScalarPoint3f(12.5, 8.5, 6.5) / 16)
+
+    # Lookups outside of the occupied region are zero
+    rng = mi.PCG32(size=1024)
+    it = dr.zeros(mi.Interaction3f, 1024)
+    it.p = mi.Point3f(rng.next_float32(), rng.next_float32(), rng.next_float32())
+    inside = dr.all((it.p >= bbox.min) & (it.p <= bbox.max))
+    assert dr.all(inside | dr.eq(vol.eval_1(it), 0.0))
+
+    # The occupancy is updated along with the data
+    params = mi.traverse(vol)
+    params['data'] = dr.zeros(mi.TensorXf, [16, 16, 16, 1])
+    params.update()
+    assert not vol.occupied_bbox().valid()
+
+    # Lookups that wrap around can reach any point of the grid
+    vol = mi.load_dict({'type': 'gridvolume', 'data': grid, 'wrap_mode': 'repeat'})
+    bbox = vol.occupied_bbox()
+    assert dr.allclose(bbox.min, 0.0) and dr.allclose(bbox.max, 1.0)
+
+
+def test09_interpolate_coefficients(variants_vec_spectral, tmpdir):
+    tmp_file = os.path.join(str(tmpdir), "out.vol")
+    # A single color (0.8, 0.4, 0.2) with a varying density
+    index = dr.arange(mi.UInt32, 64 * 3)
+    density = dr.gather(mi.Float, dr.linspace(mi.Float, 0.0, 2.0, 64), index // 3)
+    color = dr.gather(mi.Float, mi.Float(0.8, 0.4, 0.2), index % 3)
+    grid = mi.TensorXf(density * color, [4, 4, 4, 3])
+    mi.VolumeGrid(grid).write(tmp_file)
+
+    def load(interpolate_coefficients):
+        return mi.load_dict({
+            'type': 'gridvolume',
+            'filename': tmp_file,
+            'interpolate_coefficients': interpolate_coefficients,
+            'accel': False,
+        })
+
+    reference, vol = load(False), load(True)
+
+    rng = mi.PCG32(size=256)
+    it = dr.zeros(mi.Interaction3f, 256)
+    it.p = mi.Point3f(rng.next_float32(), rng.next_float32(), rng.next_float32())
+    it.wavelengths = mi.sample_shifted(rng.next_float32()) * \
+        (mi.MI_CIE_MAX - mi.MI_CIE_MIN) + mi.MI_CIE_MIN
+
+    # With a single color, interpolating the coefficients is exact
+    assert dr.allclose(vol.eval(it), reference.eval(it), rtol=1e-4, atol=1e-6)
+    assert dr.allclose(vol.max(), reference.max())
+
+
+def test10_mipmap(variants_all_rgb):
+    n = 8 * 8 * 8
+    grid = mi.TensorXf(dr.linspace(mi.Float, 0, 2, n) * dr.linspace(mi.Float, 1, 0, n),
+                       [8, 8, 8, 1])
+    vol = mi.load_dict({'type': 'gridvolume', 'data': grid, 'mipmap': True})
+
+    rng = mi.PCG32(size=256)
+    it = dr.zeros(mi.Interaction3f, 256)
+    it.p = mi.Point3f(rng.next_float32(), rng.next_float32(), rng.next_float32())
+
+    # Footprints smaller than a voxel use the full resolution grid
+    assert dr.allclose(vol.eval_filtered(it, 0.0), vol.eval(it))
+    assert dr.allclose(vol.eval_filtered(it, 1 / 16), vol.eval(it))
+
+    # Two voxels wide: means of 2x2x2 blocks at the first level
+    it.p = mi.Point3f(1 / 8)
+    index = mi.UInt32([z * 64 + y * 8 + x for z in range(2)
+                       for y in range(2) for x in range(2)])
+    expected = dr.mean(dr.gather(mi.Float, grid.array, index))
+    assert dr.allclose(vol.eval_filtered(it, 2 / 8), expected, rtol=1e-5)
+
+    # The coarsest level holds the mean of the entire grid
+    assert dr.allclose(vol.eval_filtered(it, 100.0), dr.mean(grid.array), rtol=1e-5)
@@ -0,0 +1,74 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+import numpy as np
+import os
+
+
+def write_frames(tmpdir, count):
+    # Frame i is a constant grid of value i + 1
+    for i in range(count):
+        data = np.full((4, 4, 4, 1), i + 1.0)
+        data[0, 0, 0, 0] = 0.0
+        mi.VolumeGrid(data).write(os.path.join(str(tmpdir), f'frame_{i:03d}.vol'))
+    return os.path.join(str(tmpdir), 'frame_%03d.vol')
+
+
+def test01_frames(variants_all_rgb, tmpdir):
+    pattern = write_frames(tmpdir, 5)
+    vol = mi.load_dict({
+        'type': 'gridsequence',
+        'filename': pattern,
+        'frame': 1.0,
+        'cache_size': 3,
+    })
+    assert vol.max() == 2.0
+
+    it = dr.zeros(mi.Interaction3f)
+    it.p = mi.Point3f(0.5)
+    assert dr.allclose(vol.eval_1(it), 2.0)
+
+    # Fractional frames blend consecutive frames
+    params = mi.traverse(vol)
+    params['frame'] = 2.25
+    params.update()
+    assert dr.allclose(vol.eval_1(it), 3.25)
+    assert vol.max() == 4.0
+    assert vol.min() == 0.0
+
+    # Frames are clamped to the sequence, also when jumping around
+    for frame, expected in [(0.0, 1.0), (4.0, 5.0), (7.0, 5.0), (3.0, 4.0)]:
+        params['frame'] = frame
+        params.update()
+        assert dr.allclose(vol.eval_1(it), expected)
+
+
+def test02_time(variants_all_rgb, tmpdir):
+    pattern = write_frames(tmpdir, 3)
+
+    vol = mi.load_dict({
+        'type': 'gridsequence',
+        'filename': pattern,
+        'fps': 24.0,
+    })
+    it = dr.zeros(mi.Interaction3f, 3)
+    it.p = mi.Point3f(0.5)
+    it.time = mi.Float(0, 0.5 / 24, 2 / 24)
+    assert dr.allclose(vol.eval_1(it), [1.0, 1.5, 2.0])
+
+    vol = mi.load_dict({
+        'type': 'gridsequence',
+        'filename': pattern,
+        'fps': 24.0,
+        'interpolate': False,
+    })
+    assert dr.allclose(vol.eval_1(it), [1.0, 1.0, 2.0])
+
+
+def test03_invalid_pattern(variant_scalar_rgb, tmpdir):
+    write_frames(tmpdir, 1)
+    with pytest.raises(RuntimeError):
+        mi.load_dict({
+            'type': 'gridsequence',
+            'filename': os.path.join(str(tmpdir), 'frame_000.vol'),
+        })
@@ -0,0 +1,56 @@
+import pytest
+import drjit as dr
+import mitsuba as mi
+
+
+def create_grid(channels=1):
+    # Mostly empty grid with a few occupied bricks, including a partial one
+    grid = dr.zeros(mi.TensorXf, [20, 17, 12, channels])
+    grid[2:7, 3:9, 1:5, :] = 1.5
+    grid[16:20, 15:17, 9:12, :] = 4.0
+    grid[10, 8, 6, 0] = 0.25
+    return grid
+
+
+def eval_both(grid, n=512, **kwargs):
+    dense = mi.load_dict(dict(type='gridvolume', data=grid, **kwargs))
+    sparse = mi.load_dict(dict(type='sparsegridvolume', data=grid, **kwargs))
+
+    sampler = mi.load_dict({'type': 'independent'})
+    sampler.seed(0, n)
+    it = dr.zeros(mi.Interaction3f, n)
+    # Include points outside of [0, 1]^3 to exercise the wrap modes
+    it.p = mi.Point3f(sampler.next_1d(), sampler.next_1d(), sampler.next_1d()) * 1.4 - 0.2
+    return dense, sparse, it
+
+
+@pytest.mark.parametrize('filter_type', ['trilinear', 'nearest'])
+@pytest.mark.parametrize('wrap_mode', ['clamp', 'repeat', 'mirror'])
+def test01_matches_gridvolume(variants_all_rgb, filter_type, wrap_mode):
+    dense, sparse, it = eval_both(create_grid(), filter_type=filter_type,
+                                  wrap_mode=wrap_mode, accel=False)
+    assert dr.allclose(sparse.eval_1(it), dense.eval_1(it), atol=1e-5)
+    assert dr.allclose(sparse.eval(it), dense.eval(it), atol=1e-5)
+    assert dr.all(sparse.resolution() == dense.resolution())
+
+
+def test02_multiple_channels(variants_all_rgb):
+    grid = create_grid(3)
+    grid[..., 1] *= 0.5
+    dense, sparse, it = eval_both(grid, accel=False)
+    assert dr.allclose(sparse.eval(it), dense.eval(it), atol=1e-5)
+    assert dr.allclose(sparse.eval_3(it), dense.eval_3(it), atol=1e-5)
+
+    grid = create_grid(6)
+    dense, sparse, it = eval_both(grid, accel=False)
+    assert dr.allclose(sparse.eval_6(it), dense.eval_6(it), atol=1e-5)
+
+
+def test03_bounds(variants_all_rgb):
+    grid = create_grid(3)
+    grid[..., 2] = 0
+    sparse = mi.load_dict({'type': 'sparsegridvolume', 'data': grid})
+
+    assert dr.allclose(sparse.max(), 4.0)
+    assert dr.allclose(sparse.min(), 0.0)
+    assert dr.allclose(sparse.max_per_channel(), [4.0, 4.0, 0.0])